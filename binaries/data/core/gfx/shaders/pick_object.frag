@@ -0,0 +1,30 @@
+// Writes the id of the object and the id of the province under the fragment for picking
+// [uniform] object_id id of the object
+// [uniform] province_ids province id texture, only read if has_provinces is set
+#version 330 core
+
+out uvec4 FragId;
+
+uniform int object_id;
+uniform bool has_provinces;
+uniform usampler2D province_ids;
+
+uniform float C;
+uniform float far;
+uniform float offset;
+
+in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
+
+in vec4 frag_pos;
+
+void main()
+{
+    gl_FragDepth = (log(C * frag_pos.z + offset) / log(C * far + offset));
+    uint province = 0u;
+    if (has_provinces) {
+        province = texture(province_ids, TexCoords).r;
+    }
+    FragId = uvec4(uint(object_id), province, 0u, 0u);
+}
@@ -0,0 +1,14 @@
+// Writes the id of the pane into every channel for picking, use the color mask to pick the channel
+// [uniform] object_id id of the object
+#version 330 core
+
+out uvec4 FragId;
+
+uniform int object_id;
+
+in vec2 TexCoord;
+
+void main()
+{
+    FragId = uvec4(uint(object_id));
+}
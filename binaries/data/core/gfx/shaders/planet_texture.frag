@@ -29,10 +29,11 @@ uniform bool is_roughness;
 uniform sampler2D terrain_tex;
 uniform sampler2D normal_tex;
 uniform sampler2D roughness_map;
-uniform sampler2D country_tex;
+uniform usampler2D country_tex;
 
 uniform bool country;
-uniform vec4 country_color;
+// Province id to highlight in country_tex
+uniform int country_id;
 
 const float PI = 3.14159265359;
 vec3 getNormalFromMap() {
@@ -159,16 +160,10 @@ void main() {
 
     FragColor = vec4(color, 1.0);
     if (country) {
-        // Then check if the color is the country color
-
-        vec4 color1 = texture(country_tex, TexCoords);
-        if(color1.r == country_color.r){
-        if(color1.b == country_color.b){
-        if(color1.g == country_color.g){
+        // Then check if the province is the selected province
+        if (texture(country_tex, TexCoords).r == uint(country_id)) {
             FragColor = mix(vec4(1.0, 0, 0.0, 1.0), FragColor, 0.65);
             return;
         }
-        }
-        }
     }
 }
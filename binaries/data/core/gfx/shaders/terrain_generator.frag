@@ -0,0 +1,96 @@
+#version 330 core
+// Generates the same terrain as TerrainImageGenerator does on the CPU with libnoise.
+// Perlin noise with fast quality, sampled over a sphere with NoiseMapBuilderSphere, and colored
+// with the gradient of a RendererImage.
+out vec4 FragColor;
+
+// libnoise's table of random gradient vectors, 256 texels of xyz
+uniform sampler2D gradient_table;
+
+uniform int seed;
+uniform int octaves;
+uniform float frequency;
+uniform float lacunarity;
+uniform float persistence;
+
+// Size of the destination image
+uniform vec2 size;
+
+// Gradient to color the noise with, sorted by position
+const int MAX_GRADIENT_POINTS = 16;
+uniform int gradient_count;
+uniform float gradient_positions[MAX_GRADIENT_POINTS];
+uniform vec4 gradient_colors[MAX_GRADIENT_POINTS];
+
+const float PI = 3.14159265359;
+
+float GradientNoise3D(vec3 f, ivec3 i, int noise_seed) {
+    // Same hash as libnoise, the multiplication wraps around as unsigned integers
+    uint hash = 1619u * uint(i.x) + 31337u * uint(i.y) + 6971u * uint(i.z) + 1013u * uint(noise_seed);
+    int index = int(hash);
+    index ^= (index >> 8);
+    index &= 0xff;
+    vec3 gradient = texelFetch(gradient_table, ivec2(index, 0), 0).xyz;
+    return dot(gradient, f - vec3(i)) * 2.12;
+}
+
+float GradientCoherentNoise3D(vec3 p, int noise_seed) {
+    ivec3 i0 = ivec3(floor(p));
+    ivec3 i1 = i0 + 1;
+    // Fast quality is just linear interpolation
+    vec3 s = p - vec3(i0);
+
+    float ix0 = mix(GradientNoise3D(p, ivec3(i0.x, i0.y, i0.z), noise_seed),
+                    GradientNoise3D(p, ivec3(i1.x, i0.y, i0.z), noise_seed), s.x);
+    float ix1 = mix(GradientNoise3D(p, ivec3(i0.x, i1.y, i0.z), noise_seed),
+                    GradientNoise3D(p, ivec3(i1.x, i1.y, i0.z), noise_seed), s.x);
+    float iy0 = mix(ix0, ix1, s.y);
+    ix0 = mix(GradientNoise3D(p, ivec3(i0.x, i0.y, i1.z), noise_seed),
+              GradientNoise3D(p, ivec3(i1.x, i0.y, i1.z), noise_seed), s.x);
+    ix1 = mix(GradientNoise3D(p, ivec3(i0.x, i1.y, i1.z), noise_seed),
+              GradientNoise3D(p, ivec3(i1.x, i1.y, i1.z), noise_seed), s.x);
+    float iy1 = mix(ix0, ix1, s.y);
+    return mix(iy0, iy1, s.z);
+}
+
+float Perlin(vec3 p) {
+    float value = 0.0;
+    float current_persistence = 1.0;
+    p *= frequency;
+    for (int octave = 0; octave < octaves; octave++) {
+        value += GradientCoherentNoise3D(p, seed + octave) * current_persistence;
+        p *= lacunarity;
+        current_persistence *= persistence;
+    }
+    return value;
+}
+
+vec4 GradientColor(float value) {
+    int index = 0;
+    for (; index < gradient_count; index++) {
+        if (value < gradient_positions[index]) {
+            break;
+        }
+    }
+    int index0 = clamp(index - 1, 0, gradient_count - 1);
+    int index1 = clamp(index, 0, gradient_count - 1);
+    if (index0 == index1) {
+        return gradient_colors[index1];
+    }
+    float alpha = (value - gradient_positions[index0]) / (gradient_positions[index1] - gradient_positions[index0]);
+    return mix(gradient_colors[index0], gradient_colors[index1], alpha);
+}
+
+void main()
+{
+    // Same bounds as the noise map builder, latitude -90 to 90, longitude -180 to 180
+    vec2 pixel = floor(gl_FragCoord.xy);
+    float lon = radians(-180.0 + pixel.x * 360.0 / size.x);
+    float lat = radians(-90.0 + pixel.y * 180.0 / size.y);
+    float r = cos(lat);
+    vec3 position = vec3(r * cos(lon), sin(lat), r * sin(lon));
+
+    vec4 color = GradientColor(Perlin(position));
+    // The renderer blends the gradient color with a white background
+    FragColor = vec4(mix(vec3(1.0), color.rgb, color.a), 1.0);
+}
@@ -1,4 +1,5 @@
 local starting_event = {
+    id = "core:starting-event",
     chain = 0
 }
 
@@ -20,9 +21,12 @@ function starting_event:on_tick()
                 tooltip = "Starts the \"Conquer The Stars\" event chain",
                 action = function()
                     self.chain = 1
+                    events:wake(self, 101)
                 end
             }}
         })
+        -- Wait for the player to choose
+        return false
     end
     if self.chain == 1 and date > 100 then
         core.push_event(core.get_player(), {
@@ -39,6 +43,8 @@ function starting_event:on_tick()
             }}
         })
     end
+    -- Nothing else happens until an action wakes the event
+    return false
 end
 
 -- Disable the starting event for now because it was for testing
@@ -16,6 +16,8 @@
 */
 #pragma once
 
+#include <string>
+
 namespace cqsp::client::ctx {
 struct StarSystemViewDebug {
     bool to_show = false;
@@ -29,4 +31,11 @@ struct PauseOptions {
 struct SelectedCountry {};
 
 struct SelectedProvince {};
+
+/// <summary>
+/// Set before entering the loading scene to load this save instead of generating a new universe
+/// </summary>
+struct LoadSave {
+    std::string path;
+};
 }  // namespace cqsp::client::ctx
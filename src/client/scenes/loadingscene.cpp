@@ -20,7 +20,9 @@
 
 #include <chrono>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -38,7 +40,8 @@
 
 #define LOADING_ID "../data/core/gui/screens/loading_screen.rml"
 
-cqsp::scene::LoadingScene::LoadingScene(cqsp::engine::Application& app) : cqsp::engine::Scene(app) {
+cqsp::scene::LoadingScene::LoadingScene(cqsp::engine::Application& app)
+    : cqsp::engine::Scene(app), assetLoader(std::make_unique<cqsp::asset::AssetLoader>()) {
     m_done_loading = false;
     percentage = 0;
 }
@@ -72,22 +75,32 @@ void cqsp::scene::LoadingScene::Init() {
 }
 
 void cqsp::scene::LoadingScene::Update(float deltaTime) {
-    while (assetLoader.QueueHasItems()) {
-        assetLoader.BuildNextAsset();
-    }
-    if (m_done_loading && !assetLoader.QueueHasItems() && !need_halt) {
+    // Only build for part of the frame so that the loading screen keeps animating
+    assetLoader->BuildAssets(upload_budget);
+    if (m_done_loading && !assetLoader->QueueHasItems() && !need_halt) {
         // Load font after all the shaders are done
         LoadFont();
 
-        // Load audio
+        GetAssetManager().SetLoader(std::move(assetLoader));
+
+        // Load audio, the sounds are lazy so they are decoded in the background and can be played once they are
         auto hjson = GetAssetManager().GetAsset<cqsp::asset::HjsonAsset>("core:ui_sounds");
         for (auto element : hjson->data) {
-            auto audio_asset = GetAssetManager().GetAsset<cqsp::asset::AudioAsset>(element.second.to_string());
-            if (audio_asset == nullptr) {
-                SPDLOG_WARN("Cannot find audio asset {}", element.second.to_string());
-                continue;
-            }
-            GetApp().GetAudioInterface().AddAudioClip(element.first, audio_asset);
+            std::string name = element.first;
+            std::string key = element.second.to_string();
+            cqsp::engine::Application& app = GetApp();
+            GetAssetManager().RequestAsset(key, [&app, name, key](cqsp::asset::Asset* asset) {
+                auto audio_asset = dynamic_cast<cqsp::asset::AudioAsset*>(asset);
+                if (audio_asset == nullptr) {
+                    SPDLOG_WARN("Cannot find audio asset {}", key);
+                    return;
+                }
+                app.GetAudioInterface().AddAudioClip(name, audio_asset);
+            });
+        }
+        if (GetApp().HasCmdLineArgs("-hr")) {
+            // Reload assets when they are edited
+            GetAssetManager().EnableHotReload();
         }
 
         // Remove data model
@@ -114,8 +127,8 @@ void cqsp::scene::LoadingScene::Ui(float deltaTime) {
     if (m_done_loading) {
         return;
     }
-    float current = static_cast<float>(assetLoader.getCurrentLoading());
-    float max = static_cast<float>(assetLoader.getMaxLoading());
+    float current = static_cast<float>(assetLoader->getCurrentLoading());
+    float max = static_cast<float>(assetLoader->getMaxLoading());
     loading_data.max = static_cast<int>(max);
     loading_data.current = static_cast<int>(current);
     model_handle.DirtyVariable("max");
@@ -131,11 +144,11 @@ void cqsp::scene::LoadingScene::LoadResources() {
     ZoneScoped;
     // Loading goes here
     // Read core mod
-    assetLoader.manager = &GetAssetManager();
-    assetLoader.LoadMods();
+    assetLoader->manager = &GetAssetManager();
+    assetLoader->LoadMods();
 
     SPDLOG_INFO("Done loading items");
-    need_halt = !assetLoader.GetMissingAssets().empty();
+    need_halt = !assetLoader->GetMissingAssets().empty();
     m_done_loading = true;
 }
 
@@ -48,13 +48,17 @@ class LoadingScene : public cqsp::engine::Scene {
 
     std::atomic<float> percentage;
 
-    cqsp::asset::AssetLoader assetLoader;
+    // Handed to the asset manager once loading is done, so that it can load lazy assets
+    std::unique_ptr<cqsp::asset::AssetLoader> assetLoader;
 
     Rml::ElementDocument* document;
 
     void LoadFont();
     bool need_halt = false;
 
+    // Milliseconds every frame that can be spent building assets on the main thread
+    const double upload_budget = 8.0;
+
     struct LoadingDataModel {
         int current = 0;
         int max = 0;
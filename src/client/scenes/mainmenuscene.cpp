@@ -27,8 +27,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "client/components/clientctx.h"
 #include "client/scenes/universeloadingscene.h"
 #include "client/systems/sysoptionswindow.h"
+#include "common/systems/save/savegame.h"
 #include "common/util/paths.h"
 #include "common/version.h"
 #include "engine/asset/asset.h"
@@ -57,6 +59,7 @@ void cqsp::scene::MainMenuScene::Init() {
     main_menu = GetApp().LoadDocument("../data/core/gui/mainmenu.rml");
     main_menu->Show();
     main_menu->AddEventListener(Rml::EventId::Click, &listener);
+    ShowLoadSave();
 
     settings_window.LoadDocument();
 
@@ -71,6 +74,7 @@ void cqsp::scene::MainMenuScene::Update(float deltaTime) {
         Rml::Factory::ClearStyleSheetCache();
         main_menu = GetApp().ReloadDocument("../data/core/gui/mainmenu.rml");
         main_menu->AddEventListener(Rml::EventId::Click, &listener);
+        ShowLoadSave();
         settings_window.ReloadDocument();
     }
 
@@ -214,6 +218,12 @@ void cqsp::scene::MainMenuScene::SetMainMenuImage(const std::string& file) {
         ->SetProperty("decorator", fmt::format("image({} none cover center bottom)", file));
 }
 
+void cqsp::scene::MainMenuScene::ShowLoadSave() {
+    if (!cqsp::common::systems::save::GetLatestSavePath().empty()) {
+        main_menu->GetElementById("save_game")->SetClassNames("button active_button");
+    }
+}
+
 void cqsp::scene::MainMenuScene::NextImage() {
     SetMainMenuImage(file_list[index]);
     index++;
@@ -228,6 +238,11 @@ void cqsp::scene::MainMenuScene::EventListener::ProcessEvent(Rml::Event& event)
         // Confirm window, then new game
         m_scene->GetApp().SetScene<cqsp::scene::UniverseLoadingScene>();
     } else if (id_pressed == "save_game") {
+        std::string path = cqsp::common::systems::save::GetLatestSavePath();
+        if (!path.empty()) {
+            m_scene->GetUniverse().ctx().emplace<cqsp::client::ctx::LoadSave>(path);
+            m_scene->GetApp().SetScene<cqsp::scene::UniverseLoadingScene>();
+        }
     } else if (id_pressed == "options") {
         m_scene->settings_window.Show();
         m_scene->is_options_visible = true;
@@ -66,6 +66,11 @@ class MainMenuScene : public cqsp::engine::Scene {
     void SetMainMenuImage(const std::string& file);
     void NextImage();
 
+    /// <summary>
+    /// Makes the load save button active if there is a save to load
+    /// </summary>
+    void ShowLoadSave();
+
     double last_switch = 0;
     // Change every minute
     const float switch_time = 60;
@@ -20,8 +20,10 @@
 
 #include <string>
 
+#include "client/components/clientctx.h"
 #include "client/scenes/universescene.h"
 #include "client/systems/assetloading.h"
+#include "common/systems/save/savegame.h"
 #include "common/systems/sysuniversegenerator.h"
 
 cqsp::scene::UniverseLoadingScene::UniverseLoadingScene(cqsp::engine::Application& app) : Scene(app) {}
@@ -61,6 +63,22 @@ void cqsp::scene::UniverseLoadingScene::LoadUniverse() {
     TextAsset* script_list = GetAssetManager().GetAsset<TextAsset>("core:base");
     GetApp().GetScriptInterface().RunScript(script_list->data);
     SPDLOG_INFO("Done loading scripts");
+    auto* load_save = GetUniverse().ctx().find<client::ctx::LoadSave>();
+    if (load_save != nullptr) {
+        // Replaces the generated goods and everything else with the save
+        std::string path = load_save->path;
+        GetUniverse().ctx().erase<client::ctx::LoadSave>();
+        // Load into a separate universe, so that a save that fails partway doesn't leave half of it behind in
+        // the universe that is generated instead
+        common::Universe loaded;
+        if (common::systems::save::LoadUniverse(loaded, path)) {
+            common::systems::save::MoveUniverse(loaded, GetUniverse());
+            SPDLOG_INFO("Done loading the save, entering game");
+            m_completed_loading = true;
+            return;
+        }
+        SPDLOG_WARN("Cannot load {}, generating a new universe instead", path);
+    }
     using cqsp::common::systems::universegenerator::ScriptUniverseGenerator;
     // Load universe
     ScriptUniverseGenerator script_generator(GetApp().GetScriptInterface());
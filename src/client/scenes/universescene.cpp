@@ -49,6 +49,8 @@
 #include "common/components/population.h"
 #include "common/components/resource.h"
 #include "common/components/surface.h"
+#include "common/systems/commands/replay.h"
+#include "common/systems/save/savegame.h"
 #include "engine/graphics/primitives/cube.h"
 #include "engine/graphics/primitives/polygon.h"
 #include "engine/graphics/primitives/uvsphere.h"
@@ -69,6 +71,8 @@ void cqsp::scene::UniverseScene::Init() {
 
     using cqspco::systems::simulation::Simulation;
     simulation = std::make_unique<Simulation>(GetApp().GetGame());
+    autosaver = std::make_unique<cqspco::systems::save::AutoSaver>(GetUniverse(),
+                                                                   cqspco::systems::save::GetAutosavePath());
 
     system_renderer = new cqsps::SysStarSystemRenderer(GetUniverse(), GetApp());
     system_renderer->Initialize();
@@ -96,6 +100,12 @@ void cqsp::scene::UniverseScene::Init() {
     simulation->tick();
 
     AddRmlUiSystem<cqsps::rmlui::TurnSaveWindow>();
+
+    if (GetApp().HasCmdLineArgs("--record")) {
+        // Saves the universe and logs the commands after it, so that the game can be replayed
+        namespace commands = cqspco::systems::commands;
+        commands::StartRecording(GetUniverse(), commands::GetRecordingPath());
+    }
 }
 
 void cqsp::scene::UniverseScene::Update(float deltaTime) {
@@ -106,6 +116,10 @@ void cqsp::scene::UniverseScene::Update(float deltaTime) {
         if (GetApp().ButtonIsReleased(engine::KeyInput::KEY_SPACE)) {
             ToggleTick();
         }
+        if (GetApp().ButtonIsReleased(engine::KeyInput::KEY_F5)) {
+            namespace save = cqsp::common::systems::save;
+            save::SaveUniverse(GetUniverse(), save::GetQuicksavePath());
+        }
     }
 
     if (pause_opt.to_tick &&
@@ -119,6 +133,12 @@ void cqsp::scene::UniverseScene::Update(float deltaTime) {
         // Game tick
         simulation->tick();
         system_renderer->OnTick();
+        if (GetUniverse().date.GetDate() % autosave_interval == 0) {
+            autosaver->Save();
+        }
+        if (GetUniverse().date.GetDate() % checksum_interval == 0) {
+            common::systems::commands::RecordChecksum(GetUniverse());
+        }
     }
 
     if (!game_halted) {
@@ -133,7 +153,7 @@ void cqsp::scene::UniverseScene::Update(float deltaTime) {
 
     if (view_mode) {
         GetUniverse().clear<cqsp::client::systems::MouseOverEntity>();
-        system_renderer->GetMouseOnObject(GetApp().GetMouseX(), GetApp().GetMouseY());
+        system_renderer->GetMouseOnObject();
     }
 
     for (auto& ui : documents) {
@@ -26,6 +26,8 @@
 #include "common/components/bodies.h"
 #include "common/components/organizations.h"
 #include "common/simulation.h"
+#include "common/systems/commands/replay.h"
+#include "common/systems/save/autosave.h"
 #include "engine/application.h"
 #include "engine/graphics/renderable.h"
 #include "engine/renderer/renderer.h"
@@ -39,6 +41,8 @@ class UniverseScene : public cqsp::engine::Scene {
     explicit UniverseScene(cqsp::engine::Application& app);
     ~UniverseScene() {
         // Delete ui
+        common::systems::commands::StopRecording(GetUniverse(), common::systems::commands::GetRecordingPath());
+        autosaver.reset();
         simulation.reset();
         for (auto it = user_interfaces.begin(); it != user_interfaces.end(); it++) {
             it->reset();
@@ -103,6 +107,16 @@ class UniverseScene : public cqsp::engine::Scene {
     double last_tick = 0;
 
     std::array<int, 7> tick_speeds {1000, 500, 333, 100, 50, 10, 1};
+
+    std::unique_ptr<cqsp::common::systems::save::AutoSaver> autosaver;
+    /// <summary>
+    /// Ticks between autosaves
+    /// </summary>
+    const int autosave_interval = cqsp::common::components::StarDate::WEEK;
+    /// <summary>
+    /// Ticks between the checksums of a recording
+    /// </summary>
+    const int checksum_interval = cqsp::common::components::StarDate::DAY;
     void ToggleTick();
 };
 
@@ -70,6 +70,19 @@ void LoadResource(cqsp::engine::Application& app, std::string asset_name) {
             SPDLOG_INFO("Failed to load hjson asset {}: {}", asset_name, error.what());
         } catch (Hjson::index_out_of_bounds&) {
         }
+        if (!ptr->CanReload()) {
+            continue;
+        }
+        // Load the values into the same entities when the files are changed
+        app.GetAssetManager().AddReloadCallback(it->first + ":" + asset_name, [&app](cqsp::asset::Asset* asset) {
+            T loader(app.GetUniverse());
+            try {
+                loader.ReloadHjson(dynamic_cast<cqsp::asset::HjsonAsset*>(asset)->data);
+            } catch (std::runtime_error& error) {
+                SPDLOG_INFO("Failed to reload hjson asset: {}", error.what());
+            } catch (Hjson::index_out_of_bounds&) {
+            }
+        });
     }
 }
 }  // namespace
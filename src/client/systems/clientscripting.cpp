@@ -20,12 +20,37 @@
 
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "common/scripting/functionreg.h"
 
 namespace cqsp::client::scripting {
 namespace {
+/// <summary>
+/// Keeps compiled scripts in the asset cache
+/// </summary>
+class AssetBytecodeCache : public cqsp::scripting::IBytecodeCache {
+ public:
+    explicit AssetBytecodeCache(asset::AssetCache& cache) : cache(cache) {}
+
+    bool Load(const std::string& name, std::string_view source, std::string& bytecode) override {
+        return cache.LoadBytecode(name, source, version, bytecode);
+    }
+
+    void Save(const std::string& name, std::string_view source, const std::string& bytecode) override {
+        cache.SaveBytecode(name, source, version, bytecode);
+    }
+
+ private:
+    asset::AssetCache& cache;
+#ifdef LUAJIT_VERSION
+    static constexpr const char* version = LUAJIT_VERSION;
+#else
+    static constexpr const char* version = LUA_RELEASE;
+#endif
+};
+
 sol::object JsonToLuaObject(const Hjson::Value& j, const sol::this_state& s) {
     sol::state_view lua(s);
     switch (j.type()) {
@@ -63,19 +88,35 @@ void AssetManagerInterfaces(engine::Application& app) {
 
     CREATE_NAMESPACE(client);
 
-    script_engine.set_function("require", [&](const char* script) {
+    // Scripts are compiled once, and kept in the asset cache for the next time the game starts
+    static AssetBytecodeCache bytecode_cache(app.GetAssetManager().GetCache());
+    script_engine.SetBytecodeCache(&bytecode_cache);
+
+    // Scripts are required a lot, so don't look up the key every time
+    cqsp::asset::AssetId scripts_id = app.GetAssetManager().Intern("core:scripts");
+    script_engine.set_function("require", [&, scripts_id](const char* script) {
         using cqsp::asset::TextDirectoryAsset;
         // Get script from asset loader
-        cqsp::asset::TextDirectoryAsset* asset = app.GetAssetManager().GetAsset<TextDirectoryAsset>("core:scripts");
+        cqsp::asset::TextDirectoryAsset* asset = app.GetAssetManager().GetAsset<TextDirectoryAsset>(scripts_id);
         // Get the thing
         if (asset->paths.find(script) != asset->paths.end()) {
-            return script_engine.require_script(script, asset->paths[script].data);
+            return script_engine.RequireScript(script, asset->paths[script].data);
         } else {
             SPDLOG_INFO("Cannot find require {}", script);
             return sol::make_object(script_engine, sol::nil);
         }
     });
 
+    // Changed modules are required again from the new source, scripts that already ran keep what they made
+    app.GetAssetManager().AddReloadCallback("core:scripts", [&](cqsp::asset::Asset* asset) {
+        auto* scripts = dynamic_cast<cqsp::asset::TextDirectoryAsset*>(asset);
+        for (auto& [name, script] : scripts->paths) {
+            if (script_engine.UnloadChangedScript(name, script.data)) {
+                SPDLOG_INFO("Script {} changed, it will be run again the next time that it is required", name);
+            }
+        }
+    });
+
     REGISTER_FUNCTION("get_text_asset", [&](const char* id) {
         cqsp::asset::TextAsset* asset = app.GetAssetManager().GetAsset<cqsp::asset::TextAsset>(id);
         return sol::make_object<std::string>(script_engine, asset->data);
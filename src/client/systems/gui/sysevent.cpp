@@ -20,6 +20,7 @@
 #include <string>
 
 #include "common/components/player.h"
+#include "common/systems/commands/commands.h"
 #include "engine/cqspgui.h"
 
 void cqsp::client::systems::gui::SysEvent::Init() {
@@ -50,7 +51,11 @@ void cqsp::client::systems::gui::SysEvent::DoUI(int delta_time) {
                      ImGuiWindowFlags_NoCollapse | window_flags | ImGuiWindowFlags_NoScrollbar |
                          ImGuiWindowFlags_AlwaysAutoResize);
 
-        asset::Texture* texture = GetAssetManager().GetAsset<asset::Texture>(env->image);
+        // Event images are lazy, so show the placeholder until it's loaded rather than stalling the frame
+        if (event_image.GetKey() != env->image) {
+            event_image = GetAssetManager().GetHandle<asset::Texture>(env->image);
+        }
+        asset::Texture* texture = event_image.Get();
         float multiplier = 450.f / texture->width;
         ImGui::Image(reinterpret_cast<void*>(texture->id),
                      ImVec2(texture->width * multiplier, texture->height * multiplier));
@@ -60,29 +65,27 @@ void cqsp::client::systems::gui::SysEvent::DoUI(int delta_time) {
         ImGui::EndChild();
         if (env->actions.empty()) {
             if (CQSPGui::DefaultButton("Ok", ImVec2(-FLT_MIN, 0))) {
-                queue.events.clear();
+                namespace commands = common::systems::commands;
+                commands::Issue(GetApp().GetGame(), commands::ChooseEventAction {ent});
             }
         } else {
             int pressed = -1;
             int i = 0;
             for (auto& action_result : env->actions) {
-                i++;
                 if (CQSPGui::DefaultButton(action_result->name.c_str(), ImVec2(-FLT_MIN, 0))) {
                     pressed = i;
-                    // Check if it has an event
-                    if (action_result->has_event) {
-                        sol::protected_function_result res = action_result->action(env->table);
-                        GetApp().GetScriptInterface().ParseResult(res);
-                    }
                 }
                 if (ImGui::IsItemHovered() && !action_result->tooltip.empty()) {
                     ImGui::BeginTooltip();
                     ImGui::Text(action_result->tooltip.c_str());
                     ImGui::EndTooltip();
                 }
+                i++;
             }
             if (pressed >= 0) {
-                queue.events.clear();
+                // Runs the action and clears the queue
+                common::systems::commands::Issue(GetApp().GetGame(),
+                                                 common::systems::commands::ChooseEventAction {ent, pressed});
             }
         }
         ImGui::End();
@@ -18,6 +18,7 @@
 
 #include "client/systems/sysgui.h"
 #include "common/components/event.h"
+#include "engine/asset/assetmanager.h"
 
 namespace cqsp {
 namespace client {
@@ -32,6 +33,9 @@ class SysEvent : public SysUserInterface {
     void DoUpdate(int delta_time);
     void FireEvent();
     bool to_show;
+
+ private:
+    asset::AssetHandle<asset::Texture> event_image;
 };
 }  // namespace gui
 }  // namespace systems
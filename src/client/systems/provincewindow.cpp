@@ -30,7 +30,7 @@
 #include "common/components/population.h"
 #include "common/components/ships.h"
 #include "common/components/surface.h"
-#include "common/systems/actions/shiplaunchaction.h"
+#include "common/systems/commands/commands.h"
 #include "common/util/utilnumberdisplay.h"
 #include "engine/cqspgui.h"
 
@@ -272,7 +272,7 @@ void SysProvinceInformation::SpacePortTab() {
         orb.eccentricity = eccentricity;
         orb.w = arg_of_perapsis;
         orb.LAN = LAN;
-        cqsp::common::systems::actions::LaunchShip(GetUniverse(), orb);
+        common::systems::commands::Issue(GetApp().GetGame(), common::systems::commands::LaunchShip {orb});
     }
 }
 
@@ -16,79 +16,193 @@
 */
 #include "client/systems/sysplanetterraingenerator.h"
 
+#include <glad/glad.h>
+#include <noise/vectortable.h>
 #include <spdlog/spdlog.h>
 
 #include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <tracy/Tracy.hpp>
 
 #include "common/components/bodies.h"
+#include "common/util/noisemapbuilder.h"
+#include "engine/graphics/primitives/pane.h"
 
 using cqsp::client::systems::TerrainImageGenerator;
+using cqsp::client::systems::TerrainShaderGenerator;
+
+namespace {
+// Same noise parameters on the CPU and the GPU
+constexpr double terrain_frequency = 2.;
+constexpr double terrain_lacunarity = 2.;
+constexpr double terrain_persistence = 0.5;
+}  // namespace
+
+std::shared_ptr<const noise::utils::NoiseMap> TerrainImageGenerator::BuildNoiseMap(int octaves, int size,
+                                                                                  unsigned int thread_count) {
+    auto generate = [&](noise::utils::NoiseMap& noise_map) {
+        noise::module::Perlin noise_module;
+        noise_module.SetOctaveCount(octaves);
+        noise_module.SetNoiseQuality(noise::QUALITY_FAST);
+        noise_module.SetSeed(terrain.seed);
+        noise_module.SetFrequency(terrain_frequency);
+        noise_module.SetLacunarity(terrain_lacunarity);
+        noise_module.SetPersistence(terrain_persistence);
+
+        int texture_size = std::pow(2, size);
+        common::util::BuildSphereNoiseMap(noise_module, noise_map, texture_size, texture_size, thread_count);
+    };
+    if (cache != nullptr) {
+        return cache->Get(terrain.seed, octaves, size, generate);
+    }
+    auto noise_map = std::make_shared<noise::utils::NoiseMap>();
+    generate(*noise_map);
+    return noise_map;
+}
 
-void TerrainImageGenerator::GenerateTerrain(cqsp::common::Universe& universe, int octaves, int size) {
+void TerrainImageGenerator::GenerateTerrain(cqsp::common::Universe& universe, int octaves, int size,
+                                            unsigned int thread_count) {
     ZoneScoped;
-    noise::module::Perlin noise_module;
-    noise_module.SetOctaveCount(octaves);
-    noise_module.SetNoiseQuality(noise::QUALITY_FAST);
-    noise_module.SetSeed(terrain.seed);
-    noise_module.SetFrequency(2);
+    auto noise_map = BuildNoiseMap(octaves, size, thread_count);
 
-    noise::utils::NoiseMap noise_map;
-    int textureWidth = std::pow(2, size);
-    int textureHeight = std::pow(2, size);
-    utils::NoiseMapBuilderSphere heightMapBuilder;
-    heightMapBuilder.SetSourceModule(noise_module);
-    heightMapBuilder.SetDestNoiseMap(noise_map);
-    heightMapBuilder.SetDestSize(textureWidth, textureHeight);
+    common::util::RenderNoiseImage(
+        *noise_map, height_map, [](noise::utils::RendererImage&) {}, thread_count);
 
-    heightMapBuilder.SetBounds(-90.0, 90.0, -180.0, 180.0);
+    auto& terrain_data = universe.get<cqsp::common::components::bodies::TerrainData>(terrain.terrain_type);
+    common::util::RenderNoiseImage(
+        *noise_map, albedo_map,
+        [&terrain_data](noise::utils::RendererImage& renderer) {
+            renderer.ClearGradient();
+            for (auto it = terrain_data.data.begin(); it != terrain_data.data.end(); it++) {
+                renderer.AddGradientPoint(
+                    it->first, noise::utils::Color(std::get<0>(it->second), std::get<1>(it->second),
+                                                   std::get<2>(it->second), std::get<3>(it->second)));
+            }
+        },
+        thread_count);
+}
 
-    heightMapBuilder.Build();
+void TerrainImageGenerator::GenerateHeightMap(int octaves, int size, unsigned int thread_count) {
+    ZoneScoped;
+    auto noise_map = BuildNoiseMap(octaves, size, thread_count);
 
-    noise::utils::RendererImage renderer;
-    renderer.SetSourceNoiseMap(noise_map);
-    renderer.SetDestImage(height_map);
-    renderer.Render();
+    common::util::RenderNoiseImage(
+        *noise_map, height_map, [](noise::utils::RendererImage&) {}, thread_count);
+}
 
-    renderer.SetDestImage(albedo_map);
+void TerrainImageGenerator::ClearData() {
+    height_map.ReclaimMem();
+    albedo_map.ReclaimMem();
+}
 
-    renderer.ClearGradient();
+TerrainShaderGenerator::TerrainShaderGenerator(asset::ShaderProgram_t _shader) : shader(std::move(_shader)) {
+    pane = engine::primitive::MakeTexturedPaneMesh(true);
 
-    auto& terrain_data = universe.get<cqsp::common::components::bodies::TerrainData>(terrain.terrain_type);
-    for (auto it = terrain_data.data.begin(); it != terrain_data.data.end(); it++) {
-        renderer.AddGradientPoint(it->first, noise::utils::Color(std::get<0>(it->second), std::get<1>(it->second),
-                                                                 std::get<2>(it->second), std::get<3>(it->second)));
+    // Upload libnoise's gradient vectors so that the shader hashes to the same gradients
+    std::vector<float> table(256 * 4);
+    for (size_t i = 0; i < table.size(); i++) {
+        table[i] = static_cast<float>(noise::g_randomVectors[i]);
     }
-    renderer.Render();
+    glGenTextures(1, &gradient_table);
+    glBindTexture(GL_TEXTURE_2D, gradient_table);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 256, 1, 0, GL_RGBA, GL_FLOAT, table.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void TerrainImageGenerator::GenerateHeightMap(int octaves, int size) {
-    noise::module::Perlin noise_module;
-    noise_module.SetOctaveCount(octaves);
-    noise_module.SetNoiseQuality(noise::QUALITY_FAST);
-    noise_module.SetSeed(terrain.seed);
-    noise_module.SetFrequency(2);
-
-    noise::utils::NoiseMap noise_map;
-    int textureWidth = std::pow(2, size);
-    int textureHeight = std::pow(2, size);
-    utils::NoiseMapBuilderSphere heightMapBuilder;
-    heightMapBuilder.SetSourceModule(noise_module);
-    heightMapBuilder.SetDestNoiseMap(noise_map);
-    heightMapBuilder.SetDestSize(textureWidth, textureHeight);
-
-    heightMapBuilder.SetBounds(-90.0, 90.0, -180.0, 180.0);
-
-    heightMapBuilder.Build();
-
-    noise::utils::RendererImage renderer;
-    renderer.SetSourceNoiseMap(noise_map);
-    renderer.SetDestImage(height_map);
-    renderer.Render();
+TerrainShaderGenerator::~TerrainShaderGenerator() {
+    delete pane;
+    glDeleteTextures(1, &gradient_table);
 }
 
-void TerrainImageGenerator::ClearData() {
-    height_map.ReclaimMem();
-    albedo_map.ReclaimMem();
+void TerrainShaderGenerator::GenerateTerrain(cqsp::common::Universe& universe, asset::Texture& texture,
+                                             int octaves, int size) {
+    auto& terrain_data = universe.get<cqsp::common::components::bodies::TerrainData>(terrain.terrain_type);
+    Generate(texture, octaves, size, terrain_data.data);
+}
+
+void TerrainShaderGenerator::GenerateHeightMap(asset::Texture& texture, int octaves, int size) {
+    // Same as the default grayscale gradient of the renderer
+    Gradient gradient;
+    gradient[-1.f] = std::make_tuple(0, 0, 0, 255);
+    gradient[1.f] = std::make_tuple(255, 255, 255, 255);
+    Generate(texture, octaves, size, gradient);
+}
+
+void TerrainShaderGenerator::Generate(asset::Texture& texture, int octaves, int size, const Gradient& gradient) {
+    ZoneScoped;
+    int texture_size = std::pow(2, size);
+
+    if (texture.texture_type == -1) {
+        glGenTextures(1, &texture.id);
+    }
+    texture.width = texture_size;
+    texture.height = texture_size;
+    texture.texture_type = GL_TEXTURE_2D;
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture_size, texture_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    unsigned int framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        SPDLOG_ERROR("Terrain framebuffer is not complete");
+    }
+
+    int viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glViewport(0, 0, texture_size, texture_size);
+    GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    shader->UseProgram();
+    shader->setInt("seed", terrain.seed);
+    shader->setInt("octaves", octaves);
+    shader->setFloat("frequency", static_cast<float>(terrain_frequency));
+    shader->setFloat("lacunarity", static_cast<float>(terrain_lacunarity));
+    shader->setFloat("persistence", static_cast<float>(terrain_persistence));
+    shader->setVec2("size", static_cast<float>(texture_size), static_cast<float>(texture_size));
+
+    if (static_cast<int>(gradient.size()) > max_gradient_points) {
+        SPDLOG_WARN("Terrain gradient has {} points, only the first {} are used", gradient.size(),
+                    max_gradient_points);
+    }
+    int index = 0;
+    for (auto it = gradient.begin(); it != gradient.end() && index < max_gradient_points; it++, index++) {
+        shader->setFloat(fmt::format("gradient_positions[{}]", index), it->first);
+        shader->setVec4(fmt::format("gradient_colors[{}]", index),
+                        glm::vec4(std::get<0>(it->second), std::get<1>(it->second), std::get<2>(it->second),
+                                  std::get<3>(it->second)) /
+                            255.f);
+    }
+    shader->setInt("gradient_count", index);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gradient_table);
+    pane->Draw();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (depth_test) {
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
@@ -20,16 +20,31 @@
 #include <noise/noise.h>
 #include <noiseutils.h>
 
+#include <map>
+#include <memory>
+#include <tuple>
+
 #include "common/components/bodies.h"
 #include "common/universe.h"
+#include "common/util/noisemapbuilder.h"
+#include "engine/graphics/mesh.h"
+#include "engine/graphics/shader.h"
+#include "engine/graphics/texture.h"
 
 namespace cqsp {
 namespace client {
 namespace systems {
+/// <summary>
+/// Generates planet terrain on the CPU with libnoise.
+/// <br />
+/// The noise map is split into tiles that are generated on separate threads. This is the fallback for
+/// @ref TerrainShaderGenerator when there is no OpenGL context, and can be used headless.
+/// </summary>
 class TerrainImageGenerator {
  public:
-    void GenerateTerrain(cqsp::common::Universe& universe, int octaves, int size);
-    void GenerateHeightMap(int octaves, int size);
+    /// <param name="thread_count">Number of threads to generate with, 0 uses all the hardware threads</param>
+    void GenerateTerrain(cqsp::common::Universe& universe, int octaves, int size, unsigned int thread_count = 0);
+    void GenerateHeightMap(int octaves, int size, unsigned int thread_count = 0);
     void ClearData();
 
     noise::utils::Image& GetHeightMap() { return height_map; }
@@ -37,10 +52,55 @@ class TerrainImageGenerator {
 
     cqsp::common::components::bodies::Terrain terrain;
 
+    /// <summary>
+    /// Cache to take the noise maps from, so that maps with the same seed are only generated once.
+    /// Can be null to always generate the noise.
+    /// </summary>
+    common::util::NoiseMapCache* cache = nullptr;
+
  private:
+    std::shared_ptr<const noise::utils::NoiseMap> BuildNoiseMap(int octaves, int size, unsigned int thread_count);
+
     noise::utils::Image height_map;
     noise::utils::Image albedo_map;
 };
+
+/// <summary>
+/// Generates planet terrain on the GPU directly into a texture.
+/// <br />
+/// Evaluates the same noise and gradient as @ref TerrainImageGenerator in the terrain_generator shader, so the
+/// output matches it up to float precision. Needs an active OpenGL context.
+/// </summary>
+class TerrainShaderGenerator {
+ public:
+    /// <param name="shader">The core:terrain_generator shader</param>
+    explicit TerrainShaderGenerator(asset::ShaderProgram_t shader);
+    ~TerrainShaderGenerator();
+
+    /// <summary>
+    /// Generates the colored terrain of the terrain type into the texture
+    /// </summary>
+    void GenerateTerrain(cqsp::common::Universe& universe, asset::Texture& texture, int octaves, int size);
+
+    /// <summary>
+    /// Generates a grayscale height map into the texture
+    /// </summary>
+    void GenerateHeightMap(asset::Texture& texture, int octaves, int size);
+
+    cqsp::common::components::bodies::Terrain terrain;
+
+    /// Maximum number of gradient points the shader supports
+    static constexpr int max_gradient_points = 16;
+
+ private:
+    typedef std::map<float, std::tuple<int, int, int, int>> Gradient;
+
+    void Generate(asset::Texture& texture, int octaves, int size, const Gradient& gradient);
+
+    asset::ShaderProgram_t shader;
+    engine::Mesh* pane = nullptr;
+    unsigned int gradient_table = 0;
+};
 }  // namespace systems
 }  // namespace client
 }  // namespace cqsp
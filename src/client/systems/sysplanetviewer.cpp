@@ -45,7 +45,7 @@
 #include "common/components/ships.h"
 #include "common/components/surface.h"
 #include "common/systems/actions/factoryconstructaction.h"
-#include "common/systems/actions/shiplaunchaction.h"
+#include "common/systems/commands/commands.h"
 #include "common/systems/economy/markethelpers.h"
 #include "common/util/utilnumberdisplay.h"
 #include "engine/cqspgui.h"
@@ -253,23 +253,21 @@ void SysPlanetInformation::PlanetInformationPanel() {
     ImGui::Separator();
 
     // Show resources
-    /*
     if (GetUniverse().all_of<cqspc::ResourceDistribution>(selected_planet)) {
         auto& dist = GetUniverse().get<cqspc::ResourceDistribution>(selected_planet);
         using cqsp::client::components::PlanetTerrainRender;
         // Show the resources on it
         ImGui::Text("Resources");
         if (ImGui::Button("Default")) {
-            GetUniverse().remove_if_exists<PlanetTerrainRender>(selected_planet);
+            GetUniverse().remove<PlanetTerrainRender>(selected_planet);
         }
-        for (auto it = dist.begin(); it != dist.end(); it++) {
+        for (auto it = dist.dist.begin(); it != dist.dist.end(); it++) {
             if (ImGui::Button(gui::GetName(GetUniverse(), it->first).c_str())) {
                 // Set rendering thing
-                GetUniverse().emplace_or_replace<PlanetTerrainRender>(
-                        selected_planet, it->first);
+                GetUniverse().emplace_or_replace<PlanetTerrainRender>(selected_planet, it->first);
             }
         }
-    }*/
+    }
     // List cities
     for (int i = 0; i < habit.settlements.size(); i++) {
         const bool is_selected = (selected_city_index == i);
@@ -471,7 +469,8 @@ void SysPlanetInformation::ConstructionTab() {
         if (!GetUniverse().any_of<cqspc::infrastructure::SpacePort>(selected_city_entity)) {
             if (ImGui::BeginTabItem("Space Port##Construction")) {
                 if (ImGui::Button("Construct Spaceport")) {
-                    GetUniverse().emplace<cqspc::infrastructure::SpacePort>(selected_city_entity);
+                    common::systems::commands::Issue(
+                        GetApp().GetGame(), common::systems::commands::ConstructSpacePort {selected_city_entity});
                 }
                 ImGui::EndTabItem();
             }
@@ -623,7 +622,7 @@ void SysPlanetInformation::SpacePortTab() {
         orb.eccentricity = eccentricity;
         orb.w = arg_of_perapsis;
         orb.LAN = LAN;
-        cqsp::common::systems::actions::LaunchShip(GetUniverse(), orb);
+        common::systems::commands::Issue(GetApp().GetGame(), common::systems::commands::LaunchShip {orb});
         //cqsp::common::systems::actions::CreateShip(
         //GetUniverse(), entt::null, selected_planet, star_system);
     }
@@ -739,8 +738,9 @@ void SysPlanetInformation::RecipeConstructionConstructButton(entt::entity select
     entt::entity player = GetUniverse().view<cqspc::Player>().front();
 
     entt::entity city_market = GetUniverse().get<cqspc::MarketCenter>(selected_planet).market;
-    entt::entity factory = common::systems::actions::OrderConstructionFactory(
-        GetUniverse(), selected_city_entity, city_market, selected_recipe, prod, player);
+    entt::entity factory = common::systems::commands::Issue(
+        GetApp().GetGame(),
+        common::systems::commands::ConstructFactory {selected_city_entity, city_market, selected_recipe, prod, player});
     if (factory == entt::null) {
         return;
     }
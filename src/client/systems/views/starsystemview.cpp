@@ -22,10 +22,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <filesystem>
 #include <limits>
 #include <memory>
 #include <string>
-#include <tuple>
 #include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -36,6 +36,7 @@
 #include "client/components/clientctx.h"
 #include "client/components/planetrendering.h"
 #include "client/systems/gui/systooltips.h"
+#include "client/systems/sysplanetterraingenerator.h"
 #include "common/components/area.h"
 #include "common/components/bodies.h"
 #include "common/components/coordinates.h"
@@ -46,12 +47,14 @@
 #include "common/components/ships.h"
 #include "common/components/surface.h"
 #include "common/components/units.h"
-#include "common/systems/actions/cityactions.h"
+#include "common/systems/commands/commands.h"
+#include "common/util/paths.h"
 #include "common/util/profiler.h"
 #include "engine/graphics/primitives/cube.h"
 #include "engine/graphics/primitives/line.h"
 #include "engine/graphics/primitives/pane.h"
 #include "engine/graphics/primitives/polygon.h"
+#include "engine/graphics/primitives/spherelod.h"
 #include "engine/graphics/primitives/uvsphere.h"
 #include "engine/renderer/renderer.h"
 
@@ -93,15 +96,22 @@ struct PlanetOrbit {
 
     ~PlanetOrbit() { delete orbit_mesh; }
 };
+
+// Ids in the pick buffer and the province id texture are offset by one, because 0 means nothing
+uint32_t ToPickId(entt::entity entity) { return entt::to_integral(entity) + 1; }
+
+entt::entity FromPickId(uint32_t id) { return id == 0 ? entt::null : static_cast<entt::entity>(id - 1); }
 }  // namespace
 
 void SysStarSystemRenderer::Initialize() {
     // Initialize meshes, etc
-    cqsp::engine::Mesh* sphere_mesh =
-        cqsp::engine::primitive::ConstructSphereMesh(sphere_resolution, sphere_resolution);
+    // All bodies share the same sphere meshes, and the level of detail is chosen when drawing them
+    sphere_lod.Initialize();
+    cqsp::engine::Mesh* sphere_mesh = sphere_lod.GetMesh(std::numeric_limits<float>::infinity());
 
-    // Initialize sky box
-    asset::Texture* sky_texture = m_app.GetAssetManager().GetAsset<cqsp::asset::Texture>("core:skycubemap");
+    // Initialize sky box, the cubemap is lazy so it is loaded in the background and drawn once it's ready
+    sky_cubemap = m_app.GetAssetManager().GetHandle<cqsp::asset::Texture>("core:skycubemap");
+    sky_cubemap.Get();
 
     sky.mesh = engine::primitive::MakeCube();
     sky.shaderProgram = m_app.GetAssetManager().GetAsset<asset::ShaderDefinition>("core:skybox")->MakeShader();
@@ -139,9 +149,24 @@ void SysStarSystemRenderer::Initialize() {
 
     orbit_shader = sun.shaderProgram;
 
+    // Picking
+    pick_sphere.mesh = sphere_mesh;
+    pick_sphere.shaderProgram =
+        m_app.GetAssetManager().GetAsset<asset::ShaderDefinition>("core:pickobject")->MakeShader();
+    pick_sphere.textures.push_back(&province_id_texture);
+    pick_pane_shader = m_app.GetAssetManager().GetAsset<asset::ShaderDefinition>("core:pickpane")->MakeShader();
+
     InitializeFramebuffers();
 
-    earth_map_texture = m_app.GetAssetManager().GetAsset<asset::Texture>("province_map_texture");
+    uint64_t texture_budget = m_app.GetClientOptions().GetOptions()["texture_budget"].to_int64();
+    texture_streamer.SetBudget(texture_budget * 1024 * 1024);
+
+    noise_cache = std::make_unique<common::util::NoiseMapCache>(
+        (std::filesystem::path(common::util::GetCqspSavePath()) / "cache" / "noise").string());
+    if (m_app.GetAssetManager().HasAsset("core:terrain_generator")) {
+        terrain_generator = std::make_unique<TerrainShaderGenerator>(
+            m_app.GetAssetManager().GetAsset<asset::ShaderDefinition>("core:terrain_generator")->MakeShader());
+    }
 
     LoadProvinceMap();
 }
@@ -188,17 +213,21 @@ void SysStarSystemRenderer::Render(float deltaTime) {
 
     CalculateCamera();
 
+    StreamPlanetTextures();
+
     // FIXME(EhWhoAmI): Fix log renderer so that objects that are close are rendered with a
     // "normal" depth buffer, and objects far away will be rendered with a log buffer.
     // FIXME(EhWhoAmI): Unify all the rendering of planets and stars into one single loop
     // FIXME(EhWhoAmI): Orbit lines dissapear based on distance away from the planet.
     // make them dissapear if you're focused on the planet.
-    DrawStars();
+    // All layers share one framebuffer, so they have to be drawn from back to front.
+    DrawSkybox();
     DrawBodies();
     DrawShips();
-    DrawSkybox();
 
     renderer.DrawAllLayers();
+
+    DrawPickBuffer();
 }
 
 void SysStarSystemRenderer::SeeStarSystem() {
@@ -246,7 +275,7 @@ void SysStarSystemRenderer::Update(float deltaTime) {
 
     is_founding_city = IsFoundingCity(m_universe);
 
-    CityDetection();
+    ReadPickBuffer();
 
     // Discern between clicking on UI and game
     if (!ImGui::GetIO().WantCaptureMouse && !m_app.GetRmlUiContext()->IsMouseInteracting()) {
@@ -276,18 +305,14 @@ void SysStarSystemRenderer::Update(float deltaTime) {
     using cqsp::client::components::PlanetTerrainRender;
     city_founding_position = GetMouseIntersectionOnObject(m_app.GetMouseX(), m_app.GetMouseY());
 
-    /*
     // Check if it has terrain resource rendering, and make terrain thing
     if (m_viewing_entity != entt::null && m_app.GetUniverse().all_of<PlanetTerrainRender>(m_viewing_entity)) {
         CheckResourceDistRender();
-    } else if (m_viewing_entity != entt::null) {
+    } else {
         // Reset to default
-        planet.textures.reserve(2);
-        planet.textures[0] = planet_texture;
         terrain_displaying = entt::null;
-        // Also change up the shader
-        planet.shaderProgram = pbr_shader;
-    }*/
+        overlay_body = entt::null;
+    }
     // Calculate camera
     CenterCameraOnCity();
 }
@@ -331,6 +356,9 @@ void SysStarSystemRenderer::DrawBodies() {
     glDepthFunc(GL_LESS);
     renderer.EndDraw(planet_icon_layer);
 
+    // Stars are in the physical layer as well, and also set the light position for the planets
+    DrawStars();
+
     renderer.BeginDraw(physical_layer);
     DrawAllPlanets(bodies);
     DrawAllOrbits();
@@ -368,7 +396,11 @@ void SysStarSystemRenderer::DrawSkybox() {
     sky.shaderProgram->setMat4("projection", projection);
     glDepthFunc(GL_LEQUAL);
     // skybox cube
-    engine::Draw(sky);
+    asset::Texture* sky_texture = sky_cubemap.Get();
+    if (sky_cubemap.IsReady()) {
+        sky.textures = {sky_texture};
+        engine::Draw(sky);
+    }
     glDepthFunc(GL_LESS);
     renderer.EndDraw(skybox_layer);
 }
@@ -412,21 +444,29 @@ void SysStarSystemRenderer::DrawPlanetBillboards(const entt::entity& ent_id, con
 }
 
 void SysStarSystemRenderer::DrawCityIcon(glm::vec3& object_pos) {
-    glm::vec3 pos = GetBillboardPosition(object_pos);
-    if (pos.z >= 1 || pos.z <= -1) {
+    glm::mat4 planetDispMat;
+    if (!GetCityIconMatrix(object_pos, planetDispMat)) {
         return;
     }
 
-    glm::mat4 planetDispMat = GetBillboardMatrix(pos);
-    // Scale it by the window ratio
-    planetDispMat = glm::scale(planetDispMat, glm::vec3(1, GetWindowRatio(), 1));
-
     SetBillboardProjection(city.shaderProgram, planetDispMat);
     city.shaderProgram->Set("color", 1, 0, 1, 1);
 
     engine::Draw(city);
 }
 
+bool SysStarSystemRenderer::GetCityIconMatrix(const glm::vec3& object_pos, glm::mat4& matrix) {
+    glm::vec3 pos = GetBillboardPosition(object_pos);
+    if (pos.z >= 1 || pos.z <= -1) {
+        return false;
+    }
+
+    matrix = GetBillboardMatrix(pos);
+    // Scale it by the window ratio
+    matrix = glm::scale(matrix, glm::vec3(1, GetWindowRatio(), 1));
+    return true;
+}
+
 void SysStarSystemRenderer::DrawAllCities(auto& bodies) {
     for (auto body_entity : bodies) {
         glm::vec3 object_pos = CalculateCenteredObject(body_entity);
@@ -471,6 +511,13 @@ void SysStarSystemRenderer::DrawTexturedPlanet(glm::vec3& object_pos, entt::enti
                                 // * view_scale;
     position = glm::scale(position, glm::vec3(scale));
 
+    float screen_radius = GetScreenRadius(object_pos, body.radius);
+    if (screen_radius < engine::primitive::SphereLod::billboard_radius) {
+        // The planet billboard already covers it
+        return;
+    }
+    textured_planet.mesh = sphere_lod.GetMesh(screen_radius);
+
     auto shader = textured_planet.shaderProgram.get();
     if (scale < 10.f) {
         // then use different shader if it's close enough
@@ -489,8 +536,8 @@ void SysStarSystemRenderer::DrawTexturedPlanet(glm::vec3& object_pos, entt::enti
     shader->setVec3("viewPos", cam_pos);
 
     // If a country is clicked on...
-    shader->setVec4("country_color", glm::vec4(selected_country_color, 1));
-    shader->setBool("country", countries);
+    shader->setInt("country_id", static_cast<int>(ToPickId(selected_province)));
+    shader->setBool("country", countries && m_universe.valid(selected_province));
     shader->setBool("is_roughness", have_roughness);
 
     engine::Draw(textured_planet, shader);
@@ -503,14 +550,19 @@ void SysStarSystemRenderer::GetPlanetTexture(entt::entity entity, bool& have_nor
     }
     auto& terrain_data = m_universe.get<PlanetTexture>(entity);
     textured_planet.textures.clear();
-    textured_planet.textures.push_back(terrain_data.terrain);
+    if (entity == overlay_body) {
+        // Draw the resource distribution instead of the terrain
+        textured_planet.textures.push_back(&resource_overlay);
+    } else {
+        textured_planet.textures.push_back(terrain_data.terrain);
+    }
     if (terrain_data.normal) {
         have_normal = true;
         textured_planet.textures.push_back(terrain_data.normal);
     } else {
         textured_planet.textures.push_back(terrain_data.terrain);
     }
-    textured_planet.textures.push_back(earth_map_texture);
+    textured_planet.textures.push_back(&province_id_texture);
     if (terrain_data.roughness) {
         have_roughness = true;
         textured_planet.textures.push_back(terrain_data.roughness);
@@ -602,6 +654,8 @@ void SysStarSystemRenderer::DrawStar(const entt::entity& entity, glm::vec3& obje
     transform = glm::scale(transform, glm::vec3(scale, scale, scale));
     position = position * transform;
 
+    // Stars don't have billboards, so they are always drawn
+    sun.mesh = sphere_lod.GetMesh(GetScreenRadius(object_pos, radius));
     sun.SetMVP(position, camera_matrix, projection);
     sun.shaderProgram->setVec4("color", 1, 1, 1, 1);
     engine::Draw(sun);
@@ -621,20 +675,24 @@ void SysStarSystemRenderer::DrawTerrainlessPlanet(const entt::entity& entity, gl
     glm::mat4 transform = glm::mat4(1.f);
     position = position * transform;
 
+    float screen_radius = GetScreenRadius(object_pos, scale);
+    if (screen_radius < engine::primitive::SphereLod::billboard_radius) {
+        return;
+    }
+    sun.mesh = sphere_lod.GetMesh(screen_radius);
     sun.SetMVP(position, camera_matrix, projection);
     sun.shaderProgram->setVec4("color", 1, 0, 1, 1);
     engine::Draw(sun);
 }
 
-void SysStarSystemRenderer::RenderCities(glm::vec3& object_pos, const entt::entity& body_entity) {
-    ZoneScoped;
-    // Draw Cities
+template <typename Func>
+void SysStarSystemRenderer::ForEachVisibleCity(const glm::vec3& object_pos, const entt::entity& body_entity,
+                                               Func func) {
     namespace cqspc = cqsp::common::components;
-    namespace cqspt = cqsp::common::components::types;
     if (!m_app.GetUniverse().all_of<cqspc::Habitation>(body_entity)) {
         return;
     }
-    std::vector<entt::entity> cities = m_app.GetUniverse().get<cqspc::Habitation>(body_entity).settlements;
+    const std::vector<entt::entity>& cities = m_app.GetUniverse().get<cqspc::Habitation>(body_entity).settlements;
     if (cities.empty()) {
         return;
     }
@@ -642,29 +700,35 @@ void SysStarSystemRenderer::RenderCities(glm::vec3& object_pos, const entt::enti
     auto& body = m_app.GetUniverse().get<cqspc::bodies::Body>(body_entity);
     auto quat = GetBodyRotation(body.axial, body.rotation, body.rotation_offset);
 
-    // Rotate the body
-    // Put in same layer as ships
-    city.shaderProgram->UseProgram();
-    city.shaderProgram->setVec4("color", 0.5, 0.5, 0.5, 1);
     for (auto city_entity : cities) {
         // Calculate position to render
         if (!m_app.GetUniverse().any_of<Offset>(city_entity)) {
             // Calculate offset
             continue;
         }
-        Offset doffset = m_app.GetUniverse().get<Offset>(city_entity);
         glm::vec3 city_pos = m_app.GetUniverse().get<Offset>(city_entity).offset * (float)body.radius;
         // Check if line of sight and city position intersects the sphere that is the planet
         city_pos = quat * city_pos;
         glm::vec3 city_world_pos = city_pos + object_pos;
         if (CityIsVisible(city_world_pos, object_pos, cam_pos, body.radius)) {
-            // If it's reasonably close, then we can show city names
-            //if (scroll < 3) {
-            DrawEntityName(city_world_pos, city_entity);
-            //}
-            DrawCityIcon(city_world_pos);
+            func(city_entity, city_world_pos);
         }
     }
+}
+
+void SysStarSystemRenderer::RenderCities(glm::vec3& object_pos, const entt::entity& body_entity) {
+    ZoneScoped;
+    // Draw Cities
+    // Put in same layer as ships
+    city.shaderProgram->UseProgram();
+    city.shaderProgram->setVec4("color", 0.5, 0.5, 0.5, 1);
+    ForEachVisibleCity(object_pos, body_entity, [&](entt::entity city_entity, glm::vec3& city_world_pos) {
+        // If it's reasonably close, then we can show city names
+        //if (scroll < 3) {
+        DrawEntityName(city_world_pos, city_entity);
+        //}
+        DrawCityIcon(city_world_pos);
+    });
 
     if (is_founding_city && is_rendering_founding_city) {
         DrawCityIcon(city_founding_position);
@@ -738,24 +802,177 @@ void SysStarSystemRenderer::LoadPlanetTextures() {
     }
 }
 
-void SysStarSystemRenderer::InitializeFramebuffers() {
-    auto buffer_shader = m_app.GetAssetManager().GetAsset<asset::ShaderDefinition>("core:framebuffer")->MakeShader();
+void SysStarSystemRenderer::StreamPlanetTextures() {
+    ZoneScoped;
+    auto bodies = m_universe.view<ToRender, PlanetTexture, cqspb::Body>();
+    for (entt::entity entity : bodies) {
+        auto& textures = m_universe.get<PlanetTexture>(entity);
+        double radius = m_universe.get<cqspb::Body>(entity).radius;
+        float screen_radius = GetScreenRadius(CalculateCenteredObject(entity), radius);
+        // The placeholder is good enough until the planet takes up a good part of the screen
+        if (screen_radius < streaming_radius) {
+            continue;
+        }
+        for (asset::Texture* texture : {textures.terrain, textures.normal, textures.roughness}) {
+            texture_streamer.Request(dynamic_cast<asset::StreamedTexture*>(texture), screen_radius);
+        }
+    }
+    texture_streamer.Update();
+}
 
-    ship_icon_layer = renderer.AddLayer<engine::FramebufferRenderer>(buffer_shader, *m_app.GetWindow());
-    physical_layer = renderer.AddLayer<engine::FramebufferRenderer>(buffer_shader, *m_app.GetWindow());
-    planet_icon_layer = renderer.AddLayer<engine::FramebufferRenderer>(buffer_shader, *m_app.GetWindow());
-    skybox_layer = renderer.AddLayer<engine::FramebufferRenderer>(buffer_shader, *m_app.GetWindow());
+void SysStarSystemRenderer::InitializeFramebuffers() {
+    // The default framebuffer is already multisampled with the sample count in the client options,
+    // so draw straight into it.
+    renderer.Initialize(*m_app.GetWindow());
+    pick_buffer.Initialize(*m_app.GetWindow());
+
+    // Layers are drawn from back to front
+    skybox_layer = renderer.AddLayer();
+    planet_icon_layer = renderer.AddLayer();
+    physical_layer = renderer.AddLayer();
+    ship_icon_layer = renderer.AddLayer();
 }
 
 void SysStarSystemRenderer::LoadProvinceMap() {
+    ZoneScoped;
     auto bin_asset = m_app.GetAssetManager().GetAsset<asset::BinaryAsset>("province_map");
-    // Might be able to release this after it's done
-    uint64_t file_size = bin_asset->data.size();
+    int width = 0;
+    int height = 0;
     int comp = 0;
-    auto d = stbi_load_from_memory(bin_asset->data.data(), file_size, &province_width, &province_height, &comp, 0);
+    // Always decode with alpha, because the ocean is transparent
+    unsigned char* pixels =
+        stbi_load_from_memory(bin_asset->data.data(), bin_asset->data.size(), &width, &height, &comp, 4);
+    if (pixels == nullptr) {
+        SPDLOG_ERROR("Cannot decode province map: {}", stbi_failure_reason());
+        return;
+    }
+
+    std::vector<uint32_t> ids(static_cast<size_t>(width) * height);
+    // Provinces are large areas of the same color, so only look up the color when it changes
+    int last_color = -1;
+    uint32_t last_id = 0;
+    for (size_t i = 0; i < ids.size(); i++) {
+        const unsigned char* pixel = &pixels[i * 4];
+        if (pixel[3] == 0) {
+            ids[i] = 0;
+            continue;
+        }
+        int color = common::components::ProvinceColor::toInt(pixel[0], pixel[1], pixel[2]);
+        if (color != last_color) {
+            last_color = color;
+            auto it = m_universe.province_colors.find(color);
+            last_id = (it == m_universe.province_colors.end()) ? 0 : ToPickId(it->second);
+        }
+        ids[i] = last_id;
+    }
+    stbi_image_free(pixels);
 
-    std::copy(&d[0], &d[province_width * province_height * comp], std::back_inserter(country_map));
-    delete d;
+    asset::CreateIdTexture(province_id_texture, ids.data(), width, height);
+}
+
+void SysStarSystemRenderer::DrawPickBuffer() {
+    ZoneScoped;
+    if (!pick_buffer.Begin(*m_app.GetWindow(), m_app.GetMouseX(), m_app.GetMouseY())) {
+        return;
+    }
+    auto bodies = m_universe.view<ToRender, cqspb::Body>(entt::exclude<cqspb::LightEmitter>);
+
+    // Red is the body, and billboards are behind everything else like when they're drawn
+    glColorMask(GL_TRUE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthFunc(GL_ALWAYS);
+    for (entt::entity body_entity : bodies) {
+        PickPlanetBillboard(body_entity, CalculateCenteredObject(body_entity));
+    }
+    glDepthFunc(GL_LESS);
+
+    // Green is the province under the mouse
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glColorMask(GL_TRUE, GL_TRUE, GL_FALSE, GL_FALSE);
+    for (entt::entity body_entity : m_universe.view<ToRender, cqspb::Body>()) {
+        PickBody(body_entity, CalculateCenteredObject(body_entity));
+    }
+
+    // Blue is the city, which has its own channel so that the body and province under it are still known
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glColorMask(GL_FALSE, GL_FALSE, GL_TRUE, GL_FALSE);
+    for (entt::entity body_entity : bodies) {
+        ForEachVisibleCity(CalculateCenteredObject(body_entity), body_entity,
+                           [&](entt::entity city_entity, glm::vec3& city_world_pos) {
+                               PickCityIcon(city_entity, city_world_pos);
+                           });
+    }
+
+    pick_buffer.End();
+}
+
+void SysStarSystemRenderer::PickPlanetBillboard(const entt::entity& ent_id, const glm::vec3& object_pos) {
+    glm::vec3 pos = GetBillboardPosition(object_pos);
+    if (GLPositionNotInBounds(CalculateGLPosition(object_pos), pos)) {
+        return;
+    }
+
+    SetBillboardProjection(pick_pane_shader, GetBillboardMatrix(pos));
+    pick_pane_shader->setInt("object_id", static_cast<int>(ToPickId(ent_id)));
+    engine::Draw(planet_circle, pick_pane_shader);
+}
+
+void SysStarSystemRenderer::PickBody(const entt::entity& entity, const glm::vec3& object_pos) {
+    auto& body = m_universe.get<cqspb::Body>(entity);
+    float screen_radius = GetScreenRadius(object_pos, body.radius);
+    // Stars don't have billboards, so they are always drawn
+    bool is_star = m_universe.all_of<cqspb::LightEmitter>(entity);
+    if (!is_star && screen_radius < engine::primitive::SphereLod::billboard_radius) {
+        return;
+    }
+
+    glm::mat4 position = glm::translate(glm::mat4(1.f), object_pos);
+    position *= glm::mat4(GetBodyRotation(body.axial, body.rotation, body.rotation_offset));
+    position = glm::scale(position, glm::vec3(body.radius));
+
+    bool has_provinces = m_universe.all_of<cqspb::TexturedTerrain>(entity);
+    if (has_provinces && body.radius < 10.f) {
+        // Same as the near shader when the planet is drawn
+        glDepthFunc(GL_ALWAYS);
+    }
+
+    auto& shader = pick_sphere.shaderProgram;
+    pick_sphere.mesh = sphere_lod.GetMesh(screen_radius);
+    shader->SetMVP(position, camera_matrix, projection);
+    shader->setInt("object_id", static_cast<int>(ToPickId(entity)));
+    shader->setBool("has_provinces", has_provinces);
+    engine::Draw(pick_sphere);
+    glDepthFunc(GL_LESS);
+}
+
+void SysStarSystemRenderer::PickCityIcon(const entt::entity& city_entity, const glm::vec3& object_pos) {
+    glm::mat4 matrix;
+    if (!GetCityIconMatrix(object_pos, matrix)) {
+        return;
+    }
+
+    SetBillboardProjection(pick_pane_shader, matrix);
+    pick_pane_shader->setInt("object_id", static_cast<int>(ToPickId(city_entity)));
+    engine::Draw(city, pick_pane_shader);
+}
+
+void SysStarSystemRenderer::ReadPickBuffer() {
+    ZoneScoped;
+    pick_buffer.Poll();
+    const glm::uvec4& ids = pick_buffer.GetResult();
+
+    // The entities may have been destroyed since the pick was drawn
+    auto valid_or_null = [&](uint32_t id) {
+        entt::entity entity = FromPickId(id);
+        return m_universe.valid(entity) ? entity : entt::null;
+    };
+    hovering_body = valid_or_null(ids.r);
+    hovering_province = valid_or_null(ids.g);
+    hovering_city = valid_or_null(ids.b);
+
+    if (hovering_province != entt::null && m_universe.all_of<common::components::ProvinceColor>(hovering_province)) {
+        auto& color = m_universe.get<common::components::ProvinceColor>(hovering_province);
+        selected_province_color = glm::vec3(color.r, color.g, color.b) / 255.f;
+    }
 }
 
 glm::quat SysStarSystemRenderer::GetBodyRotation(double axial, double rotation, double day_offset) {
@@ -872,7 +1089,7 @@ void SysStarSystemRenderer::CalculateCamera() {
     cam_pos = glm::vec3(cos(view_y) * sin(view_x), sin(view_y), cos(view_y) * cos(view_x)) * (float)scroll;
     cam_up = glm::vec3(0.0f, 1.0f, 0.0f);
     camera_matrix = glm::lookAt(cam_pos, glm::vec3(0.f, 0.f, 0.f), cam_up);
-    projection = glm::infinitePerspective(glm::radians(45.f), GetWindowRatio(), 0.1f);
+    projection = glm::infinitePerspective(glm::radians(field_of_view), GetWindowRatio(), 0.1f);
     viewport = glm::vec4(0.f, 0.f, m_app.GetWindowWidth(), m_app.GetWindowHeight());
 }
 
@@ -908,11 +1125,10 @@ void SysStarSystemRenderer::MoveCamera(double deltaTime) {
 }
 
 void SysStarSystemRenderer::CheckResourceDistRender() {
-#if FALSE
     using cqsp::client::components::PlanetTerrainRender;
     // Then check if it's the same rendered object
     auto& rend = m_app.GetUniverse().get<PlanetTerrainRender>(m_viewing_entity);
-    if (rend.resource == terrain_displaying) {
+    if (rend.resource == terrain_displaying && overlay_body == m_viewing_entity) {
         return;
     }
 
@@ -923,17 +1139,29 @@ void SysStarSystemRenderer::CheckResourceDistRender() {
     }
 
     auto& dist = m_app.GetUniverse().get<ResourceDistribution>(m_viewing_entity);
-    TerrainImageGenerator gen;
-    gen.terrain.seed = dist.dist[rend.resource];
-    gen.GenerateHeightMap(3, 9);
-    // Make the UI
-    unsigned int a = GeneratePlanetTexture(gen.GetHeightMap());
-    planet_resource = GenerateTexture(a, gen.GetHeightMap());
+    auto seed = dist.dist.find(rend.resource);
+    if (seed == dist.dist.end()) {
+        return;
+    }
+    if (terrain_generator != nullptr) {
+        // Renders straight into the overlay texture, so nothing has to be uploaded
+        terrain_generator->terrain.seed = static_cast<int>(seed->second);
+        terrain_generator->GenerateHeightMap(resource_overlay, 3, 9);
+    } else {
+        TerrainImageGenerator gen;
+        gen.terrain.seed = static_cast<int>(seed->second);
+        // The noise is cached, so only the first time a resource is shown has to generate it
+        gen.cache = noise_cache.get();
+        gen.GenerateHeightMap(3, 9);
+        auto& height_map = gen.GetHeightMap();
+        if (resource_overlay.texture_type != -1) {
+            glDeleteTextures(1, &resource_overlay.id);
+        }
+        asset::CreateTexture(resource_overlay, reinterpret_cast<unsigned char*>(height_map.GetSlabPtr(0)),
+                             height_map.GetWidth(), height_map.GetHeight(), 4);
+    }
     terrain_displaying = rend.resource;
-    // Switch view mode
-    planet.textures[0] = planet_resource;
-    planet.shaderProgram = no_light_shader;
-#endif
+    overlay_body = m_viewing_entity;
 }
 
 glm::vec3 SysStarSystemRenderer::CalculateMouseRay(const glm::vec3& ray_nds) {
@@ -969,15 +1197,10 @@ void SysStarSystemRenderer::FoundCity() {
     auto s = GetCitySurfaceCoordinate();
     SPDLOG_INFO("Founding city at {} {}", s.latitude(), s.longitude());
 
-    entt::entity settlement =
-        cqsp::common::actions::CreateCity(m_app.GetUniverse(), on_planet, s.latitude(), s.longitude());
-    // Set the name of the city
-    cqspc::Name& name = m_universe.emplace<cqspc::Name>(settlement);
-    name.name = m_universe.name_generators["Town Names"].Generate("1");
-
     // Set country
     // Add population and economy
-    m_app.GetUniverse().emplace<cqspc::IndustrialZone>(settlement);
+    common::systems::commands::Issue(m_app.GetGame(),
+                                     common::systems::commands::FoundCity {on_planet, s.latitude(), s.longitude()});
 
     m_app.GetUniverse().clear<CityFounding>();
 
@@ -986,13 +1209,14 @@ void SysStarSystemRenderer::FoundCity() {
 
 void SysStarSystemRenderer::SelectCountry() {
     // Country selection
+    // Nothing to select if the mouse is over the ocean
+    if (!m_universe.valid(hovering_province)) {
+        return;
+    }
     // Then select planet and tell the state
     selected_country_color = selected_province_color;
     selected_province = hovering_province;
     // Set the selected province
-    if (!m_universe.valid(selected_province)) {
-        return;
-    }
     m_universe.clear<cqsp::client::ctx::SelectedProvince>();
     m_universe.emplace_or_replace<cqsp::client::ctx::SelectedProvince>(selected_province);
     countries = true;
@@ -1023,6 +1247,11 @@ void SysStarSystemRenderer::FocusOnEntity(entt::entity ent) {
 
 float SysStarSystemRenderer::GetWindowRatio() { return window_ratio; }
 
+float SysStarSystemRenderer::GetScreenRadius(const glm::vec3& object_pos, double radius) {
+    return engine::primitive::SphereLod::GetScreenRadius(radius, glm::distance(object_pos, cam_pos),
+                                                         glm::radians(field_of_view), m_app.GetWindowHeight());
+}
+
 void SysStarSystemRenderer::GenerateOrbitLines() {
     ZoneScoped;
     SPDLOG_TRACE("Creating planet orbits");
@@ -1060,8 +1289,7 @@ void SysStarSystemRenderer::RenderInformationWindow(double deltaTime) {
         country_name_t =
             systems::gui::GetName(m_universe, m_universe.get<common::components::Province>(selected_province).country);
     }
-    ImGui::TextFmt("Hovering on Texture: {} {}", tex_x, tex_y);
-    ImGui::TextFmt("Texture color: {} {} {}", tex_r, tex_g, tex_b);
+    ImGui::TextFmt("Hovering body: {} province: {} city: {}", hovering_body, hovering_province, hovering_city);
     ImGui::TextFmt("Selected country color: {} {} {}", selected_country_color.x, selected_country_color.y,
                    selected_country_color.z);
     ImGui::TextFmt("Focused planets: {}", m_universe.view<FocusedPlanet>().size());
@@ -1095,8 +1323,8 @@ void SysStarSystemRenderer::RenderSelectedObjectInformation() {
 
         if (ImGui::Button("Burn prograde")) {
             // Add 10m/s prograde or something
-            auto& impulse = m_universe.get_or_emplace<common::components::types::Impulse>(m_viewing_entity);
-            impulse.impulse += norm;
+            common::systems::commands::Issue(m_app.GetGame(),
+                                             common::systems::commands::AddImpulse {m_viewing_entity, norm});
         }
         ImGui::SliderFloat("Text", &delta_v, -1, 1);
     }
@@ -1127,41 +1355,6 @@ common::components::types::SurfaceCoordinate SysStarSystemRenderer::GetCitySurfa
     return s;
 }
 
-void SysStarSystemRenderer::CityDetection() {
-    ZoneScoped;
-    if (on_planet == entt::null || !m_universe.valid(on_planet)) {
-        return;
-    }
-    auto s = GetCitySurfaceCoordinate();
-
-    // Look for the vector
-    // Rotate based on the axial tilt and roation
-    int x = (-1 * (s.latitude() * 2 - 180)) / 360 * province_height;
-    int y = fmod(s.longitude() + 180, 360) / 360. * province_width;
-    int pos = (x * province_width + y) * 4;
-    tex_x = x;
-    tex_y = y;
-    std::tuple<int, int, int, int> t =
-        std::make_tuple(country_map[pos], country_map[pos + 1], country_map[pos + 2], country_map[pos + 3]);
-    tex_r = std::get<0>(t);
-    tex_g = std::get<1>(t);
-    tex_b = std::get<2>(t);
-
-    if (std::get<3>(t) == 0) {
-        // Then ignore because it is ocean
-        return;
-    }
-    ZoneNamed(LookforProvince, true);
-    {
-        selected_province_color = (glm::vec3(std::get<0>(t), std::get<1>(t), std::get<2>(t)) / 255.f);
-        int i = common::components::ProvinceColor::toInt(tex_r, tex_g, tex_b);
-        if (m_universe.province_colors.find(i) != m_universe.province_colors.end()) {
-            hovering_province = m_universe.province_colors[i];
-        } else {
-        }
-    }
-}
-
 glm::vec3 SysStarSystemRenderer::GetMouseIntersectionOnObject(int mouse_x, int mouse_y) {
     ZoneScoped;
     // Normalize 3d device coordinates
@@ -1245,36 +1438,12 @@ void SysStarSystemRenderer::GenerateOrbit(entt::entity body) {
     line.orbit_mesh = engine::primitive::CreateLineSequence(orbit_points);
 }
 
-entt::entity SysStarSystemRenderer::GetMouseOnObject(int mouse_x, int mouse_y) {
-    namespace cqspb = cqsp::common::components::bodies;
-
-    // Loop through objects
-    auto bodies = m_app.GetUniverse().view<ToRender, cqspb::Body>();
-    for (entt::entity ent_id : bodies) {
-        glm::vec3 object_pos = CalculateCenteredObject(ent_id);
-        // Check if the sphere is rendered or not
-        // Normalize 3d device coordinates
-        float x = (2.0f * mouse_x) / m_app.GetWindowWidth() - 1.0f;
-        float y = 1.0f - (2.0f * mouse_y) / m_app.GetWindowHeight();
-        float z = 1.0f;
-
-        glm::vec3 ray_wor = CalculateMouseRay(glm::vec3(x, y, z));
-        auto& body = m_app.GetUniverse().get<cqspb::Body>(ent_id);
-        float radius = body.radius;
-
-        // Check for intersection for sphere
-        glm::vec3 sub = cam_pos - object_pos;
-        float b = glm::dot(ray_wor, sub);
-        // Object radius
-        float c = glm::dot(sub, sub) - radius * radius;
-
-        // Get the closer value
-        if ((b * b - c) >= 0) {
-            m_app.GetUniverse().emplace<MouseOverEntity>(ent_id);
-            return ent_id;
-        }
+entt::entity SysStarSystemRenderer::GetMouseOnObject() {
+    if (hovering_body == entt::null) {
+        return entt::null;
     }
-    return entt::null;
+    m_app.GetUniverse().emplace<MouseOverEntity>(hovering_body);
+    return hovering_body;
 }
 
 bool SysStarSystemRenderer::IsFoundingCity(common::Universe& universe) {
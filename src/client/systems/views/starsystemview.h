@@ -17,6 +17,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -25,14 +26,20 @@
 
 #include "common/components/coordinates.h"
 #include "common/universe.h"
+#include "common/util/noisemapbuilder.h"
 #include "engine/application.h"
+#include "engine/graphics/primitives/spherelod.h"
 #include "engine/graphics/renderable.h"
+#include "engine/graphics/texturestreamer.h"
 #include "engine/renderer/framebuffer.h"
+#include "engine/renderer/pickbuffer.h"
 #include "engine/renderer/renderer.h"
 
 namespace cqsp {
 namespace client {
 namespace systems {
+class TerrainShaderGenerator;
+
 // TODO(EhWhoAmI): Would be helpful to move the following structs to a header file.
 /*
  * Tag class for bodies to render.
@@ -82,7 +89,10 @@ class SysStarSystemRenderer {
 
     double GetDivider() { return divider; }
 
-    entt::entity GetMouseOnObject(int mouse_x, int mouse_y);
+    /// <summary>
+    /// Marks the body under the mouse with MouseOverEntity, as found by the last pick pass.
+    /// </summary>
+    entt::entity GetMouseOnObject();
 
     static bool IsFoundingCity(common::Universe &universe);
 
@@ -95,6 +105,7 @@ class SysStarSystemRenderer {
 
  private:
     entt::entity m_viewing_entity = entt::null;
+    /// Resource of the overlay that is in resource_overlay
     entt::entity terrain_displaying = entt::null;
 
     cqsp::common::Universe &m_universe;
@@ -107,17 +118,24 @@ class SysStarSystemRenderer {
     cqsp::engine::Renderable ship_overlay;
     cqsp::engine::Renderable city;
     cqsp::engine::Renderable sun;
+    cqsp::engine::Renderable pick_sphere;
 
     cqsp::asset::ShaderProgram_t orbit_shader;
     cqsp::asset::ShaderProgram_t near_shader;
-#if FALSE
-    // Disabled for now
-    asset::ShaderProgram_t no_light_shader;
-#endif
+    cqsp::asset::ShaderProgram_t pick_pane_shader;
+    /// <summary>
+    /// Resource distribution that is drawn over the terrain of overlay_body, picked in the planet viewer
+    /// </summary>
+    asset::Texture resource_overlay;
+    entt::entity overlay_body = entt::null;
 
     cqsp::asset::Texture *planet_texture;
+    cqsp::asset::AssetHandle<cqsp::asset::Texture> sky_cubemap;
     cqsp::asset::Texture *planet_heightmap;
-    cqsp::asset::Texture *earth_map_texture;
+    /// <summary>
+    /// Province of every pixel of the province map, as pick ids. 0 is the ocean, or pixels without a province.
+    /// </summary>
+    cqsp::asset::Texture province_id_texture;
 
     glm::vec3 cam_pos;
     glm::vec3 cam_up = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -137,6 +155,11 @@ class SysStarSystemRenderer {
     void DrawPlanetBillboards(const entt::entity &ent_id, const glm::vec3 &object_pos);
     void DrawShipIcon(glm::vec3 &object_pos);
     void DrawCityIcon(glm::vec3 &object_pos);
+    /// <summary>
+    /// Gets the billboard matrix of a city icon.
+    /// </summary>
+    /// <returns>False if the city icon is off screen</returns>
+    bool GetCityIconMatrix(const glm::vec3 &object_pos, glm::mat4 &matrix);
 
     void DrawAllCities(auto &bodies);
 
@@ -150,14 +173,38 @@ class SysStarSystemRenderer {
 
     void DrawStar(const entt::entity &entity, glm::vec3 &object_pos);
     void RenderCities(glm::vec3 &object_pos, const entt::entity &body_entity);
+    /// <summary>
+    /// Calls func with the entity and position of every city of the body that is not hidden behind the body.
+    /// </summary>
+    template <typename Func>
+    void ForEachVisibleCity(const glm::vec3 &object_pos, const entt::entity &body_entity, Func func);
     bool CityIsVisible(glm::vec3 city_pos, glm::vec3 planet_pos, glm::vec3 cam_pos, double radius);
     void CalculateCityPositions();
     void CalculateScroll();
 
     void LoadPlanetTextures();
+    /// <summary>
+    /// Requests the full resolution textures of the planets that are close to the camera
+    /// </summary>
+    void StreamPlanetTextures();
     void InitializeFramebuffers();
+    /// <summary>
+    /// Makes the province id texture from the province map and the province colors.
+    /// </summary>
     void LoadProvinceMap();
 
+    /// <summary>
+    /// Draws the ids of the billboards, bodies, provinces and cities under the mouse into the pick buffer.
+    /// </summary>
+    void DrawPickBuffer();
+    void PickPlanetBillboard(const entt::entity &ent_id, const glm::vec3 &object_pos);
+    void PickBody(const entt::entity &entity, const glm::vec3 &object_pos);
+    void PickCityIcon(const entt::entity &city_entity, const glm::vec3 &object_pos);
+    /// <summary>
+    /// Reads the body, province and city under the mouse from the last finished pick.
+    /// </summary>
+    void ReadPickBuffer();
+
     void GenerateOrbit(entt::entity entity);
 
     /// <summary>
@@ -202,6 +249,11 @@ class SysStarSystemRenderer {
 
     float GetWindowRatio();
 
+    /// <summary>
+    /// Radius in pixels of a body with the radius at the position
+    /// </summary>
+    float GetScreenRadius(const glm::vec3 &object_pos, double radius);
+
     void GenerateOrbitLines();
 
     void RenderInformationWindow(double deltaTime);
@@ -214,7 +266,7 @@ class SysStarSystemRenderer {
     glm::vec3 sun_position;
     glm::vec3 sun_color;
 
-    engine::LayerRenderer renderer;
+    engine::SinglePassLayerRenderer renderer;
 
     int ship_icon_layer;
     int planet_icon_layer;
@@ -230,42 +282,35 @@ class SysStarSystemRenderer {
 
     entt::entity selected_city = entt::null;
 
-    /// <summary>
-    /// For debugging, the x position of the mouse on the texture
-    /// </summary>
-    int tex_x;
-
-    /// <summary>
-    /// For debugging, the y position of the mouse on the texture
-    /// </summary>
-    int tex_y;
-
-    /// <summary>
-    /// Debugging colors
-    /// </summary>
-    int tex_r;
-    int tex_g;
-    int tex_b;
-
-    int province_height = 0;
-    int province_width = 0;
-
-    std::vector<unsigned char> country_map;
-
     common::components::types::SurfaceCoordinate GetCitySurfaceCoordinate();
-    void CityDetection();
+
+    engine::PickBuffer pick_buffer;
 
     glm::vec3 selected_province_color;
     glm::vec3 selected_country_color;
-    entt::entity hovering_province;
-    entt::entity selected_province;
+    entt::entity hovering_body = entt::null;
+    entt::entity hovering_province = entt::null;
+    entt::entity hovering_city = entt::null;
+    entt::entity selected_province = entt::null;
     bool countries = false;
 
     const double object_distance = 0.4;
 
     int orbits_generated = 0;
 
-    const int sphere_resolution = 64;
+    engine::primitive::SphereLod sphere_lod;
+
+    asset::TextureStreamer texture_streamer;
+    // Screen radius in pixels where planets start streaming in their full resolution textures
+    const float streaming_radius = 128.f;
+
+    // Vertical field of view in degrees
+    const float field_of_view = 45.f;
+
+    // Noise maps of the resource distributions, so that switching between resources only generates them once
+    std::unique_ptr<common::util::NoiseMapCache> noise_cache;
+    // Generates the resource overlay on the GPU, null if the terrain generator shader is missing
+    std::unique_ptr<TerrainShaderGenerator> terrain_generator;
 };
 }  // namespace systems
 }  // namespace client
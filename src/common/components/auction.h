@@ -16,6 +16,7 @@
 */
 #pragma once
 
+#include <deque>
 #include <functional>
 #include <map>
 #include <vector>
@@ -26,7 +27,7 @@ namespace cqsp {
 namespace common {
 namespace components {
 struct Order {
-    Order() : price(0), quantity(0) {}
+    Order() : price(0), quantity(0), agent(entt::null) {}
     Order(double price, double quantity, entt::entity agent) : price(price), quantity(quantity), agent(agent) {}
 
     /// <summary>
@@ -46,50 +47,192 @@ inline bool operator<(const Order& lhs, const Order& rhs) { return lhs.price < r
 
 inline bool operator>(const Order& lhs, const Order& rhs) { return lhs.price > rhs.price; }
 
-template <class T>
-class SortedOrderList : public std::vector<Order> {
+/// <summary>
+/// All the orders at a single price, filled in the order that they were placed.
+/// </summary>
+struct PriceLevel {
+    std::deque<Order> orders;
+    /// <summary>
+    /// Sum of the quantity of the orders
+    /// </summary>
+    double quantity = 0;
+};
+
+/// <summary>
+/// One side of an order book. The orders are bucketed by price, so placing an order and taking
+/// the best order are O(log n) of the number of prices, and the depth is kept as orders are
+/// placed and filled instead of being summed up when it's needed.
+/// <br>
+/// The best price is at the front, as decided by Compare.
+/// </summary>
+template <class Compare>
+class OrderBookSide {
  public:
-    using std::vector<Order>::vector;
+    using LevelMap = std::map<double, PriceLevel, Compare>;
+
     void put(const Order& order) {
-        SortedOrderList<T>::iterator it = std::lower_bound(begin(), end(), order, T());
-        insert(it, order);
+        if (order.quantity <= 0) {
+            return;
+        }
+        PriceLevel& level = levels[order.price];
+        level.orders.push_back(order);
+        level.quantity += order.quantity;
+        depth += order.quantity;
+        count++;
+    }
+
+    bool empty() const { return levels.empty(); }
+
+    /// <summary>
+    /// Number of orders
+    /// </summary>
+    size_t size() const { return count; }
+
+    /// <summary>
+    /// The oldest order at the best price. The side must not be empty.
+    /// </summary>
+    Order& front() { return levels.begin()->second.orders.front(); }
+    const Order& front() const { return levels.begin()->second.orders.front(); }
+
+    double BestPrice() const { return levels.begin()->first; }
+
+    /// <summary>
+    /// Quantity of all the orders on this side
+    /// </summary>
+    double Depth() const { return depth; }
+
+    /// <summary>
+    /// Quantity of the orders at a price
+    /// </summary>
+    double DepthAt(double price) const {
+        auto it = levels.find(price);
+        return it == levels.end() ? 0 : it->second.quantity;
     }
+
+    /// <summary>
+    /// Takes up to quantity from the front order, and removes the order when it's used up.
+    /// </summary>
+    /// <returns>The quantity that was taken</returns>
+    double Fill(double quantity) {
+        auto level = levels.begin();
+        Order& order = level->second.orders.front();
+        if (quantity >= order.quantity) {
+            quantity = order.quantity;
+            pop_front();
+            return quantity;
+        }
+        order.quantity -= quantity;
+        level->second.quantity -= quantity;
+        depth -= quantity;
+        return quantity;
+    }
+
+    void pop_front() {
+        auto level = levels.begin();
+        const double quantity = level->second.orders.front().quantity;
+        level->second.orders.pop_front();
+        level->second.quantity -= quantity;
+        count--;
+        if (level->second.orders.empty()) {
+            levels.erase(level);
+        }
+        // Don't let rounding leave depth behind on an empty side
+        depth = levels.empty() ? 0 : depth - quantity;
+    }
+
+    void clear() {
+        levels.clear();
+        depth = 0;
+        count = 0;
+    }
+
+    /// <summary>
+    /// The orders from the front to the back.
+    /// </summary>
+    std::vector<Order> Orders() const {
+        std::vector<Order> orders;
+        orders.reserve(count);
+        for (const auto& [price, level] : levels) {
+            orders.insert(orders.end(), level.orders.begin(), level.orders.end());
+        }
+        return orders;
+    }
+
+    auto begin() const { return levels.begin(); }
+    auto end() const { return levels.end(); }
+
+ private:
+    LevelMap levels;
+    double depth = 0;
+    size_t count = 0;
 };
 
 /// <summary>
-/// Greatest to smallest
+/// Buy orders, highest price first
 /// </summary>
-typedef SortedOrderList<std::greater<Order>> DescendingSortedOrderList;
+typedef OrderBookSide<std::greater<double>> BidList;
+
+/// <summary>
+/// Sell orders, lowest price first
+/// </summary>
+typedef OrderBookSide<std::less<double>> AskList;
+
+/// <summary>
+/// Goods that changed hands when orders were matched.
+/// </summary>
+struct Trade {
+    entt::entity good;
+    entt::entity buyer;
+    entt::entity seller;
+    double price;
+    double quantity;
+};
 
 /// <summary>
-/// Smallest to greatest
+/// The orders for a single good in a market.
 /// </summary>
-typedef SortedOrderList<std::less<Order>> AscendingSortedOrderList;
+struct OrderBook {
+    BidList bids;
+    AskList asks;
+
+    /// <summary>
+    /// Price that the book last cleared at
+    /// </summary>
+    double last_price = 0;
+    /// <summary>
+    /// Quantity traded the last time the book was cleared
+    /// </summary>
+    double volume = 0;
+
+    /// <summary>
+    /// If someone is willing to pay as much as someone else is asking for
+    /// </summary>
+    bool Crossed() const { return !bids.empty() && !asks.empty() && bids.BestPrice() >= asks.BestPrice(); }
+};
 
 struct AuctionHouse {
-    std::map<entt::entity, DescendingSortedOrderList> sell_orders;
-    std::map<entt::entity, AscendingSortedOrderList> buy_orders;
+    std::map<entt::entity, OrderBook> books;
 
-    void AddSellOrder(entt::entity good, Order&& order) { sell_orders[good].put(order); }
+    OrderBook& operator[](entt::entity good) { return books[good]; }
 
-    void AddBuyOrder(entt::entity good, Order&& order) { buy_orders[good].put(order); }
+    /// <summary>
+    /// Places an order without matching it. The order is matched when the auction house is cleared.
+    /// </summary>
+    void AddSellOrder(entt::entity good, Order&& order) { books[good].asks.put(order); }
 
-    double GetDemand(entt::entity good) {
-        const AscendingSortedOrderList& buy_list = buy_orders[good];
-        double demand = 0;
-        for (const Order& order : buy_list) {
-            demand += order.quantity;
-        }
-        return demand;
+    /// <summary>
+    /// Places an order without matching it. The order is matched when the auction house is cleared.
+    /// </summary>
+    void AddBuyOrder(entt::entity good, Order&& order) { books[good].bids.put(order); }
+
+    double GetDemand(entt::entity good) const {
+        auto it = books.find(good);
+        return it == books.end() ? 0 : it->second.bids.Depth();
     }
 
-    double GetSupply(entt::entity good) {
-        const DescendingSortedOrderList& sell_list = sell_orders[good];
-        double supply = 0;
-        for (const Order& order : sell_list) {
-            supply += order.quantity;
-        }
-        return supply;
+    double GetSupply(entt::entity good) const {
+        auto it = books.find(good);
+        return it == books.end() ? 0 : it->second.asks.Depth();
     }
 };
 }  // namespace components
@@ -265,7 +265,8 @@ struct PolarCoordinate_tp {
 typedef PolarCoordinate_tp<types::astronomical_unit> PolarCoordinate;
 
 struct MoveTarget {
-    entt::entity target;
+    entt::entity target = entt::null;
+    MoveTarget() = default;
     explicit MoveTarget(entt::entity _targetent) : target(_targetent) {}
 };
 
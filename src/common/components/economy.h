@@ -174,6 +174,7 @@ struct Wallet {
         GDP_change = 0;
     }
     double GetGDPChange() { return GDP_change; }
+    double GetChange() const { return change; }
 
  private:
     double balance = 0;
@@ -229,6 +230,14 @@ struct LaborInformation {
 };
 
 struct FactoryProducing {};
+
+/// <summary>
+/// Goods that a market traded with other markets over trade routes on the last day.
+/// </summary>
+struct TradeFlows {
+    ResourceLedger imports;
+    ResourceLedger exports;
+};
 }  // namespace components
 }  // namespace common
 }  // namespace cqsp
@@ -16,6 +16,8 @@
 */
 #pragma once
 
+#include <cstdint>
+
 #include <entt/entt.hpp>
 
 namespace cqsp {
@@ -56,6 +58,25 @@ class SpacePort {};
 struct Highway {
     int extent;
 };
+
+enum class RouteType : uint8_t { Highway, SpacePort, Orbit };
+
+/// <summary>
+/// A transport link between two markets. Goods are traded over it in both directions.
+/// </summary>
+struct TradeRoute {
+    entt::entity from;
+    entt::entity to;
+    /// <summary>
+    /// Cost to move a unit of goods over the route
+    /// </summary>
+    double cost;
+    /// <summary>
+    /// Units of goods that can be moved over the route per day, for all goods together
+    /// </summary>
+    double capacity;
+    RouteType type;
+};
 }  // namespace infrastructure
 }  // namespace components
 }  // namespace common
@@ -33,7 +33,8 @@ struct Fleet {
     std::vector<entt::entity> subfleets;
     std::vector<entt::entity> ships;
     entt::entity parent_fleet = entt::null;
-    entt::entity owner;
+    entt::entity owner = entt::null;
+    Fleet() = default;
     Fleet(entt::entity parent_fleet, entt::entity _owner, unsigned int _echelon)
         : parent_fleet(parent_fleet), owner(_owner), echelon(_echelon) {}
     // creates top level fleet
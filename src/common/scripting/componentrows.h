@@ -0,0 +1,68 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+namespace cqsp::scripting {
+/// <summary>
+/// Values of a component copied out of the registry into rows of doubles, so that scripts can read every
+/// entity with the component in one call instead of calling into the game once per entity.
+/// <br>
+/// In lua, `rows:get(row, column)` and `rows:entity(row)` start at 1. Under LuaJIT, the values can also be read
+/// without going through the bindings with `local values = rows:values()`, where the value of a column of a row is
+/// `values[row * rows:columns() + column]`, starting at 0. The values can be read while the rows are alive.
+/// </summary>
+class ComponentRows {
+ public:
+    explicit ComponentRows(int columns) : column_count(columns) {}
+
+    void Reserve(size_t rows) {
+        entities.reserve(rows);
+        values.reserve(rows * column_count);
+    }
+
+    template <class... Values>
+    void Add(entt::entity entity, Values... row) {
+        static_assert(sizeof...(Values) > 0);
+        entities.push_back(entity);
+        (values.push_back(static_cast<double>(row)), ...);
+    }
+
+    int size() const { return static_cast<int>(entities.size()); }
+    int columns() const { return column_count; }
+
+    // Out of range throws, which sol turns into a lua error
+    double get(int row, int column) const {
+        if (column < 1 || column > column_count) {
+            throw std::out_of_range("Column is out of range");
+        }
+        return values.at(static_cast<size_t>(row - 1) * column_count + (column - 1));
+    }
+    entt::entity entity(int row) const { return entities.at(static_cast<size_t>(row - 1)); }
+
+    void* data() { return values.data(); }
+
+ private:
+    int column_count;
+    std::vector<entt::entity> entities;
+    std::vector<double> values;
+};
+}  // namespace cqsp::scripting
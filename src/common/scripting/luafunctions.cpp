@@ -21,6 +21,8 @@
 #include <string>
 #include <vector>
 
+#include <spdlog/spdlog.h>
+
 #include "common/components/area.h"
 #include "common/components/bodies.h"
 #include "common/components/coordinates.h"
@@ -35,11 +37,13 @@
 #include "common/components/science.h"
 #include "common/components/ships.h"
 #include "common/components/surface.h"
+#include "common/scripting/componentrows.h"
 #include "common/scripting/functionreg.h"
 #include "common/systems/actions/cityactions.h"
 #include "common/systems/actions/factoryconstructaction.h"
 #include "common/systems/actions/shiplaunchaction.h"
 #include "common/systems/economy/markethelpers.h"
+#include "common/systems/save/savedcomponents.h"
 #include "common/systems/science/labs.h"
 #include "common/systems/science/technology.h"
 #include "common/util/random/stdrandom.h"
@@ -112,6 +116,129 @@ void FunctionUniverseBodyGen(cqsp::common::Universe& universe, cqsp::scripting::
     });
 }
 
+/// <summary>
+/// Makes room for `count` more of the component, so that inserting many of them doesn't grow the storage again
+/// and again.
+/// </summary>
+template <class Component>
+void ReserveMore(cqsp::common::Universe& universe, size_t count) {
+    auto& storage = universe.storage<Component>();
+    storage.reserve(storage.size() + count);
+}
+
+cqspt::Orbit ReadOrbit(const sol::table& table) {
+    cqspt::Orbit orbit;
+    orbit.semi_major_axis = table.get_or("semi_major_axis", 0.0);
+    orbit.eccentricity = table.get_or("eccentricity", 0.0);
+    orbit.inclination = table.get_or("inclination", 0.0);
+    orbit.LAN = table.get_or("LAN", 0.0);
+    orbit.w = table.get_or("w", 0.0);
+    orbit.M0 = table.get_or("M0", 0.0);
+    orbit.CalculateVariables();
+    return orbit;
+}
+
+/// <summary>
+/// Adds the orbits, and the kinematics at the start of the orbits, to entities that don't have an orbit yet
+/// </summary>
+void InsertOrbits(cqsp::common::Universe& universe, const std::vector<entt::entity>& entities,
+                  const std::vector<cqspt::Orbit>& orbits) {
+    std::vector<cqspt::Kinematics> kinematics(orbits.size());
+    for (size_t i = 0; i < orbits.size(); i++) {
+        cqspt::UpdatePos(kinematics[i], orbits[i]);
+    }
+    ReserveMore<cqspt::Orbit>(universe, entities.size());
+    ReserveMore<cqspt::Kinematics>(universe, entities.size());
+    universe.insert<cqspt::Orbit>(entities.begin(), entities.end(), orbits.begin());
+    universe.insert<cqspt::Kinematics>(entities.begin(), entities.end(), kinematics.begin());
+}
+
+/// <summary>
+/// Functions that create many bodies in one call, so that generating large systems isn't slowed down by calling
+/// into the game for every body.
+/// </summary>
+void FunctionBulkBodyGen(cqsp::common::Universe& universe, cqsp::scripting::ScriptInterface& script_engine) {
+    CREATE_NAMESPACE(core);
+
+    // Takes an array of bodies, which look like
+    // { star = false, radius = 6371, mass = 5.97e24, orbit = { semi_major_axis = 1.5e8, eccentricity = 0.01,
+    //   inclination = 0, LAN = 0, w = 0, M0 = 0 } }
+    // where everything is optional, and bodies are planets unless they are stars.
+    // Returns the created bodies in the same order.
+    REGISTER_FUNCTION("add_bodies", [&](const sol::table& bodies) {
+        size_t count = bodies.size();
+        std::vector<entt::entity> entities(count);
+        universe.create(entities.begin(), entities.end());
+
+        std::vector<cqspb::Body> body_components(count);
+        std::vector<entt::entity> planets;
+        std::vector<entt::entity> stars;
+        std::vector<entt::entity> orbiting;
+        std::vector<cqspt::Orbit> orbits;
+        planets.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            sol::table body = bodies[i + 1];
+            body_components[i].radius = body.get_or("radius", 0.0);
+            body_components[i].mass = body.get_or("mass", 0.0);
+            if (body.get_or("star", false)) {
+                stars.push_back(entities[i]);
+            } else {
+                planets.push_back(entities[i]);
+            }
+            sol::optional<sol::table> orbit = body["orbit"];
+            if (orbit) {
+                orbiting.push_back(entities[i]);
+                orbits.push_back(ReadOrbit(*orbit));
+            }
+        }
+
+        ReserveMore<cqspb::Body>(universe, count);
+        universe.insert<cqspb::Body>(entities.begin(), entities.end(), body_components.begin());
+        universe.insert<cqspb::Planet>(planets.begin(), planets.end());
+        universe.insert<cqspb::Star>(stars.begin(), stars.end());
+        universe.insert<cqspb::LightEmitter>(stars.begin(), stars.end());
+        InsertOrbits(universe, orbiting, orbits);
+        return sol::as_table(std::move(entities));
+    });
+
+    // Takes an array of { body = entity, semi_major_axis = ..., ... }, like set_orbit
+    REGISTER_FUNCTION("set_orbits", [&](const sol::table& table) {
+        size_t count = table.size();
+        std::vector<entt::entity> entities;
+        std::vector<cqspt::Orbit> orbits;
+        entities.reserve(count);
+        orbits.reserve(count);
+        for (size_t i = 1; i <= count; i++) {
+            sol::table orbit = table[i];
+            entities.push_back(orbit.get_or("body", entt::entity(entt::null)));
+            orbits.push_back(ReadOrbit(orbit));
+        }
+        InsertOrbits(universe, entities, orbits);
+    });
+
+    // Takes an array of { planet = entity, latitude = ..., longitude = ... }, and returns the cities in the
+    // same order
+    REGISTER_FUNCTION("add_planet_settlements", [&](const sol::table& table) {
+        size_t count = table.size();
+        std::vector<entt::entity> cities(count);
+        universe.create(cities.begin(), cities.end());
+
+        std::vector<cqspt::SurfaceCoordinate> coordinates;
+        coordinates.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            sol::table settlement = table[i + 1];
+            entt::entity planet = settlement.get_or("planet", entt::entity(entt::null));
+            coordinates.emplace_back(settlement.get_or("latitude", 0.0), settlement.get_or("longitude", 0.0));
+            universe.get_or_emplace<cqspc::Habitation>(planet).settlements.push_back(cities[i]);
+        }
+        ReserveMore<cqspc::Settlement>(universe, count);
+        ReserveMore<cqspt::SurfaceCoordinate>(universe, count);
+        universe.insert<cqspc::Settlement>(cities.begin(), cities.end());
+        universe.insert<cqspt::SurfaceCoordinate>(cities.begin(), cities.end(), coordinates.begin());
+        return sol::as_table(std::move(cities));
+    });
+}
+
 void FunctionCivilizationGen(cqsp::common::Universe& universe, cqsp::scripting::ScriptInterface& script_engine) {
     CREATE_NAMESPACE(core);
 
@@ -203,6 +330,7 @@ void FunctionEconomy(cqsp::common::Universe& universe, cqsp::scripting::ScriptIn
             // Assign price to market
             market.market_information[entity].price = universe.get<cqspc::Price>(entity);
         }
+        cqsp::common::systems::save::MarkDirty<cqspc::Market>(universe);
         return market_entity;
         // return entity;
     };
@@ -218,6 +346,21 @@ void FunctionEconomy(cqsp::common::Universe& universe, cqsp::scripting::ScriptIn
 
     REGISTER_FUNCTION("add_cash", [&](entt::entity participant, double balance) {
         universe.get_or_emplace<cqspc::Wallet>(participant) += balance;
+        cqsp::common::systems::save::MarkDirty<cqspc::Wallet>(universe);
+    });
+
+    REGISTER_FUNCTION("add_trade_route", [&](entt::entity from, entt::entity to, double cost, double capacity,
+                                             const std::string& type) {
+        using cqspc::infrastructure::RouteType;
+        RouteType route_type = RouteType::Highway;
+        if (type == "spaceport") {
+            route_type = RouteType::SpacePort;
+        } else if (type == "orbit") {
+            route_type = RouteType::Orbit;
+        } else if (type != "highway") {
+            SPDLOG_WARN("Unknown trade route type {}, using highway", type);
+        }
+        return cqsp::common::systems::economy::AddTradeRoute(universe, from, to, cost, capacity, route_type);
     });
 }
 
@@ -354,6 +497,57 @@ void FunctionScience(cqsp::common::Universe& universe, cqsp::scripting::ScriptIn
         res.potential_research.insert(tech);
     });
 }
+
+/// <summary>
+/// Bulk readers of components, see @ref cqsp::scripting::ComponentRows
+/// </summary>
+void FunctionBulkAccess(cqsp::common::Universe& universe, cqsp::scripting::ScriptInterface& script_engine) {
+    using cqsp::scripting::ComponentRows;
+    script_engine.new_usertype<ComponentRows>("ComponentRows", sol::no_constructor, "size", &ComponentRows::size,
+                                              "columns", &ComponentRows::columns, "get", &ComponentRows::get,
+                                              "entity", &ComponentRows::entity, "values",
+                                              [&script_engine](ComponentRows& rows) {
+                                                  return script_engine.ReadDoubles(rows.data());
+                                              });
+
+    CREATE_NAMESPACE(core);
+
+    // Semi major axis, eccentricity, inclination, LAN, argument of periapsis, mean anomaly at epoch
+    REGISTER_FUNCTION("read_orbits", [&]() {
+        auto view = universe.view<cqspt::Orbit>();
+        ComponentRows rows(6);
+        rows.Reserve(view.size());
+        for (auto [entity, orbit] : view.each()) {
+            rows.Add(entity, orbit.semi_major_axis, orbit.eccentricity, orbit.inclination, orbit.LAN, orbit.w,
+                     orbit.M0);
+        }
+        return rows;
+    });
+
+    // Position, then velocity
+    REGISTER_FUNCTION("read_kinematics", [&]() {
+        auto view = universe.view<cqspt::Kinematics>();
+        ComponentRows rows(6);
+        rows.Reserve(view.size());
+        for (auto [entity, kinematics] : view.each()) {
+            const glm::dvec3& position = kinematics.position;
+            const glm::dvec3& velocity = kinematics.velocity;
+            rows.Add(entity, position.x, position.y, position.z, velocity.x, velocity.y, velocity.z);
+        }
+        return rows;
+    });
+
+    // Population, labor force
+    REGISTER_FUNCTION("read_populations", [&]() {
+        auto view = universe.view<cqspc::PopulationSegment>();
+        ComponentRows rows(2);
+        rows.Reserve(view.size());
+        for (auto [entity, segment] : view.each()) {
+            rows.Add(entity, segment.population, segment.labor_force);
+        }
+        return rows;
+    });
+}
 }  // namespace
 
 void cqsp::scripting::LoadFunctions(cqsp::common::Universe& universe, cqsp::scripting::ScriptInterface& script_engine) {
@@ -363,9 +557,11 @@ void cqsp::scripting::LoadFunctions(cqsp::common::Universe& universe, cqsp::scri
     FunctionPopulation(universe, script_engine);
     FunctionRandom(universe, script_engine);
     FunctionUniverseBodyGen(universe, script_engine);
+    FunctionBulkBodyGen(universe, script_engine);
     FunctionUser(universe, script_engine);
     FunctionEvent(universe, script_engine);
     FunctionShips(universe, script_engine);
     FunctionResource(universe, script_engine);
     FunctionScience(universe, script_engine);
+    FunctionBulkAccess(universe, script_engine);
 }
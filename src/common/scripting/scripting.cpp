@@ -17,17 +17,42 @@
 #include "common/scripting/scripting.h"
 
 #include <fmt/format.h>
+#include <tracy/Tracy.hpp>
 
 #include <iostream>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "common/util/logging.h"
 
 using cqsp::scripting::ScriptInterface;
 
+namespace {
+uint64_t HashSource(std::string_view source) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : source) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void BudgetHook(lua_State* L, lua_Debug*) { luaL_error(L, "script ran out of its instruction budget"); }
+}  // namespace
+
 ScriptInterface::ScriptInterface() {
     open_libraries(sol::lib::base, sol::lib::table, sol::lib::math, sol::lib::package);
+#ifdef CQSP_LUAJIT
+    open_libraries(sol::lib::jit, sol::lib::ffi);
+    // Mods share the state with the core scripts, and ffi can call any C function, so scripts only get the
+    // reader of the bulk component readers that is made from it, see @ref ReadDoubles
+    sol::protected_function make_reader =
+        load("local ffi = ffi return function(pointer) return ffi.cast('const double*', pointer) end");
+    double_reader = make_reader();
+    (*this)["ffi"] = sol::lua_nil;
+    (*this)["package"]["loaded"]["ffi"] = sol::lua_nil;
+#endif
     // Initialize loggers
     logger = cqsp::common::util::make_logger("lua");
     // Add a sink to get the scripting log
@@ -38,6 +63,10 @@ ScriptInterface::ScriptInterface() {
     // Log information
     std::string version = (*this)["_VERSION"];
     SPDLOG_LOGGER_INFO(logger, "Lua version: {}", version);
+#ifdef CQSP_LUAJIT
+    std::string jit_version = (*this)["jit"]["version"];
+    SPDLOG_LOGGER_INFO(logger, "LuaJIT version: {}", jit_version);
+#endif
     SPDLOG_LOGGER_INFO(logger, "Sol version: {}.{}.{}", SOL_VERSION_MAJOR, SOL_VERSION_MINOR, SOL_VERSION_PATCH);
 }
 
@@ -52,6 +81,107 @@ void ScriptInterface::ParseResult(const sol::protected_function_result& result)
 
 void ScriptInterface::RunScript(std::string_view str) { ParseResult(safe_script(str)); }
 
+sol::load_result ScriptInterface::LoadScript(const std::string& name, std::string_view code) {
+    ZoneScoped;
+    uint64_t hash = HashSource(code);
+    auto compiled = compiled_scripts.find(name);
+    if (compiled != compiled_scripts.end() && compiled->second.source_hash == hash) {
+        sol::load_result chunk = load(compiled->second.bytecode, name, sol::load_mode::binary);
+        if (chunk.valid()) {
+            return chunk;
+        }
+    }
+
+    std::string bytecode;
+    if (bytecode_cache != nullptr && bytecode_cache->Load(name, code, bytecode)) {
+        sol::load_result chunk = load(bytecode, name, sol::load_mode::binary);
+        if (chunk.valid()) {
+            compiled_scripts[name] = {hash, std::move(bytecode)};
+            return chunk;
+        }
+        SPDLOG_LOGGER_WARN(logger, "Cached bytecode of {} does not load, compiling it again", name);
+    }
+
+    sol::load_result chunk = load(code, name, sol::load_mode::text);
+    if (!chunk.valid()) {
+        return chunk;
+    }
+    sol::protected_function function = chunk;
+    sol::bytecode dumped = function.dump();
+    CompiledScript& script = compiled_scripts[name];
+    script.source_hash = hash;
+    script.bytecode = std::string(dumped.as_string_view());
+    if (bytecode_cache != nullptr) {
+        bytecode_cache->Save(name, code, script.bytecode);
+    }
+    return chunk;
+}
+
+sol::object ScriptInterface::RequireScript(const std::string& name, std::string_view code) {
+    sol::table loaded = (*this)["package"]["loaded"];
+    sol::object module = loaded[name];
+    if (module.valid() && module.get_type() != sol::type::lua_nil) {
+        return module;
+    }
+
+    sol::load_result chunk = LoadScript(name, code);
+    if (!chunk.valid()) {
+        sol::error err = chunk;
+        values.push_back(err.what());
+        SPDLOG_LOGGER_INFO(logger, "{}", err.what());
+        return sol::make_object(*this, sol::nil);
+    }
+    sol::protected_function function = chunk;
+    sol::protected_function_result result = function(name);
+    if (!result.valid()) {
+        ParseResult(result);
+        return sol::make_object(*this, sol::nil);
+    }
+    sol::object value = result;
+    if (value.get_type() == sol::type::lua_nil) {
+        // Scripts that don't return anything are still only run once
+        value = sol::make_object(*this, true);
+    }
+    loaded[name] = value;
+    return value;
+}
+
+bool ScriptInterface::UnloadChangedScript(const std::string& name, std::string_view code) {
+    auto compiled = compiled_scripts.find(name);
+    if (compiled == compiled_scripts.end() || compiled->second.source_hash == HashSource(code)) {
+        return false;
+    }
+    sol::table loaded = (*this)["package"]["loaded"];
+    loaded[name] = sol::lua_nil;
+    return true;
+}
+
+void ScriptInterface::Interpret(const sol::protected_function& function) {
+#ifdef CQSP_LUAJIT
+    sol::protected_function off = (*this)["jit"]["off"];
+    ParseResult(off(function, true));
+#endif
+}
+
+sol::object ScriptInterface::ReadDoubles(void* pointer) {
+#ifdef CQSP_LUAJIT
+    sol::protected_function_result result = double_reader(pointer);
+    if (result.valid()) {
+        return result;
+    }
+    ParseResult(result);
+#endif
+    return sol::make_object(*this, sol::lua_nil);
+}
+
+void ScriptInterface::SetInstructionBudget(int budget) {
+    if (budget > 0) {
+        lua_sethook(lua_state(), BudgetHook, LUA_MASKCOUNT, budget);
+    } else {
+        lua_sethook(lua_state(), nullptr, 0, 0);
+    }
+}
+
 void ScriptInterface::RegisterDataGroup(std::string_view name) {
     script(fmt::format(R"({} = {{
         data = {{}},
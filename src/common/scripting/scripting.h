@@ -19,15 +19,29 @@
 #include <spdlog/sinks/ringbuffer_sink.h>
 #include <spdlog/spdlog.h>
 
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include <sol/sol.hpp>
 
 namespace cqsp {
 namespace scripting {
+/// <summary>
+/// Keeps the bytecode that scripts compile to between runs, so that they don't have to be parsed again.
+/// </summary>
+class IBytecodeCache {
+ public:
+    virtual ~IBytecodeCache() = default;
+    /// <returns>If there is bytecode for the source</returns>
+    virtual bool Load(const std::string& name, std::string_view source, std::string& bytecode) = 0;
+    virtual void Save(const std::string& name, std::string_view source, const std::string& bytecode) = 0;
+};
+
 class ScriptInterface : public sol::state {
  public:
     using sol::state::state;
@@ -38,11 +52,80 @@ class ScriptInterface : public sol::state {
     void Init();
     int GetLength(std::string_view);
 
+    /// <summary>
+    /// Compiles the script, or loads the bytecode that the same source was compiled to before.
+    /// </summary>
+    sol::load_result LoadScript(const std::string& name, std::string_view code);
+
+    /// <summary>
+    /// Runs the script the first time that it is required, and keeps what it returns in package.loaded like
+    /// the require of lua does.
+    /// </summary>
+    sol::object RequireScript(const std::string& name, std::string_view code);
+
+    /// <summary>
+    /// Removes the script from package.loaded if its source is different from when it was required, so that the
+    /// next require runs the new source.
+    /// </summary>
+    /// <returns>If the script was removed</returns>
+    bool UnloadChangedScript(const std::string& name, std::string_view code);
+
+    /// <summary>
+    /// Where compiled scripts are kept between runs, null to only keep them while the game runs.
+    /// </summary>
+    void SetBytecodeCache(IBytecodeCache* cache) { bytecode_cache = cache; }
+
+    /// <summary>
+    /// Calls the function, and raises an error in it if it runs more than `budget` lua instructions, so that
+    /// a script that loops forever can't hang the game.
+    /// <br>
+    /// LuaJIT doesn't count the instructions of compiled code, so functions with a budget should be interpreted,
+    /// see @ref Interpret.
+    /// </summary>
+    template <class... Args>
+    sol::protected_function_result CallWithBudget(const sol::protected_function& function, int budget,
+                                                  Args&&... args) {
+        SetInstructionBudget(budget);
+        sol::protected_function_result result = function(std::forward<Args>(args)...);
+        SetInstructionBudget(0);
+        return result;
+    }
+
+    /// <summary>
+    /// A `const double*` cdata of the pointer, so that scripts can index the values without ffi. Nil on Lua.
+    /// </summary>
+    sol::object ReadDoubles(void* pointer);
+
+    /// <summary>
+    /// Stops LuaJIT from compiling the function and the functions defined in it. Does nothing on Lua.
+    /// </summary>
+    void Interpret(const sol::protected_function& function);
+
     std::vector<std::string> values;
 
     std::vector<std::string> GetLogs();
 
  private:
+    /// <summary>
+    /// Zero to remove the budget
+    /// </summary>
+    void SetInstructionBudget(int budget);
+
+    struct CompiledScript {
+        uint64_t source_hash;
+        std::string bytecode;
+    };
+
+    /// <summary>
+    /// Bytecode of the scripts that were loaded, by name
+    /// </summary>
+    std::map<std::string, CompiledScript> compiled_scripts;
+    IBytecodeCache* bytecode_cache = nullptr;
+    /// <summary>
+    /// Casts pointers with ffi, which is kept away from the scripts
+    /// </summary>
+    sol::protected_function double_reader;
+
     std::shared_ptr<spdlog::logger> logger;
     std::shared_ptr<spdlog::sinks::ringbuffer_sink_mt> ringbuffer_sink;
 };
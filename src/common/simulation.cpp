@@ -37,6 +37,7 @@
 #include "common/systems/economy/sysinfrastructure.h"
 #include "common/systems/economy/sysmarket.h"
 #include "common/systems/economy/syspopulation.h"
+#include "common/systems/economy/systrade.h"
 #include "common/systems/history/sysmarkethistory.h"
 #include "common/systems/movement/sysmovement.h"
 #include "common/systems/navy/sysnavy.h"
@@ -61,8 +62,9 @@ Simulation::Simulation(cqsp::common::Game& game) : m_game(game), m_universe(game
     AddSystem<cqspcs::InfrastructureSim>();
     AddSystem<cqspcs::SysPopulationConsumption>();
     AddSystem<cqspcs::SysProduction>();
+    AddSystem<cqspcs::SysTrade>();
 
-    // AddSystem<cqspcs::SysAgent>();
+    AddSystem<cqspcs::SysAgent>();
     AddSystem<cqspcs::SysMarket>();
     AddSystem<cqspcs::history::SysMarketHistory>();
     AddSystem<cqspcs::SysOrbit>();
@@ -52,6 +52,11 @@ class StarDate {
 
     int GetDate() { return date; }
 
+    /// <summary>
+    /// Sets the tick directly, for loading saves
+    /// </summary>
+    void SetDate(int _date) { date = _date; }
+
     double ToSecond() { return date * 60; }
     double ToDay() { return date / (float)1440.; }
 
@@ -0,0 +1,167 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/commands/commands.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/components/area.h"
+#include "common/components/event.h"
+#include "common/components/infrastructure.h"
+#include "common/components/name.h"
+#include "common/systems/actions/cityactions.h"
+#include "common/systems/actions/factoryconstructaction.h"
+#include "common/systems/actions/shiplaunchaction.h"
+#include "common/systems/economy/markethelpers.h"
+#include "common/systems/save/savearchive.h"
+
+namespace cqsp::common::systems::commands {
+namespace cqspc = cqsp::common::components;
+namespace cqspt = cqsp::common::components::types;
+
+namespace {
+constexpr char log_magic[4] = {'C', 'Q', 'L', 'G'};
+/// <summary>
+/// Increment this whenever a command or its fields change
+/// </summary>
+constexpr uint32_t log_version = 1;
+
+entt::entity Run(Game& game, const FoundCity& command) {
+    Universe& universe = game.GetUniverse();
+    entt::entity settlement =
+        cqsp::common::actions::CreateCity(universe, command.planet, command.latitude, command.longitude);
+    universe.emplace<cqspc::Name>(settlement, universe.name_generators["Town Names"].Generate("1"));
+    universe.emplace<cqspc::IndustrialZone>(settlement);
+    return settlement;
+}
+
+entt::entity Run(Game& game, const ConstructFactory& command) {
+    return actions::OrderConstructionFactory(game.GetUniverse(), command.city, command.market, command.recipe,
+                                             command.productivity, command.builder);
+}
+
+entt::entity Run(Game& game, const ConstructSpacePort& command) {
+    game.GetUniverse().get_or_emplace<cqspc::infrastructure::SpacePort>(command.city);
+    economy::ConnectCity(game.GetUniverse(), command.city);
+    return entt::null;
+}
+
+entt::entity Run(Game& game, const LaunchShip& command) {
+    cqspt::Orbit orbit = command.orbit;
+    return actions::LaunchShip(game.GetUniverse(), orbit);
+}
+
+entt::entity Run(Game& game, const AddImpulse& command) {
+    game.GetUniverse().get_or_emplace<cqspt::Impulse>(command.body).impulse += command.impulse;
+    return entt::null;
+}
+
+entt::entity Run(Game& game, const ChooseEventAction& command) {
+    auto* queue = game.GetUniverse().try_get<event::EventQueue>(command.entity);
+    if (queue == nullptr || queue->events.empty()) {
+        return entt::null;
+    }
+    std::shared_ptr<event::Event> front = queue->events.front();
+    if (command.action >= 0 && command.action < static_cast<int>(front->actions.size())) {
+        auto& result = front->actions[command.action];
+        if (result->has_event) {
+            sol::protected_function_result res = result->action(front->table);
+            game.GetScriptInterface().ParseResult(res);
+        }
+    }
+    queue->events.clear();
+    return entt::null;
+}
+}  // namespace
+
+template <class Archive>
+void Serialize(Archive& archive, CommandLog::Entry& entry) {
+    archive.Field(entry.tick);
+    archive.Field(entry.command);
+}
+
+entt::entity Execute(Game& game, const Command& command) {
+    return std::visit([&game](const auto& alternative) { return Run(game, alternative); }, command);
+}
+
+entt::entity Issue(Game& game, const Command& command) {
+    Universe& universe = game.GetUniverse();
+    if (auto* log = universe.ctx().find<CommandLog>(); log != nullptr) {
+        log->entries.push_back({universe.GetDate(), command});
+    }
+    return Execute(game, command);
+}
+
+bool WriteLog(const std::string& path, const CommandLog& log) {
+    std::vector<char> buffer;
+    save::OutputArchive archive(buffer);
+    archive.Write(log_magic, sizeof(log_magic));
+    archive.Field(log_version);
+    archive.Field(log.entries);
+    archive.Field(log.checksums);
+
+    std::filesystem::path file_path(path);
+    if (file_path.has_parent_path()) {
+        std::filesystem::create_directories(file_path.parent_path());
+    }
+    std::ofstream output(file_path, std::ios::binary);
+    output.write(buffer.data(), buffer.size());
+    if (!output.good()) {
+        SPDLOG_ERROR("Cannot write command log {}", path);
+        return false;
+    }
+    return true;
+}
+
+bool ReadLog(const std::string& path, CommandLog& log) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input.good()) {
+        SPDLOG_ERROR("Cannot open command log {}", path);
+        return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    save::InputArchive archive(buffer.data(), buffer.size());
+    char file_magic[4];
+    uint32_t file_version = 0;
+    archive.Read(file_magic, sizeof(file_magic));
+    archive.Field(file_version);
+    if (archive.Failed() || std::memcmp(file_magic, log_magic, sizeof(log_magic)) != 0) {
+        SPDLOG_ERROR("{} is not a command log", path);
+        return false;
+    }
+    if (file_version != log_version) {
+        SPDLOG_ERROR("Command log version {} is not supported, the current version is {}", file_version,
+                     log_version);
+        return false;
+    }
+    archive.Field(log.entries);
+    archive.Field(log.checksums);
+    if (archive.Failed() || !archive.AtEnd()) {
+        SPDLOG_ERROR("Command log {} is broken", path);
+        return false;
+    }
+    return true;
+}
+}  // namespace cqsp::common::systems::commands
@@ -0,0 +1,125 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <entt/entt.hpp>
+#include <glm/vec3.hpp>
+
+#include "common/components/coordinates.h"
+#include "common/game.h"
+
+namespace cqsp::common::systems::commands {
+// Everything that the player does to the universe goes through a command, so that a save and the commands
+// issued after it can play out the game again. Commands only hold plain values, the names and other values
+// that come from the random generator are made when the command is run.
+
+/// <summary>
+/// Founds a city on the planet, and names it with the town name generator
+/// </summary>
+struct FoundCity {
+    entt::entity planet = entt::null;
+    double latitude = 0;
+    double longitude = 0;
+};
+
+struct ConstructFactory {
+    entt::entity city = entt::null;
+    entt::entity market = entt::null;
+    entt::entity recipe = entt::null;
+    int productivity = 0;
+    /// <summary>
+    /// Who pays for the factory
+    /// </summary>
+    entt::entity builder = entt::null;
+};
+
+struct ConstructSpacePort {
+    entt::entity city = entt::null;
+};
+
+struct LaunchShip {
+    components::types::Orbit orbit;
+};
+
+/// <summary>
+/// Adds to the impulse of the body, which is applied on the next orbit update
+/// </summary>
+struct AddImpulse {
+    entt::entity body = entt::null;
+    glm::dvec3 impulse {0, 0, 0};
+};
+
+/// <summary>
+/// Runs the action of the event at the front of the event queue, and then clears the queue.
+/// </summary>
+struct ChooseEventAction {
+    entt::entity entity = entt::null;
+    /// <summary>
+    /// Index of the action in the event, or -1 to dismiss the event without doing anything
+    /// </summary>
+    int action = -1;
+};
+
+/// <summary>
+/// New commands have to be added to the end, because the index of the command is saved in the log.
+/// </summary>
+using Command = std::variant<FoundCity, ConstructFactory, ConstructSpacePort, LaunchShip, AddImpulse,
+                             ChooseEventAction>;
+
+/// <summary>
+/// The commands that were issued, in order, and the date that they were issued on. Commands are issued between
+/// ticks, so a command with the date `n` runs after tick `n` and before tick `n + 1`.
+/// <br>
+/// Recording is turned on by putting a log in the context of the universe.
+/// </summary>
+struct CommandLog {
+    struct Entry {
+        int tick;
+        Command command;
+    };
+
+    std::vector<Entry> entries;
+
+    /// <summary>
+    /// Checksums of the universe at some dates, so that a replay can tell the first date that it stopped
+    /// matching. They are taken at the end of the tick, before the commands of that date are run.
+    /// </summary>
+    std::map<int, uint64_t> checksums;
+};
+
+/// <summary>
+/// Runs the command without logging it. Use @ref Issue for commands from the player.
+/// </summary>
+/// <returns>The entity that the command created, or entt::null if it didn't create one</returns>
+entt::entity Execute(Game& game, const Command& command);
+
+/// <summary>
+/// Runs the command, and adds it to the command log if it's being recorded.
+/// </summary>
+/// <returns>The entity that the command created, or entt::null if it didn't create one</returns>
+entt::entity Issue(Game& game, const Command& command);
+
+bool WriteLog(const std::string& path, const CommandLog& log);
+/// <returns>If the log was read. If it wasn't, the log may be half read.</returns>
+bool ReadLog(const std::string& path, CommandLog& log);
+}  // namespace cqsp::common::systems::commands
@@ -0,0 +1,126 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/commands/replay.h"
+
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "common/systems/save/savegame.h"
+#include "common/util/paths.h"
+
+namespace cqsp::common::systems::commands {
+namespace {
+constexpr uint64_t fnv_offset = 14695981039346656037ULL;
+constexpr uint64_t fnv_prime = 1099511628211ULL;
+
+uint64_t Hash(uint64_t hash, const std::vector<char>& buffer) {
+    for (char c : buffer) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= fnv_prime;
+    }
+    return hash;
+}
+}  // namespace
+
+uint64_t Checksum(Universe& universe) {
+    ZoneScoped;
+    save::SaveData save = save::MakeSave(universe);
+    uint64_t hash = Hash(fnv_offset, save.state);
+    hash = Hash(hash, save.entities);
+    for (auto& [index, pool] : save.pools) {
+        hash ^= index;
+        hash *= fnv_prime;
+        hash = Hash(hash, pool);
+    }
+    return hash;
+}
+
+bool StartRecording(Universe& universe, const std::string& path) {
+    if (!save::SaveUniverse(universe, path)) {
+        return false;
+    }
+    CommandLog& log = universe.ctx().emplace<CommandLog>();
+    log.entries.clear();
+    log.checksums.clear();
+    log.checksums[universe.GetDate()] = Checksum(universe);
+    SPDLOG_INFO("Recording commands from date {}", universe.GetDate());
+    return true;
+}
+
+void RecordChecksum(Universe& universe) {
+    if (auto* log = universe.ctx().find<CommandLog>(); log != nullptr) {
+        log->checksums[universe.GetDate()] = Checksum(universe);
+    }
+}
+
+bool StopRecording(Universe& universe, const std::string& path) {
+    auto* log = universe.ctx().find<CommandLog>();
+    if (log == nullptr) {
+        return false;
+    }
+    bool written = WriteLog(GetLogPath(path), *log);
+    universe.ctx().erase<CommandLog>();
+    return written;
+}
+
+bool IsRecording(Universe& universe) { return universe.ctx().find<CommandLog>() != nullptr; }
+
+std::string GetLogPath(const std::string& path) { return path + ".log"; }
+
+std::string GetRecordingPath() {
+    return (std::filesystem::path(util::GetCqspSavePath()) / "saves" /
+            (std::string("recording") + save::save_extension))
+        .string();
+}
+
+ReplayResult Replay(Game& game, const CommandLog& log, int end_date, const std::function<void()>& tick) {
+    ZoneScoped;
+    Universe& universe = game.GetUniverse();
+    ReplayResult result;
+    auto entry = log.entries.begin();
+    while (entry != log.entries.end() && entry->tick < universe.GetDate()) {
+        SPDLOG_WARN("Skipping command from date {}, before the replay starts", entry->tick);
+        entry++;
+    }
+    while (true) {
+        int date = universe.GetDate();
+        if (auto checksum = log.checksums.find(date); checksum != log.checksums.end()) {
+            result.checked++;
+            if (!result.Desynced() && checksum->second != Checksum(universe)) {
+                SPDLOG_ERROR("Replay does not match the recording from date {}", date);
+                result.desync_date = date;
+            }
+        }
+        for (; entry != log.entries.end() && entry->tick == date; entry++) {
+            Execute(game, entry->command);
+        }
+        if (date >= end_date) {
+            break;
+        }
+        tick();
+    }
+    return result;
+}
+
+ReplayResult Replay(Game& game, simulation::Simulation& simulation, const CommandLog& log, int end_date) {
+    return Replay(game, log, end_date, [&simulation]() { simulation.tick(); });
+}
+}  // namespace cqsp::common::systems::commands
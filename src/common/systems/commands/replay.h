@@ -0,0 +1,85 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "common/game.h"
+#include "common/simulation.h"
+#include "common/systems/commands/commands.h"
+
+namespace cqsp::common::systems::commands {
+/// <summary>
+/// Hash of everything that a full save of the universe has. Two universes with the same checksum save the same.
+/// </summary>
+uint64_t Checksum(Universe& universe);
+
+/// <summary>
+/// Saves the universe to the path as the start of a recording, and starts logging the commands that are issued.
+/// </summary>
+bool StartRecording(Universe& universe, const std::string& path);
+
+/// <summary>
+/// Adds the checksum of the universe at the current date to the log, if the universe is being recorded.
+/// Call between ticks, before the commands of the tick are issued.
+/// </summary>
+void RecordChecksum(Universe& universe);
+
+/// <summary>
+/// Writes the log next to the save that the recording started from, and stops recording.
+/// </summary>
+bool StopRecording(Universe& universe, const std::string& path);
+
+bool IsRecording(Universe& universe);
+
+/// <summary>
+/// Path of the command log of a recording
+/// </summary>
+std::string GetLogPath(const std::string& path);
+
+/// <summary>
+/// Path of the recording, in the save folder
+/// </summary>
+std::string GetRecordingPath();
+
+struct ReplayResult {
+    /// <summary>
+    /// First date where the checksum of the universe didn't match the log, -1 if everything matched
+    /// </summary>
+    int desync_date = -1;
+    /// <summary>
+    /// Number of checksums that were compared
+    /// </summary>
+    int checked = 0;
+
+    bool Desynced() const { return desync_date >= 0; }
+};
+
+/// <summary>
+/// Plays the log on top of the universe until the end date, running the commands between the ticks that they
+/// were issued between. The universe should be loaded from the save that the recording started from, with
+/// @ref save::LoadUniverse, and the log with @ref ReadLog.
+/// <br>
+/// Replaying doesn't stop when the checksums stop matching, so that the replay can still be used to reproduce
+/// the performance of a game.
+/// </summary>
+/// <param name="tick">Runs one tick of the simulation</param>
+ReplayResult Replay(Game& game, const CommandLog& log, int end_date, const std::function<void()>& tick);
+ReplayResult Replay(Game& game, simulation::Simulation& simulation, const CommandLog& log, int end_date);
+}  // namespace cqsp::common::systems::commands
@@ -16,97 +16,127 @@
 */
 #include "common/systems/economy/auctionhandler.h"
 
-#include <spdlog/spdlog.h>
+#include <algorithm>
+
+#include <tracy/Tracy.hpp>
+
+#include "common/components/economy.h"
+#include "common/components/resource.h"
+#include "common/systems/save/savedcomponents.h"
 
 bool cqsp::common::systems::BuyGood(components::AuctionHouse& auction_house, entt::entity agent, entt::entity good,
-                                    double price, double quantity) {
-    // The orders we want to try and fufill
-    auto& sell_order_list = auction_house.sell_orders[good];
-    auto& buy_order_list = auction_house.buy_orders[good];
+                                    double price, double quantity, std::vector<components::Trade>& trades) {
+    return BuyGood(auction_house[good], agent, good, price, quantity, trades);
+}
 
-    // Check if goods are being sold
-    if (sell_order_list.empty()) {
-        // Then make new buy order
-        components::Order order(price, quantity, agent);
-        buy_order_list.put(order);
-        return false;
-    }
-    // Then pop the first in the list, and check if the price works
-    while (!sell_order_list.empty()) {
-        components::Order& first = sell_order_list.front();
-        // Then check if the price is right
-        if (first.price > price) {
-            break;
-        }
-        // Buy good, and fufill demand
-        if (first.quantity > quantity) {
-            first.quantity -= quantity;
-            quantity = 0;
-            // Also subtract wallet
-            // Thing done!
-            return true;
-        } else {
-            // remove order, remove quantity
-            quantity -= first.quantity;
-            // Remove buy order
-            sell_order_list.erase(sell_order_list.begin());
-        }
+bool cqsp::common::systems::BuyGood(components::OrderBook& book, entt::entity agent, entt::entity good,
+                                    double price, double quantity, std::vector<components::Trade>& trades) {
+    // Take the cheapest sell orders while the price works
+    while (quantity > 0 && !book.asks.empty() && book.asks.BestPrice() <= price) {
+        const components::Order& ask = book.asks.front();
+        const entt::entity seller = ask.agent;
+        const double ask_price = ask.price;
+        const double filled = book.asks.Fill(quantity);
+        trades.push_back({good, agent, seller, ask_price, filled});
+        quantity -= filled;
     }
 
     if (quantity <= 0) {
         return true;
     }
     // Then place a buy order because the order could not be fufulled.
-    components::Order order(price, quantity, agent);
-    buy_order_list.put(order);
+    book.bids.put(components::Order(price, quantity, agent));
     return false;
 }
 
 bool cqsp::common::systems::SellGood(components::AuctionHouse& auction_house, entt::entity agent, entt::entity good,
-                                     double price, double quantity) {
-    // The place we will put our order if we cannot fufill it
-    auto& sell_order_list = auction_house.sell_orders[good];
-
-    // The orders we want to try and fufill
-    auto& buy_order_list = auction_house.buy_orders[good];
+                                     double price, double quantity, std::vector<components::Trade>& trades) {
+    return SellGood(auction_house[good], agent, good, price, quantity, trades);
+}
 
-    // Check if goods are being sold
-    if (buy_order_list.empty()) {
-        // Then make new order
-        components::Order order(price, quantity, agent);
-        sell_order_list.put(order);
-        return false;
-    }
-    // Then pop the first in the list, and check if the price works
-    while (!buy_order_list.empty()) {
-        components::Order& first = buy_order_list.front();
-        // Then check if the price is right
-        if (first.price < price) {
-            break;
-        }
-        // Buy good, and fufill demand
-        if (first.quantity > quantity) {
-            first.quantity -= quantity;
-            quantity = 0;
-            // Also subtract wallet
-            // Thing done!
-            return true;
-        } else {
-            // remove order, remove quantity
-            quantity -= first.quantity;
-            // Remove buy order
-            buy_order_list.erase(buy_order_list.begin());
-            if (quantity == 0) {
-                break;
-            }
-        }
+bool cqsp::common::systems::SellGood(components::OrderBook& book, entt::entity agent, entt::entity good,
+                                     double price, double quantity, std::vector<components::Trade>& trades) {
+    // Fill the highest buy orders while the price works
+    while (quantity > 0 && !book.bids.empty() && book.bids.BestPrice() >= price) {
+        const components::Order& bid = book.bids.front();
+        const entt::entity buyer = bid.agent;
+        const double bid_price = bid.price;
+        const double filled = book.bids.Fill(quantity);
+        trades.push_back({good, buyer, agent, bid_price, filled});
+        quantity -= filled;
     }
 
     if (quantity <= 0) {
         return true;
     }
     // Then place a sell order because the order could not be fufulled.
-    components::Order order(price, quantity, agent);
-    sell_order_list.put(order);
+    book.asks.put(components::Order(price, quantity, agent));
     return false;
 }
+
+double cqsp::common::systems::ClearBook(components::OrderBook& book, entt::entity good,
+                                        std::vector<components::Trade>& trades) {
+    const size_t first = trades.size();
+    double bid_price = 0;
+    double ask_price = 0;
+    while (book.Crossed()) {
+        const components::Order& bid = book.bids.front();
+        const components::Order& ask = book.asks.front();
+        bid_price = bid.price;
+        ask_price = ask.price;
+        const double quantity = std::min(bid.quantity, ask.quantity);
+        trades.push_back({good, bid.agent, ask.agent, 0, quantity});
+        book.bids.Fill(quantity);
+        book.asks.Fill(quantity);
+    }
+
+    // Everything trades at the price of the last match, so that the order the orders were placed in
+    // doesn't decide who gets the better price
+    const double price = (bid_price + ask_price) / 2;
+    double volume = 0;
+    for (size_t i = first; i < trades.size(); i++) {
+        trades[i].price = price;
+        volume += trades[i].quantity;
+    }
+    book.volume = volume;
+    if (volume > 0) {
+        book.last_price = price;
+    }
+    return volume;
+}
+
+void cqsp::common::systems::ClearAuctionHouse(components::AuctionHouse& auction_house,
+                                              std::vector<components::Trade>& trades) {
+    for (auto& [good, book] : auction_house.books) {
+        ClearBook(book, good, trades);
+    }
+}
+
+void cqsp::common::systems::SettleTrades(Universe& universe, const std::vector<components::Trade>& trades) {
+    ZoneScoped;
+    if (trades.empty()) {
+        return;
+    }
+    for (const components::Trade& trade : trades) {
+        const double cost = trade.price * trade.quantity;
+        if (universe.valid(trade.buyer)) {
+            if (auto* wallet = universe.try_get<components::Wallet>(trade.buyer); wallet != nullptr) {
+                *wallet -= cost;
+                save::MarkDirty<components::Wallet>(universe, trade.buyer);
+            }
+            if (auto* stockpile = universe.try_get<components::ResourceStockpile>(trade.buyer); stockpile != nullptr) {
+                (*stockpile)[trade.good] += trade.quantity;
+            }
+        }
+        if (universe.valid(trade.seller)) {
+            if (auto* wallet = universe.try_get<components::Wallet>(trade.seller); wallet != nullptr) {
+                *wallet += cost;
+                save::MarkDirty<components::Wallet>(universe, trade.seller);
+            }
+            if (auto* stockpile = universe.try_get<components::ResourceStockpile>(trade.seller);
+                stockpile != nullptr) {
+                (*stockpile)[trade.good] -= trade.quantity;
+            }
+        }
+    }
+}
@@ -16,9 +16,12 @@
 */
 #pragma once
 
+#include <vector>
+
 #include <entt/entt.hpp>
 
 #include "common/components/auction.h"
+#include "common/universe.h"
 
 namespace cqsp {
 namespace common {
@@ -27,25 +30,61 @@ namespace systems {
 /// Buys a good from the market
 /// </summary>
 /// <param name="auction_house">Auction house to buy from</param>
+/// <param name="agent">Agent that is buying</param>
 /// <param name="good">Good to buy</param>
 /// <param name="price">Price</param>
 /// <param name="quantity">Quantity</param>
+/// <param name="trades">The sell orders that are taken are appended to this, at the price of the sell order</param>
 /// <returns>True if the order is fufilled immediately, false if a buy order is
 /// placed.</returns>
-bool BuyGood(components::AuctionHouse& auction_house, entt::entity good, entt::entity agent, double price,
-             double quantity);
+bool BuyGood(components::AuctionHouse& auction_house, entt::entity agent, entt::entity good, double price,
+             double quantity, std::vector<components::Trade>& trades);
+
+/// <summary>
+/// Buys a good from the order book of the good. Use this instead of looking up the book for every order
+/// when placing a lot of orders for the same good.
+/// </summary>
+bool BuyGood(components::OrderBook& book, entt::entity agent, entt::entity good, double price, double quantity,
+             std::vector<components::Trade>& trades);
 
 /// <summary>
 /// Sells a good to the market
 /// </summary>
-/// <param name="auction_house">Auction house to buy from</param>
-/// <param name="good">Good to buy</param>
+/// <param name="auction_house">Auction house to sell to</param>
+/// <param name="agent">Agent that is selling</param>
+/// <param name="good">Good to sell</param>
 /// <param name="price">Price</param>
 /// <param name="quantity">Quantity</param>
+/// <param name="trades">The buy orders that are filled are appended to this, at the price of the buy order</param>
 /// <returns>True if the order is fufilled immediately, false if a sell order is
 /// placed.</returns>
-bool SellGood(components::AuctionHouse& auction_house, entt::entity good, entt::entity agent, double price,
-              double quantity);
+bool SellGood(components::AuctionHouse& auction_house, entt::entity agent, entt::entity good, double price,
+              double quantity, std::vector<components::Trade>& trades);
+
+/// <summary>
+/// Sells a good to the order book of the good.
+/// </summary>
+bool SellGood(components::OrderBook& book, entt::entity agent, entt::entity good, double price, double quantity,
+              std::vector<components::Trade>& trades);
+
+/// <summary>
+/// Matches all the crossed orders in the book at a single price, halfway between the last bid and ask
+/// that were matched. Orders that aren't matched stay in the book.
+/// </summary>
+/// <param name="trades">Trades are appended to this</param>
+/// <returns>Quantity that was traded</returns>
+double ClearBook(components::OrderBook& book, entt::entity good, std::vector<components::Trade>& trades);
+
+/// <summary>
+/// Clears the book of every good in the auction house.
+/// </summary>
+void ClearAuctionHouse(components::AuctionHouse& auction_house, std::vector<components::Trade>& trades);
+
+/// <summary>
+/// Moves the money and goods of the trades between the wallets and stockpiles of the agents. Agents
+/// without a wallet or a stockpile are skipped for that part.
+/// </summary>
+void SettleTrades(Universe& universe, const std::vector<components::Trade>& trades);
 }  // namespace systems
 }  // namespace common
 }  // namespace cqsp
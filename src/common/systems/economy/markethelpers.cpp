@@ -16,14 +16,29 @@
 */
 #include "common/systems/economy/markethelpers.h"
 
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <tracy/Tracy.hpp>
+
+#include "common/components/auction.h"
+#include "common/components/coordinates.h"
 #include "common/components/economy.h"
 #include "common/components/history.h"
+#include "common/components/organizations.h"
+#include "common/components/surface.h"
+#include "common/systems/save/savedcomponents.h"
 
 void cqsp::common::systems::economy::AddParticipant(cqsp::common::Universe& universe, entt::entity market_entity,
                                                     entt::entity entity) {
     namespace cqspc = cqsp::common::components;
     auto& market = universe.get<cqspc::Market>(market_entity);
     market.participants.insert(entity);
+    save::MarkDirty<cqspc::Market>(universe);
     universe.emplace<cqspc::MarketAgent>(entity, market_entity);
     universe.get_or_emplace<cqspc::Wallet>(entity);
 }
@@ -36,6 +51,130 @@ double cqsp::common::systems::economy::GetCost(cqsp::common::Universe& universe,
     return universe.get<components::Market>(market).GetPrice(ledger);
 }
 
+entt::entity cqsp::common::systems::economy::AddTradeRoute(Universe& universe, entt::entity from, entt::entity to,
+                                                          double cost, double capacity,
+                                                          components::infrastructure::RouteType type) {
+    entt::entity route = universe.create();
+    universe.emplace<components::infrastructure::TradeRoute>(route, from, to, cost, capacity, type);
+    return route;
+}
+
+namespace {
+entt::entity GetCityMarket(cqsp::common::Universe& universe, entt::entity city) {
+    namespace cqspc = cqsp::common::components;
+    auto* governed = universe.try_get<cqspc::Governed>(city);
+    if (governed == nullptr || !universe.valid(governed->governor) ||
+        !universe.all_of<cqspc::Market>(governed->governor)) {
+        return entt::null;
+    }
+    return governed->governor;
+}
+
+double GetTransportCost(cqsp::common::Universe& universe, entt::entity city) {
+    auto* infrastructure = universe.try_get<cqsp::common::components::infrastructure::CityInfrastructure>(city);
+    return infrastructure == nullptr ? 0 : infrastructure->default_purchase_cost;
+}
+
+/// <summary>
+/// The cheapest transport cost of the cities of a market that have highways or space ports
+/// </summary>
+struct MarketReach {
+    /// <summary>
+    /// Cities with highways, by the planet that they are on
+    /// </summary>
+    std::map<entt::entity, double> highways;
+    double space_port = std::numeric_limits<double>::infinity();
+};
+
+/// <summary>
+/// Routes go both ways, so the markets are ordered
+/// </summary>
+using RouteKey = std::tuple<entt::entity, entt::entity, cqsp::common::components::infrastructure::RouteType>;
+
+RouteKey MakeRouteKey(entt::entity a, entt::entity b, cqsp::common::components::infrastructure::RouteType type) {
+    return (a < b) ? RouteKey(a, b, type) : RouteKey(b, a, type);
+}
+}  // namespace
+
+void cqsp::common::systems::economy::ConnectCity(Universe& universe, entt::entity city) {
+    ConnectCities(universe, {city});
+}
+
+void cqsp::common::systems::economy::ConnectCities(Universe& universe, const std::vector<entt::entity>& cities) {
+    ZoneScoped;
+    namespace cqspc = cqsp::common::components;
+    namespace infrastructure = cqsp::common::components::infrastructure;
+    constexpr double unreachable = std::numeric_limits<double>::infinity();
+
+    // Routes link markets, so only the cheapest city of each market matters
+    std::map<entt::entity, MarketReach> reach;
+    for (entt::entity city : universe.view<cqspc::Settlement>()) {
+        const entt::entity market = GetCityMarket(universe, city);
+        const bool highway = universe.all_of<infrastructure::Highway>(city);
+        const bool space_port = universe.all_of<infrastructure::SpacePort>(city);
+        if (market == entt::null || (!highway && !space_port)) {
+            continue;
+        }
+        MarketReach& market_reach = reach[market];
+        const double cost = GetTransportCost(universe, city);
+        auto* coordinate = universe.try_get<cqspc::types::SurfaceCoordinate>(city);
+        if (highway && coordinate != nullptr && coordinate->planet != entt::null) {
+            auto [it, inserted] = market_reach.highways.try_emplace(coordinate->planet, cost);
+            it->second = std::min(it->second, cost);
+        }
+        if (space_port) {
+            market_reach.space_port = std::min(market_reach.space_port, cost);
+        }
+    }
+
+    std::set<entt::entity> markets;
+    for (entt::entity city : cities) {
+        const entt::entity market = GetCityMarket(universe, city);
+        if (reach.contains(market)) {
+            markets.insert(market);
+        }
+    }
+    if (markets.empty()) {
+        return;
+    }
+
+    std::set<RouteKey> routes;
+    for (auto [entity, route] : universe.view<infrastructure::TradeRoute>().each()) {
+        routes.insert(MakeRouteKey(route.from, route.to, route.type));
+    }
+    auto connect = [&](entt::entity from, entt::entity to, infrastructure::RouteType type, double cost,
+                       double capacity) {
+        if (routes.insert(MakeRouteKey(from, to, type)).second) {
+            AddTradeRoute(universe, from, to, cost, capacity, type);
+        }
+    };
+
+    for (entt::entity market : markets) {
+        const MarketReach& from = reach[market];
+        for (const auto& [other_market, to] : reach) {
+            // Cities of the same country already share a market
+            if (other_market == market) {
+                continue;
+            }
+            // Highways go over the cheapest planet that both markets have highways on
+            double highway_cost = unreachable;
+            for (const auto& [planet, cost] : from.highways) {
+                auto it = to.highways.find(planet);
+                if (it != to.highways.end()) {
+                    highway_cost = std::min(highway_cost, cost + it->second);
+                }
+            }
+            if (highway_cost != unreachable) {
+                connect(market, other_market, infrastructure::RouteType::Highway, highway_cost, highway_capacity);
+            }
+            if (from.space_port != unreachable && to.space_port != unreachable) {
+                connect(market, other_market, infrastructure::RouteType::SpacePort,
+                        from.space_port + to.space_port + launch_cost, space_port_capacity);
+            }
+        }
+    }
+}
+
 entt::entity cqsp::common::systems::economy::CreateMarket(Universe& universe) {
     entt::entity market = universe.create();
     CreateMarket(universe, market);
@@ -45,6 +184,7 @@ entt::entity cqsp::common::systems::economy::CreateMarket(Universe& universe) {
 void cqsp::common::systems::economy::CreateMarket(Universe& universe, entt::entity market) {
     universe.get_or_emplace<components::Market>(market);
     universe.get_or_emplace<components::MarketHistory>(market);
+    universe.get_or_emplace<components::AuctionHouse>(market);
 }
 
 bool cqsp::common::systems::economy::PurchaseGood(Universe& universe, entt::entity agent,
@@ -70,6 +210,8 @@ bool cqsp::common::systems::economy::PurchaseGood(Universe& universe, entt::enti
     }
 
     // Then agent has enough money to buy
+    save::MarkDirty<components::Market>(universe);
+    save::MarkDirty<components::Wallet>(universe);
     market_comp.AddDemand(purchase);
     if (universe.all_of<components::ResourceStockpile>(agent)) {
         universe.get<components::ResourceStockpile>(agent) += purchase;
@@ -85,6 +227,8 @@ bool cqsp::common::systems::economy::SellGood(Universe& universe, entt::entity a
     entt::entity market = universe.get<components::MarketAgent>(agent).market;
     auto& market_comp = universe.get<components::Market>(market);
     auto& agent_stockpile = universe.get<components::ResourceStockpile>(agent);
+    save::MarkDirty<components::Market>(universe);
+    save::MarkDirty<components::Wallet>(universe);
     market_comp.AddSupply(selling);
 
     // Remove from stockpile
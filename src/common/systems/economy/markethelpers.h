@@ -16,8 +16,11 @@
 */
 #pragma once
 
+#include <vector>
+
 #include <entt/entt.hpp>
 
+#include "common/components/infrastructure.h"
 #include "common/components/resource.h"
 #include "common/universe.h"
 
@@ -46,6 +49,44 @@ bool SellGood(Universe& universe, entt::entity agent, components::ResourceLedger
 void AddParticipant(cqsp::common::Universe& universe, entt::entity market, entt::entity entity);
 
 double GetCost(cqsp::common::Universe& universe, entt::entity market, components::ResourceLedger ledger);
+
+/// <summary>
+/// Links two markets with a trade route, so that goods can be traded between them.
+/// </summary>
+/// <param name="cost">Cost to move a unit of goods over the route</param>
+/// <param name="capacity">Units of goods that can be moved over the route per day</param>
+/// <returns>The route</returns>
+entt::entity AddTradeRoute(Universe& universe, entt::entity from, entt::entity to, double cost, double capacity,
+                           components::infrastructure::RouteType type);
+
+/// <summary>
+/// Units of goods that a highway between two markets can move per day
+/// </summary>
+constexpr double highway_capacity = 1000000;
+/// <summary>
+/// Units of goods that the space ports of two markets can move between them per day
+/// </summary>
+constexpr double space_port_capacity = 10000;
+/// <summary>
+/// Cost to launch a unit of goods, on top of the transport costs of the cities
+/// </summary>
+constexpr double launch_cost = 1;
+
+/// <summary>
+/// Links the markets of the countries that govern the cities to the markets that they can reach, over highways
+/// to markets with highways on the same planet, and through space ports to other markets with space ports.
+/// Routes link markets, so each pair of markets gets at most one route of each type, which costs the transport
+/// costs of the cheapest cities of both markets that have the infrastructure. Routes that already link the
+/// markets aren't added again.
+/// <br>
+/// Connect all the cities that were added at once, every call looks at every city and route.
+/// </summary>
+void ConnectCities(Universe& universe, const std::vector<entt::entity>& cities);
+
+/// <summary>
+/// Connects a single city, see @ref ConnectCities
+/// </summary>
+void ConnectCity(Universe& universe, entt::entity city);
 }  // namespace economy
 }  // namespace systems
 }  // namespace common
@@ -0,0 +1,127 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/economy/marketsolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <tracy/Tracy.hpp>
+
+namespace cqsp::common::systems {
+void MarketSolver::SetGoods(std::vector<entt::entity> new_goods) {
+    std::sort(new_goods.begin(), new_goods.end());
+    std::vector<double> new_supply_elasticity(new_goods.size(), default_supply_elasticity);
+    std::vector<double> new_demand_elasticity(new_goods.size(), default_demand_elasticity);
+    for (size_t i = 0; i < new_goods.size(); i++) {
+        auto it = std::lower_bound(goods.begin(), goods.end(), new_goods[i]);
+        if (it != goods.end() && *it == new_goods[i]) {
+            new_supply_elasticity[i] = supply_elasticity[it - goods.begin()];
+            new_demand_elasticity[i] = demand_elasticity[it - goods.begin()];
+        }
+    }
+    goods = std::move(new_goods);
+    supply_elasticity = std::move(new_supply_elasticity);
+    demand_elasticity = std::move(new_demand_elasticity);
+    exponents.resize(goods.size());
+    for (size_t i = 0; i < goods.size(); i++) {
+        exponents[i] = 1 / (supply_elasticity[i] + demand_elasticity[i]);
+    }
+    Clear();
+}
+
+void MarketSolver::SetElasticity(entt::entity good, double supply, double demand) {
+    auto it = std::lower_bound(goods.begin(), goods.end(), good);
+    if (it == goods.end() || *it != good || supply + demand <= 0) {
+        return;
+    }
+    size_t index = it - goods.begin();
+    supply_elasticity[index] = supply;
+    demand_elasticity[index] = demand;
+    exponents[index] = 1 / (supply + demand);
+}
+
+void MarketSolver::Clear() {
+    rows = 0;
+    supply.clear();
+    demand.clear();
+    prices.clear();
+}
+
+size_t MarketSolver::AddMarket(const components::ResourceLedger& market_supply,
+                               const components::ResourceLedger& market_demand,
+                               const components::ResourceLedger& market_price) {
+    const size_t offset = rows * goods.size();
+    supply.resize(offset + goods.size(), 0);
+    demand.resize(offset + goods.size(), 0);
+    prices.resize(offset + goods.size(), 0);
+    Gather(market_supply, supply.data() + offset);
+    Gather(market_demand, demand.data() + offset);
+    Gather(market_price, prices.data() + offset);
+    return rows++;
+}
+
+void MarketSolver::Gather(const components::ResourceLedger& ledger, double* row) const {
+    auto good = goods.begin();
+    for (auto it = ledger.begin(); it != ledger.end() && good != goods.end(); it++) {
+        good = std::lower_bound(good, goods.end(), it->first);
+        if (good != goods.end() && *good == it->first) {
+            row[good - goods.begin()] = it->second;
+        }
+    }
+}
+
+void MarketSolver::Solve() {
+    ZoneScoped;
+    const size_t columns = goods.size();
+    constexpr double min_step = 1 / max_step;
+    for (size_t row = 0; row < rows; row++) {
+        const double* row_supply = supply.data() + row * columns;
+        const double* row_demand = demand.data() + row * columns;
+        double* row_price = prices.data() + row * columns;
+        for (size_t i = 0; i < columns; i++) {
+            const double s = row_supply[i];
+            const double d = row_demand[i];
+            double step = 1;
+            if (s > 0 && d > 0) {
+                step = std::pow(d / s, exponents[i]);
+            } else if (d > 0) {
+                step = max_step;
+            } else if (s > 0) {
+                step = min_step;
+            }
+            step = std::clamp(step, min_step, max_step);
+            row_price[i] = std::max(row_price[i] * step, min_price);
+        }
+    }
+}
+
+void MarketSolver::WritePrices(size_t row, components::ResourceLedger& price) const {
+    const double* row_price = prices.data() + row * goods.size();
+    auto it = price.begin();
+    for (size_t i = 0; i < goods.size(); i++) {
+        while (it != price.end() && it->first < goods[i]) {
+            it++;
+        }
+        if (it != price.end() && it->first == goods[i]) {
+            it->second = row_price[i];
+        } else {
+            price[goods[i]] = row_price[i];
+        }
+    }
+}
+}  // namespace cqsp::common::systems
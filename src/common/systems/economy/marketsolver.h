@@ -0,0 +1,104 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "common/components/resource.h"
+
+namespace cqsp::common::systems {
+/// <summary>
+/// Solves the price of every good in every market at once.
+/// <br>
+/// The supply and demand ledgers of the markets are copied into flat arrays with a row per market and a
+/// column per good, and every price is stepped in a single pass over the arrays.
+/// <br>
+/// Supply and demand are taken to have constant elasticity around the current price, so the excess demand
+/// ln(D / S) is linear in ln(price), and one Newton step on it lands on the price that clears the market:
+/// <br>
+/// price * (D / S) ^ (1 / (supply elasticity + demand elasticity))
+/// </summary>
+class MarketSolver {
+ public:
+    static constexpr double default_supply_elasticity = 0.5;
+    static constexpr double default_demand_elasticity = 1.0;
+    /// <summary>
+    /// The most that a price can be multiplied or divided by in one step, so that goods that are not
+    /// supplied or demanded at all don't jump to infinity or zero.
+    /// </summary>
+    static constexpr double max_step = 4;
+    static constexpr double min_price = 0.00001;
+
+    /// <summary>
+    /// Sets the goods that are priced. Elasticities of goods that were already set are kept.
+    /// </summary>
+    void SetGoods(std::vector<entt::entity> goods);
+
+    void SetElasticity(entt::entity good, double supply, double demand);
+
+    const std::vector<entt::entity>& GetGoods() const { return goods; }
+
+    /// <summary>
+    /// Starts a new batch of markets.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Adds a market to the batch
+    /// </summary>
+    /// <returns>The row of the market</returns>
+    size_t AddMarket(const components::ResourceLedger& supply, const components::ResourceLedger& demand,
+                     const components::ResourceLedger& price);
+
+    /// <summary>
+    /// Steps the prices of every market in the batch.
+    /// </summary>
+    void Solve();
+
+    /// <summary>
+    /// Writes the solved prices of a row into a price ledger.
+    /// </summary>
+    void WritePrices(size_t row, components::ResourceLedger& price) const;
+
+    double GetPrice(size_t row, size_t good) const { return prices[row * goods.size() + good]; }
+
+ private:
+    /// <summary>
+    /// Copies a ledger into a row. Both the ledger and the goods are sorted by entity, so this is a single
+    /// pass over both instead of a lookup per good.
+    /// </summary>
+    void Gather(const components::ResourceLedger& ledger, double* row) const;
+
+    /// <summary>
+    /// Sorted by entity
+    /// </summary>
+    std::vector<entt::entity> goods;
+    /// <summary>
+    /// 1 / (supply elasticity + demand elasticity) of every good
+    /// </summary>
+    std::vector<double> exponents;
+    std::vector<double> supply_elasticity;
+    std::vector<double> demand_elasticity;
+
+    size_t rows = 0;
+    std::vector<double> supply;
+    std::vector<double> demand;
+    std::vector<double> prices;
+};
+}  // namespace cqsp::common::systems
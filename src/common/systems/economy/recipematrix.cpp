@@ -0,0 +1,267 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/economy/recipematrix.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include <tracy/Tracy.hpp>
+
+namespace cqsp::common::systems {
+using components::Recipe;
+
+RecipeMatrix::RecipeMatrix(Universe& _universe) : universe(_universe) {
+    universe.on_construct<Recipe>().connect<&RecipeMatrix::OnChange>(*this);
+    universe.on_update<Recipe>().connect<&RecipeMatrix::OnChange>(*this);
+    universe.on_destroy<Recipe>().connect<&RecipeMatrix::OnChange>(*this);
+}
+
+RecipeMatrix::~RecipeMatrix() {
+    universe.on_construct<Recipe>().disconnect(this);
+    universe.on_update<Recipe>().disconnect(this);
+    universe.on_destroy<Recipe>().disconnect(this);
+}
+
+void RecipeMatrix::OnChange(entt::registry&, entt::entity) { compiled = false; }
+
+bool RecipeMatrix::Update() {
+    if (compiled) {
+        return false;
+    }
+    Compile();
+    compiled = true;
+    return true;
+}
+
+int RecipeMatrix::GoodIndex(entt::entity good) const {
+    auto it = good_index.find(good);
+    return it == good_index.end() ? -1 : it->second;
+}
+
+int RecipeMatrix::RecipeIndex(entt::entity recipe) const {
+    auto it = recipe_index.find(recipe);
+    return it == recipe_index.end() ? -1 : it->second;
+}
+
+void RecipeMatrix::Compile() {
+    ZoneScoped;
+    recipes.clear();
+    goods.clear();
+    for (auto [entity, recipe] : universe.view<Recipe>().each()) {
+        if (!universe.valid(recipe.output.entity)) {
+            continue;
+        }
+        recipes.push_back(entity);
+        goods.push_back(recipe.output.entity);
+        for (const auto& [good, amount] : recipe.input) {
+            goods.push_back(good);
+        }
+        for (const auto& [good, amount] : recipe.capitalcost) {
+            goods.push_back(good);
+        }
+    }
+    std::sort(recipes.begin(), recipes.end());
+    std::sort(goods.begin(), goods.end());
+    goods.erase(std::unique(goods.begin(), goods.end()), goods.end());
+
+    good_index.clear();
+    for (size_t i = 0; i < goods.size(); i++) {
+        good_index[goods[i]] = static_cast<int>(i);
+    }
+    recipe_index.clear();
+    for (size_t i = 0; i < recipes.size(); i++) {
+        recipe_index[recipes[i]] = static_cast<int>(i);
+    }
+
+    const size_t good_count = goods.size();
+    input_matrix.assign(good_count * recipes.size(), 0);
+    capital_matrix.assign(good_count * recipes.size(), 0);
+    output_matrix.assign(good_count * recipes.size(), 0);
+    columns.assign(recipes.size(), {});
+    producer.assign(good_count, -1);
+    for (size_t r = 0; r < recipes.size(); r++) {
+        const Recipe& recipe = universe.get<Recipe>(recipes[r]);
+        Column& column = columns[r];
+        column.input_sum = 0;
+        column.capital_sum = 0;
+        for (const auto& [good, amount] : recipe.input) {
+            const size_t g = good_index[good];
+            input_matrix[r * good_count + g] = amount;
+            column.inputs.push_back({g, amount});
+            column.input_sum += amount;
+        }
+        for (const auto& [good, amount] : recipe.capitalcost) {
+            const size_t g = good_index[good];
+            capital_matrix[r * good_count + g] = amount;
+            column.capital.push_back({g, amount});
+            column.capital_sum += amount;
+        }
+        column.output = good_index[recipe.output.entity];
+        column.output_amount = recipe.output.amount;
+        column.workers = recipe.workers;
+        output_matrix[r * good_count + column.output] = recipe.output.amount;
+        if (producer[column.output] < 0 && recipe.output.amount > 0) {
+            producer[column.output] = static_cast<int>(r);
+        }
+    }
+
+    // Depth first over the producers, so that the inputs of a good are done before it. Reversing
+    // that puts every good before its inputs.
+    plan_order.clear();
+    std::vector<char> visited(good_count, false);
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t start = 0; start < good_count; start++) {
+        if (visited[start]) {
+            continue;
+        }
+        visited[start] = true;
+        stack.emplace_back(start, 0);
+        while (!stack.empty()) {
+            auto& [good, next] = stack.back();
+            const std::vector<Entry>* inputs = (producer[good] < 0) ? nullptr : &columns[producer[good]].inputs;
+            if (inputs != nullptr && next < inputs->size()) {
+                const size_t input = (*inputs)[next++].good;
+                if (!visited[input]) {
+                    visited[input] = true;
+                    stack.emplace_back(input, 0);
+                }
+                continue;
+            }
+            plan_order.push_back(good);
+            stack.pop_back();
+        }
+    }
+    std::reverse(plan_order.begin(), plan_order.end());
+    SPDLOG_INFO("Compiled {} recipes over {} goods", recipes.size(), goods.size());
+}
+
+std::vector<double> RecipeMatrix::Gather(const components::ResourceLedger& ledger) const {
+    std::vector<double> values(goods.size(), 0);
+    auto good = goods.begin();
+    for (auto it = ledger.begin(); it != ledger.end() && good != goods.end(); it++) {
+        good = std::lower_bound(good, goods.end(), it->first);
+        if (good != goods.end() && *good == it->first) {
+            values[good - goods.begin()] = it->second;
+        }
+    }
+    return values;
+}
+
+void RecipeMatrix::AddTo(const std::vector<double>& values, components::ResourceLedger& ledger) const {
+    for (size_t g = 0; g < goods.size(); g++) {
+        if (values[g] != 0) {
+            ledger[goods[g]] += values[g];
+        }
+    }
+}
+
+void RecipeMatrix::MinOfInputs(const std::vector<double>& values, std::vector<double>& input_min,
+                               std::vector<double>& capital_min) const {
+    input_min.resize(columns.size());
+    capital_min.resize(columns.size());
+    for (size_t r = 0; r < columns.size(); r++) {
+        double capital = std::numeric_limits<double>::infinity();
+        for (const Entry& entry : columns[r].capital) {
+            capital = std::min(capital, values[entry.good]);
+        }
+        double input = capital;
+        for (const Entry& entry : columns[r].inputs) {
+            input = std::min(input, values[entry.good]);
+        }
+        input_min[r] = columns[r].inputs.empty() && columns[r].capital.empty() ? 1 : input;
+        capital_min[r] = columns[r].capital.empty() ? 1 : capital;
+    }
+}
+
+std::vector<double> RecipeMatrix::InputCost(const std::vector<double>& prices) const {
+    std::vector<double> cost(columns.size(), 0);
+    for (size_t r = 0; r < columns.size(); r++) {
+        for (const Entry& entry : columns[r].inputs) {
+            cost[r] += entry.amount * prices[entry.good];
+        }
+    }
+    return cost;
+}
+
+std::vector<double> RecipeMatrix::Consumption(const std::vector<double>& activity, double capital_scale) const {
+    std::vector<double> consumption(goods.size(), 0);
+    for (size_t r = 0; r < columns.size(); r++) {
+        if (activity[r] == 0) {
+            continue;
+        }
+        for (const Entry& entry : columns[r].inputs) {
+            consumption[entry.good] += entry.amount * activity[r];
+        }
+        for (const Entry& entry : columns[r].capital) {
+            consumption[entry.good] += entry.amount * capital_scale * activity[r];
+        }
+    }
+    return consumption;
+}
+
+std::vector<double> RecipeMatrix::Production(const std::vector<double>& activity) const {
+    std::vector<double> production(goods.size(), 0);
+    for (size_t r = 0; r < columns.size(); r++) {
+        production[columns[r].output] += columns[r].output_amount * activity[r];
+    }
+    return production;
+}
+
+ProductionPlan RecipeMatrix::Plan(entt::entity good, double amount) const {
+    ProductionPlan plan;
+    const int target = GoodIndex(good);
+    if (target < 0 || producer[target] < 0) {
+        plan.raw[good] = amount;
+        return plan;
+    }
+
+    std::vector<double> needed(goods.size(), 0);
+    std::vector<size_t> position(goods.size());
+    for (size_t i = 0; i < plan_order.size(); i++) {
+        position[plan_order[i]] = i;
+    }
+    needed[target] = amount;
+    for (size_t i = position[target]; i < plan_order.size(); i++) {
+        const size_t g = plan_order[i];
+        if (needed[g] <= 0) {
+            continue;
+        }
+        if (producer[g] < 0) {
+            plan.raw[goods[g]] += needed[g];
+            continue;
+        }
+        const size_t r = producer[g];
+        const double size = needed[g] / columns[r].output_amount;
+        plan.recipes[recipes[r]] += size;
+        for (const Entry& entry : columns[r].inputs) {
+            if (position[entry.good] <= i) {
+                // The good is needed to make itself, so the loop has to be started from outside
+                plan.raw[goods[entry.good]] += entry.amount * size;
+            } else {
+                needed[entry.good] += entry.amount * size;
+            }
+        }
+        for (const Entry& entry : columns[r].capital) {
+            plan.capital[goods[entry.good]] += entry.amount * size;
+        }
+    }
+    return plan;
+}
+}  // namespace cqsp::common::systems
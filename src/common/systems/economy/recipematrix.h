@@ -0,0 +1,175 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "common/components/resource.h"
+#include "common/universe.h"
+
+namespace cqsp::common::systems {
+/// <summary>
+/// What it takes to make an amount of a good
+/// </summary>
+struct ProductionPlan {
+    /// <summary>
+    /// Size that each recipe has to run at
+    /// </summary>
+    std::map<entt::entity, double> recipes;
+    /// <summary>
+    /// Goods that no recipe makes, so they have to be mined, grown or bought
+    /// </summary>
+    components::ResourceLedger raw;
+    /// <summary>
+    /// Capital goods that the factories of the recipes need
+    /// </summary>
+    components::ResourceLedger capital;
+};
+
+/// <summary>
+/// Every recipe compiled into goods by recipes matrices of their inputs, capital costs and outputs, per unit of
+/// industry size.
+/// <br>
+/// The matrices are dense so that any entry can be looked up, and every recipe also keeps its inputs as a sparse
+/// column, which is what the products over all recipes use.
+/// <br>
+/// Recipes only change when they are loaded, so the matrices are compiled again on the next update after a recipe
+/// is added, patched or removed.
+/// </summary>
+class RecipeMatrix {
+ public:
+    explicit RecipeMatrix(Universe& universe);
+    ~RecipeMatrix();
+
+    RecipeMatrix(const RecipeMatrix&) = delete;
+    RecipeMatrix& operator=(const RecipeMatrix&) = delete;
+
+    /// <summary>
+    /// Compiles the recipes again if they changed.
+    /// </summary>
+    /// <returns>If the recipes were compiled</returns>
+    bool Update();
+
+    size_t GoodCount() const { return goods.size(); }
+    size_t RecipeCount() const { return recipes.size(); }
+
+    entt::entity GetGood(size_t good) const { return goods[good]; }
+    entt::entity GetRecipe(size_t recipe) const { return recipes[recipe]; }
+
+    /// <summary>
+    /// Index of the good, or -1 if no recipe uses or makes it
+    /// </summary>
+    int GoodIndex(entt::entity good) const;
+    int RecipeIndex(entt::entity recipe) const;
+
+    double Input(size_t good, size_t recipe) const { return input_matrix[recipe * goods.size() + good]; }
+    double Capital(size_t good, size_t recipe) const { return capital_matrix[recipe * goods.size() + good]; }
+    double Output(size_t good, size_t recipe) const { return output_matrix[recipe * goods.size() + good]; }
+
+    /// <summary>
+    /// Index of the good that the recipe makes
+    /// </summary>
+    size_t OutputGood(size_t recipe) const { return columns[recipe].output; }
+    double OutputAmount(size_t recipe) const { return columns[recipe].output_amount; }
+    double InputSum(size_t recipe) const { return columns[recipe].input_sum; }
+    double CapitalSum(size_t recipe) const { return columns[recipe].capital_sum; }
+    double Workers(size_t recipe) const { return columns[recipe].workers; }
+
+    /// <summary>
+    /// Copies a ledger into a vector with an element for every good
+    /// </summary>
+    std::vector<double> Gather(const components::ResourceLedger& ledger) const;
+
+    /// <summary>
+    /// Adds the non zero elements of a vector of goods to a ledger
+    /// </summary>
+    void AddTo(const std::vector<double>& values, components::ResourceLedger& ledger) const;
+
+    /// <summary>
+    /// The smallest value of the inputs and capital of every recipe, and the smallest value of only the capital.
+    /// Recipes without inputs or capital get 1.
+    /// </summary>
+    void MinOfInputs(const std::vector<double>& values, std::vector<double>& input_min,
+                     std::vector<double>& capital_min) const;
+
+    /// <summary>
+    /// Cost of the inputs of every recipe for a unit of size
+    /// </summary>
+    std::vector<double> InputCost(const std::vector<double>& prices) const;
+
+    /// <summary>
+    /// Goods that the recipes consume when they run at the activities, with capital_scale of their capital
+    /// </summary>
+    std::vector<double> Consumption(const std::vector<double>& activity, double capital_scale) const;
+
+    /// <summary>
+    /// Goods that the recipes make when they run at the activities
+    /// </summary>
+    std::vector<double> Production(const std::vector<double>& activity) const;
+
+    /// <summary>
+    /// Finds the recipes that make a good, and what they need, all the way down to the goods that no recipe
+    /// makes. When more than one recipe makes a good, the first one that was loaded is used. Goods that are
+    /// needed to make themselves are counted as raw goods.
+    /// </summary>
+    ProductionPlan Plan(entt::entity good, double amount) const;
+
+ private:
+    struct Entry {
+        size_t good;
+        double amount;
+    };
+
+    struct Column {
+        std::vector<Entry> inputs;
+        std::vector<Entry> capital;
+        size_t output;
+        double output_amount;
+        double input_sum;
+        double capital_sum;
+        double workers;
+    };
+
+    void OnChange(entt::registry&, entt::entity recipe);
+    void Compile();
+
+    Universe& universe;
+    bool compiled = false;
+
+    std::vector<entt::entity> goods;
+    std::map<entt::entity, int> good_index;
+    std::vector<entt::entity> recipes;
+    std::map<entt::entity, int> recipe_index;
+
+    std::vector<double> input_matrix;
+    std::vector<double> capital_matrix;
+    std::vector<double> output_matrix;
+    std::vector<Column> columns;
+
+    /// <summary>
+    /// The recipe that is used to make each good, -1 if no recipe makes it
+    /// </summary>
+    std::vector<int> producer;
+    /// <summary>
+    /// Goods ordered so that every good comes before the inputs of its producer, ignoring cycles
+    /// </summary>
+    std::vector<size_t> plan_order;
+};
+}  // namespace cqsp::common::systems
@@ -16,60 +16,19 @@
 */
 #include "common/systems/economy/sysagent.h"
 
-#include "common/components/economy.h"
-#include "common/systems/economy/markethelpers.h"
+#include <vector>
 
-void cqsp::common::systems::SysAgent::DoSystem() {
-    /*
-    auto view = GetUniverse().view<cqsp::common::components::MarketAgent>();
-    for (entt::entity entity : view) {
-        // Sell resources that agents produced
-        double production_multiplier = 1;
-        if (GetUniverse().any_of<components::FactoryProductivity>(entity)) {
-            auto& prod = GetUniverse().get<components::FactoryProductivity>(entity);
-            production_multiplier = prod.current_production;
-        }
-        components::ResourceLedger selling;
-        
-        if (GetUniverse().all_of<components::ResourceGenerator>(entity)) {
-            auto& gen = GetUniverse().get<components::ResourceGenerator>(entity);
-            selling.MultiplyAdd(gen, production_multiplier);
-        }
-        
-
-        // Recipe things
-        auto resource_converter = GetUniverse().try_get<components::ResourceConverter>(entity);
-        components::Recipe* recipe = nullptr;
-        if (resource_converter != nullptr && GetUniverse().all_of<components::FactoryProducing>(entity)) {
-            recipe = GetUniverse().try_get<components::Recipe>(resource_converter->recipe);
-            // Sell the recipe production
-            selling.MultiplyAdd(recipe->output, production_multiplier);
-            GetUniverse().remove<components::FactoryProducing>(entity);
-        }
-        if (!selling.empty()) {
-            economy::SellGood(GetUniverse(), entity, selling);
-        }
+#include <tracy/Tracy.hpp>
 
-        // Buy the resources that they produced
-        components::ResourceLedger buying;
-        if (GetUniverse().all_of<components::ResourceConsumption>(entity)) {
-            auto& gen = GetUniverse().get<components::ResourceConsumption>(entity);
-            buying.MultiplyAdd(gen, production_multiplier);
-        }
+#include "common/components/auction.h"
+#include "common/systems/economy/auctionhandler.h"
 
-        if (resource_converter != nullptr && recipe != nullptr) {
-            // Sell the recipe production
-            buying.MultiplyAdd(recipe->input, production_multiplier);
-        }
-        // Check if they buy or sell the goods, if they cannot achieve that,
-        // then deal with it
-        if (buying.empty()) {
-            continue;
-        }
-        bool success = economy::PurchaseGood(GetUniverse(), entity, buying);
-        if (success) {
-            GetUniverse().emplace_or_replace<components::FactoryProducing>(entity);
-        }
+void cqsp::common::systems::SysAgent::DoSystem() {
+    ZoneScoped;
+    Universe& universe = GetUniverse();
+    std::vector<components::Trade> trades;
+    for (entt::entity market : universe.view<components::AuctionHouse>()) {
+        ClearAuctionHouse(universe.get<components::AuctionHouse>(market), trades);
     }
-    */
+    SettleTrades(universe, trades);
 }
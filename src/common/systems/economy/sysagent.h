@@ -19,6 +19,12 @@
 #include "common/systems/isimulationsystem.h"
 
 namespace cqsp::common::systems {
+/// <summary>
+/// Clears the order books of every market with an auction house once per tick, and settles the trades
+/// between the agents. Orders placed during the tick are matched together at the end of it.
+/// <br>
+/// Every market gets an auction house when it is created, or when the markets are initialized.
+/// </summary>
 class SysAgent : public ISimulationSystem {
  public:
     explicit SysAgent(Game& game) : ISimulationSystem(game) {}
@@ -16,6 +16,10 @@
 */
 #include "common/systems/economy/sysfactory.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <spdlog/spdlog.h>
 
 #include <tracy/Tracy.hpp>
@@ -26,19 +30,65 @@
 #include "common/components/name.h"
 #include "common/components/organizations.h"
 #include "common/components/surface.h"
+#include "common/systems/save/savedcomponents.h"
 #include "common/util/profiler.h"
 
 namespace cqsp::common::systems {
 namespace cqspc = cqsp::common::components;
 namespace {
+/// <summary>
+/// Share of the capital cost of a recipe that is used up every day
+/// </summary>
+constexpr double capital_upkeep = 0.01;
+
+/// <summary>
+/// A market's goods and recipes as vectors, so that industries only have to index into them
+/// </summary>
+struct MarketProduction {
+    MarketProduction(const RecipeMatrix& recipes, cqspc::Market& market) {
+        const cqspc::ResourceLedger& history_sd_ratio =
+            market.history.empty() ? market.sd_ratio : market.history.back().sd_ratio;
+        sd_ratio = recipes.Gather(market.sd_ratio);
+        last_sd_ratio = recipes.Gather(history_sd_ratio);
+        prices = recipes.Gather(market.price);
+        start_prices = prices;
+        recipes.MinOfInputs(last_sd_ratio, input_limit, capital_limit);
+        input_cost = recipes.InputCost(prices);
+        activity.assign(recipes.RecipeCount(), 0);
+    }
+
+    std::vector<double> sd_ratio;
+    /// <summary>
+    /// Supply over demand of the last day in the history of the market
+    /// </summary>
+    std::vector<double> last_sd_ratio;
+    std::vector<double> prices;
+    std::vector<double> start_prices;
+    /// <summary>
+    /// Per recipe, how much the least supplied input and capital good is supplied
+    /// </summary>
+    std::vector<double> input_limit;
+    std::vector<double> capital_limit;
+    /// <summary>
+    /// Per recipe, the cost of the inputs for a unit of size
+    /// </summary>
+    std::vector<double> input_cost;
+    /// <summary>
+    /// Per recipe, the size of all the industries running it, after throttling
+    /// </summary>
+    std::vector<double> activity;
+};
+
 /// <summary>
 /// Runs the production cycle
-/// Consumes material from the market based on supply and then sells the manufactured goods on the market.
+/// Adds the size of the industries to the activity of their recipes, which is turned into consumption and
+/// production for the whole market at once.
 /// </summary>
 /// <param name="universe">Registry used for searching for components</param>
 /// <param name="entity">Entity containing an Inudstries that need to be processed</param>
 /// <param name="market">The market the industry uses.</param>
-void ProcessIndustries(common::Universe& universe, entt::entity entity, cqspc::Market& market) {
+void ProcessIndustries(common::Universe& universe, entt::entity entity, cqspc::Market& market,
+                       const RecipeMatrix& recipes, MarketProduction& production) {
     // Get the transport cost
     auto& infrastructure = universe.get<cqspc::infrastructure::CityInfrastructure>(entity);
     // Calculate the infrastructure cost
@@ -49,42 +99,32 @@ void ProcessIndustries(common::Universe& universe, entt::entity entity, cqspc::M
         // Process imdustries
         // Industries MUST have production and a linked recipe
         if (!universe.all_of<components::Production>(productionentity)) continue;
-        components::Recipe recipe =
-            universe.get_or_emplace<components::Recipe>(universe.get<components::Production>(productionentity).recipe);
+        const int recipe = recipes.RecipeIndex(universe.get<components::Production>(productionentity).recipe);
+        if (recipe < 0) continue;
+        const size_t output = recipes.OutputGood(recipe);
         components::IndustrySize& size = universe.get_or_emplace<components::IndustrySize>(productionentity, 1000.0);
-        // Calculate resource consumption
-        components::ResourceLedger capitalinput = recipe.capitalcost * (0.01 * size.size);
-        components::ResourceLedger input = (recipe.input + size.size) + capitalinput;
-
-        // Calculate the greatest possible production
-        components::ResourceLedger output;  // * ratio.output;
-        output[recipe.output.entity] = recipe.output.amount * size.size;
 
         // Figure out what's throttling production and maintaince
-        double limitedinput = CopyVals(input, market.history.back().sd_ratio).Min();
-        double limitedcapitalinput = CopyVals(capitalinput, market.history.back().sd_ratio).Min();
+        const double limitedinput = production.input_limit[recipe];
+        double limitedcapitalinput = production.capital_limit[recipe];
 
         // Log how much manufacturing is being throttled by input
-        market[recipe.output.entity].inputratio = limitedinput;
+        market[recipes.GetGood(output)].inputratio = limitedinput;
+
+        // If an input good is undersupplied on the market, throttle production
+        const double activity = size.size * std::min(limitedinput, 1.0);
+        production.activity[recipe] += activity;
 
-        if (market.history.back().sd_ratio[recipe.output.entity] < 1.1) {
+        if (production.last_sd_ratio[output] < 1.1) {
             if (limitedcapitalinput > 1) limitedcapitalinput = 1;
             size.size *= 1 + (0.01) * std::fmin(limitedcapitalinput, 1);
         } else {
             size.size *= 0.99;
         }
-        if (limitedinput < 1) {  // If an input good is undersupplied on
-                                 // the market, throttle production
-            input *= limitedinput;
-            output *= limitedinput;
-            // Industry
-        }
 
-        market.demand += input;
-        market.supply += output;
-
-        double output_transport_cost = output.GetSum() * infra_cost;
-        double input_transport_cost = input.GetSum() * infra_cost;
+        double output_transport_cost = recipes.OutputAmount(recipe) * activity * infra_cost;
+        double input_transport_cost =
+            (recipes.InputSum(recipe) + recipes.CapitalSum(recipe) * capital_upkeep) * activity * infra_cost;
         // Next time need to compute the costs along with input and
         // output so that the factory doesn't overspend. We sorta
         // need a balanced economy
@@ -93,23 +133,34 @@ void ProcessIndustries(common::Universe& universe, entt::entity entity, cqspc::M
         // Maintainence costs will still have to be upkept, so if
         // there isnt any resources to upkeep the place, then stop
         // the production
-        costs.materialcosts = (recipe.input * size.size * market.price).GetSum();
-        costs.profit = (recipe.output * market.price).GetSum();
-        if (market.sd_ratio[recipe.output.entity] > 1) {
-            costs.profit /= market.sd_ratio[recipe.output.entity];
+        costs.materialcosts = production.input_cost[recipe] * size.size;
+        costs.profit = recipes.OutputAmount(recipe) * production.prices[output];
+        if (production.sd_ratio[output] > 1) {
+            costs.profit /= production.sd_ratio[output];
         }
-        costs.wages = size.size * recipe.workers * 50000;
+        costs.wages = size.size * recipes.Workers(recipe) * 50000;
         costs.net = costs.profit - costs.maintenance - costs.materialcosts - costs.wages;
         costs.transport = output_transport_cost + input_transport_cost;
-        double& price = market.price[recipe.output.entity];
+        double& price = production.prices[output];
         if (costs.net > 0) {
             price += (-0.1 + price * -0.01f);
         } else {
             price += (0.2 + price * 0.01f);
         }
+    }
+}
 
-        // ratio.ratio = recipe.input.UnitLeger(size.size);
-        // ratio.output = recipe.output.UnitLeger(size.size);
+/// <summary>
+/// Adds the consumption and production of all the industries of the market to it, and the prices that the
+/// industries changed.
+/// </summary>
+void FinishMarket(cqspc::Market& market, const RecipeMatrix& recipes, const MarketProduction& production) {
+    recipes.AddTo(recipes.Consumption(production.activity, capital_upkeep), market.demand);
+    recipes.AddTo(recipes.Production(production.activity), market.supply);
+    for (size_t g = 0; g < recipes.GoodCount(); g++) {
+        if (production.prices[g] != production.start_prices[g]) {
+            market.price[recipes.GetGood(g)] = production.prices[g];
+        }
     }
 }
 }  // namespace
@@ -117,6 +168,7 @@ void ProcessIndustries(common::Universe& universe, entt::entity entity, cqspc::M
 void SysProduction::DoSystem() {
     ZoneScoped;
     Universe& universe = GetUniverse();
+    recipes.Update();
     auto view = universe.view<components::IndustrialZone>();
     BEGIN_TIMED_BLOCK(INDUSTRY);
     int factories = 0;
@@ -130,10 +182,13 @@ void SysProduction::DoSystem() {
         if (!universe.any_of<cqspc::CountryCityList>(entity)) {
             return;
         }
+        MarketProduction production(recipes, market);
         auto& habitation = universe.get<cqspc::CountryCityList>(entity);
         for (entt::entity settlement : habitation.city_list) {
-            ProcessIndustries(universe, settlement, market);
+            ProcessIndustries(universe, settlement, market, recipes, production);
         }
+        FinishMarket(market, recipes, production);
+        save::MarkDirty<cqspc::Market>(universe, entity);
     }
     END_TIMED_BLOCK(INDUSTRY);
     SPDLOG_TRACE("Updated {} factories, {} industries", factories, view.size());
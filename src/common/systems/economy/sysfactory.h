@@ -16,6 +16,7 @@
 */
 #pragma once
 
+#include "common/systems/economy/recipematrix.h"
 #include "common/systems/isimulationsystem.h"
 
 namespace cqsp::common::systems {
@@ -24,8 +25,13 @@ namespace cqsp::common::systems {
 // Main goal is to maintain stable pricing
 class SysProduction : public ISimulationSystem {
  public:
-    explicit SysProduction(Game& game) : ISimulationSystem(game) {}
+    explicit SysProduction(Game& game) : ISimulationSystem(game), recipes(game.GetUniverse()) {}
     void DoSystem() override;
     int Interval() override { return components::StarDate::DAY; }
+
+    const RecipeMatrix& GetRecipes() const { return recipes; }
+
+ private:
+    RecipeMatrix recipes;
 };
 }  // namespace cqsp::common::systems
@@ -17,13 +17,20 @@
 #include "common/systems/economy/sysfinance.h"
 
 #include "common/components/economy.h"
+#include "common/systems/save/savedcomponents.h"
 
 namespace cqsp::common::systems {
 void SysWalletReset::DoSystem() {
     namespace cqspc = cqsp::common::components;
     auto view = GetUniverse().view<cqspc::Wallet>();
     for (entt::entity entity : view) {
-        GetUniverse().get<cqspc::Wallet>(entity).Reset();
+        auto& wallet = GetUniverse().get<cqspc::Wallet>(entity);
+        // Most wallets don't change between resets
+        if (wallet.GetChange() == 0 && wallet.GetGDPChange() == 0) {
+            continue;
+        }
+        wallet.Reset();
+        save::MarkDirty<cqspc::Wallet>(GetUniverse(), entity);
     }
 }
 }  // namespace cqsp::common::systems
@@ -17,13 +17,14 @@
 #include "common/systems/economy/sysmarket.h"
 
 #include <fstream>
-#include <limits>
 #include <utility>
 
 #include <tracy/Tracy.hpp>
 
+#include "common/components/auction.h"
 #include "common/components/economy.h"
 #include "common/components/name.h"
+#include "common/systems/save/savedcomponents.h"
 
 void cqsp::common::systems::SysMarket::DoSystem() {
     ZoneScoped;
@@ -33,44 +34,34 @@ void cqsp::common::systems::SysMarket::DoSystem() {
     TracyPlot("Market Count", (int64_t)marketview.size());
     auto goodsview = GetUniverse().view<components::Price>();
     Universe& universe = GetUniverse();
-    // Calculate all the things
+
+    // Goods are only added when the universe is loaded, so the count changing is enough to tell
+    if (goodsview.size() != solver.GetGoods().size()) {
+        solver.SetGoods({goodsview.begin(), goodsview.end()});
+    }
+
+    // Collect the supply and demand of every market, and solve the prices together
+    solver.Clear();
     for (entt::entity entity : marketview) {
-        // Get the resources and process the price, then do things, I guess
-        // Get demand
         components::Market& market = universe.get<components::Market>(entity);
+        // Markets that were made without CreateMarket, such as the ones of countries, need one to take orders
+        universe.get_or_emplace<components::AuctionHouse>(entity);
 
         // TODO(EhWhoAmI): GDP Calculations
         // market.gdp = market.volume* market.price;
 
         // Calculate Supply and demand
         market.sd_ratio = market.supply.SafeDivision(market.demand);
-        // market.ds_ratio = market.previous_demand.SafeDivision(market.supply);
-        // market.ds_ratio = market.ds_ratio.Clamp(0, 2);
-
-        for (entt::entity good_entity : goodsview) {
-            const double sd_ratio = market.sd_ratio[good_entity];
-            double& price = market.price[good_entity];
-            // If supply and demand = 0, then it will be undefined
-            if (sd_ratio < 1) {
-                // Too much demand, so we will increase the price
-                // Later increase it based on SD ratio
-                price += (0.02 + price * 0.01f);
-                //price = 0.5;
-            } else if (sd_ratio > 1 || sd_ratio == std::numeric_limits<double>::infinity()) {
-                // Too much supply, so we will decrease the price
-                price += (-0.01 + price * -0.01f);
+        solver.AddMarket(market.supply, market.demand, market.price);
+    }
+    solver.Solve();
 
-                // Limit price to a minimum of 0.001
-                if (price < 0.00001) {
-                    price = 0.00001;
-                }
-            } else {
-                // Keep price approximately the same
-            }
-        }
-        // Set the previous supply and demand
-        //components::MarketInformation current = market;
-        //market.history.push_back(current);
+    // The view is in the same order as long as no markets are added in between
+    size_t row = 0;
+    for (entt::entity entity : marketview) {
+        components::Market& market = universe.get<components::Market>(entity);
+        solver.WritePrices(row++, market.price);
+        save::MarkDirty<components::Market>(universe, entity);
 
         // Swap and clear?
         std::swap(market.supply, market.previous_supply);
@@ -89,6 +80,7 @@ void cqsp::common::systems::SysMarket::InitializeMarket(Game& game) {
     auto goodsview = game.GetUniverse().view<components::Price>();
 
     Universe& universe = game.GetUniverse();
+    save::MarkDirty<components::Market>(universe);
     // Calculate all the things
     for (entt::entity entity : marketview) {
         // Get the resources and process the price, then do things, I guess
@@ -16,6 +16,7 @@
 */
 #pragma once
 
+#include "common/systems/economy/marketsolver.h"
 #include "common/systems/isimulationsystem.h"
 
 namespace cqsp::common::systems {
@@ -30,5 +31,10 @@ class SysMarket : public ISimulationSystem {
     /// </summary>
     /// <param name="game"></param>
     static void InitializeMarket(Game& game);
+
+    MarketSolver& GetSolver() { return solver; }
+
+ private:
+    MarketSolver solver;
 };
 }  // namespace cqsp::common::systems
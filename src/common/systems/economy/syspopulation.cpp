@@ -26,6 +26,7 @@
 #include "common/components/population.h"
 #include "common/components/resource.h"
 #include "common/components/surface.h"
+#include "common/systems/save/savedcomponents.h"
 
 namespace cqspc = cqsp::common::components;
 
@@ -39,6 +40,7 @@ void SysPopulationGrowth::DoSystem() {
     namespace cqspc = cqsp::common::components;
     Universe& universe = GetUniverse();
 
+    save::MarkDirty<cqspc::PopulationSegment>(universe);
     auto view = universe.view<cqspc::PopulationSegment>();
     for (entt::entity entity : view) {
         auto& segment = universe.get<cqspc::PopulationSegment>(entity);
@@ -168,6 +170,9 @@ void ProcessSettlement(cqsp::common::Universe& universe, entt::entity settlement
 void SysPopulationConsumption::DoSystem() {
     ZoneScoped;
     Universe& universe = GetUniverse();
+    save::MarkDirty<cqspc::PopulationSegment>(universe);
+    save::MarkDirty<cqspc::Wallet>(universe);
+    save::MarkDirty<cqspc::Market>(universe);
 
     cqspc::ResourceConsumption marginal_propensity_base;
     cqspc::ResourceConsumption autonomous_consumption_base;
@@ -0,0 +1,156 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/economy/systrade.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <tracy/Tracy.hpp>
+
+#include "common/components/economy.h"
+#include "common/systems/save/savedcomponents.h"
+#include "common/util/parallel.h"
+
+namespace cqsp::common::systems {
+namespace cqspc = cqsp::common::components;
+
+SysTrade::SysTrade(Game& game) : ISimulationSystem(game), network(game.GetUniverse()) {}
+
+void SysTrade::DoSystem() {
+    ZoneScoped;
+    Universe& universe = GetUniverse();
+    network.Update();
+    route_load.clear();
+    universe.clear<cqspc::TradeFlows>();
+
+    const std::vector<entt::entity>& markets = network.GetMarkets();
+    const size_t market_count = markets.size();
+    if (market_count < 2) {
+        return;
+    }
+
+    auto goodsview = universe.view<cqspc::Price>();
+    goods.assign(goodsview.begin(), goodsview.end());
+    const size_t good_count = goods.size();
+
+    // Copy the markets into flat arrays, a row for each good
+    supply.assign(good_count * market_count, 0);
+    demand.assign(good_count * market_count, 0);
+    prices.assign(good_count * market_count, 0);
+    for (size_t m = 0; m < market_count; m++) {
+        const cqspc::Market* market = universe.try_get<cqspc::Market>(markets[m]);
+        if (market == nullptr) {
+            continue;
+        }
+        for (size_t g = 0; g < good_count; g++) {
+            supply[g * market_count + m] = market->supply[goods[g]];
+            demand[g * market_count + m] = market->demand[goods[g]];
+            prices[g * market_count + m] = market->price[goods[g]];
+        }
+    }
+
+    std::vector<std::vector<Flow>> flows(good_count);
+    util::ParallelForEach(static_cast<int>(good_count), 0, [&](int g) { FindFlows(g, flows[g]); });
+
+    // Scale the flows down to the capacity of the routes that they go over
+    for (const std::vector<Flow>& good_flows : flows) {
+        for (const Flow& flow : good_flows) {
+            for (entt::entity route : network.Path(flow.from, flow.to)) {
+                route_load[route] += flow.amount;
+            }
+        }
+    }
+    std::map<entt::entity, double> route_scale;
+    for (const auto& [route, load] : route_load) {
+        // Routes have a daily capacity
+        const double capacity =
+            universe.get<cqspc::infrastructure::TradeRoute>(route).capacity / components::StarDate::DAY;
+        route_scale[route] = (load > capacity) ? capacity / load : 1;
+    }
+    for (auto& [route, load] : route_load) {
+        load = 0;
+    }
+
+    save::MarkDirty<cqspc::Market>(universe);
+    for (size_t g = 0; g < good_count; g++) {
+        for (const Flow& flow : flows[g]) {
+            const std::vector<entt::entity> path = network.Path(flow.from, flow.to);
+            double scale = 1;
+            for (entt::entity route : path) {
+                scale = std::min(scale, route_scale[route]);
+            }
+            const double amount = flow.amount * scale;
+            for (entt::entity route : path) {
+                route_load[route] += amount;
+            }
+
+            cqspc::Market* exporter = universe.try_get<cqspc::Market>(markets[flow.from]);
+            cqspc::Market* importer = universe.try_get<cqspc::Market>(markets[flow.to]);
+            exporter->demand[goods[g]] += amount;
+            importer->supply[goods[g]] += amount;
+            universe.get_or_emplace<cqspc::TradeFlows>(markets[flow.from]).exports[goods[g]] += amount;
+            universe.get_or_emplace<cqspc::TradeFlows>(markets[flow.to]).imports[goods[g]] += amount;
+        }
+    }
+}
+
+void SysTrade::FindFlows(size_t good, std::vector<Flow>& flows) const {
+    const size_t market_count = network.GetMarkets().size();
+    const double* good_supply = supply.data() + good * market_count;
+    const double* good_demand = demand.data() + good * market_count;
+    const double* good_price = prices.data() + good * market_count;
+
+    std::vector<double> weights(market_count);
+    std::vector<double> inflow(market_count, 0);
+    for (size_t from = 0; from < market_count; from++) {
+        const double surplus = good_supply[from] - good_demand[from];
+        if (surplus <= 0) {
+            continue;
+        }
+        double total_weight = 0;
+        for (size_t to = 0; to < market_count; to++) {
+            weights[to] = 0;
+            const double shortage = good_demand[to] - good_supply[to];
+            const double cost = network.Distance(static_cast<int>(from), static_cast<int>(to));
+            if (to == from || shortage <= 0 || good_price[to] - good_price[from] <= cost) {
+                continue;
+            }
+            weights[to] = shortage / std::pow(1 + cost, distance_exponent);
+            total_weight += weights[to];
+        }
+        if (total_weight <= 0) {
+            continue;
+        }
+        for (size_t to = 0; to < market_count; to++) {
+            if (weights[to] > 0) {
+                const double shortage = good_demand[to] - good_supply[to];
+                const double amount = std::min(surplus * weights[to] / total_weight, shortage);
+                flows.push_back({static_cast<int>(from), static_cast<int>(to), amount});
+                inflow[to] += amount;
+            }
+        }
+    }
+
+    // Markets can't take in more than they are short of
+    for (Flow& flow : flows) {
+        const double shortage = good_demand[flow.to] - good_supply[flow.to];
+        if (inflow[flow.to] > shortage) {
+            flow.amount *= shortage / inflow[flow.to];
+        }
+    }
+}
+}  // namespace cqsp::common::systems
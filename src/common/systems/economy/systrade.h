@@ -0,0 +1,77 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "common/systems/economy/tradenetwork.h"
+#include "common/systems/isimulationsystem.h"
+
+namespace cqsp::common::systems {
+/// <summary>
+/// Moves goods between markets that are linked by trade routes.
+/// <br>
+/// Flows follow a gravity model: every market with a surplus of a good sends it to the markets that lack it,
+/// weighted by their shortage and falling off with the cost of the cheapest path between them. Goods only flow
+/// if the price difference pays for the transport. Flows are then scaled down to fit the capacity of the routes
+/// that they use.
+/// <br>
+/// Exports are added to the demand of the exporting market, and imports to the supply of the importing market,
+/// so it has to run after the markets are filled and before their prices are solved. The markets are filled every
+/// tick, so this runs every tick too, with a tick's share of the daily capacity of the routes.
+/// </summary>
+class SysTrade : public ISimulationSystem {
+ public:
+    /// <summary>
+    /// How quickly flows fall off with the cost of the path
+    /// </summary>
+    static constexpr double distance_exponent = 2;
+
+    explicit SysTrade(Game& game);
+    void DoSystem() override;
+    int Interval() override { return 1; }
+
+    TradeNetwork& GetNetwork() { return network; }
+
+    /// <summary>
+    /// Units of goods that went over each route on the last tick
+    /// </summary>
+    const std::map<entt::entity, double>& GetRouteLoad() const { return route_load; }
+
+ private:
+    struct Flow {
+        int from;
+        int to;
+        double amount;
+    };
+
+    /// <summary>
+    /// Finds the flows of a single good. Reads the flat supply, demand and price arrays, which have a row
+    /// per good and a column per market.
+    /// </summary>
+    void FindFlows(size_t good, std::vector<Flow>& flows) const;
+
+    TradeNetwork network;
+    std::map<entt::entity, double> route_load;
+
+    std::vector<entt::entity> goods;
+    std::vector<double> supply;
+    std::vector<double> demand;
+    std::vector<double> prices;
+};
+}  // namespace cqsp::common::systems
@@ -0,0 +1,187 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/economy/tradenetwork.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+#include <tracy/Tracy.hpp>
+
+#include "common/util/parallel.h"
+
+namespace cqsp::common::systems {
+using components::infrastructure::TradeRoute;
+
+namespace {
+constexpr double unreachable = std::numeric_limits<double>::infinity();
+}  // namespace
+
+TradeNetwork::TradeNetwork(Universe& _universe) : universe(_universe) {
+    universe.on_construct<TradeRoute>().connect<&TradeNetwork::OnChange>(*this);
+    universe.on_update<TradeRoute>().connect<&TradeNetwork::OnChange>(*this);
+    universe.on_destroy<TradeRoute>().connect<&TradeNetwork::OnChange>(*this);
+}
+
+TradeNetwork::~TradeNetwork() {
+    universe.on_construct<TradeRoute>().disconnect(this);
+    universe.on_update<TradeRoute>().disconnect(this);
+    universe.on_destroy<TradeRoute>().disconnect(this);
+}
+
+void TradeNetwork::OnChange(entt::registry&, entt::entity route) { changed_routes.insert(route); }
+
+int TradeNetwork::IndexOf(entt::entity market) const {
+    auto it = market_index.find(market);
+    return it == market_index.end() ? -1 : it->second;
+}
+
+double TradeNetwork::Distance(entt::entity from, entt::entity to) const {
+    int from_index = IndexOf(from);
+    int to_index = IndexOf(to);
+    if (from_index < 0 || to_index < 0) {
+        return from == to ? 0 : unreachable;
+    }
+    return Distance(from_index, to_index);
+}
+
+std::vector<entt::entity> TradeNetwork::Path(int from, int to) const {
+    std::vector<entt::entity> path;
+    for (int market = to; market != from;) {
+        entt::entity route = PreviousRoute(from, market);
+        if (route == entt::null) {
+            return {};
+        }
+        path.push_back(route);
+        const TradeRoute& trade_route = routes.at(route);
+        market = (market_index.at(trade_route.to) == market) ? market_index.at(trade_route.from)
+                                                               : market_index.at(trade_route.to);
+    }
+    return path;
+}
+
+void TradeNetwork::Update() {
+    ZoneScoped;
+    if (!rebuild && changed_routes.empty()) {
+        last_update_count = 0;
+        return;
+    }
+
+    std::map<entt::entity, TradeRoute> current;
+    std::vector<entt::entity> current_markets;
+    for (auto [entity, route] : universe.view<TradeRoute>().each()) {
+        current.emplace(entity, route);
+        current_markets.push_back(route.from);
+        current_markets.push_back(route.to);
+    }
+    std::sort(current_markets.begin(), current_markets.end());
+    current_markets.erase(std::unique(current_markets.begin(), current_markets.end()), current_markets.end());
+
+    // Markets joining or leaving the network change every row, so everything is found again
+    if (current_markets != markets) {
+        rebuild = true;
+    }
+
+    const size_t count = current_markets.size();
+    std::vector<char> dirty(count, rebuild);
+    if (!rebuild) {
+        // A path from a source can only change if it used a route that changed, or if a changed route
+        // is now shorter than the path that it would replace.
+        for (entt::entity entity : changed_routes) {
+            auto old_route = routes.find(entity);
+            auto new_route = current.find(entity);
+            for (size_t source = 0; source < count; source++) {
+                const double* row = distance.data() + source * count;
+                const entt::entity* previous = previous_route.data() + source * count;
+                if (old_route != routes.end()) {
+                    const TradeRoute& route = old_route->second;
+                    if (previous[market_index[route.from]] == entity || previous[market_index[route.to]] == entity) {
+                        dirty[source] = true;
+                    }
+                }
+                if (new_route != current.end()) {
+                    const TradeRoute& route = new_route->second;
+                    const double from = row[market_index[route.from]];
+                    const double to = row[market_index[route.to]];
+                    if (from + route.cost < to || to + route.cost < from) {
+                        dirty[source] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    routes = std::move(current);
+    changed_routes.clear();
+    if (rebuild) {
+        markets = std::move(current_markets);
+        market_index.clear();
+        for (size_t i = 0; i < count; i++) {
+            market_index[markets[i]] = static_cast<int>(i);
+        }
+        distance.assign(count * count, unreachable);
+        previous_route.assign(count * count, entt::null);
+    }
+    adjacency.assign(count, {});
+    for (const auto& [entity, route] : routes) {
+        const int from = market_index[route.from];
+        const int to = market_index[route.to];
+        adjacency[from].push_back({to, route.cost, entity});
+        adjacency[to].push_back({from, route.cost, entity});
+    }
+    rebuild = false;
+
+    std::vector<int> sources;
+    for (size_t source = 0; source < count; source++) {
+        if (dirty[source]) {
+            sources.push_back(static_cast<int>(source));
+        }
+    }
+    util::ParallelForEach(static_cast<int>(sources.size()), 0, [&](int i) { FindPaths(sources[i]); });
+    last_update_count = static_cast<int>(sources.size());
+}
+
+void TradeNetwork::FindPaths(int source) {
+    const size_t count = markets.size();
+    double* row = distance.data() + source * count;
+    entt::entity* previous = previous_route.data() + source * count;
+    std::fill(row, row + count, unreachable);
+    std::fill(previous, previous + count, entt::null);
+
+    using Entry = std::pair<double, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    row[source] = 0;
+    queue.emplace(0, source);
+    while (!queue.empty()) {
+        auto [cost, market] = queue.top();
+        queue.pop();
+        if (cost > row[market]) {
+            continue;
+        }
+        for (const Edge& edge : adjacency[market]) {
+            const double next = cost + edge.cost;
+            if (next < row[edge.to]) {
+                row[edge.to] = next;
+                previous[edge.to] = edge.route;
+                queue.emplace(next, edge.to);
+            }
+        }
+    }
+}
+}  // namespace cqsp::common::systems
@@ -0,0 +1,113 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "common/components/infrastructure.h"
+#include "common/universe.h"
+
+namespace cqsp::common::systems {
+/// <summary>
+/// The graph of markets linked by trade routes, with the cheapest path between every pair of markets.
+/// <br>
+/// Routes that are added, patched or removed are tracked through the signals of the universe, and when
+/// only a few routes change, only the paths from markets that could use those routes are found again.
+/// Paths from different markets are found on separate threads.
+/// </summary>
+class TradeNetwork {
+ public:
+    explicit TradeNetwork(Universe& universe);
+    ~TradeNetwork();
+
+    TradeNetwork(const TradeNetwork&) = delete;
+    TradeNetwork& operator=(const TradeNetwork&) = delete;
+
+    /// <summary>
+    /// Brings the paths up to date with the routes.
+    /// </summary>
+    void Update();
+
+    /// <summary>
+    /// Markets that are linked by at least one route, sorted by entity
+    /// </summary>
+    const std::vector<entt::entity>& GetMarkets() const { return markets; }
+
+    /// <summary>
+    /// Index of the market, or -1 if it has no routes
+    /// </summary>
+    int IndexOf(entt::entity market) const;
+
+    /// <summary>
+    /// Cost of the cheapest path between two markets, infinity if they aren't connected
+    /// </summary>
+    double Distance(int from, int to) const { return distance[from * markets.size() + to]; }
+    double Distance(entt::entity from, entt::entity to) const;
+
+    /// <summary>
+    /// The route that the cheapest path from a market takes to get to another market, or null if
+    /// there isn't one.
+    /// </summary>
+    entt::entity PreviousRoute(int from, int to) const { return previous_route[from * markets.size() + to]; }
+
+    /// <summary>
+    /// The routes of the cheapest path between two markets, from the end of the path to the beginning
+    /// </summary>
+    std::vector<entt::entity> Path(int from, int to) const;
+
+    /// <summary>
+    /// Number of markets whose paths were found again in the last update
+    /// </summary>
+    int LastUpdateCount() const { return last_update_count; }
+
+ private:
+    struct Edge {
+        int to;
+        double cost;
+        entt::entity route;
+    };
+
+    void OnChange(entt::registry&, entt::entity route);
+
+    /// <summary>
+    /// Dijkstra from a single market. Only writes to the row of the market, so that rows can be found
+    /// in parallel.
+    /// </summary>
+    void FindPaths(int source);
+
+    Universe& universe;
+
+    std::vector<entt::entity> markets;
+    std::map<entt::entity, int> market_index;
+    std::vector<std::vector<Edge>> adjacency;
+
+    /// <summary>
+    /// The routes as they were at the last update, so that the change to a route can be found
+    /// </summary>
+    std::map<entt::entity, components::infrastructure::TradeRoute> routes;
+    std::set<entt::entity> changed_routes;
+    bool rebuild = true;
+
+    std::vector<double> distance;
+    std::vector<entt::entity> previous_route;
+    int last_update_count = 0;
+};
+}  // namespace cqsp::common::systems
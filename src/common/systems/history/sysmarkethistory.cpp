@@ -18,11 +18,13 @@
 
 #include "common/components/economy.h"
 #include "common/components/history.h"
+#include "common/systems/save/savedcomponents.h"
 
 void cqsp::common::systems::history::SysMarketHistory::DoSystem() {
     for (entt::entity marketentity : GetUniverse().view<components::Market>()) {
         components::Market& market_data = GetUniverse().get<components::Market>(marketentity);
         market_data.history.push_back(market_data);
+        save::MarkDirty<components::Market>(GetUniverse(), marketentity);
     }
     auto view = GetUniverse().view<components::Market, components::MarketHistory>();
     for (entt::entity entity : view) {
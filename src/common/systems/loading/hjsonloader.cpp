@@ -20,50 +20,130 @@
 
 #include <vector>
 
+#include <tracy/Tracy.hpp>
+
 #include "common/components/name.h"
 #include "common/systems/loading/loadutil.h"
 
 namespace cqsp::common::systems::loading {
 int HjsonLoader::LoadHjson(const Hjson::Value& values) {
+    ZoneScoped;
     int assets = 0;
+    // Create all the entities at once, rather than growing the entity list one at a time
+    std::vector<entt::entity> entities(values.size());
+    universe.create(entities.begin(), entities.end());
+
     std::vector<entt::entity> entity_list;
+    entity_list.reserve(entities.size());
     for (int i = 0; i < values.size(); i++) {
-        Hjson::Value value = values[i];
-
-        entt::entity entity = universe.create();
-        if (!LoadInitialValues(universe, entity, value)) {
-            SPDLOG_WARN("No identifier");
+        entt::entity entity = entities[i];
+        if (!LoadEntity(values[i], entity)) {
             universe.destroy(entity);
             continue;
         }
+        entity_list.push_back(entity);
+        assets++;
+    }
+
+    // Load all the assets again to parse?
+    for (entt::entity entity : entity_list) {
+        PostLoad(entity);
+    }
+    PostLoadAll(entity_list);
 
-        value = Hjson::Merge(GetDefaultValues(), value);
+    return assets;
+}
 
-        // Catch errors
-        bool success = false;
-        try {
-            success = LoadValue(value, entity);
-        } catch (Hjson::index_out_of_bounds& ioob) {
-            auto& id = universe.get<components::Identifier>(entity).identifier;
-            SPDLOG_WARN("Index out of bounds for {}: {}", id, ioob.what());
-        } catch (Hjson::type_mismatch& tm) {
-            auto& id = universe.get<components::Identifier>(entity).identifier;
-            SPDLOG_WARN("Type mismatch for {}: {}", id, tm.what());
+int HjsonLoader::ReloadHjson(const Hjson::Value& values) {
+    if (!CanReload()) {
+        SPDLOG_WARN("Loader cannot reload values");
+        return 0;
+    }
+    int assets = 0;
+    std::vector<entt::entity> entity_list;
+    for (int i = 0; i < values.size(); i++) {
+        const Hjson::Value& value = values[i];
+        entt::entity entity = entt::null;
+        if (value["identifier"].type() == Hjson::Type::String) {
+            auto it = loaded_entities->find(value["identifier"].to_string());
+            if (it != loaded_entities->end() && universe.valid(it->second)) {
+                entity = it->second;
+            }
         }
 
-        if (!success) {
-            universe.destroy(entity);
+        bool existing = entity != entt::null;
+        if (existing) {
+            // Start from an empty entity, so that nothing from the old values is left behind
+            for (auto [id, storage] : universe.storage()) {
+                if (storage.contains(entity)) {
+                    storage.remove(entity);
+                }
+            }
+        } else {
+            entity = universe.create();
+        }
+
+        if (!LoadEntity(value, entity)) {
+            if (existing) {
+                SPDLOG_WARN("Failed to reload {}, it is left empty", value["identifier"].to_string());
+            } else {
+                universe.destroy(entity);
+            }
             continue;
         }
         entity_list.push_back(entity);
         assets++;
     }
 
-    // Load all the assets again to parse?
     for (entt::entity entity : entity_list) {
         PostLoad(entity);
     }
-
+    PostLoadAll(entity_list);
     return assets;
 }
+
+bool HjsonLoader::LoadEntity(const Hjson::Value& value, entt::entity entity) {
+    if (!LoadInitialValues(universe, entity, value)) {
+        SPDLOG_WARN("No identifier");
+        return false;
+    }
+
+    // Catch errors
+    bool success = false;
+    try {
+        success = LoadValue(ResolveDefaults(value), entity);
+    } catch (Hjson::index_out_of_bounds& ioob) {
+        auto& id = universe.get<components::Identifier>(entity).identifier;
+        SPDLOG_WARN("Index out of bounds for {}: {}", id, ioob.what());
+    } catch (Hjson::type_mismatch& tm) {
+        auto& id = universe.get<components::Identifier>(entity).identifier;
+        SPDLOG_WARN("Type mismatch for {}: {}", id, tm.what());
+    }
+    return success;
+}
+
+Hjson::Value HjsonLoader::ResolveDefaults(const Hjson::Value& value) {
+    const Hjson::Value& defaults = GetDefaultValues();
+    bool missing = false;
+    for (const auto& [key, default_value] : defaults) {
+        if (!value[key].defined()) {
+            missing = true;
+            break;
+        }
+    }
+    // Most values have everything, and maps and vectors are only references, so nothing is copied
+    if (!missing) {
+        return value;
+    }
+    Hjson::Value resolved(Hjson::Type::Map);
+    for (const auto& [key, member] : value) {
+        resolved[key] = member;
+    }
+    for (const auto& [key, default_value] : defaults) {
+        if (!value[key].defined()) {
+            resolved[key] = default_value;
+        }
+    }
+    return resolved;
+}
 }  // namespace cqsp::common::systems::loading
@@ -18,6 +18,10 @@
 
 #include <hjson.h>
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "common/universe.h"
 
 namespace cqsp::common::systems::loading {
@@ -26,10 +30,47 @@ class HjsonLoader {
     explicit HjsonLoader(Universe& universe) : universe(universe) {}
     virtual const Hjson::Value& GetDefaultValues() = 0;
     int LoadHjson(const Hjson::Value& values);
+
+    /// <summary>
+    /// Loads the values again after they changed. Entities that were loaded before are loaded again in place,
+    /// so that everything referring to them stays valid, and new entities are made for new identifiers.
+    /// <br />
+    /// All the components of a reloaded entity are removed before loading it, including the ones that were
+    /// added by other systems.
+    /// </summary>
+    /// <returns>The number of entities that were loaded</returns>
+    int ReloadHjson(const Hjson::Value& values);
+
+    /// <summary>
+    /// If the loader can find the entities that it loaded before, which is needed to reload them.
+    /// </summary>
+    bool CanReload() const { return loaded_entities != nullptr; }
+
     virtual bool LoadValue(const Hjson::Value& values, entt::entity entity) = 0;
     virtual void PostLoad(const entt::entity& entity) {}
+    /// <summary>
+    /// Runs once after every entity of a load or reload went through PostLoad
+    /// </summary>
+    virtual void PostLoadAll(const std::vector<entt::entity>& entities) {}
 
  protected:
     Universe& universe;
+
+    /// <summary>
+    /// Where the loader keeps the entities that it loads by their identifier, null if it doesn't.
+    /// </summary>
+    std::map<std::string, entt::entity>* loaded_entities = nullptr;
+
+ private:
+    /// <summary>
+    /// Loads a value into the entity, and returns if it was loaded.
+    /// </summary>
+    bool LoadEntity(const Hjson::Value& value, entt::entity entity);
+
+    /// <summary>
+    /// Adds the default values that the value doesn't have. Only the top level of the value is copied, and only
+    /// when a default is missing.
+    /// </summary>
+    Hjson::Value ResolveDefaults(const Hjson::Value& value);
 };
 }  // namespace cqsp::common::systems::loading
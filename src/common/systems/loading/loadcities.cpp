@@ -19,6 +19,7 @@
 #include <spdlog/spdlog.h>
 
 #include <string>
+#include <vector>
 
 #include "common/components/area.h"
 #include "common/components/coordinates.h"
@@ -29,45 +30,54 @@
 #include "common/components/population.h"
 #include "common/components/surface.h"
 #include "common/systems/actions/factoryconstructaction.h"
+#include "common/systems/economy/markethelpers.h"
+#include "common/systems/loading/loadutil.h"
 
 namespace cqsp::common::systems::loading {
 bool CityLoader::LoadValue(const Hjson::Value& values, entt::entity entity) {
+    std::string identifier = universe.get<components::Identifier>(entity).identifier;
     // Load the city
-    std::string planet = values["planet"].to_string();
-    double longi = values["coordinates"]["longitude"].to_double();
-    double lat = values["coordinates"]["latitude"].to_double();
+    const Hjson::Value& coordinates = values["coordinates"];
+    double longi = coordinates["longitude"].to_double();
+    double lat = coordinates["latitude"].to_double();
     auto& sc = universe.emplace<components::types::SurfaceCoordinate>(entity, lat, longi);
-    sc.planet = universe.planets[planet];
-
-    universe.get_or_emplace<components::Habitation>(universe.planets[planet]).settlements.push_back(entity);
+    sc.planet = FindIdentifier(universe.planets, values["planet"].to_string());
+    if (sc.planet != entt::null) {
+        universe.get_or_emplace<components::Habitation>(sc.planet).settlements.push_back(entity);
+    } else {
+        SPDLOG_WARN("City {} has planet {}, but it's undefined", identifier, values["planet"].to_string());
+    }
 
-    if (!values["timezone"].empty()) {
-        entt::entity tz = universe.time_zones[values["timezone"].to_string()];
+    const Hjson::Value& timezone = values["timezone"];
+    if (!timezone.empty()) {
+        entt::entity tz = FindIdentifier(universe.time_zones, timezone.to_string());
         universe.emplace<components::CityTimeZone>(entity, tz);
     }
 
     auto& settlement = universe.emplace<components::Settlement>(entity);
     // Load population
-    if (!values["population"].empty()) {
-        Hjson::Value population = values["population"];
+    const Hjson::Value& population = values["population"];
+    if (!population.empty()) {
+        settlement.population.resize(population.size());
+        universe.create(settlement.population.begin(), settlement.population.end());
         for (int i = 0; i < population.size(); i++) {
-            Hjson::Value population_seg = population[i];
-            entt::entity pop_ent = universe.create();
+            const Hjson::Value& population_seg = population[i];
+            entt::entity pop_ent = settlement.population[i];
 
             auto size = population_seg["size"].to_int64();
             int64_t labor_force = size / 2;
-            if (!population_seg["labor_force"].empty()) {
-                labor_force = population_seg["labor_force"].to_int64();
+            const Hjson::Value& labor_force_value = population_seg["labor_force"];
+            if (!labor_force_value.empty()) {
+                labor_force = labor_force_value.to_int64();
             }
 
             auto& segment = universe.emplace<components::PopulationSegment>(pop_ent);
             segment.population = size;
             segment.labor_force = labor_force;
             universe.emplace<components::LaborInformation>(pop_ent);
-            settlement.population.push_back(pop_ent);
         }
     } else {
-        SPDLOG_WARN("City {} does not have any population", universe.get<components::Identifier>(entity).identifier);
+        SPDLOG_WARN("City {} does not have any population", identifier);
     }
 
     universe.emplace<components::ResourceLedger>(entity);
@@ -83,19 +93,17 @@ bool CityLoader::LoadValue(const Hjson::Value& values, entt::entity entity) {
 
     industry.industries.push_back(commercial);
 
-    if (!values["industry"].empty()) {
-        Hjson::Value industry_hjson = values["industry"];
-
+    const Hjson::Value& industry_hjson = values["industry"];
+    if (!industry_hjson.empty()) {
         for (int i = 0; i < industry_hjson.size(); i++) {
-            Hjson::Value ind_val = industry_hjson[i];
+            const Hjson::Value& ind_val = industry_hjson[i];
             auto recipe = ind_val["recipe"].to_string();
             auto productivity = ind_val["productivity"].to_double();
-            if (universe.recipes.find(recipe) == universe.recipes.end()) {
-                SPDLOG_INFO("Recipe {} not found in city {}", recipe,
-                            universe.get<components::Identifier>(entity).identifier);
+            entt::entity rec_ent = FindIdentifier(universe.recipes, recipe);
+            if (rec_ent == entt::null) {
+                SPDLOG_INFO("Recipe {} not found in city {}", recipe, identifier);
                 continue;
             }
-            entt::entity rec_ent = universe.recipes[recipe];
 
             actions::CreateFactory(universe, entity, rec_ent, productivity);
         }
@@ -106,50 +114,56 @@ bool CityLoader::LoadValue(const Hjson::Value& values, entt::entity entity) {
         universe.emplace<components::infrastructure::SpacePort>(entity);
     }
 
-    if (!values["country"].empty()) {
-        if (universe.countries.find(values["country"]) != universe.countries.end()) {
-            entt::entity country = universe.countries[values["country"]];
+    const Hjson::Value& country_value = values["country"];
+    if (!country_value.empty()) {
+        entt::entity country = FindIdentifier(universe.countries, country_value.to_string());
+        if (country != entt::null) {
             universe.emplace<components::Governed>(entity, country);
             // Add self to country?
             universe.get_or_emplace<components::CountryCityList>(country).city_list.push_back(entity);
         } else {
-            SPDLOG_INFO("City {} has country {}, but it's undefined",
-                        universe.get<components::Identifier>(entity).identifier, values["country"]);
+            SPDLOG_INFO("City {} has country {}, but it's undefined", identifier, country_value.to_string());
         }
     } else {
-        SPDLOG_WARN("City {} has no country", universe.get<components::Identifier>(entity).identifier);
+        SPDLOG_WARN("City {} has no country", identifier);
     }
 
-    if (!values["province"].empty()) {
-        if (universe.provinces[values["province"]] != universe.provinces.end()) {
-            entt::entity province = universe.provinces[values["province"]];
+    const Hjson::Value& province_value = values["province"];
+    if (!province_value.empty()) {
+        entt::entity province = FindIdentifier(universe.provinces, province_value.to_string());
+        if (province != entt::null) {
             // Now add self to province
             universe.get<components::Province>(province).cities.push_back(entity);
         } else {
-            SPDLOG_WARN("City {} has province {}, but it's undefined",
-                        universe.get<components::Identifier>(entity).identifier, values["province"]);
+            SPDLOG_WARN("City {} has province {}, but it's undefined", identifier, province_value.to_string());
         }
     }
 
     // Add infrastructure to city
     auto& infrastructure = universe.emplace<components::infrastructure::CityInfrastructure>(entity);
-    if (!values["transport"].empty()) {
-        infrastructure.default_purchase_cost = values["transport"].to_double();
+    const Hjson::Value& transport = values["transport"];
+    if (!transport.empty()) {
+        infrastructure.default_purchase_cost = transport.to_double();
     } else {
         infrastructure.default_purchase_cost = 100;
     }
-    if (!values["infrastructure"].empty()) {
-        SPDLOG_INFO("Has Infrastructure");
+    const Hjson::Value& infrastructure_hjson = values["infrastructure"];
+    if (!infrastructure_hjson.empty()) {
         // Load infrastructure
-        if (!values["infrastructure"]["highway"].empty()) {
-            SPDLOG_INFO("Has highway");
+        const Hjson::Value& highway_hjson = infrastructure_hjson["highway"];
+        if (!highway_hjson.empty()) {
             // Set the stuff
             auto& highway = universe.emplace<components::infrastructure::Highway>(entity);
-            highway.extent = values["infrastructure"]["highway"].to_double();
+            highway.extent = highway_hjson.to_double();
         }
     }
     return true;
 }
 
 void CityLoader::PostLoad(const entt::entity& entity) {}
+
+void CityLoader::PostLoadAll(const std::vector<entt::entity>& entities) {
+    // Every city is loaded by now, so the routes can be found all at once
+    economy::ConnectCities(universe, entities);
+}
 }  // namespace cqsp::common::systems::loading
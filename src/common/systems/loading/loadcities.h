@@ -16,6 +16,8 @@
  */
 #pragma once
 
+#include <vector>
+
 #include "common/systems/loading/hjsonloader.h"
 
 namespace cqsp::common::systems::loading {
@@ -30,6 +32,7 @@ class CityLoader : public HjsonLoader {
     const Hjson::Value& GetDefaultValues() override { return default_val; }
     bool LoadValue(const Hjson::Value& values, entt::entity entity) override;
     void PostLoad(const entt::entity& entity) override;
+    void PostLoadAll(const std::vector<entt::entity>& entities) override;
 
  private:
     Hjson::Value default_val;
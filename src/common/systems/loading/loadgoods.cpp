@@ -18,6 +18,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <string>
 #include <tuple>
 
@@ -68,6 +69,7 @@ void LoadTerrainData(cqsp::common::Universe& universe, Hjson::Value& value) {
 }
 
 GoodLoader::GoodLoader(Universe& universe) : HjsonLoader(universe) {
+    loaded_entities = &universe.goods;
     default_val["price"] = 1.f;
     default_val["tags"] = Hjson::Type::Vector;
 }
@@ -111,7 +113,11 @@ bool GoodLoader::LoadValue(const Hjson::Value& values, entt::entity entity) {
         cg.marginal_propensity = marginal_propensity;
         SPDLOG_INFO("Creating consumer good {} with values: {} {}", identifier, cg.autonomous_consumption,
                     cg.marginal_propensity);
-        universe.consumergoods.push_back(entity);
+        // Already listed if the good is being reloaded
+        if (std::find(universe.consumergoods.begin(), universe.consumergoods.end(), entity) ==
+            universe.consumergoods.end()) {
+            universe.consumergoods.push_back(entity);
+        }
     }
 
     for (int i = 0; i < values["tags"].size(); i++) {
@@ -134,6 +140,7 @@ bool GoodLoader::LoadValue(const Hjson::Value& values, entt::entity entity) {
 }
 
 RecipeLoader::RecipeLoader(Universe& universe) : HjsonLoader(universe) {
+    loaded_entities = &universe.recipes;
     default_val["input"] = Hjson::Type::Vector;
     default_val["output"] = Hjson::Type::Vector;
 }
@@ -18,43 +18,101 @@
 
 #include <spdlog/spdlog.h>
 
-#include <sstream>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <tracy/Tracy.hpp>
 
 #include "common/components/name.h"
 #include "common/components/organizations.h"
 #include "common/components/surface.h"
+#include "common/systems/loading/loadutil.h"
+#include "common/util/parallel.h"
+
+namespace {
+struct ProvinceLine {
+    std::string_view identifier;
+    std::string_view country;
+    cqsp::common::components::ProvinceColor color;
+    bool valid = false;
+};
+
+std::string_view NextToken(std::string_view& line) {
+    std::size_t comma = line.find(',');
+    std::string_view token = line.substr(0, comma);
+    line = (comma == std::string_view::npos) ? std::string_view() : line.substr(comma + 1);
+    return token;
+}
+
+bool ParseInt(std::string_view token, int& value) {
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    return result.ec == std::errc();
+}
+
+ProvinceLine ParseProvinceLine(std::string_view line) {
+    ProvinceLine province;
+    province.identifier = NextToken(line);
+    bool valid = ParseInt(NextToken(line), province.color.r);
+    valid &= ParseInt(NextToken(line), province.color.g);
+    valid &= ParseInt(NextToken(line), province.color.b);
+    province.country = NextToken(line);
+    province.valid = valid;
+    return province;
+}
+}  // namespace
 
 void cqsp::common::systems::loading::LoadProvinces(common::Universe& universe, const std::string& text) {
+    ZoneScoped;
     // The text has to be csv, so treat it is csv
-    std::istringstream f(text);
-    std::string line;
-    while (std::getline(f, line)) {
-        // Split and parse
-        std::string token;
-        std::istringstream f2(line);
-        std::getline(f2, token, ',');
-        std::string identifier = token;
-        std::getline(f2, token, ',');
-        std::string r = token;
-        std::getline(f2, token, ',');
-        std::string g = token;
-        std::getline(f2, token, ',');
-        std::string b = token;
-        std::getline(f2, token, ',');
-        std::string country = token;
-        // Create
-        entt::entity entity = universe.create();
-        universe.emplace<components::Province>(entity, universe.countries[country]);
+    std::vector<std::string_view> lines;
+    std::string_view remaining(text);
+    while (!remaining.empty()) {
+        std::size_t end = remaining.find('\n');
+        std::string_view line = remaining.substr(0, end);
+        remaining = (end == std::string_view::npos) ? std::string_view() : remaining.substr(end + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+
+    // Parsing doesn't touch the universe, so the lines can be parsed at the same time
+    std::vector<ProvinceLine> provinces(lines.size());
+    common::util::ParallelForRange(static_cast<int>(lines.size()), 0, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            provinces[i] = ParseProvinceLine(lines[i]);
+        }
+    });
+
+    // Create
+    std::vector<entt::entity> entities(provinces.size());
+    universe.create(entities.begin(), entities.end());
+    for (size_t i = 0; i < provinces.size(); i++) {
+        const ProvinceLine& line = provinces[i];
+        entt::entity entity = entities[i];
+        if (!line.valid) {
+            SPDLOG_WARN("Province {} has an invalid color", line.identifier);
+            universe.destroy(entity);
+            continue;
+        }
+        std::string identifier(line.identifier);
+        entt::entity country = FindIdentifier(universe.countries, std::string(line.country));
+        universe.emplace<components::Province>(entity, country);
         universe.emplace<components::Identifier>(entity, identifier);
-        auto& color = universe.emplace<components::ProvinceColor>(entity, std::stoi(r), std::stoi(g), std::stoi(b));
+        auto& color = universe.emplace<components::ProvinceColor>(entity, line.color);
         if (universe.provinces.find(identifier) == universe.provinces.end()) {
             universe.provinces[identifier] = entity;
         } else {
             SPDLOG_WARN("Province {} conflicts with an already preexisting province", identifier);
         }
         // Add province to country
-        universe.get_or_emplace<components::CountryCityList>(universe.countries[country])
-            .province_list.push_back(entity);
+        if (country != entt::null) {
+            universe.get_or_emplace<components::CountryCityList>(country).province_list.push_back(entity);
+        }
 
         universe.province_colors[color] = entity;
     }
@@ -37,6 +37,20 @@ std::string trim(const std::string& str, const std::string& whitespace = " \t")
 
     return str.substr(strBegin, strRange);
 }
+
+/// Gets the next line of the text without copying it, and moves past it.
+bool NextLine(std::string_view& text, std::string_view& line) {
+    if (text.empty()) {
+        return false;
+    }
+    size_t end = text.find('\n');
+    line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return true;
+}
 }  // namespace
 
 components::types::Orbit GetOrbit(const std::string& line_one, const std::string& line_two, const double& GM) {
@@ -97,31 +111,30 @@ double GetEpoch(double year, double time) {
     return time * 86400. + year_diff * 31557600.;
 }
 
-void LoadSatellites(Universe& universe, std::string& string) {
+void LoadSatellites(Universe& universe, std::string_view string) {
     // Load satellite data
-    std::istringstream f(string);
-    std::string line;
+    std::string_view line;
     int count = 0;
     entt::entity earth = universe.planets["earth"];
     const double GM = universe.get<components::bodies::Body>(earth).GM;
 
     // Get the next three lines or something like that
-    while (std::getline(f, line)) {
+    while (NextLine(string, line)) {
         if (line.empty()) {
             break;
         }
-        line = trim(line);
+        std::string name = trim(std::string(line));
 
-        std::string line_one;
-        std::getline(f, line_one);
-        std::string line_two;
-        std::getline(f, line_two);
+        std::string_view line_one;
+        NextLine(string, line_one);
+        std::string_view line_two;
+        NextLine(string, line_two);
         entt::entity satellite = universe.create();
-        universe.emplace<components::Name>(satellite, line);
+        universe.emplace<components::Name>(satellite, name);
         // Calculate the thingies
         // Add to earth
         // Calculate the thingies
-        auto orbit = GetOrbit(line_one, line_two, GM);
+        auto orbit = GetOrbit(std::string(line_one), std::string(line_two), GM);
         orbit.inclination += universe.get<components::bodies::Body>(earth).axial * cos(orbit.inclination);
         // orbit.M0 += universe.get<components::bodies::Body>(earth).axial;
         orbit.CalculateVariables();
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "common/components/coordinates.h"
 #include "common/universe.h"
@@ -25,5 +26,5 @@ namespace cqsp::common::systems::loading {
 components::types::Orbit GetOrbit(const std::string& line_one, const std::string& line_two, const double& GM);
 int GetEpochYear(int year);
 double GetEpoch(double year, double time);
-void LoadSatellites(Universe& universe, std::string& string);
+void LoadSatellites(Universe& universe, std::string_view string);
 }  // namespace cqsp::common::systems::loading
@@ -65,6 +65,14 @@ cqsp::common::components::ResourceLedger HjsonToLedger(cqsp::common::Universe& u
     return stockpile;
 }
 
+entt::entity FindIdentifier(const std::map<std::string, entt::entity>& map, const std::string& identifier) {
+    auto it = map.find(identifier);
+    if (it == map.end()) {
+        return entt::null;
+    }
+    return it->second;
+}
+
 bool VerifyHjsonValueExists(const Hjson::Value& value, const std::string& name, Hjson::Type type) {
     return value[name].type() == type;
 }
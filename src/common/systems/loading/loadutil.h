@@ -42,6 +42,13 @@ bool LoadInitialValues(Universe& universe, const entt::entity& entity, const Hjs
 
 components::ResourceLedger HjsonToLedger(cqsp::common::Universe&, Hjson::Value&);
 
+/// <summary>
+/// Finds the entity with the identifier in one of the maps of the universe, without adding the identifier
+/// to the map if it isn't there.
+/// </summary>
+/// <returns>The entity, or entt::null if there isn't one</returns>
+entt::entity FindIdentifier(const std::map<std::string, entt::entity>& map, const std::string& identifier);
+
 bool VerifyHjsonValueExists(const Hjson::Value& value, const std::string& name, Hjson::Type type);
 /// <summary>
 /// For the values that *need* to exist
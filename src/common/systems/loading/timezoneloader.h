@@ -21,7 +21,7 @@
 namespace cqsp::common::systems::loading {
 class TimezoneLoader : public HjsonLoader {
  public:
-    explicit TimezoneLoader(Universe& universe) : HjsonLoader(universe) {}
+    explicit TimezoneLoader(Universe& universe) : HjsonLoader(universe) { loaded_entities = &universe.time_zones; }
 
     const Hjson::Value& GetDefaultValues() override { return default_val; }
     bool LoadValue(const Hjson::Value& values, entt::entity entity) override;
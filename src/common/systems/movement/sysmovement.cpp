@@ -23,6 +23,7 @@
 #include "common/components/coordinates.h"
 #include "common/components/ships.h"
 #include "common/components/units.h"
+#include "common/systems/save/savedcomponents.h"
 
 namespace cqsp::common::systems {
 namespace cqspc = cqsp::common::components;
@@ -32,6 +33,7 @@ namespace cqspt = cqsp::common::components::types;
 void SysOrbit::DoSystem() {
     ZoneScoped;
     Universe& universe = GetGame().GetUniverse();
+    // The anomalies follow from the date, so orbits are only marked when the orbital elements change
     ParseOrbitTree(entt::null, universe.sun);
 }
 
@@ -57,6 +59,7 @@ void LeaveSOI(Universe& universe, const entt::entity& body, entt::entity& parent
                                  universe.date.ToSecond());
         orb.reference_body = p_orb.reference_body;
         orb.CalculateVariables();
+        save::MarkDirty<cqspt::Orbit>(universe, body);
 
         // Update dirty orbit
         universe.emplace_or_replace<cqspc::bodies::DirtyOrbit>(body);
@@ -94,6 +97,7 @@ void SysOrbit::ParseOrbitTree(entt::entity parent, entt::entity body) {
             orb = cqspt::Vec3ToOrbit(pos.position, pos.velocity + impulse.impulse, p_bod.GM, universe.date.ToSecond());
             orb.reference_body = reference;
             orb.CalculateVariables();
+            save::MarkDirty<cqspt::Orbit>(universe, body);
             pos.position = cqspt::toVec3(orb);
             pos.velocity = cqspt::OrbitVelocityToVec3(orb, orb.v);
             universe.emplace_or_replace<cqspc::bodies::DirtyOrbit>(body);
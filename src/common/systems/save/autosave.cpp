@@ -0,0 +1,205 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/save/autosave.h"
+
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <type_traits>
+#include <utility>
+
+#include "common/systems/save/savearchive.h"
+#include "common/systems/save/savedcomponents.h"
+
+namespace cqsp::common::systems::save {
+namespace {
+template <class Component>
+void CopyComponent(Component& copy, const Component& component) {
+    // Assigning over the old copy reuses its memory, which makes copying maps and vectors cheaper
+    copy = component;
+}
+
+/// <summary>
+/// The history of a market only grows, and is by far the largest part of it, so only the days that were added
+/// since the last copy are copied.
+/// </summary>
+void CopyComponent(components::Market& copy, const components::Market& market) {
+    // Same fields as the Serialize of markets
+    static_cast<components::MarketInformation&>(copy) = market;
+    copy.market_information = market.market_information;
+    copy.last_market_information = market.last_market_information;
+    copy.participants = market.participants;
+    copy.GDP = market.GDP;
+    if (copy.history.size() > market.history.size()) {
+        copy.history.clear();
+    }
+    copy.history.insert(copy.history.end(), market.history.begin() + copy.history.size(), market.history.end());
+}
+}  // namespace
+
+template <class Component>
+class AutoSaver::PoolCopy : public AutoSaver::IPoolCopy {
+ public:
+    void Copy(Universe& universe) override {
+        copied = true;
+        auto view = universe.view<Component>();
+        if constexpr (std::is_empty_v<Component>) {
+            entities.clear();
+            entities.insert(entities.end(), view.begin(), view.end());
+        } else {
+            // Keep the copies of the entities that are still there, so that they are copied over
+            std::erase_if(components, [&](const auto& pair) { return !view.contains(pair.first); });
+            for (auto [entity, component] : view.each()) {
+                CopyComponent(components[entity], component);
+            }
+        }
+    }
+
+    void Copy(Universe& universe, std::vector<entt::entity>& changed) override {
+        if constexpr (std::is_empty_v<Component>) {
+            Copy(universe);
+        } else {
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+            for (entt::entity entity : changed) {
+                if (universe.valid(entity) && universe.all_of<Component>(entity)) {
+                    CopyComponent(components[entity], universe.get<Component>(entity));
+                } else {
+                    components.erase(entity);
+                }
+            }
+        }
+    }
+
+    bool IsCopied() const override { return copied; }
+
+    // Same layout as the pools of full saves
+    void Write(std::vector<char>& buffer) override {
+        buffer.clear();
+        OutputArchive archive(buffer);
+        if constexpr (std::is_empty_v<Component>) {
+            archive.Field(static_cast<uint32_t>(entities.size()));
+            for (entt::entity entity : entities) {
+                archive.Field(entity);
+            }
+        } else {
+            archive.Field(static_cast<uint32_t>(components.size()));
+            for (auto& [entity, component] : components) {
+                archive.Field(entity);
+                archive.Field(component);
+            }
+        }
+    }
+
+ private:
+    bool copied = false;
+    std::vector<entt::entity> entities;
+    std::map<entt::entity, Component> components;
+};
+
+template <class Component>
+void AutoSaver::OnChange(entt::registry&, entt::entity entity) {
+    universe.ctx().at<DirtyComponents>().entities[SavedComponents::IndexOf<Component>()].push_back(entity);
+}
+
+AutoSaver::AutoSaver(Universe& _universe, const std::string& _path, int _deltas_per_save)
+    : universe(_universe), path(_path), deltas_per_save(_deltas_per_save), copied(SavedComponents::size, false) {
+    universe.ctx().emplace<DirtyComponents>();
+    pools.resize(SavedComponents::size);
+    SavedComponents::ForEach([&]<class Component, size_t id>() {
+        pools[id] = std::make_unique<PoolCopy<Component>>();
+        if constexpr (IsTracked<Component>()) {
+            universe.on_construct<Component>().template connect<&AutoSaver::OnChange<Component>>(*this);
+            universe.on_update<Component>().template connect<&AutoSaver::OnChange<Component>>(*this);
+            universe.on_destroy<Component>().template connect<&AutoSaver::OnChange<Component>>(*this);
+        }
+    });
+}
+
+AutoSaver::~AutoSaver() {
+    Wait();
+    SavedComponents::ForEach([&]<class Component, size_t id>() {
+        if constexpr (IsTracked<Component>()) {
+            universe.on_construct<Component>().disconnect(this);
+            universe.on_update<Component>().disconnect(this);
+            universe.on_destroy<Component>().disconnect(this);
+        }
+    });
+    universe.ctx().erase<DirtyComponents>();
+}
+
+bool AutoSaver::Save() {
+    ZoneScoped;
+    if (writing) {
+        return false;
+    }
+    Wait();
+    auto start = std::chrono::steady_clock::now();
+
+    bool full = delta_count < 0 || delta_count >= deltas_per_save;
+    save.kind = full ? SaveKind::Full : SaveKind::Delta;
+    save.pools.clear();
+    WriteState(universe, save.state);
+    WriteEntities(universe, save.entities);
+
+    auto& dirty = universe.ctx().at<DirtyComponents>();
+    SavedComponents::ForEach([&]<class Component, size_t id>() {
+        if (!IsTracked<Component>() || !pools[id]->IsCopied() || dirty.pools[id]) {
+            pools[id]->Copy(universe);
+        } else if (dirty.IsDirty(id)) {
+            pools[id]->Copy(universe, dirty.entities[id]);
+        }
+        // The copies of the tracked components are kept up to date, so full saves can write them as they are
+        copied[id] = full || !IsTracked<Component>() || dirty.IsDirty(id);
+    });
+    dirty.Clear();
+
+    delta_count = full ? 0 : delta_count + 1;
+    last_pause = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    TracyPlot("Autosave Pause", last_pause);
+    SPDLOG_DEBUG("Autosave paused the simulation for {:.2f} ms", last_pause);
+    writing = true;
+    thread = std::thread([this]() { Write(); });
+    return true;
+}
+
+void AutoSaver::Wait() {
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void AutoSaver::Write() {
+    ZoneScoped;
+    for (size_t id = 0; id < pools.size(); id++) {
+        if (copied[id]) {
+            pools[id]->Write(save.pools[static_cast<uint16_t>(id)]);
+        }
+    }
+    std::string file = (save.kind == SaveKind::Full) ? path : GetDeltaPath(path, delta_count);
+    if (WriteSave(file, save)) {
+        SPDLOG_INFO("Autosaved to {}", file);
+    } else {
+        // Write everything next time, because the deltas after this would be missing the changes in this one
+        delta_count = -1;
+    }
+    writing = false;
+}
+}  // namespace cqsp::common::systems::save
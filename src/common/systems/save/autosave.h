@@ -0,0 +1,109 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/systems/save/savegame.h"
+#include "common/universe.h"
+
+namespace cqsp::common::systems::save {
+/// <summary>
+/// Autosaves the universe without stopping the simulation for long.
+/// <br>
+/// Between ticks, the components that changed since the last autosave are copied, which is all that the
+/// simulation waits for. The copies are then serialized, compressed and written on a background thread.
+/// <br>
+/// The first autosave writes everything. The autosaves after it are deltas that only have the components that
+/// changed, until enough deltas are written and the next autosave writes everything again.
+/// </summary>
+class AutoSaver {
+ public:
+    /// <param name="deltas_per_save">Number of deltas written after each full save</param>
+    AutoSaver(Universe& universe, const std::string& path, int deltas_per_save = 10);
+    ~AutoSaver();
+
+    /// <summary>
+    /// Copies the changed components and starts writing them. Call between ticks.
+    /// </summary>
+    /// <returns>False if the last autosave is still being written, then nothing is saved</returns>
+    bool Save();
+
+    bool IsWriting() const { return writing; }
+
+    /// <summary>
+    /// How long the simulation waited for the last autosave, in milliseconds
+    /// </summary>
+    double GetLastPause() const { return last_pause; }
+
+    /// <summary>
+    /// Waits for the autosave that is being written
+    /// </summary>
+    void Wait();
+
+ private:
+    /// <summary>
+    /// Copy of the components of one type, as they were at the last autosave
+    /// </summary>
+    class IPoolCopy {
+     public:
+        virtual ~IPoolCopy() = default;
+        /// <summary>
+        /// Copies every component of the pool
+        /// </summary>
+        virtual void Copy(Universe& universe) = 0;
+        /// <summary>
+        /// Only copies the components of the entities again, and removes the ones that the entities don't have
+        /// anymore. Everything else is kept from the copy before.
+        /// </summary>
+        virtual void Copy(Universe& universe, std::vector<entt::entity>& entities) = 0;
+        virtual bool IsCopied() const = 0;
+        virtual void Write(std::vector<char>& buffer) = 0;
+    };
+
+    template <class Component>
+    class PoolCopy;
+
+    void Write();
+
+    template <class Component>
+    void OnChange(entt::registry&, entt::entity);
+
+    Universe& universe;
+    std::string path;
+    int deltas_per_save;
+    /// <summary>
+    /// Number of deltas written since the last full save, -1 if nothing is saved yet
+    /// </summary>
+    int delta_count = -1;
+
+    std::vector<std::unique_ptr<IPoolCopy>> pools;
+    /// <summary>
+    /// The pools that were copied for the autosave that is being written
+    /// </summary>
+    std::vector<bool> copied;
+    SaveData save;
+
+    std::thread thread;
+    std::atomic<bool> writing = false;
+    double last_pause = 0;
+};
+}  // namespace cqsp::common::systems::save
@@ -0,0 +1,504 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "common/components/area.h"
+#include "common/components/auction.h"
+#include "common/components/bodies.h"
+#include "common/components/economy.h"
+#include "common/components/history.h"
+#include "common/components/name.h"
+#include "common/components/organizations.h"
+#include "common/components/resource.h"
+#include "common/components/science.h"
+#include "common/components/ships.h"
+#include "common/components/surface.h"
+
+namespace cqsp::common::systems::save {
+// Components that are trivially copyable are saved as they are in memory. The rest list their
+// fields here, in the order that they are saved. The same function is used for saving and loading,
+// so changing the order of the fields changes the save format, and needs a new save version.
+
+template <class Archive, class Ledger>
+requires std::is_base_of_v<components::ResourceLedger, Ledger>
+void Serialize(Archive& archive, Ledger& ledger) {
+    uint64_t size = ledger.size();
+    archive.Field(size);
+    if constexpr (Archive::is_loading) {
+        ledger.clear();
+        for (uint64_t i = 0; i < size && !archive.Failed(); i++) {
+            entt::entity good;
+            double amount;
+            archive.Field(good);
+            archive.Field(amount);
+            ledger.emplace(good, amount);
+        }
+    } else {
+        for (const auto& [good, amount] : ledger) {
+            archive.Field(good);
+            archive.Field(amount);
+        }
+    }
+}
+
+// Order book sides are saved as their orders from front to back, and placed again when loaded
+template <class Archive, class Compare>
+void Serialize(Archive& archive, components::OrderBookSide<Compare>& side) {
+    if constexpr (Archive::is_loading) {
+        std::vector<components::Order> orders;
+        archive.Field(orders);
+        side.clear();
+        for (const components::Order& order : orders) {
+            side.put(order);
+        }
+    } else {
+        archive.Field(side.Orders());
+    }
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::OrderBook& book) {
+    archive.Field(book.bids);
+    archive.Field(book.asks);
+    archive.Field(book.last_price);
+    archive.Field(book.volume);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::IndustrialZone& zone) {
+    archive.Field(zone.industries);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::AuctionHouse& house) {
+    archive.Field(house.books);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::bodies::TexturedTerrain& terrain) {
+    archive.Field(terrain.terrain_name);
+    archive.Field(terrain.normal_name);
+    archive.Field(terrain.roughness_name);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::bodies::OrbitalSystem& system) {
+    archive.Field(system.children);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::bodies::TerrainData& terrain) {
+    archive.Field(terrain.sea_level);
+    archive.Field(terrain.data);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::MarketInformation& market) {
+    archive.Field(market.demand);
+    archive.Field(market.sd_ratio);
+    archive.Field(market.ds_ratio);
+    archive.Field(market.supply);
+    archive.Field(market.volume);
+    archive.Field(market.price);
+    archive.Field(market.previous_demand);
+    archive.Field(market.previous_supply);
+    archive.Field(market.latent_supply);
+    archive.Field(market.last_latent_demand);
+    archive.Field(market.latent_demand);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Market& market) {
+    archive.Field(static_cast<components::MarketInformation&>(market));
+    archive.Field(market.history);
+    archive.Field(market.market_information);
+    archive.Field(market.last_market_information);
+    archive.Field(market.participants);
+    archive.Field(market.GDP);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::MarketHistory& history) {
+    archive.Field(history.price_history);
+    archive.Field(history.sd_ratio);
+    archive.Field(history.supply);
+    archive.Field(history.demand);
+    archive.Field(history.volume);
+    archive.Field(history.gdp);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Name& name) {
+    archive.Field(name.name);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Identifier& identifier) {
+    archive.Field(identifier.identifier);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Description& description) {
+    archive.Field(description.description);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::CountryCityList& list) {
+    archive.Field(list.city_list);
+    archive.Field(list.province_list);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Unit& unit) {
+    archive.Field(unit.unit_name);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Recipe& recipe) {
+    archive.Field(recipe.input);
+    archive.Field(recipe.output);
+    archive.Field(recipe.type);
+    archive.Field(recipe.interval);
+    archive.Field(recipe.workers);
+    archive.Field(recipe.capitalcost);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::RecipeCost& cost) {
+    archive.Field(cost.fixed);
+    archive.Field(cost.scaling);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::ResourceIO& io) {
+    archive.Field(io.input);
+    archive.Field(io.output);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::ResourceDistribution& distribution) {
+    archive.Field(distribution.dist);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::science::Field& field) {
+    archive.Field(field.parents);
+    archive.Field(field.adjacent);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::science::Science& science) {
+    archive.Field(science.difficulty);
+    archive.Field(science.fields);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::science::Lab& lab) {
+    archive.Field(lab.science_contribution);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::science::ScientificProgress& progress) {
+    archive.Field(progress.science_progress);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::science::ScientificResearch& research) {
+    archive.Field(research.current_research);
+    archive.Field(research.potential_research);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::science::TechnologicalProgress& progress) {
+    archive.Field(progress.researched_techs);
+    archive.Field(progress.researched_recipes);
+    archive.Field(progress.researched_mining);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::science::Technology& technology) {
+    archive.Field(technology.fields);
+    archive.Field(technology.actions);
+    archive.Field(technology.difficulty);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::ships::Fleet& fleet) {
+    archive.Field(fleet.echelon);
+    archive.Field(fleet.subfleets);
+    archive.Field(fleet.ships);
+    archive.Field(fleet.parent_fleet);
+    archive.Field(fleet.owner);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Habitation& habitation) {
+    archive.Field(habitation.settlements);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Settlement& settlement) {
+    archive.Field(settlement.population);
+}
+
+template <class Archive>
+void Serialize(Archive& archive, components::Province& province) {
+    archive.Field(province.country);
+    archive.Field(province.cities);
+}
+
+template <class Archive, class T>
+concept HasSerialize = requires(Archive& archive, T& value) { Serialize(archive, value); };
+
+/// <summary>
+/// Writes values into a byte buffer. Also works as an output archive for entt::snapshot.
+/// </summary>
+class OutputArchive {
+ public:
+    static constexpr bool is_loading = false;
+
+    explicit OutputArchive(std::vector<char>& buffer) : buffer(buffer) {}
+
+    void operator()(entt::entity entity) { Field(entity); }
+    void operator()(std::underlying_type_t<entt::entity> value) { Field(value); }
+
+    template <class Component>
+    void operator()(entt::entity entity, const Component& component) {
+        Field(entity);
+        Field(component);
+    }
+
+    template <class T>
+    void Field(const T& value) {
+        if constexpr (HasSerialize<OutputArchive, T>) {
+            // Saving doesn't change the value, the function just also has to be able to load it
+            Serialize(*this, const_cast<T&>(value));
+        } else {
+            static_assert(std::is_trivially_copyable_v<T>, "Type needs a Serialize function to be saved");
+            Write(&value, sizeof(T));
+        }
+    }
+
+    void Field(const std::string& value) {
+        Field(static_cast<uint64_t>(value.size()));
+        Write(value.data(), value.size());
+    }
+
+    template <class T, class Alloc>
+    void Field(const std::vector<T, Alloc>& value) {
+        Field(static_cast<uint64_t>(value.size()));
+        if constexpr (!HasSerialize<OutputArchive, T> && std::is_trivially_copyable_v<T>) {
+            Write(value.data(), value.size() * sizeof(T));
+        } else {
+            for (const T& element : value) {
+                Field(element);
+            }
+        }
+    }
+
+    template <class Key, class Value, class Compare, class Alloc>
+    void Field(const std::map<Key, Value, Compare, Alloc>& value) {
+        Field(static_cast<uint64_t>(value.size()));
+        for (const auto& [key, element] : value) {
+            Field(key);
+            Field(element);
+        }
+    }
+
+    template <class T, class Compare, class Alloc>
+    void Field(const std::set<T, Compare, Alloc>& value) {
+        Field(static_cast<uint64_t>(value.size()));
+        for (const T& element : value) {
+            Field(element);
+        }
+    }
+
+    template <class... T>
+    void Field(const std::tuple<T...>& value) {
+        std::apply([this](const auto&... element) { (Field(element), ...); }, value);
+    }
+
+    /// <summary>
+    /// Variants are saved as the index of the alternative, then the alternative
+    /// </summary>
+    template <class... T>
+    void Field(const std::variant<T...>& value) {
+        static_assert(sizeof...(T) <= UINT8_MAX);
+        Field(static_cast<uint8_t>(value.index()));
+        std::visit([this](const auto& alternative) { Field(alternative); }, value);
+    }
+
+    void Write(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    bool Failed() const { return false; }
+
+ private:
+    std::vector<char>& buffer;
+};
+
+/// <summary>
+/// Reads values written by OutputArchive from a byte buffer. Also works as an input archive for
+/// entt::snapshot_loader.
+/// <br>
+/// If the buffer ends too early, the archive fails, and everything read after that is zero, so that
+/// the loading can finish without reading past the end of the buffer.
+/// </summary>
+class InputArchive {
+ public:
+    static constexpr bool is_loading = true;
+
+    InputArchive(const char* data, size_t size) : data(data), size(size) {}
+
+    void operator()(entt::entity& entity) { Field(entity); }
+    void operator()(std::underlying_type_t<entt::entity>& value) { Field(value); }
+
+    template <class Component>
+    void operator()(entt::entity& entity, Component& component) {
+        Field(entity);
+        Field(component);
+    }
+
+    template <class T>
+    void Field(T& value) {
+        if constexpr (HasSerialize<InputArchive, T>) {
+            Serialize(*this, value);
+        } else {
+            static_assert(std::is_trivially_copyable_v<T>, "Type needs a Serialize function to be loaded");
+            Read(&value, sizeof(T));
+        }
+    }
+
+    void Field(std::string& value) {
+        uint64_t length = ReadSize();
+        value.resize(length);
+        Read(value.data(), length);
+    }
+
+    template <class T, class Alloc>
+    void Field(std::vector<T, Alloc>& value) {
+        uint64_t length = ReadSize();
+        if constexpr (!HasSerialize<InputArchive, T> && std::is_trivially_copyable_v<T>) {
+            value.resize(length);
+            Read(value.data(), length * sizeof(T));
+        } else {
+            value.clear();
+            value.reserve(length);
+            for (uint64_t i = 0; i < length; i++) {
+                Field(value.emplace_back());
+            }
+        }
+    }
+
+    template <class Key, class Value, class Compare, class Alloc>
+    void Field(std::map<Key, Value, Compare, Alloc>& value) {
+        uint64_t length = ReadSize();
+        value.clear();
+        for (uint64_t i = 0; i < length; i++) {
+            Key key {};
+            Field(key);
+            Field(value[key]);
+        }
+    }
+
+    template <class T, class Compare, class Alloc>
+    void Field(std::set<T, Compare, Alloc>& value) {
+        uint64_t length = ReadSize();
+        value.clear();
+        for (uint64_t i = 0; i < length; i++) {
+            T element {};
+            Field(element);
+            value.insert(value.end(), std::move(element));
+        }
+    }
+
+    template <class... T>
+    void Field(std::tuple<T...>& value) {
+        std::apply([this](auto&... element) { (Field(element), ...); }, value);
+    }
+
+    template <class... T>
+    void Field(std::variant<T...>& value) {
+        uint8_t index = 0;
+        Field(index);
+        if (index >= sizeof...(T)) {
+            failed = true;
+            return;
+        }
+        EmplaceAlternative(value, index, std::index_sequence_for<T...> {});
+        std::visit([this](auto& alternative) { Field(alternative); }, value);
+    }
+
+    void Read(void* out, size_t length) {
+        if (failed || length > size - position) {
+            failed = true;
+            std::memset(out, 0, length);
+            return;
+        }
+        std::memcpy(out, data + position, length);
+        position += length;
+    }
+
+    bool Failed() const { return failed; }
+    void Fail() { failed = true; }
+
+    /// <summary>
+    /// If everything in the buffer has been read
+    /// </summary>
+    bool AtEnd() const { return position == size; }
+
+ private:
+    /// <summary>
+    /// Reads the length of a container. Every element takes up at least a byte, so a length
+    /// longer than the rest of the buffer means that the buffer is broken.
+    /// </summary>
+    uint64_t ReadSize() {
+        uint64_t length = 0;
+        Field(length);
+        if (length > size - position) {
+            failed = true;
+            return 0;
+        }
+        return length;
+    }
+
+    template <class Variant, size_t... I>
+    void EmplaceAlternative(Variant& value, size_t index, std::index_sequence<I...>) {
+        ((index == I ? static_cast<void>(value.template emplace<I>()) : static_cast<void>(0)), ...);
+    }
+
+    const char* data;
+    size_t size;
+    size_t position = 0;
+    bool failed = false;
+};
+}  // namespace cqsp::common::systems::save
@@ -0,0 +1,192 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/components/area.h"
+#include "common/components/auction.h"
+#include "common/components/bodies.h"
+#include "common/components/coordinates.h"
+#include "common/components/economy.h"
+#include "common/components/history.h"
+#include "common/components/infrastructure.h"
+#include "common/components/name.h"
+#include "common/components/organizations.h"
+#include "common/components/player.h"
+#include "common/components/population.h"
+#include "common/components/ports.h"
+#include "common/components/resource.h"
+#include "common/components/science.h"
+#include "common/components/ships.h"
+#include "common/components/surface.h"
+#include "common/universe.h"
+
+namespace cqsp::common::systems::save {
+template <class... Components>
+struct ComponentList {
+    static constexpr size_t size = sizeof...(Components);
+
+    template <class Component>
+    static constexpr bool Contains() {
+        return (std::is_same_v<Component, Components> || ...);
+    }
+
+    /// <summary>
+    /// Index of the component in the list, which is the id of the component in saves
+    /// </summary>
+    template <class Component>
+    static constexpr uint16_t IndexOf() {
+        static_assert(Contains<Component>(), "Component is not in the list");
+        uint16_t index = 0;
+        (void)((std::is_same_v<Component, Components> || (index++, false)) || ...);
+        return index;
+    }
+
+    /// <summary>
+    /// Calls function.template operator()&lt;Component, index&gt;() for every component in the list, in order
+    /// </summary>
+    template <class Function>
+    static void ForEach(Function&& function) {
+        ForEach(function, std::index_sequence_for<Components...> {});
+    }
+
+ private:
+    template <class Function, size_t... Index>
+    static void ForEach(Function& function, std::index_sequence<Index...>) {
+        (function.template operator()<Components, Index>(), ...);
+    }
+};
+
+namespace cqspc = cqsp::common::components;
+namespace cqspb = cqsp::common::components::bodies;
+namespace cqspt = cqsp::common::components::types;
+
+/// <summary>
+/// Every component that is saved. Components of the client, such as the rendering components, and the event
+/// queues, which hold lua functions, are not saved.
+/// <br>
+/// The index of a component is its id in saves, so add new components at the end and increment the save version.
+/// </summary>
+using SavedComponents = ComponentList<
+    // Bodies
+    cqspb::Body, cqspb::TexturedTerrain, cqspb::NautralObject, cqspb::OrbitalSystem, cqspb::DirtyOrbit,
+    cqspb::Terrain, cqspb::TerrainData, cqspb::Star, cqspb::Planet, cqspb::LightEmitter,
+    // Coordinates
+    cqspt::Orbit, cqspt::OrbitDirty, cqspt::Kinematics, cqspt::Impulse, cqspt::GalacticCoordinate,
+    cqspt::MoveTarget, cqspt::SurfaceCoordinate,
+    // Goods and production
+    cqspc::Matter, cqspc::Energy, cqspc::Unit, cqspc::Good, cqspc::ConsumerGood, cqspc::Mineral, cqspc::Capital,
+    cqspc::ResourceLedger, cqspc::Recipe, cqspc::RecipeCost, cqspc::IndustrySize, cqspc::CostBreakdown,
+    cqspc::ResourceIO, cqspc::FactoryTimer, cqspc::ResourceConsumption, cqspc::ResourceProduction,
+    cqspc::ResourceConverter, cqspc::ResourceStockpile, cqspc::FailedResourceTransfer,
+    cqspc::FailedResourceProduction, cqspc::FailedResourceConsumption, cqspc::ResourceDistribution,
+    cqspc::IndustrialZone, cqspc::Production, cqspc::Factory, cqspc::Mine, cqspc::Service, cqspc::Farm,
+    cqspc::RawResourceGen,
+    // Economy
+    cqspc::Market, cqspc::Price, cqspc::Currency, cqspc::CostTable, cqspc::Wallet, cqspc::MarketAgent,
+    cqspc::MarketCenter, cqspc::Commercial, cqspc::Employer, cqspc::LaborInformation, cqspc::FactoryProducing,
+    cqspc::MarketHistory, cqspc::AuctionHouse,
+    // Infrastructure
+    cqspc::infrastructure::Infrastructure, cqspc::infrastructure::CityInfrastructure,
+    cqspc::infrastructure::PowerPlant, cqspc::infrastructure::PowerConsumption, cqspc::infrastructure::CityPower,
+    cqspc::infrastructure::BrownOut, cqspc::infrastructure::SpacePort, cqspc::infrastructure::Highway,
+    cqspc::infrastructure::TradeRoute,
+    // Organizations and people
+    cqspc::Name, cqspc::Identifier, cqspc::Description, cqspc::Governed, cqspc::Organization, cqspc::Country,
+    cqspc::CountryCityList, cqspc::Player, cqspc::PopulationSegment, cqspc::Hunger, cqspc::LaunchVehicle,
+    // Science
+    cqspc::science::Field, cqspc::science::Science, cqspc::science::Lab, cqspc::science::ScientificProgress,
+    cqspc::science::ScienceProject, cqspc::science::ScientificResearch, cqspc::science::TechnologicalProgress,
+    cqspc::science::Technology,
+    // Ships
+    cqspc::ships::Ship, cqspc::ships::Fleet, cqspc::ships::Command,
+    // Surface
+    cqspc::Surface, cqspc::Habitation, cqspc::Settlement, cqspc::TimeZone, cqspc::CityTimeZone, cqspc::Province,
+    cqspc::ProvinceColor>;
+
+/// <summary>
+/// Components that autosaves only copy after they change. Adding, removing, patching or replacing them marks them
+/// as changed, and code that changes them in place has to call MarkDirty, or autosaves will miss the change.
+/// Only the entities that are marked are copied again, so mark the entities that really changed where possible.
+/// <br>
+/// Every other saved component is copied on every autosave, except for tags, which can't change in place.
+/// </summary>
+using TrackedComponents = ComponentList<
+    // Changed in place by the simulation
+    cqspc::Market, cqspc::Wallet, cqspc::PopulationSegment, cqspt::Orbit,
+    // Only changed when the universe is loaded
+    cqspc::Name, cqspc::Identifier, cqspc::Description, cqspc::Unit, cqspc::ConsumerGood, cqspb::Body,
+    cqspb::TexturedTerrain, cqspb::Terrain, cqspb::TerrainData, cqspc::Province, cqspc::ProvinceColor,
+    cqspc::TimeZone, cqspc::CityTimeZone, cqspc::science::Field, cqspc::science::Science>;
+
+template <class Component>
+constexpr bool IsTracked() {
+    return std::is_empty_v<Component> || TrackedComponents::Contains<Component>();
+}
+
+/// <summary>
+/// The saved components that changed since the last autosave, by their index in SavedComponents. Only in the
+/// context of the universe when it is being autosaved.
+/// </summary>
+struct DirtyComponents {
+    /// <summary>
+    /// Pools where every component may have changed
+    /// </summary>
+    std::vector<bool> pools = std::vector<bool>(SavedComponents::size, false);
+    /// <summary>
+    /// Entities whose component changed, an entity can be in here more than once
+    /// </summary>
+    std::vector<std::vector<entt::entity>> entities = std::vector<std::vector<entt::entity>>(SavedComponents::size);
+
+    bool IsDirty(size_t pool) const { return pools[pool] || !entities[pool].empty(); }
+
+    void Clear() {
+        pools.assign(SavedComponents::size, false);
+        for (auto& changed : entities) {
+            changed.clear();
+        }
+    }
+};
+
+/// <summary>
+/// Tells the autosave that a tracked component may have changed in place on any entity
+/// </summary>
+template <class Component>
+void MarkDirty(Universe& universe) {
+    static_assert(TrackedComponents::Contains<Component>(), "Only tracked components have to be marked");
+    auto* dirty = universe.ctx().find<DirtyComponents>();
+    if (dirty != nullptr) {
+        dirty->pools[SavedComponents::IndexOf<Component>()] = true;
+    }
+}
+
+/// <summary>
+/// Tells the autosave that the component of the entity was changed in place
+/// </summary>
+template <class Component>
+void MarkDirty(Universe& universe, entt::entity entity) {
+    static_assert(TrackedComponents::Contains<Component>(), "Only tracked components have to be marked");
+    auto* dirty = universe.ctx().find<DirtyComponents>();
+    if (dirty != nullptr) {
+        dirty->entities[SavedComponents::IndexOf<Component>()].push_back(entity);
+    }
+}
+}  // namespace cqsp::common::systems::save
@@ -0,0 +1,425 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/systems/save/savegame.h"
+
+#include <lz4.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "common/systems/save/savearchive.h"
+#include "common/systems/save/savedcomponents.h"
+#include "common/util/paths.h"
+
+namespace cqsp::common::systems::save {
+namespace {
+/// <summary>
+/// Everything in the universe that isn't in the registry
+/// </summary>
+template <class Archive>
+void UniverseFields(Archive& archive, Universe& universe) {
+    archive.Field(universe.goods);
+    archive.Field(universe.consumergoods);
+    archive.Field(universe.recipes);
+    archive.Field(universe.terrain_data);
+    archive.Field(universe.fields);
+    archive.Field(universe.technologies);
+    archive.Field(universe.planets);
+    archive.Field(universe.time_zones);
+    archive.Field(universe.countries);
+    archive.Field(universe.provinces);
+    archive.Field(universe.province_colors);
+    archive.Field(universe.sun);
+    archive.Field(universe.event_wake_dates);
+}
+
+template <class Component>
+void WritePool(OutputArchive& archive, Universe& universe) {
+    auto view = universe.view<Component>();
+    archive.Field(static_cast<uint32_t>(view.size()));
+    if constexpr (std::is_empty_v<Component>) {
+        for (entt::entity entity : view) {
+            archive.Field(entity);
+        }
+    } else {
+        for (auto [entity, component] : view.each()) {
+            archive.Field(entity);
+            archive.Field(component);
+        }
+    }
+}
+
+template <class Component>
+void ReadPool(InputArchive& archive, Universe& universe) {
+    uint32_t count = 0;
+    archive.Field(count);
+    for (uint32_t i = 0; i < count && !archive.Failed(); i++) {
+        entt::entity entity;
+        archive.Field(entity);
+        if (!universe.valid(entity)) {
+            archive.Fail();
+            return;
+        }
+        if constexpr (std::is_empty_v<Component>) {
+            universe.emplace_or_replace<Component>(entity);
+        } else {
+            Component component {};
+            archive.Field(component);
+            universe.emplace_or_replace<Component>(entity, std::move(component));
+        }
+    }
+}
+
+template <class T>
+void Write(std::ostream& output, const T& value) {
+    output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+bool Read(std::istream& input, T& value) {
+    input.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return input.good();
+}
+
+std::filesystem::file_time_type GetSaveTime(const std::string& path) {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return std::filesystem::file_time_type::min();
+    }
+    for (int delta = 1; std::filesystem::exists(GetDeltaPath(path, delta)); delta++) {
+        time = std::max(time, std::filesystem::last_write_time(GetDeltaPath(path, delta), error));
+    }
+    return time;
+}
+}  // namespace
+
+void WriteState(Universe& universe, std::vector<char>& buffer) {
+    buffer.clear();
+    OutputArchive archive(buffer);
+    archive.Field(universe.date.GetDate());
+    archive.Field(universe.random->GetState());
+    UniverseFields(archive, universe);
+}
+
+void WriteEntities(Universe& universe, std::vector<char>& buffer) {
+    buffer.clear();
+    OutputArchive archive(buffer);
+    entt::snapshot {universe}.entities(archive);
+}
+
+SaveData MakeSave(Universe& universe) {
+    ZoneScoped;
+    SaveData save;
+    WriteState(universe, save.state);
+    WriteEntities(universe, save.entities);
+    SavedComponents::ForEach([&]<class Component, size_t id>() {
+        OutputArchive archive(save.pools[id]);
+        WritePool<Component>(archive, universe);
+    });
+    return save;
+}
+
+void MergeSave(SaveData& save, SaveData&& delta) {
+    save.state = std::move(delta.state);
+    save.entities = std::move(delta.entities);
+    for (auto& [id, pool] : delta.pools) {
+        save.pools[id] = std::move(pool);
+    }
+}
+
+bool LoadSave(Universe& universe, const SaveData& save) {
+    ZoneScoped;
+    if (save.kind != SaveKind::Full) {
+        SPDLOG_ERROR("Only full saves can be loaded, deltas have to be merged into a full save");
+        return false;
+    }
+    if (save.pools.size() != SavedComponents::size || save.pools.rbegin()->first != SavedComponents::size - 1) {
+        SPDLOG_ERROR("Save doesn't have every component");
+        return false;
+    }
+
+    InputArchive state(save.state.data(), save.state.size());
+    int date;
+    std::string random_state;
+    state.Field(date);
+    state.Field(random_state);
+
+    universe.clear();
+    UniverseFields(state, universe);
+    if (state.Failed() || !state.AtEnd()) {
+        SPDLOG_ERROR("Save is corrupted");
+        return false;
+    }
+
+    InputArchive entities(save.entities.data(), save.entities.size());
+    entt::snapshot_loader {universe}.entities(entities);
+    if (entities.Failed() || !entities.AtEnd()) {
+        SPDLOG_ERROR("Save is corrupted");
+        return false;
+    }
+
+    bool loaded = true;
+    SavedComponents::ForEach([&]<class Component, size_t id>() {
+        const std::vector<char>& pool = save.pools.at(id);
+        InputArchive archive(pool.data(), pool.size());
+        ReadPool<Component>(archive, universe);
+        if (archive.Failed() || !archive.AtEnd()) {
+            SPDLOG_ERROR("Save is corrupted at component {}", id);
+            loaded = false;
+        }
+    });
+    if (!loaded) {
+        return false;
+    }
+
+    universe.date.SetDate(date);
+    universe.random->SetState(random_state);
+    return true;
+}
+
+bool WriteSave(std::ostream& output, const SaveData& save, bool compress) {
+    ZoneScoped;
+    std::vector<char> buffer;
+    OutputArchive archive(buffer);
+    archive.Field(save.state);
+    archive.Field(save.entities);
+    archive.Field(save.pools);
+
+    SaveCompression compression = SaveCompression::None;
+    std::vector<char> compressed;
+    const char* data = buffer.data();
+    uint64_t stored_size = buffer.size();
+    if (compress && !buffer.empty() && buffer.size() <= static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+        ZoneScopedN("Compress");
+        compressed.resize(LZ4_compressBound(static_cast<int>(buffer.size())));
+        int compressed_size = LZ4_compress_default(buffer.data(), compressed.data(), static_cast<int>(buffer.size()),
+                                                   static_cast<int>(compressed.size()));
+        if (compressed_size > 0) {
+            compression = SaveCompression::LZ4;
+            data = compressed.data();
+            stored_size = compressed_size;
+        }
+    }
+
+    output.write(save_magic, sizeof(save_magic));
+    Write(output, save_version);
+    Write(output, save.kind);
+    Write(output, compression);
+    Write(output, static_cast<uint64_t>(buffer.size()));
+    Write(output, stored_size);
+    output.write(data, stored_size);
+    return output.good();
+}
+
+bool ReadSave(std::istream& input, SaveData& save) {
+    ZoneScoped;
+    char file_magic[4];
+    uint32_t file_version;
+    SaveCompression compression;
+    uint64_t size;
+    uint64_t stored_size;
+    input.read(file_magic, sizeof(file_magic));
+    if (!input.good() || memcmp(file_magic, save_magic, sizeof(save_magic)) != 0) {
+        SPDLOG_ERROR("Not a save file");
+        return false;
+    }
+    if (!Read(input, file_version) || file_version != save_version) {
+        SPDLOG_ERROR("Save version {} is not supported, the current version is {}", file_version, save_version);
+        return false;
+    }
+    if (!Read(input, save.kind) || !Read(input, compression) || !Read(input, size) || !Read(input, stored_size)) {
+        SPDLOG_ERROR("Save header is incomplete");
+        return false;
+    }
+
+    std::vector<char> stored(stored_size);
+    input.read(stored.data(), stored_size);
+    if (static_cast<uint64_t>(input.gcount()) != stored_size) {
+        SPDLOG_ERROR("Save is truncated");
+        return false;
+    }
+
+    std::vector<char> buffer;
+    if (compression == SaveCompression::LZ4) {
+        ZoneScopedN("Decompress");
+        if (size > static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+            stored_size > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+            SPDLOG_ERROR("Save is too large");
+            return false;
+        }
+        buffer.resize(size);
+        int result = LZ4_decompress_safe(stored.data(), buffer.data(), static_cast<int>(stored_size),
+                                         static_cast<int>(size));
+        if (result != static_cast<int>(size)) {
+            SPDLOG_ERROR("Failed to decompress save");
+            return false;
+        }
+    } else if (compression == SaveCompression::None && size == stored_size) {
+        buffer = std::move(stored);
+    } else {
+        SPDLOG_ERROR("Unknown save compression {}", static_cast<int>(compression));
+        return false;
+    }
+
+    InputArchive archive(buffer.data(), buffer.size());
+    archive.Field(save.state);
+    archive.Field(save.entities);
+    archive.Field(save.pools);
+    if (archive.Failed() || !archive.AtEnd() ||
+        (!save.pools.empty() && save.pools.rbegin()->first >= SavedComponents::size)) {
+        SPDLOG_ERROR("Save is corrupted");
+        return false;
+    }
+    return true;
+}
+
+bool WriteSave(const std::string& path, const SaveData& save, bool compress) {
+    std::filesystem::path file_path(path);
+    if (file_path.has_parent_path()) {
+        std::filesystem::create_directories(file_path.parent_path());
+    }
+    std::filesystem::path temp_path = file_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream output(temp_path, std::ios::binary);
+        if (!output.good() || !WriteSave(output, save, compress)) {
+            SPDLOG_ERROR("Cannot write save {}", path);
+            return false;
+        }
+    }
+    std::error_code error;
+    if (save.kind == SaveKind::Full) {
+        // The deltas of the last full save don't apply to this one. If the game stops before the new save
+        // replaces the old one, the old save is still loaded as it was when it was written.
+        int delta = 1;
+        while (std::filesystem::remove(GetDeltaPath(path, delta), error)) {
+            delta++;
+        }
+    }
+    std::filesystem::rename(temp_path, file_path, error);
+    if (error) {
+        SPDLOG_ERROR("Cannot write save {}: {}", path, error.message());
+        return false;
+    }
+    return true;
+}
+
+std::string GetDeltaPath(const std::string& path, int delta) { return path + "." + std::to_string(delta); }
+
+bool SaveUniverse(Universe& universe, std::ostream& output, bool compress) {
+    return WriteSave(output, MakeSave(universe), compress);
+}
+
+bool SaveUniverse(Universe& universe, const std::string& path, bool compress) {
+    if (!WriteSave(path, MakeSave(universe), compress)) {
+        return false;
+    }
+    SPDLOG_INFO("Saved universe to {}", path);
+    return true;
+}
+
+bool LoadUniverse(Universe& universe, std::istream& input) {
+    SaveData save;
+    return ReadSave(input, save) && LoadSave(universe, save);
+}
+
+bool LoadUniverse(Universe& universe, const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input.good()) {
+        SPDLOG_ERROR("Cannot open save {}", path);
+        return false;
+    }
+    SaveData save;
+    if (!ReadSave(input, save)) {
+        SPDLOG_ERROR("Cannot load save {}", path);
+        return false;
+    }
+    for (int delta = 1; std::filesystem::exists(GetDeltaPath(path, delta)); delta++) {
+        std::ifstream delta_input(GetDeltaPath(path, delta), std::ios::binary);
+        SaveData delta_save;
+        if (!ReadSave(delta_input, delta_save) || delta_save.kind != SaveKind::Delta) {
+            // Everything up to the last good delta is still consistent
+            SPDLOG_WARN("Cannot load delta {} of save {}, loading the deltas before it", delta, path);
+            break;
+        }
+        MergeSave(save, std::move(delta_save));
+    }
+    if (!LoadSave(universe, save)) {
+        SPDLOG_ERROR("Cannot load save {}", path);
+        return false;
+    }
+    SPDLOG_INFO("Loaded universe from {}", path);
+    return true;
+}
+
+void MoveUniverse(Universe& source, Universe& target) {
+    ZoneScoped;
+    static_cast<entt::registry&>(target) = std::move(static_cast<entt::registry&>(source));
+    // Same as UniverseFields
+    target.goods = std::move(source.goods);
+    target.consumergoods = std::move(source.consumergoods);
+    target.recipes = std::move(source.recipes);
+    target.terrain_data = std::move(source.terrain_data);
+    target.fields = std::move(source.fields);
+    target.technologies = std::move(source.technologies);
+    target.planets = std::move(source.planets);
+    target.time_zones = std::move(source.time_zones);
+    target.countries = std::move(source.countries);
+    target.provinces = std::move(source.provinces);
+    target.province_colors = std::move(source.province_colors);
+    target.sun = source.sun;
+    target.event_wake_dates = std::move(source.event_wake_dates);
+    target.date = source.date;
+    // The name generators point at the random generator, so keep it and only take its state
+    target.random->SetState(source.random->GetState());
+}
+
+std::string GetQuicksavePath() {
+    return (std::filesystem::path(util::GetCqspSavePath()) / "saves" / (std::string("quicksave") + save_extension))
+        .string();
+}
+
+std::string GetAutosavePath() {
+    return (std::filesystem::path(util::GetCqspSavePath()) / "saves" / (std::string("autosave") + save_extension))
+        .string();
+}
+
+std::string GetLatestSavePath() {
+    std::string quicksave = GetQuicksavePath();
+    std::string autosave = GetAutosavePath();
+    bool has_quicksave = std::filesystem::exists(quicksave);
+    bool has_autosave = std::filesystem::exists(autosave);
+    if (has_quicksave && has_autosave) {
+        return GetSaveTime(autosave) > GetSaveTime(quicksave) ? autosave : quicksave;
+    }
+    if (has_quicksave) {
+        return quicksave;
+    }
+    if (has_autosave) {
+        return autosave;
+    }
+    return "";
+}
+}  // namespace cqsp::common::systems::save
@@ -0,0 +1,138 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "common/universe.h"
+
+namespace cqsp::common::systems::save {
+enum class SaveCompression : uint8_t {
+    None = 0,
+    LZ4 = 1,
+};
+
+enum class SaveKind : uint8_t {
+    /// Everything in the universe
+    Full = 0,
+    /// Only the components that changed since the save before it. Loaded on top of a full save.
+    Delta = 1,
+};
+
+/// <summary>
+/// Save files start with the magic and version, then the kind of save, the compression, the size of the saved
+/// data and the size that it is stored as.
+/// </summary>
+constexpr char save_magic[4] = {'C', 'Q', 'S', 'V'};
+/// <summary>
+/// Increment this whenever the saved components or their fields change, older saves will then refuse to load
+/// instead of loading garbage.
+/// </summary>
+constexpr uint32_t save_version = 5;
+constexpr char save_extension[] = ".cqsave";
+
+/// <summary>
+/// A save that is split into blocks, so that deltas can replace the blocks of the saves before them.
+/// </summary>
+struct SaveData {
+    SaveKind kind = SaveKind::Full;
+    /// <summary>
+    /// Date, random generator and lookup maps of the universe
+    /// </summary>
+    std::vector<char> state;
+    /// <summary>
+    /// Entities of the registry, alive and destroyed
+    /// </summary>
+    std::vector<char> entities;
+    /// <summary>
+    /// Component blocks, by the index of the component in SavedComponents. Each block is the count, then
+    /// each entity followed by its component.
+    /// </summary>
+    std::map<uint16_t, std::vector<char>> pools;
+};
+
+void WriteState(Universe& universe, std::vector<char>& buffer);
+void WriteEntities(Universe& universe, std::vector<char>& buffer);
+
+/// <summary>
+/// Serializes everything in the universe into a full save
+/// </summary>
+SaveData MakeSave(Universe& universe);
+
+/// <summary>
+/// Replaces the blocks of the save with the blocks of the delta.
+/// </summary>
+void MergeSave(SaveData& save, SaveData&& delta);
+
+/// <summary>
+/// Replaces everything in the universe with a full save. The goods and other data that are loaded from
+/// scripts should already be loaded, because the name generators and scripts are not saved.
+/// </summary>
+/// <returns>If the save was loaded. If it wasn't, the universe may be half loaded and should be thrown away.</returns>
+bool LoadSave(Universe& universe, const SaveData& save);
+
+/// <param name="compress">Compress the save with lz4</param>
+/// <returns>If the whole save was written</returns>
+bool WriteSave(std::ostream& output, const SaveData& save, bool compress = true);
+bool ReadSave(std::istream& input, SaveData& save);
+
+/// <summary>
+/// Writes the save to a temporary file first and then replaces the file, so that a crash while saving doesn't
+/// destroy the last save.
+/// </summary>
+bool WriteSave(const std::string& path, const SaveData& save, bool compress = true);
+
+/// <summary>
+/// Path of the nth delta of a save
+/// </summary>
+std::string GetDeltaPath(const std::string& path, int delta);
+
+bool SaveUniverse(Universe& universe, std::ostream& output, bool compress = true);
+bool SaveUniverse(Universe& universe, const std::string& path, bool compress = true);
+
+bool LoadUniverse(Universe& universe, std::istream& input);
+/// <summary>
+/// Loads the save and every delta that was written after it.
+/// </summary>
+bool LoadUniverse(Universe& universe, const std::string& path);
+
+/// <summary>
+/// Moves everything that is saved from one universe into another, so that a save can be loaded into a separate
+/// universe and only replace the game once it has loaded. What isn't saved, like the name generators, is kept.
+/// </summary>
+void MoveUniverse(Universe& source, Universe& target);
+
+/// <summary>
+/// Path of the save that quick saving writes to, in the save folder
+/// </summary>
+std::string GetQuicksavePath();
+
+/// <summary>
+/// Path of the autosave, in the save folder
+/// </summary>
+std::string GetAutosavePath();
+
+/// <summary>
+/// The quick save or autosave, whichever was written last, or an empty string if there are none.
+/// </summary>
+std::string GetLatestSavePath();
+}  // namespace cqsp::common::systems::save
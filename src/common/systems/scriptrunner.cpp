@@ -18,30 +18,119 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <map>
 #include <string>
 #include <vector>
 
 #include "common/util/profiler.h"
 
 cqsp::common::systems::SysScript::SysScript(Game &game) : ISimulationSystem(game) {
-    sol::optional<std::vector<sol::table>> optional = game.GetScriptInterface()["events"]["data"];
-    events = *optional;
+    scripting::ScriptInterface &script = game.GetScriptInterface();
+    // What the universe was saved with, the events write their own dates into it as they are scheduled
+    std::map<std::string, int> wake_dates = std::move(game.GetUniverse().event_wake_dates);
+    game.GetUniverse().event_wake_dates.clear();
+    sol::optional<std::vector<sol::table>> optional = script["events"]["data"];
+    if (!optional) {
+        return;
+    }
+    for (sol::table &table : *optional) {
+        ScriptEvent &event = events.emplace_back();
+        event.table = table;
+        event.on_tick = table["on_tick"];
+        event.budget = table.get_or("budget", 0);
+        if (event.budget > 0) {
+            // Compiled code does not count instructions, so only events without a budget are compiled
+            script.Interpret(event.on_tick);
+        }
+        event.wake_date = -1;
+        // Events are inserted in the same order every time, so the index works as an id if there isn't one
+        event.id = table.get_or<std::string>("id", std::to_string(events.size() - 1));
+        event_index[table.pointer()] = events.size() - 1;
+
+        auto saved = wake_dates.find(event.id);
+        if (saved == wake_dates.end()) {
+            // Every new event runs on the first tick, and asks for when it runs next
+            Wake(events.size() - 1, 0);
+        } else if (saved->second >= 0) {
+            Wake(events.size() - 1, saved->second);
+        }
+    }
+    script["events"]["wake"] = [this](const sol::table &, const sol::table &event, sol::optional<int> date) {
+        auto index = event_index.find(event.pointer());
+        if (index == event_index.end()) {
+            SPDLOG_WARN("Cannot wake an event that was not inserted into events");
+            return;
+        }
+        Wake(index->second, date.value_or(0));
+    };
 }
 
 cqsp::common::systems::SysScript::~SysScript() {
+    // The events table outlives this system, so it can't call back into it
+    GetGame().GetScriptInterface()["events"]["wake"] = sol::nil;
     // So it doesn't crash when we delete this
-    for (auto &evet : events) {
-        evet.abandon();
+    for (auto &event : events) {
+        event.table.abandon();
+        event.on_tick.abandon();
     }
     events.clear();
 }
 
 void cqsp::common::systems::SysScript::DoSystem() {
+    int date = GetUniverse().date.GetDate();
+    if (schedule.empty() || schedule.begin()->first > date) {
+        return;
+    }
     BEGIN_TIMED_BLOCK(ScriptEngine);
-    GetGame().GetScriptInterface()["date"] = GetUniverse().date.GetDate();
-    for (auto &a : events) {
-        sol::protected_function_result result = a["on_tick"](a);
-        GetGame().GetScriptInterface().ParseResult(result);
+    scripting::ScriptInterface &script = GetGame().GetScriptInterface();
+    script["date"] = date;
+    while (!schedule.empty() && schedule.begin()->first <= date) {
+        size_t index = schedule.begin()->second;
+        schedule.erase(schedule.begin());
+        SetWakeDate(index, -1);
+
+        sol::protected_function_result result =
+            script.CallWithBudget(events[index].on_tick, events[index].budget, events[index].table);
+        if (!result.valid()) {
+            script.ParseResult(result);
+            SPDLOG_WARN("Event failed on date {}, it will sleep until it is woken", date);
+            Sleep(index);
+            continue;
+        }
+        sol::object next = result;
+        if (next.get_type() == sol::type::number) {
+            Wake(index, static_cast<int>(next.as<double>()));
+        } else if (next.get_type() != sol::type::boolean || next.as<bool>()) {
+            Wake(index, date + 1);
+        }
     }
     END_TIMED_BLOCK(ScriptEngine);
 }
+
+void cqsp::common::systems::SysScript::Wake(size_t event, int date) {
+    date = std::max(date, GetUniverse().date.GetDate() + 1);
+    int &wake_date = events[event].wake_date;
+    if (wake_date >= 0) {
+        if (wake_date <= date) {
+            // Already runs sooner
+            return;
+        }
+        schedule.erase({wake_date, event});
+    }
+    SetWakeDate(event, date);
+    schedule.insert({date, event});
+}
+
+void cqsp::common::systems::SysScript::Sleep(size_t event) {
+    int wake_date = events[event].wake_date;
+    if (wake_date >= 0) {
+        schedule.erase({wake_date, event});
+    }
+    SetWakeDate(event, -1);
+}
+
+void cqsp::common::systems::SysScript::SetWakeDate(size_t event, int date) {
+    events[event].wake_date = date;
+    GetUniverse().event_wake_dates[events[event].id] = date;
+}
@@ -16,6 +16,10 @@
 */
 #pragma once
 
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "common/scripting/scripting.h"
@@ -29,22 +33,31 @@ namespace systems {
 /// Runs scripts that are added to the game
 /// </summary>
 ///
-/// To run a script every single tick, you have to do this:
+/// To run a script, you have to do this:
 /// ```lua
 /// local test_event = {
 ///     -- you can define all sorts of variables needed here
+///     -- optional, the most lua instructions that on_tick can run
+///     budget = 100000
 /// }
 ///
 /// local test_event:on_tick()
 ///     -- All sorts of events take place here
+///     -- Return the date to run next, false to sleep until the event is woken, or nothing to run next tick
+///     return date + 24
 /// end
 ///
 /// -- then add it to the event queue.
 /// events:insert(test_event)
 /// ```
 ///
-/// This is likely to be unoptimized because it runs all the scripts every
-/// single tick.
+/// Events only run on the dates that they ask for, so events that are waiting for something should sleep
+/// and be woken with `events:wake(event)`, or `events:wake(event, date)` to run on a date.
+/// The dates that the events run next are saved by the `id` of the event, or by the order that the events are
+/// inserted in if they don't have one. Only the dates are saved, not the fields of the event.
+/// Events that fail or run out of their budget are put to sleep. Events without a budget run for as long as they
+/// need to, so an event that loops forever hangs the game. Budgets are only worth it for events that can loop for
+/// long, because on LuaJIT, events with a budget are interpreted, which makes them several times slower.
 class SysScript : public cqsp::common::systems::ISimulationSystem {
  public:
     explicit SysScript(Game& game);
@@ -52,8 +65,38 @@ class SysScript : public cqsp::common::systems::ISimulationSystem {
     void DoSystem();
     int Interval() { return 1; }
 
+    /// <summary>
+    /// Makes the event run on the date, or on the next tick if the date has passed.
+    /// </summary>
+    void Wake(size_t event, int date);
+
  private:
-    std::vector<sol::table> events;
+    struct ScriptEvent {
+        std::string id;
+        sol::table table;
+        sol::protected_function on_tick;
+        int budget;
+        /// <summary>
+        /// Date that the event runs next, or -1 if it is asleep
+        /// </summary>
+        int wake_date;
+    };
+
+    void Sleep(size_t event);
+    /// <summary>
+    /// Keeps the date in the universe too, so that it is saved
+    /// </summary>
+    void SetWakeDate(size_t event, int date);
+
+    std::vector<ScriptEvent> events;
+    /// <summary>
+    /// Events that are awake, ordered by the date that they run next
+    /// </summary>
+    std::set<std::pair<int, size_t>> schedule;
+    /// <summary>
+    /// Index of the events by their lua table, so that lua can wake them
+    /// </summary>
+    std::unordered_map<const void*, size_t> event_index;
 };
 }  // namespace systems
 }  // namespace common
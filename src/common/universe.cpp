@@ -20,4 +20,8 @@
 
 #include "common/util/random/stdrandom.h"
 
-cqsp::common::Universe::Universe() { random = std::make_unique<cqsp::common::util::StdRandom>(42); }
+cqsp::common::Universe::Universe() : Universe(42) {}
+
+cqsp::common::Universe::Universe(int seed) {
+    random = std::make_unique<cqsp::common::util::StdRandom>(seed);
+}
@@ -32,6 +32,8 @@ namespace common {
 class Universe : public entt::registry {
  public:
     Universe();
+    /// <param name="seed">Seed of the random generator, so that the same seed and inputs play out the same</param>
+    explicit Universe(int seed);
     components::StarDate date;
 
     std::map<std::string, entt::entity> goods;
@@ -46,6 +48,11 @@ class Universe : public entt::registry {
     std::map<std::string, entt::entity> countries;
     std::map<std::string, entt::entity> provinces;
     std::map<int, entt::entity> province_colors;
+    /// <summary>
+    /// Date that each script event runs next by the id of the event, or -1 if it is asleep, so that events keep
+    /// their schedule when the universe is saved and loaded.
+    /// </summary>
+    std::map<std::string, int> event_wake_dates;
 
     entt::entity sun;
 
@@ -0,0 +1,229 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/util/noisemapbuilder.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <tracy/Tracy.hpp>
+
+void cqsp::common::util::BuildSphereNoiseMap(const noise::module::Module& module, noise::utils::NoiseMap& dest,
+                                             int width, int height, unsigned int thread_count) {
+    ZoneScoped;
+    dest.SetSize(width, height);
+    noise::model::Sphere sphere(module);
+    const double x_delta = 360.0 / width;
+    const double y_delta = 180.0 / height;
+    const int tiles_x = (width + noise_map_tile_size - 1) / noise_map_tile_size;
+    const int tiles_y = (height + noise_map_tile_size - 1) / noise_map_tile_size;
+    ParallelForEach(tiles_x * tiles_y, thread_count, [&](int tile) {
+        const int x_begin = (tile % tiles_x) * noise_map_tile_size;
+        const int y_begin = (tile / tiles_x) * noise_map_tile_size;
+        const int x_end = std::min(x_begin + noise_map_tile_size, width);
+        const int y_end = std::min(y_begin + noise_map_tile_size, height);
+        for (int y = y_begin; y < y_end; y++) {
+            float* row = dest.GetSlabPtr(y);
+            const double lat = -90.0 + y * y_delta;
+            for (int x = x_begin; x < x_end; x++) {
+                row[x] = static_cast<float>(sphere.GetValue(lat, -180.0 + x * x_delta));
+            }
+        }
+    });
+}
+
+void cqsp::common::util::RenderNoiseImage(const noise::utils::NoiseMap& source, noise::utils::Image& dest,
+                                          const std::function<void(noise::utils::RendererImage&)>& configure,
+                                          unsigned int thread_count) {
+    ZoneScoped;
+    const int width = source.GetWidth();
+    dest.SetSize(width, source.GetHeight());
+    ParallelForRange(source.GetHeight(), thread_count, [&](int begin, int end) {
+        if (begin == end) {
+            return;
+        }
+        // The renderer only works on whole noise maps, so copy the band out and render that
+        noise::utils::NoiseMap band_map(width, end - begin);
+        for (int y = begin; y < end; y++) {
+            std::copy_n(source.GetConstSlabPtr(y), width, band_map.GetSlabPtr(y - begin));
+        }
+        noise::utils::Image band_image;
+        noise::utils::RendererImage renderer;
+        configure(renderer);
+        renderer.SetSourceNoiseMap(band_map);
+        renderer.SetDestImage(band_image);
+        renderer.Render();
+        for (int y = begin; y < end; y++) {
+            std::copy_n(band_image.GetConstSlabPtr(y - begin), width, dest.GetSlabPtr(y));
+        }
+    });
+}
+
+using cqsp::common::util::NoiseMapCache;
+
+namespace {
+// Magic and version of the files in the disk cache
+constexpr char noise_cache_magic[4] = {'C', 'Q', 'N', 'M'};
+constexpr int noise_cache_version = 1;
+}  // namespace
+
+NoiseMapCache::NoiseMapCache(std::string _directory, size_t _max_entries)
+    : directory(std::move(_directory)), max_entries(std::max<size_t>(_max_entries, 1)) {
+    if (!directory.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            SPDLOG_WARN("Cannot create noise map cache directory {}: {}", directory, ec.message());
+            directory.clear();
+        }
+    }
+}
+
+std::shared_ptr<const noise::utils::NoiseMap> NoiseMapCache::Get(
+    int seed, int octaves, int size, const std::function<void(noise::utils::NoiseMap&)>& generate) {
+    ZoneScoped;
+    Key key(seed, octaves, size);
+    std::unique_lock lock(mutex);
+    if (auto it = maps.find(key); it != maps.end()) {
+        lru.splice(lru.begin(), lru, it->second.second);
+        return it->second.first;
+    }
+    if (auto it = pending.find(key); it != pending.end()) {
+        // Another thread is already building this map, so wait for it instead of building it twice
+        std::shared_future<std::shared_ptr<noise::utils::NoiseMap>> future = it->second;
+        lock.unlock();
+        return future.get();
+    }
+
+    // Build the map without holding the lock, so that other maps can be fetched or built in the meantime
+    std::promise<std::shared_ptr<noise::utils::NoiseMap>> promise;
+    pending[key] = promise.get_future().share();
+    lock.unlock();
+
+    auto map = std::make_shared<noise::utils::NoiseMap>();
+    try {
+        if (!Load(key, *map)) {
+            generate(*map);
+            Save(key, *map);
+        }
+    } catch (...) {
+        lock.lock();
+        pending.erase(key);
+        lock.unlock();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    lock.lock();
+    pending.erase(key);
+    lru.push_front(key);
+    maps[key] = std::make_pair(map, lru.begin());
+    while (maps.size() > max_entries) {
+        maps.erase(lru.back());
+        lru.pop_back();
+    }
+    lock.unlock();
+    promise.set_value(map);
+    return map;
+}
+
+bool NoiseMapCache::Contains(int seed, int octaves, int size) {
+    std::lock_guard lock(mutex);
+    return maps.find(Key(seed, octaves, size)) != maps.end();
+}
+
+void NoiseMapCache::Clear() {
+    std::lock_guard lock(mutex);
+    maps.clear();
+    lru.clear();
+}
+
+size_t NoiseMapCache::GetSize() {
+    std::lock_guard lock(mutex);
+    return maps.size();
+}
+
+std::string NoiseMapCache::GetFilePath(const Key& key) {
+    return (std::filesystem::path(directory) /
+            fmt::format("{}_{}_{}.noise", std::get<0>(key), std::get<1>(key), std::get<2>(key)))
+        .string();
+}
+
+bool NoiseMapCache::Load(const Key& key, noise::utils::NoiseMap& map) {
+    if (directory.empty()) {
+        return false;
+    }
+    std::ifstream file(GetFilePath(key), std::ios::binary);
+    if (!file.good()) {
+        return false;
+    }
+    char magic[4];
+    int version = 0;
+    int width = 0;
+    int height = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    if (!file.good() || !std::equal(magic, magic + 4, noise_cache_magic) || version != noise_cache_version ||
+        width <= 0 || height <= 0) {
+        return false;
+    }
+    map.SetSize(width, height);
+    for (int y = 0; y < height; y++) {
+        file.read(reinterpret_cast<char*>(map.GetSlabPtr(y)), sizeof(float) * width);
+    }
+    if (!file.good()) {
+        SPDLOG_WARN("Noise map cache file {} is truncated", GetFilePath(key));
+        return false;
+    }
+    return true;
+}
+
+void NoiseMapCache::Save(const Key& key, const noise::utils::NoiseMap& map) {
+    if (directory.empty()) {
+        return;
+    }
+    // Write to a temporary file first so that a crash never leaves half a map behind
+    std::string path = GetFilePath(key);
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        int width = map.GetWidth();
+        int height = map.GetHeight();
+        file.write(noise_cache_magic, sizeof(noise_cache_magic));
+        file.write(reinterpret_cast<const char*>(&noise_cache_version), sizeof(noise_cache_version));
+        file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+        file.write(reinterpret_cast<const char*>(&height), sizeof(height));
+        for (int y = 0; y < height; y++) {
+            file.write(reinterpret_cast<const char*>(map.GetConstSlabPtr(y)), sizeof(float) * width);
+        }
+        if (!file.good()) {
+            SPDLOG_WARN("Cannot write noise map cache file {}", temp_path);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        SPDLOG_WARN("Cannot write noise map cache file {}: {}", path, ec.message());
+    }
+}
@@ -0,0 +1,107 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <noise/noise.h>
+#include <noiseutils.h>
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "common/util/parallel.h"
+
+namespace cqsp::common::util {
+/// Width and height of the tiles that noise maps are built in
+constexpr int noise_map_tile_size = 64;
+
+/// <summary>
+/// Builds a noise map of the entire sphere, the same as noise::utils::NoiseMapBuilderSphere with bounds of
+/// -90 to 90 latitude and -180 to 180 longitude, but the map is split into tiles that are built on separate
+/// threads.
+/// <br />
+/// Every pixel is computed from its row and column, so the output does not depend on the thread count.
+/// </summary>
+/// <param name="module">Noise module to sample, it is only read from</param>
+/// <param name="thread_count">Number of threads to use, 0 uses all the hardware threads</param>
+void BuildSphereNoiseMap(const noise::module::Module& module, noise::utils::NoiseMap& dest, int width, int height,
+                         unsigned int thread_count = 0);
+
+/// <summary>
+/// Renders the noise map into the image in latitude bands on separate threads.
+/// <br />
+/// Every band gets its own renderer, so configure is called once per band to set up the gradient and lighting.
+/// Lighting is computed per band, so it will not blend across band edges.
+/// </summary>
+void RenderNoiseImage(const noise::utils::NoiseMap& source, noise::utils::Image& dest,
+                      const std::function<void(noise::utils::RendererImage&)>& configure,
+                      unsigned int thread_count = 0);
+
+/// <summary>
+/// Keeps generated noise maps so that they only have to be generated once.
+/// <br />
+/// Maps are keyed by the seed, octave count and size they were generated with, so everything else about the
+/// noise has to stay the same for every map in one cache. The most recently used maps are kept in memory, and
+/// if a directory is set, every map is also written to disk so that it survives restarts.
+/// </summary>
+class NoiseMapCache {
+ public:
+    /// <param name="directory">Directory to save the maps to, empty to only cache in memory</param>
+    /// <param name="max_entries">Number of maps to keep in memory</param>
+    explicit NoiseMapCache(std::string directory = "", size_t max_entries = 16);
+
+    /// <summary>
+    /// Gets the noise map from memory or disk, or calls generate to build it if it is not cached.
+    /// <br />
+    /// The map is built without holding the lock, so different maps can be built on different threads at once.
+    /// Threads that ask for a map that is being built wait for it instead of building it again.
+    /// </summary>
+    std::shared_ptr<const noise::utils::NoiseMap> Get(int seed, int octaves, int size,
+                                                      const std::function<void(noise::utils::NoiseMap&)>& generate);
+
+    /// If the map is in memory
+    bool Contains(int seed, int octaves, int size);
+
+    /// Clears the memory cache, the maps on disk are kept
+    void Clear();
+
+    size_t GetSize();
+
+ private:
+    typedef std::tuple<int, int, int> Key;
+
+    std::string GetFilePath(const Key& key);
+    bool Load(const Key& key, noise::utils::NoiseMap& map);
+    void Save(const Key& key, const noise::utils::NoiseMap& map);
+
+    std::string directory;
+    size_t max_entries;
+
+    std::mutex mutex;
+    /// Most recently used maps at the front
+    std::list<Key> lru;
+    std::map<Key, std::pair<std::shared_ptr<noise::utils::NoiseMap>, std::list<Key>::iterator>> maps;
+    /// Maps that are being built right now
+    std::map<Key, std::shared_future<std::shared_ptr<noise::utils::NoiseMap>>> pending;
+};
+}  // namespace cqsp::common::util
@@ -0,0 +1,175 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "common/util/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cqsp::common::util {
+namespace {
+struct Job {
+    const std::function<void(int, int)>* func;
+    int count;
+    int tasks;
+    std::atomic_int next = 0;
+    std::atomic_int done = 0;
+    /// <summary>
+    /// The first exception that a task threw, thrown again by the thread that runs the job
+    /// </summary>
+    std::exception_ptr error;
+};
+
+class ThreadPool {
+ public:
+    ThreadPool() {
+        // The thread that calls Run works as well, so leave a hardware thread for it
+        unsigned int count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        workers.reserve(count);
+        for (unsigned int i = 0; i < count; i++) {
+            workers.emplace_back([this]() { Work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        condition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void Run(Job& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(&job);
+        }
+        condition.notify_all();
+
+        // Work on the job here too. A worker that calls this from inside a task then always makes progress
+        // on its own job, so nested calls can't deadlock waiting for the pool.
+        for (int task = job.next++; task < job.tasks; task = job.next++) {
+            RunTask(job, task);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&job]() { return job.done == job.tasks; });
+        // Workers only look at the job while holding the lock, so it can be removed and freed after this
+        auto it = std::find(jobs.begin(), jobs.end(), &job);
+        if (it != jobs.end()) {
+            jobs.erase(it);
+        }
+        lock.unlock();
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+ private:
+    void Work() {
+        while (true) {
+            Job* job = nullptr;
+            int task = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]() { return !running || !jobs.empty(); });
+                if (!running) {
+                    return;
+                }
+                job = jobs.front();
+                task = job->next++;
+                if (task >= job->tasks) {
+                    // Every task is taken, the thread that owns the job is waiting for the rest
+                    jobs.pop_front();
+                    continue;
+                }
+            }
+            RunTask(*job, task);
+        }
+    }
+
+    void RunTask(Job& job, int task) {
+        int begin = static_cast<int>(static_cast<long long>(job.count) * task / job.tasks);
+        int end = static_cast<int>(static_cast<long long>(job.count) * (task + 1) / job.tasks);
+        try {
+            (*job.func)(begin, end);
+        } catch (...) {
+            // Don't let it leave the task, the job has to be finished before it can be thrown
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+        }
+        if (++job.done == job.tasks) {
+            // The job may be freed as soon as it is done, so it can't be touched after this
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable finished;
+    std::deque<Job*> jobs;
+    bool running = true;
+};
+
+ThreadPool& GetThreadPool() {
+    static ThreadPool pool;
+    return pool;
+}
+}  // namespace
+
+void ParallelForRange(int count, unsigned int thread_count, const std::function<void(int, int)>& func) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = std::min(thread_count, static_cast<unsigned int>(std::max(count, 1)));
+    if (thread_count <= 1) {
+        func(0, count);
+        return;
+    }
+
+    Job job;
+    job.func = &func;
+    job.count = count;
+    job.tasks = static_cast<int>(thread_count);
+    GetThreadPool().Run(job);
+}
+
+void ParallelForEach(int count, unsigned int thread_count, const std::function<void(int)>& func) {
+    std::atomic_int next = 0;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Every thread pulls indices until there are none left
+    ParallelForRange(std::min(count, static_cast<int>(thread_count)), thread_count, [&](int, int) {
+        for (int index = next++; index < count; index = next++) {
+            func(index);
+        }
+    });
+}
+}  // namespace cqsp::common::util
@@ -0,0 +1,42 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <functional>
+
+namespace cqsp::common::util {
+/// <summary>
+/// Runs the function over the range [0, count), split into contiguous ranges that are run on separate threads.
+/// The function is given the beginning and the end of the range it has to process.
+/// <br />
+/// The ranges run on a pool of threads that is started on the first call and kept for the rest of the program,
+/// along with the calling thread, so it is cheap enough to call every tick. It can also be called from inside
+/// another parallel call.
+/// <br />
+/// If the function throws, the other ranges still run, and the first exception is thrown again from here once
+/// they are done.
+/// </summary>
+/// <param name="thread_count">Number of ranges to split into, 0 uses all the hardware threads</param>
+void ParallelForRange(int count, unsigned int thread_count, const std::function<void(int, int)>& func);
+
+/// <summary>
+/// Runs the function for every index in [0, count) on separate threads. Threads take the next index as soon
+/// as they are done with their last one, so it works best when the work per index is uneven.
+/// </summary>
+/// <param name="thread_count">Number of threads to use, 0 uses all the hardware threads</param>
+void ParallelForEach(int count, unsigned int thread_count, const std::function<void(int)>& func);
+}  // namespace cqsp::common::util
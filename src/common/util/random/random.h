@@ -16,6 +16,8 @@
 */
 #pragma once
 
+#include <string>
+
 namespace cqsp::common::util {
 class IRandom {
  public:
@@ -23,6 +25,12 @@ class IRandom {
     virtual int GetRandomInt(int, int) = 0;
     virtual int GetRandomNormal(double, double) = 0;
 
+    /// <summary>
+    /// The internal state of the generator, so that a save can carry on with the same numbers.
+    /// </summary>
+    virtual std::string GetState() = 0;
+    virtual void SetState(const std::string&) = 0;
+
  protected:
     int seed;
 };
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <random>
+#include <sstream>
+#include <string>
 
 #include "common/util/random/random.h"
 
@@ -35,6 +37,17 @@ class StdRandom : public IRandom {
         return static_cast<int>(round(norm(random_gen)));
     }
 
+    std::string GetState() {
+        std::stringstream stream;
+        stream << random_gen;
+        return stream.str();
+    }
+
+    void SetState(const std::string& state) {
+        std::stringstream stream(state);
+        stream >> random_gen;
+    }
+
  private:
     std::mt19937 random_gen;
 };
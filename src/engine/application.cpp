@@ -129,6 +129,8 @@ class GLWindow : public cqsp::engine::Window {
 
     bool MouseDragged() const { return !(m_mouse_x == m_mouse_x_on_pressed && m_mouse_y == m_mouse_y_on_pressed); }
 
+    bool MouseInWindow() const { return m_mouse_in_window; }
+
     void KeyboardCallback(GLFWwindow* _w, int key, int scancode, int action, int mods) {
         if (action == GLFW_PRESS) {
             m_keys_held[key] = true;
@@ -150,6 +152,7 @@ class GLWindow : public cqsp::engine::Window {
     }
 
     void MouseEnterCallback(GLFWwindow* _w, int entered) {
+        m_mouse_in_window = entered == GLFW_TRUE;
         RmlGLFW::ProcessCursorEnterCallback(app->GetRmlUiContext(), entered);
     }
 
@@ -330,6 +333,7 @@ class GLWindow : public cqsp::engine::Window {
     bool window_size_changed;
     double m_mouse_x;
     double m_mouse_y;
+    bool m_mouse_in_window = true;
 
     double m_mouse_x_on_pressed;
     double m_mouse_y_on_pressed;
@@ -614,6 +618,9 @@ void Application::run() {
             m_scene_manager.SwitchScene();
         }
 
+        // Build any assets that were asked for last frame
+        manager.Update();
+
         // Update
         m_scene_manager.Update(deltaTime);
 
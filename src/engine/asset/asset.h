@@ -155,6 +155,15 @@ class Asset {
  public:
     // Virtual destructor to make class virtual
     virtual ~Asset() {}
+
+    /// <summary>
+    /// Takes the contents of a freshly loaded copy of the asset, so that everything pointing to this asset
+    /// sees the new contents. Used when reloading assets that changed on disk.
+    /// </summary>
+    /// <param name="other">The new asset, of the same type. It is left with the old contents.</param>
+    /// <returns>If the asset could be replaced</returns>
+    virtual bool Replace(Asset& other) { return false; }
+
     std::string path;
 };
 }  // namespace asset
@@ -0,0 +1,504 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "engine/asset/assetcache.h"
+
+#include <glad/glad.h>
+#include <fmt/format.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <utility>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/enginelogger.h"
+
+namespace cqsp::asset {
+namespace {
+constexpr char cache_magic[4] = {'C', 'Q', 'A', 'C'};
+// Increase when the format of any entry changes, so that old entries are rebuilt
+constexpr uint32_t cache_version = 2;
+
+enum class HjsonTag : uint8_t { Undefined, Null, Bool, Double, Int64, String, Vector, Map };
+
+template <typename T>
+void Write(std::vector<uint8_t>& output, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    output.insert(output.end(), bytes, bytes + sizeof(T));
+}
+
+void WriteString(std::vector<uint8_t>& output, const std::string& string) {
+    Write<uint32_t>(output, static_cast<uint32_t>(string.size()));
+    output.insert(output.end(), string.begin(), string.end());
+}
+
+template <typename T>
+bool Read(const std::vector<uint8_t>& input, size_t& position, T& value) {
+    if (position + sizeof(T) > input.size()) {
+        return false;
+    }
+    memcpy(&value, input.data() + position, sizeof(T));
+    position += sizeof(T);
+    return true;
+}
+
+bool ReadString(const std::vector<uint8_t>& input, size_t& position, std::string& string) {
+    uint32_t size;
+    if (!Read(input, position, size) || position + size > input.size()) {
+        return false;
+    }
+    string.assign(reinterpret_cast<const char*>(input.data() + position), size);
+    position += size;
+    return true;
+}
+}  // namespace
+
+AssetCache::AssetCache(const std::string& _directory) { SetDirectory(_directory); }
+
+void AssetCache::SetDirectory(const std::string& _directory) {
+    directory = _directory;
+    // Each directory has its own key
+    std::lock_guard lock(key_mutex);
+    bytecode_key.reset();
+}
+
+bool AssetCache::LoadImage(const std::string& key, std::span<const uint8_t> source, CachedImage& image) {
+    ZoneScoped;
+    std::vector<uint8_t> payload;
+    if (!ReadEntry(GetPath(key, "tex"), Hash(source.data(), source.size()), payload)) {
+        return false;
+    }
+    size_t position = 0;
+    if (!Read(payload, position, image.width) || !Read(payload, position, image.height) ||
+        !Read(payload, position, image.components)) {
+        return false;
+    }
+    size_t size = static_cast<size_t>(image.width) * image.height * image.components;
+    if (payload.size() - position != size) {
+        return false;
+    }
+    image.pixels.assign(payload.begin() + position, payload.end());
+    return true;
+}
+
+void AssetCache::SaveImage(const std::string& key, std::span<const uint8_t> source, const unsigned char* pixels,
+                           int width, int height, int components) {
+    ZoneScoped;
+    if (!IsEnabled()) {
+        return;
+    }
+    size_t size = static_cast<size_t>(width) * height * components;
+    std::vector<uint8_t> payload;
+    payload.reserve(sizeof(int) * 3 + size);
+    Write(payload, width);
+    Write(payload, height);
+    Write(payload, components);
+    payload.insert(payload.end(), pixels, pixels + size);
+    WriteEntry(GetPath(key, "tex"), Hash(source.data(), source.size()), payload);
+}
+
+bool AssetCache::LoadHjson(const std::string& key, std::string_view source, Hjson::Value& value) {
+    ZoneScoped;
+    std::vector<uint8_t> payload;
+    if (!ReadEntry(GetPath(key, "hjb"), Hash(source.data(), source.size()), payload)) {
+        return false;
+    }
+    size_t position = 0;
+    return DeserializeHjson(payload, position, value) && position == payload.size();
+}
+
+void AssetCache::SaveHjson(const std::string& key, std::string_view source, const Hjson::Value& value) {
+    ZoneScoped;
+    if (!IsEnabled()) {
+        return;
+    }
+    std::vector<uint8_t> payload;
+    SerializeHjson(value, payload);
+    WriteEntry(GetPath(key, "hjb"), Hash(source.data(), source.size()), payload);
+}
+
+bool AssetCache::LoadBytecode(const std::string& key, std::string_view source, std::string_view version,
+                              std::string& bytecode) {
+    ZoneScoped;
+    std::vector<uint8_t> payload;
+    uint64_t hash = Hash(source.data(), source.size(), Hash(version.data(), version.size()));
+    if (!ReadEntry(GetPath(key, "luac"), hash, payload)) {
+        return false;
+    }
+    // The signature covers the source hash too, so signed bytecode can't be moved to another script
+    size_t position = 0;
+    uint64_t signature;
+    if (!Read(payload, position, signature)) {
+        return false;
+    }
+    Write(payload, hash);
+    uint64_t expected = KeyedHash(GetBytecodeKey(), payload.data() + position, payload.size() - position);
+    if (signature != expected) {
+        ENGINE_LOG_WARN("Cached bytecode of {} is not signed by this cache, compiling it again", key);
+        return false;
+    }
+    bytecode.assign(payload.begin() + position, payload.end() - sizeof(hash));
+    return true;
+}
+
+void AssetCache::SaveBytecode(const std::string& key, std::string_view source, std::string_view version,
+                              const std::string& bytecode) {
+    ZoneScoped;
+    if (!IsEnabled()) {
+        return;
+    }
+    uint64_t hash = Hash(source.data(), source.size(), Hash(version.data(), version.size()));
+    std::vector<uint8_t> signed_data(bytecode.begin(), bytecode.end());
+    Write(signed_data, hash);
+    std::vector<uint8_t> payload;
+    payload.reserve(sizeof(uint64_t) + bytecode.size());
+    Write(payload, KeyedHash(GetBytecodeKey(), signed_data.data(), signed_data.size()));
+    payload.insert(payload.end(), bytecode.begin(), bytecode.end());
+    WriteEntry(GetPath(key, "luac"), hash, payload);
+}
+
+unsigned int AssetCache::LoadProgram(const std::string& source) {
+    ZoneScoped;
+    std::vector<uint8_t> payload;
+    uint64_t hash = Hash(source.data(), source.size(), GetDriverHash());
+    if (!ReadEntry(GetPath(fmt::format("{:016x}", hash), "prog"), hash, payload)) {
+        return 0;
+    }
+    size_t position = 0;
+    uint32_t format;
+    if (!Read(payload, position, format)) {
+        return 0;
+    }
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, format, payload.data() + position, static_cast<GLsizei>(payload.size() - position));
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        // The driver can reject binaries for any reason, so just compile it again
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void AssetCache::SaveProgram(const std::string& source, unsigned int program) {
+    ZoneScoped;
+    if (!IsEnabled()) {
+        return;
+    }
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<uint8_t> payload(sizeof(uint32_t) + length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, payload.data() + sizeof(uint32_t));
+    uint32_t format_value = format;
+    memcpy(payload.data(), &format_value, sizeof(uint32_t));
+    payload.resize(sizeof(uint32_t) + length);
+
+    uint64_t hash = Hash(source.data(), source.size(), GetDriverHash());
+    WriteEntry(GetPath(fmt::format("{:016x}", hash), "prog"), hash, payload);
+}
+
+uint64_t AssetCache::Hash(const void* data, size_t size, uint64_t hash) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t AssetCache::KeyedHash(const std::array<uint64_t, 2>& key, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    auto rotate = [](uint64_t x, int b) { return (x << b) | (x >> (64 - b)); };
+    uint64_t v0 = 0x736f6d6570736575ull ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dull ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ull ^ key[0];
+    uint64_t v3 = 0x7465646279746573ull ^ key[1];
+    auto round = [&]() {
+        v0 += v1;
+        v1 = rotate(v1, 13) ^ v0;
+        v0 = rotate(v0, 32);
+        v2 += v3;
+        v3 = rotate(v3, 16) ^ v2;
+        v0 += v3;
+        v3 = rotate(v3, 21) ^ v0;
+        v2 += v1;
+        v1 = rotate(v1, 17) ^ v2;
+        v2 = rotate(v2, 32);
+    };
+    size_t end = size - size % 8;
+    for (size_t i = 0; i < end; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        v3 ^= word;
+        round();
+        round();
+        v0 ^= word;
+    }
+    // The last word holds the rest of the bytes and the length
+    uint64_t last = static_cast<uint64_t>(size) << 56;
+    for (size_t i = 0; i < size % 8; i++) {
+        last |= static_cast<uint64_t>(bytes[end + i]) << (8 * i);
+    }
+    v3 ^= last;
+    round();
+    round();
+    v0 ^= last;
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; i++) {
+        round();
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+const std::array<uint64_t, 2>& AssetCache::GetBytecodeKey() {
+    std::lock_guard lock(key_mutex);
+    if (bytecode_key) {
+        return *bytecode_key;
+    }
+    std::array<uint64_t, 2> key;
+    std::string path = (std::filesystem::path(directory) / "bytecode.key").string();
+    std::ifstream input(path, std::ios::binary);
+    input.read(reinterpret_cast<char*>(key.data()), sizeof(key));
+    if (!input.good() || input.gcount() != sizeof(key)) {
+        // Everything signed with another key is rebuilt anyway
+        std::random_device random;
+        for (uint64_t& word : key) {
+            word = (static_cast<uint64_t>(random()) << 32) | random();
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(key.data()), sizeof(key));
+        if (!output.good()) {
+            ENGINE_LOG_WARN("Cannot write the bytecode key {}, scripts will be compiled again next time", path);
+        }
+    }
+    bytecode_key = key;
+    return *bytecode_key;
+}
+
+void AssetCache::SerializeHjson(const Hjson::Value& value, std::vector<uint8_t>& output) {
+    switch (value.type()) {
+        case Hjson::Type::Null:
+            Write(output, HjsonTag::Null);
+            break;
+        case Hjson::Type::Bool:
+            Write(output, HjsonTag::Bool);
+            Write<uint8_t>(output, static_cast<bool>(value) ? 1 : 0);
+            break;
+        case Hjson::Type::Double:
+            Write(output, HjsonTag::Double);
+            Write(output, value.to_double());
+            break;
+        case Hjson::Type::Int64:
+            Write(output, HjsonTag::Int64);
+            Write<int64_t>(output, value.to_int64());
+            break;
+        case Hjson::Type::String:
+            Write(output, HjsonTag::String);
+            WriteString(output, value.to_string());
+            break;
+        case Hjson::Type::Vector:
+            Write(output, HjsonTag::Vector);
+            Write<uint32_t>(output, static_cast<uint32_t>(value.size()));
+            for (int i = 0; i < static_cast<int>(value.size()); i++) {
+                SerializeHjson(value[i], output);
+            }
+            break;
+        case Hjson::Type::Map:
+            Write(output, HjsonTag::Map);
+            Write<uint32_t>(output, static_cast<uint32_t>(value.size()));
+            // In insertion order, so that the map reads back the same as it was parsed
+            for (int i = 0; i < static_cast<int>(value.size()); i++) {
+                WriteString(output, value.key(i));
+                SerializeHjson(value[i], output);
+            }
+            break;
+        default:
+            Write(output, HjsonTag::Undefined);
+            break;
+    }
+}
+
+bool AssetCache::DeserializeHjson(const std::vector<uint8_t>& input, size_t& position, Hjson::Value& value) {
+    HjsonTag tag;
+    if (!Read(input, position, tag)) {
+        return false;
+    }
+    switch (tag) {
+        case HjsonTag::Undefined:
+            value = Hjson::Value();
+            return true;
+        case HjsonTag::Null:
+            value = Hjson::Value(Hjson::Type::Null);
+            return true;
+        case HjsonTag::Bool: {
+            uint8_t boolean;
+            if (!Read(input, position, boolean)) {
+                return false;
+            }
+            value = Hjson::Value(boolean != 0);
+            return true;
+        }
+        case HjsonTag::Double: {
+            double number;
+            if (!Read(input, position, number)) {
+                return false;
+            }
+            value = Hjson::Value(number);
+            return true;
+        }
+        case HjsonTag::Int64: {
+            int64_t number;
+            if (!Read(input, position, number)) {
+                return false;
+            }
+            value = Hjson::Value(number);
+            return true;
+        }
+        case HjsonTag::String: {
+            std::string string;
+            if (!ReadString(input, position, string)) {
+                return false;
+            }
+            value = Hjson::Value(string);
+            return true;
+        }
+        case HjsonTag::Vector: {
+            uint32_t size;
+            if (!Read(input, position, size)) {
+                return false;
+            }
+            value = Hjson::Value(Hjson::Type::Vector);
+            for (uint32_t i = 0; i < size; i++) {
+                Hjson::Value element;
+                if (!DeserializeHjson(input, position, element)) {
+                    return false;
+                }
+                value.push_back(element);
+            }
+            return true;
+        }
+        case HjsonTag::Map: {
+            uint32_t size;
+            if (!Read(input, position, size)) {
+                return false;
+            }
+            value = Hjson::Value(Hjson::Type::Map);
+            for (uint32_t i = 0; i < size; i++) {
+                std::string key;
+                Hjson::Value element;
+                if (!ReadString(input, position, key) || !DeserializeHjson(input, position, element)) {
+                    return false;
+                }
+                value[key] = element;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string AssetCache::GetPath(const std::string& key, const char* extension) {
+    return (std::filesystem::path(directory) /
+            fmt::format("{:016x}.{}", Hash(key.data(), key.size()), extension))
+        .string();
+}
+
+bool AssetCache::ReadEntry(const std::string& path, uint64_t source_hash, std::vector<uint8_t>& payload) {
+    if (!IsEnabled()) {
+        return false;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file.good()) {
+        return false;
+    }
+    std::error_code ec;
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t hash = 0;
+    uint64_t size = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+    file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!file.good() || memcmp(magic, cache_magic, sizeof(magic)) != 0 || version != cache_version ||
+        hash != source_hash) {
+        // Stale, it will be written again once the asset is rebuilt
+        return false;
+    }
+    // Check the size against the file before allocating, in case the entry is corrupt
+    constexpr uint64_t header_size = sizeof(magic) + sizeof(version) + sizeof(hash) + sizeof(size);
+    if (std::filesystem::file_size(path, ec) != header_size + size || ec) {
+        return false;
+    }
+    payload.resize(size);
+    file.read(reinterpret_cast<char*>(payload.data()), size);
+    return static_cast<uint64_t>(file.gcount()) == size;
+}
+
+void AssetCache::WriteEntry(const std::string& path, uint64_t source_hash, const std::vector<uint8_t>& payload) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    // Write to a temporary file first, so that a crash never leaves a half written entry behind
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        uint64_t size = payload.size();
+        file.write(cache_magic, sizeof(cache_magic));
+        file.write(reinterpret_cast<const char*>(&cache_version), sizeof(cache_version));
+        file.write(reinterpret_cast<const char*>(&source_hash), sizeof(source_hash));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+        if (!file.good()) {
+            ENGINE_LOG_WARN("Cannot write asset cache entry {}", temp_path);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        ENGINE_LOG_WARN("Cannot write asset cache entry {}: {}", path, ec.message());
+    }
+}
+
+uint64_t AssetCache::GetDriverHash() {
+    if (driver_hash != 0) {
+        return driver_hash;
+    }
+    std::string driver;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte* string = glGetString(name);
+        if (string != nullptr) {
+            driver += reinterpret_cast<const char*>(string);
+        }
+    }
+    driver_hash = Hash(driver.data(), driver.size());
+    return driver_hash;
+}
+}  // namespace cqsp::asset
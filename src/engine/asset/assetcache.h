@@ -0,0 +1,130 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <hjson.h>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cqsp {
+namespace asset {
+/// <summary>
+/// A decoded image read from the @ref AssetCache
+/// </summary>
+struct CachedImage {
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+    int components = 0;
+};
+
+/// <summary>
+/// On disk cache of the work that is done when loading assets, so that a warm start skips it.
+/// <br>
+/// It keeps decoded textures, hjson in a compact binary form and linked shader program binaries.
+/// Every entry stores a hash of the source it was built from, and is ignored and rebuilt when the
+/// source changes. Entries are keyed by the virtual path of the asset.
+/// <br>
+/// The cache is disabled until a directory is set. Reading and writing different keys from multiple
+/// threads is safe, but programs have to be loaded and saved on the main thread.
+/// </summary>
+class AssetCache {
+ public:
+    AssetCache() = default;
+    explicit AssetCache(const std::string& directory);
+
+    /// <summary>
+    /// Sets the directory the cache is kept in, an empty directory disables the cache.
+    /// </summary>
+    void SetDirectory(const std::string& directory);
+    const std::string& GetDirectory() const { return directory; }
+    bool IsEnabled() const { return !directory.empty(); }
+
+    /// <summary>
+    /// Reads the decoded image of the encoded source file, if it is cached.
+    /// </summary>
+    bool LoadImage(const std::string& key, std::span<const uint8_t> source, CachedImage& image);
+    void SaveImage(const std::string& key, std::span<const uint8_t> source, const unsigned char* pixels, int width,
+                   int height, int components);
+
+    /// <summary>
+    /// Reads the parsed hjson of the source text, if it is cached.
+    /// </summary>
+    bool LoadHjson(const std::string& key, std::string_view source, Hjson::Value& value);
+    void SaveHjson(const std::string& key, std::string_view source, const Hjson::Value& value);
+
+    /// <summary>
+    /// Reads the compiled bytecode of the script source, if it is cached.
+    /// Bytecode only loads in the lua version that it was compiled with, so the version is part of the hash.
+    /// <br>
+    /// Lua doesn't check bytecode before running it, so the bytecode is signed with a key that is made for each
+    /// cache directory, and bytecode that wasn't written by this cache is never returned.
+    /// </summary>
+    bool LoadBytecode(const std::string& key, std::string_view source, std::string_view version,
+                      std::string& bytecode);
+    void SaveBytecode(const std::string& key, std::string_view source, std::string_view version,
+                      const std::string& bytecode);
+
+    /// <summary>
+    /// Creates a program from the cached binary of the shader source.
+    /// Binaries are only valid for the same driver, so the renderer and version strings are part of the hash.
+    /// </summary>
+    /// <returns>The program, or 0 if it is not cached or the driver rejected it</returns>
+    unsigned int LoadProgram(const std::string& source);
+    void SaveProgram(const std::string& source, unsigned int program);
+
+    /// <summary>
+    /// 64 bit FNV-1a hash
+    /// </summary>
+    static uint64_t Hash(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+
+    /// <summary>
+    /// SipHash-2-4, a hash that can't be forged without the key
+    /// </summary>
+    static uint64_t KeyedHash(const std::array<uint64_t, 2>& key, const void* data, size_t size);
+
+    static void SerializeHjson(const Hjson::Value& value, std::vector<uint8_t>& output);
+    /// <summary>
+    /// Reads hjson written by @ref SerializeHjson, starting at `position`, which is moved past the value.
+    /// </summary>
+    /// <returns>If the data was valid</returns>
+    static bool DeserializeHjson(const std::vector<uint8_t>& input, size_t& position, Hjson::Value& value);
+
+ private:
+    std::string GetPath(const std::string& key, const char* extension);
+    bool ReadEntry(const std::string& path, uint64_t source_hash, std::vector<uint8_t>& payload);
+    void WriteEntry(const std::string& path, uint64_t source_hash, const std::vector<uint8_t>& payload);
+    uint64_t GetDriverHash();
+    /// <summary>
+    /// Reads the key that bytecode is signed with, or makes a new one if the cache doesn't have one yet
+    /// </summary>
+    const std::array<uint64_t, 2>& GetBytecodeKey();
+
+    std::string directory;
+    uint64_t driver_hash = 0;
+    std::optional<std::array<uint64_t, 2>> bytecode_key;
+    std::mutex key_mutex;
+};
+}  // namespace asset
+}  // namespace cqsp
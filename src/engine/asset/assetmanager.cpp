@@ -21,6 +21,7 @@
 #include <stb_image.h>
 
 #include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <regex>
@@ -28,9 +29,12 @@
 #include <vector>
 
 #include <tracy/Tracy.hpp>
+#include <tracy/common/TracySystem.hpp>
 
+#include "common/util/parallel.h"
 #include "common/util/paths.h"
 #include "engine/asset/vfs/nativevfs.h"
+#include "engine/asset/vfs/packvfs.h"
 #include "engine/audio/alaudioasset.h"
 #include "engine/enginelogger.h"
 
@@ -49,8 +53,22 @@ class ImagePrototype : public AssetPrototype {
     int height;
     int components;
 
+    /// <summary>
+    /// Owns the pixels if they were read from the cache instead of decoded by stb_image
+    /// </summary>
+    std::vector<unsigned char> cached_pixels;
+
     asset::TextureLoadingOptions options;
 
+    void FreeData() {
+        if (cached_pixels.empty()) {
+            stbi_image_free(data);
+        } else {
+            cached_pixels = std::vector<unsigned char>();
+        }
+        data = nullptr;
+    }
+
     int GetPrototypeType() { return PrototypeType::TEXTURE; }
 };
 
@@ -77,25 +95,401 @@ class ShaderPrototype : public AssetPrototype {
 
 class FontPrototype : public AssetPrototype {
  public:
-    std::vector<uint8_t> fontBuffer;
+    /// The font is read in place from the file until it is built
+    IVirtualFilePtr file;
+    std::span<const uint8_t> fontBuffer;
     int size;
 
     int GetPrototypeType() { return PrototypeType::FONT; }
 };
 }  // namespace
 
-bool Package::HasAsset(const char* asset) { return assets.count(asset) != 0; }
-bool Package::HasAsset(const std::string& asset) { return assets.count(asset) != 0; }
+bool Package::HasAsset(const char* asset) { return HasAsset(std::string(asset)); }
+bool Package::HasAsset(const std::string& asset) { return assets.count(asset) != 0 || lazy_assets.count(asset) != 0; }
 
 void Package::ClearAssets() {
     for (auto a = assets.begin(); a != assets.end(); a++) {
         a->second.reset();
     }
     assets.clear();
+    lazy_assets.clear();
+    resources.clear();
 }
 
 AssetManager::AssetManager() {}
 
+AssetManager::~AssetManager() {
+    if (request_worker.joinable()) {
+        {
+            std::lock_guard lock(request_mutex);
+            stop_worker = true;
+        }
+        request_condition.notify_all();
+        request_worker.join();
+    }
+}
+
+void AssetManager::SetLoader(std::unique_ptr<AssetLoader> _loader) {
+    loader = std::move(_loader);
+    loader->manager = this;
+    if (!request_worker.joinable()) {
+        request_worker = std::thread([this]() { RequestWorker(); });
+    }
+}
+
+void AssetManager::AddPackage(std::unique_ptr<Package> package) {
+    std::string name = package->name;
+    packages[name] = std::move(package);
+}
+
+Package* AssetManager::FindPackage(const std::string& key, std::string& package_key) {
+    std::size_t separation = key.find(":");
+    // Default name is core
+    std::string package_name = "core";
+    if (separation != std::string::npos) {
+        package_name = key.substr(0, separation);
+    }
+    package_key = key.substr(separation + 1, key.length());
+    auto it = packages.find(package_name);
+    if (it == packages.end()) {
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+AssetId AssetManager::Intern(const std::string& key) {
+    std::lock_guard lock(intern_mutex);
+    auto it = interned_keys.find(key);
+    if (it != interned_keys.end()) {
+        return it->second;
+    }
+    std::size_t separation = key.find(":");
+    // Default name is core
+    std::string package_name = "core";
+    if (separation != std::string::npos) {
+        package_name = key.substr(0, separation);
+    }
+    std::string package_key = key.substr(separation + 1, key.length());
+
+    // The same asset can be asked for with or without the package name
+    std::string full_key = package_name + ":" + package_key;
+    it = interned_keys.find(full_key);
+    if (it != interned_keys.end()) {
+        interned_keys[key] = it->second;
+        return it->second;
+    }
+
+    if (slot_count == slot_page_size * slot_page_count) {
+        ENGINE_LOG_CRITICAL("Too many asset keys, cannot intern {}", key);
+        return AssetId();
+    }
+    auto& page = slot_pages[slot_count / slot_page_size];
+    if (page == nullptr) {
+        page = std::make_unique<AssetSlot[]>(slot_page_size);
+    }
+    AssetId id {slot_count++};
+    AssetSlot& slot = GetSlot(id);
+    slot.package = package_name;
+    slot.key = package_key;
+    interned_keys[full_key] = id;
+    interned_keys[key] = id;
+    return id;
+}
+
+Asset* AssetManager::ResolveSlot(AssetSlot& slot) {
+    if (slot.asset != nullptr) {
+        return slot.asset;
+    }
+    auto package = packages.find(slot.package);
+    if (package == packages.end()) {
+        ENGINE_LOG_ERROR("Cannot find package {}", slot.package);
+        return nullptr;
+    }
+    if (!package->second->HasAsset(slot.key)) {
+        ENGINE_LOG_ERROR("Cannot find asset {}", slot.key);
+        return nullptr;
+    }
+    if (!package->second->IsLoaded(slot.key)) {
+        // Asked for right now, so it can't wait for the background loading
+        LoadLazyAsset(*package->second, slot.key);
+    }
+    auto asset = package->second->assets.find(slot.key);
+    if (asset == package->second->assets.end()) {
+        return nullptr;
+    }
+    slot.asset = asset->second.get();
+    return slot.asset;
+}
+
+Asset* AssetManager::FindLoadedAsset(const std::string& key) { return FindLoadedAsset(Intern(key)); }
+
+Asset* AssetManager::FindLoadedAsset(AssetId id) {
+    if (!id.Valid()) {
+        return nullptr;
+    }
+    AssetSlot& slot = GetSlot(id);
+    if (slot.asset != nullptr) {
+        return slot.asset;
+    }
+    auto package = packages.find(slot.package);
+    if (package == packages.end()) {
+        return nullptr;
+    }
+    auto it = package->second->assets.find(slot.key);
+    if (it == package->second->assets.end()) {
+        return nullptr;
+    }
+    slot.asset = it->second.get();
+    return slot.asset;
+}
+
+void AssetManager::RequestAsset(const std::string& key, const std::function<void(Asset*)>& callback) {
+    std::string package_key;
+    Package* package = FindPackage(key, package_key);
+    if (package == nullptr || !package->HasAsset(package_key)) {
+        ENGINE_LOG_ERROR("Cannot find asset {}", key);
+        if (callback) {
+            callback(nullptr);
+        }
+        return;
+    }
+    if (package->IsLoaded(package_key)) {
+        if (callback) {
+            callback(package->assets[package_key].get());
+        }
+        return;
+    }
+    std::string full_key = package->name + ":" + package_key;
+    auto it = requests.find(full_key);
+    if (it == requests.end()) {
+        it = requests.emplace(full_key, AssetRequest {package, package_key, {}}).first;
+        {
+            std::lock_guard lock(request_mutex);
+            request_queue.emplace(full_key, package->lazy_assets[package_key]);
+        }
+        request_condition.notify_one();
+    }
+    if (callback) {
+        it->second.callbacks.push_back(callback);
+    }
+}
+
+void AssetManager::RequestWorker() {
+    tracy::SetThreadName("Asset Requests");
+    while (true) {
+        std::pair<std::string, ResourceEntry> request;
+        {
+            std::unique_lock lock(request_mutex);
+            request_condition.wait(lock, [this]() { return stop_worker || !request_queue.empty(); });
+            if (stop_worker) {
+                return;
+            }
+            request = std::move(request_queue.front());
+            request_queue.pop();
+        }
+        ZoneScopedN("Decode requested asset");
+        const ResourceEntry& entry = request.second;
+        std::unique_ptr<Asset> asset;
+        try {
+            std::lock_guard loader_lock(loader_mutex);
+            asset = loader->LoadAsset(entry.type, entry.path, entry.key, entry.hints);
+        } catch (std::exception& ex) {
+            ENGINE_LOG_ERROR("Failed to load asset {}: {}", entry.key, ex.what());
+        }
+        if (asset != nullptr) {
+            asset->path = entry.path;
+        }
+        std::lock_guard lock(request_mutex);
+        decoded.emplace_back(request.first, std::move(asset));
+    }
+}
+
+void AssetManager::Update(double budget) {
+    if (loader == nullptr) {
+        return;
+    }
+    ZoneScoped;
+    if (watcher != nullptr) {
+        ReloadChangedAssets();
+    }
+    {
+        // Take these before building, because their prototypes are already in the queue
+        std::lock_guard lock(request_mutex);
+        for (auto& asset : decoded) {
+            building.push_back(std::move(asset));
+        }
+        decoded.clear();
+    }
+    loader->BuildAssets(budget);
+    if (loader->QueueHasItems()) {
+        return;
+    }
+    // Everything that was decoded is built now
+    for (auto& [key, asset] : building) {
+        FinishRequest(key, std::move(asset));
+    }
+    building.clear();
+}
+
+void AssetManager::FinishRequest(const std::string& key, std::unique_ptr<Asset> asset) {
+    auto it = requests.find(key);
+    if (it == requests.end()) {
+        return;
+    }
+    AssetRequest request = std::move(it->second);
+    requests.erase(it);
+
+    Package& package = *request.package;
+    // It might have been loaded with GetAsset while it was being decoded
+    if (!package.IsLoaded(request.key)) {
+        if (asset == nullptr) {
+            ENGINE_LOG_WARN("Asset {} was not loaded properly", key);
+        } else {
+            package.assets[request.key] = std::move(asset);
+        }
+        package.lazy_assets.erase(request.key);
+    }
+    Asset* loaded = package.IsLoaded(request.key) ? package.assets[request.key].get() : nullptr;
+    for (auto& callback : request.callbacks) {
+        callback(loaded);
+    }
+}
+
+void AssetManager::LoadLazyAsset(Package& package, const std::string& key) {
+    ZoneScoped;
+    auto it = package.lazy_assets.find(key);
+    if (it == package.lazy_assets.end() || loader == nullptr) {
+        return;
+    }
+    ResourceEntry entry = std::move(it->second);
+    package.lazy_assets.erase(it);
+    std::unique_ptr<Asset> asset;
+    {
+        // Waits for the request worker if it is in the middle of loading something
+        std::lock_guard loader_lock(loader_mutex);
+        asset = loader->LoadAsset(entry.type, entry.path, entry.key, entry.hints);
+    }
+    // Anything it needs on the main thread has to be built before it can be used
+    while (loader->QueueHasItems()) {
+        loader->BuildNextAsset();
+    }
+    if (asset == nullptr) {
+        ENGINE_LOG_WARN("Asset {} was not loaded properly", key);
+        return;
+    }
+    asset->path = entry.path;
+    package.assets[key] = std::move(asset);
+}
+
+bool AssetManager::EnableHotReload() {
+    if (watcher != nullptr) {
+        return true;
+    }
+    watcher = std::make_unique<FileWatcher>();
+    if (!watcher->IsSupported()) {
+        ENGINE_LOG_INFO("Hot reloading is not supported on this platform");
+        watcher.reset();
+        return false;
+    }
+    for (auto& [name, prototype] : m_package_prototype_list) {
+        if (packages.count(name) == 0 || !std::filesystem::is_directory(prototype.path)) {
+            continue;
+        }
+        if (watcher->Watch(prototype.path)) {
+            watched_packages.emplace_back(std::filesystem::canonical(prototype.path), name);
+            ENGINE_LOG_INFO("Watching {} for changes", prototype.path);
+        }
+    }
+    return true;
+}
+
+void AssetManager::AddReloadCallback(const std::string& key, const std::function<void(Asset*)>& callback) {
+    std::string full_key = (key.find(':') == std::string::npos) ? "core:" + key : key;
+    std::lock_guard lock(reload_mutex);
+    reload_callbacks[full_key].push_back(callback);
+}
+
+void AssetManager::ReloadChangedAssets() {
+    std::vector<std::string> changed = watcher->Poll();
+    if (changed.empty()) {
+        return;
+    }
+    ZoneScoped;
+    for (const std::string& native_path : changed) {
+        // Get the path that the package is mounted with
+        std::filesystem::path file = std::filesystem::weakly_canonical(native_path);
+        auto root = std::find_if(watched_packages.begin(), watched_packages.end(), [&](const auto& watched) {
+            auto relative = file.lexically_relative(watched.first);
+            return !relative.empty() && *relative.begin() != "..";
+        });
+        if (root == watched_packages.end() || packages.count(root->second) == 0) {
+            continue;
+        }
+        std::string path = root->second + "/" + file.lexically_relative(root->first).generic_string();
+        if (GetFilename(path) == "resource.hjson") {
+            ENGINE_LOG_INFO("{} changed, new resources are only loaded when the game starts", path);
+            continue;
+        }
+
+        Package& package = *packages[root->second];
+        for (auto& [key, entry] : package.resources) {
+            bool matches = entry.path == path || path.starts_with(entry.path + "/");
+            if (!matches && entry.type == AssetType::SHADER_DEFINITION && package.IsLoaded(key)) {
+                // Shader definitions are made from more than one file
+                auto* definition = dynamic_cast<ShaderDefinition*>(package.assets[key].get());
+                if (definition != nullptr) {
+                    auto& sources = definition->sources;
+                    matches = std::find(sources.begin(), sources.end(), path) != sources.end();
+                }
+            }
+            if (matches) {
+                ReloadAsset(package, entry);
+            }
+        }
+    }
+}
+
+void AssetManager::ReloadAsset(Package& package, const ResourceEntry& entry) {
+    ZoneScoped;
+    // Lazy assets that aren't loaded yet will be loaded from the new file anyway
+    if (!package.IsLoaded(entry.key)) {
+        return;
+    }
+    ENGINE_LOG_INFO("Reloading {}", entry.key);
+    std::unique_ptr<Asset> asset;
+    try {
+        std::lock_guard loader_lock(loader_mutex);
+        asset = loader->LoadAsset(entry.type, entry.path, entry.key, entry.hints);
+    } catch (std::exception& ex) {
+        ENGINE_LOG_ERROR("Failed to reload asset {}: {}", entry.key, ex.what());
+    }
+    while (loader->QueueHasItems()) {
+        loader->BuildNextAsset();
+    }
+    if (asset == nullptr) {
+        ENGINE_LOG_WARN("Asset {} was not reloaded properly", entry.key);
+        return;
+    }
+    asset->path = entry.path;
+    Asset* loaded = package.assets[entry.key].get();
+    if (!loaded->Replace(*asset)) {
+        ENGINE_LOG_INFO("Asset {} cannot be reloaded while the game is running", entry.key);
+        return;
+    }
+
+    std::vector<std::function<void(Asset*)>> callbacks;
+    {
+        std::lock_guard lock(reload_mutex);
+        auto it = reload_callbacks.find(package.name + ":" + entry.key);
+        if (it != reload_callbacks.end()) {
+            callbacks = it->second;
+        }
+    }
+    for (auto& callback : callbacks) {
+        callback(loaded);
+    }
+}
+
 ShaderProgram_t AssetManager::MakeShader(const std::string& vert, const std::string& frag) {
     return std::make_shared<ShaderProgram>(*GetAsset<Shader>(vert.c_str()), *GetAsset<Shader>(frag.c_str()));
 }
@@ -159,7 +553,25 @@ void AssetManager::LoadDefaultTexture() {
     asset::CreateTexture(empty_texture, texture_bytes, 2, 2, 3, f);
 }
 
-void AssetManager::ClearAssets() { ZoneScoped packages.clear(); }
+void AssetManager::ClearAssets() {
+    ZoneScoped;
+    {
+        std::lock_guard lock(request_mutex);
+        request_queue = {};
+        decoded.clear();
+    }
+    requests.clear();
+    building.clear();
+    packages.clear();
+    // Keep the interned keys, only forget the assets that they were found as
+    std::lock_guard lock(intern_mutex);
+    for (uint32_t i = 0; i < slot_count; i++) {
+        AssetSlot& slot = GetSlot(AssetId {i});
+        slot.asset = nullptr;
+        slot.type = nullptr;
+        slot.typed = nullptr;
+    }
+}
 
 void AssetManager::SaveModList() {
     Hjson::Value enabled_mods;
@@ -215,14 +627,19 @@ void AssetLoader::LoadMods() {
 
     ENGINE_LOG_INFO("Loading potential mods");
 
-    // Load core
-    mod_load(LoadModPrototype((data_path / "core").string()));
+    // Load core, from the packed core if it has been packed
+    std::filesystem::path core_path = data_path / "core";
+    if (std::filesystem::is_regular_file(data_path / (std::string("core") + PackFileSystem::extension))) {
+        core_path = data_path / (std::string("core") + PackFileSystem::extension);
+    }
+    mod_load(LoadModPrototype(core_path.string()));
 
     // Enable core by default
     all_mods["core"] = true;
 
     // Load other packages
     std::filesystem::path save_path(cqsp::common::util::GetCqspSavePath());
+    manager->cache.SetDirectory((save_path / "cache" / "assets").string());
     std::filesystem::path mods_folder = save_path / "mods";
     if (!std::filesystem::exists(mods_folder)) {
         std::filesystem::create_directories(mods_folder);
@@ -260,7 +677,7 @@ void AssetLoader::LoadMods() {
         if (package == nullptr) {
             continue;
         }
-        manager->packages[it.first] = std::move(package);
+        manager->AddPackage(std::move(package));
     }
 }
 
@@ -274,7 +691,7 @@ std::optional<PackagePrototype> AssetLoader::LoadModPrototype(const std::string&
     std::filesystem::path package_path(path_string);
     IVirtualFileSystem* vfs = GetVfs(path_string);
 
-    if (!vfs->IsFile("info.hjson")) {
+    if (vfs == nullptr || !vfs->IsFile("info.hjson")) {
         ENGINE_LOG_INFO("Mod prototype unable to be loaded from {}", path_string);
         return std::nullopt;
     }
@@ -309,6 +726,10 @@ std::unique_ptr<Package> AssetLoader::LoadPackage(std::string path) {
 
     // Mount the path
     IVirtualFileSystem* vfs = GetVfs(package_path.string());
+    if (vfs == nullptr) {
+        ENGINE_LOG_ERROR("Failed to load package {}", package_path.string());
+        return nullptr;
+    }
 
     // Mount package path
     ENGINE_LOG_INFO("Loading package {}", package_path.string());
@@ -344,7 +765,11 @@ std::unique_ptr<Package> AssetLoader::LoadPackage(std::string path) {
     if (mounter.IsDirectory(mount_point, "scripts") && mounter.IsFile(mount_point, "scripts/base.lua")) {
         // Load base.lua for the base folder
         package->assets["base"] = LoadText(&mounter, mount_point + "/scripts/base.lua", "base", Hjson::Value());
-        package->assets["scripts"] = LoadScriptDirectory(&mounter, mount_point + "/scripts", Hjson::Value());
+        package->resources["base"] = {AssetType::TEXT, mount_point + "/scripts/base.lua", "base", Hjson::Value()};
+        Hjson::Value script_hints;
+        script_hints["scripts"] = true;
+        package->assets["scripts"] = LoadScriptDirectory(&mounter, mount_point + "/scripts", script_hints);
+        package->resources["scripts"] = {AssetType::TEXT_ARRAY, mount_point + "/scripts", "scripts", script_hints};
         ENGINE_LOG_INFO("Loaded scripts");
     } else {
         ENGINE_LOG_INFO("No script file for package {}", package->name);
@@ -388,6 +813,7 @@ void AssetLoader::PlaceAsset(Package& package, const AssetType& type, const std:
         return;
     }
     asset->path = path;
+    std::lock_guard lock(package_mutex);
     package.assets[key] = std::move(asset);
 }
 
@@ -407,10 +833,25 @@ void AssetLoader::BuildNextAsset() {
         case PrototypeType::TEXTURE: {
             ImagePrototype* texture_prototype = dynamic_cast<ImagePrototype*>(temp.prototype);
             Texture* asset = dynamic_cast<Texture*>(texture_prototype->asset);
-            asset::CreateTexture(*asset, texture_prototype->data, texture_prototype->width, texture_prototype->height,
+            if (StreamedTexture* streamed = dynamic_cast<StreamedTexture*>(asset); streamed != nullptr) {
+                // Only upload the placeholder, the full texture is streamed in later
+                asset::CreateTexture(*streamed, streamed->placeholder.data(), streamed->placeholder_width,
+                                     streamed->placeholder_height, streamed->components, streamed->options);
+                break;
+            }
+            size_t size = static_cast<size_t>(texture_prototype->width) * texture_prototype->height *
+                          texture_prototype->components;
+            auto offset = staging_ring.Stage(texture_prototype->data, size);
+            // When the image is staged, the pointer is the offset into the ring
+            unsigned char* pixels = offset ? reinterpret_cast<unsigned char*>(*offset) : texture_prototype->data;
+            asset::CreateTexture(*asset, pixels, texture_prototype->width, texture_prototype->height,
                                  texture_prototype->components, texture_prototype->options);
+            if (offset) {
+                staging_ring.Fence();
+                StagingRing::Unbind();
+            }
 
-            stbi_image_free(texture_prototype->data);
+            texture_prototype->FreeData();
             break;
         }
         case PrototypeType::SHADER: {
@@ -434,7 +875,7 @@ void AssetLoader::BuildNextAsset() {
             CubemapPrototype* prototype = dynamic_cast<CubemapPrototype*>(temp.prototype);
             Texture* asset = dynamic_cast<Texture*>(prototype->asset);
             asset::LoadCubemapData(*asset, prototype->data, prototype->width, prototype->height, prototype->components,
-                                   prototype->options);
+                                   prototype->options, &staging_ring);
         } break;
     }
 
@@ -442,6 +883,18 @@ void AssetLoader::BuildNextAsset() {
     delete temp.prototype;
 }
 
+void AssetLoader::BuildAssets(double budget) {
+    ZoneScoped;
+    auto start = std::chrono::steady_clock::now();
+    while (QueueHasItems()) {
+        BuildNextAsset();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() > budget) {
+            break;
+        }
+    }
+}
+
 std::unique_ptr<Asset> AssetLoader::LoadText(VirtualMounter* mount, const std::string& path, const std::string& key,
                                              const Hjson::Value& hints) {
     ZoneScoped;
@@ -461,6 +914,11 @@ std::unique_ptr<Asset> AssetLoader::LoadTextDirectory(VirtualMounter* mount, con
     if (!mount->IsDirectory(path)) {
         return nullptr;
     }
+    // The scripts directory is loaded again like this when it changes
+    Hjson::Value scripts = hints["scripts"];
+    if (scripts.defined() && scripts.type() == Hjson::Type::Bool && static_cast<bool>(scripts)) {
+        return LoadScriptDirectory(mount, path, hints);
+    }
     std::unique_ptr<cqspa::TextDirectoryAsset> asset = std::make_unique<cqspa::TextDirectoryAsset>();
     auto dir = mount->OpenDirectory(path.c_str());
     int size = dir->GetSize();
@@ -494,10 +952,33 @@ std::unique_ptr<Asset> AssetLoader::LoadTexture(VirtualMounter* mount, const std
     }
 
     auto file = mount->Open(path.c_str(), FileModes::Binary);
-    uint64_t file_size = file->Size();
-    auto buffer = ReadAllFromVFile(file.get());
-    prototype->data = stbi_load_from_memory(buffer.data(), file_size, &prototype->width, &prototype->height,
-                                            &prototype->components, 0);
+    // View the file in place rather than copying it, the encoded bytes are only needed while decoding
+    std::span<const uint8_t> buffer = file->View();
+    AssetCache* cache = GetCache();
+
+    Hjson::Value streamed = hints["streamed"];
+    if (streamed.defined() && streamed.type() == Hjson::Type::Bool && static_cast<bool>(streamed)) {
+        bool mag_filter = prototype->options.mag_filter;
+        delete prototype;
+        return LoadStreamedTexture(file, path, key, mag_filter);
+    }
+
+    CachedImage cached;
+    if (cache != nullptr && cache->LoadImage(path, buffer, cached)) {
+        prototype->cached_pixels = std::move(cached.pixels);
+        prototype->data = prototype->cached_pixels.data();
+        prototype->width = cached.width;
+        prototype->height = cached.height;
+        prototype->components = cached.components;
+    } else {
+        prototype->data = stbi_load_from_memory(buffer.data(), buffer.size(), &prototype->width, &prototype->height,
+                                                &prototype->components, 0);
+        if (prototype->data && cache != nullptr) {
+            cache->SaveImage(path, buffer, prototype->data, prototype->width, prototype->height,
+                             prototype->components);
+        }
+    }
+
     if (prototype->data) {
         QueueHolder holder(prototype);
 
@@ -510,12 +991,62 @@ std::unique_ptr<Asset> AssetLoader::LoadTexture(VirtualMounter* mount, const std
     return std::move(texture);
 }
 
+std::unique_ptr<Asset> AssetLoader::LoadStreamedTexture(const IVirtualFilePtr& file, const std::string& path,
+                                                        const std::string& key, bool mag_filter) {
+    ZoneScoped;
+    std::span<const uint8_t> buffer = file->View();
+    // Only the header is read here, the full image is decoded by the streamer when it is needed
+    std::unique_ptr<StreamedTexture> texture = std::make_unique<StreamedTexture>();
+    if (!stbi_info_from_memory(buffer.data(), buffer.size(), &texture->full_width, &texture->full_height,
+                               &texture->components)) {
+        ENGINE_LOG_ERROR("Failed to load image {}", key);
+        return nullptr;
+    }
+    texture->options.mag_filter = mag_filter;
+
+    // The placeholder is cached on its own, so that it is the only thing read on startup
+    const std::string placeholder_key = path + "#placeholder";
+    AssetCache* cache = GetCache();
+    CachedImage cached;
+    if (cache != nullptr && cache->LoadImage(placeholder_key, buffer, cached) &&
+        cached.components == texture->components) {
+        texture->placeholder = std::move(cached.pixels);
+        texture->placeholder_width = cached.width;
+        texture->placeholder_height = cached.height;
+    } else {
+        int width, height, components;
+        unsigned char* data = stbi_load_from_memory(buffer.data(), buffer.size(), &width, &height, &components, 0);
+        if (data == nullptr) {
+            ENGINE_LOG_ERROR("Failed to load image {}", key);
+            return nullptr;
+        }
+        texture->placeholder = DownsampleImage(data, width, height, components, streamed_placeholder_size,
+                                               texture->placeholder_width, texture->placeholder_height);
+        stbi_image_free(data);
+        if (cache != nullptr) {
+            cache->SaveImage(placeholder_key, buffer, texture->placeholder.data(), texture->placeholder_width,
+                             texture->placeholder_height, texture->components);
+        }
+    }
+    // Keep the file open and decode straight from it later, rather than keeping a copy
+    texture->file = buffer;
+    texture->source = file;
+
+    ImagePrototype* prototype = new ImagePrototype();
+    prototype->asset = texture.get();
+    prototype->key = key;
+    prototype->options = texture->options;
+    m_asset_queue.push(QueueHolder(prototype));
+    return std::move(texture);
+}
+
 std::unique_ptr<cqsp::asset::Asset> AssetLoader::LoadBinaryAsset(cqsp::asset::VirtualMounter* mount,
                                                                  const std::string& path, const std::string& key,
                                                                  const Hjson::Value& hints) {
     std::unique_ptr<BinaryAsset> asset = std::make_unique<BinaryAsset>();
     auto file = mount->Open(path);
-    asset->data = ReadAllFromVFile(file.get());
+    asset->data = file->View();
+    asset->file = std::move(file);
     return asset;
 }
 
@@ -529,31 +1060,41 @@ std::unique_ptr<Asset> AssetLoader::LoadHjson(VirtualMounter* mount, const std::
 
     // Load a directory if it's a directory
     if (mount->IsDirectory(path)) {
-        // Load and append to assets.
         auto dir = mount->OpenDirectory(path);
+        std::vector<std::shared_ptr<IVirtualFile>> files;
         for (int i = 0; i < dir->GetSize(); i++) {
-            auto file = dir->GetFile(i);
-            Hjson::Value result;
-            // Since it's a directory, we will assume it's an array, and push back the values.
+            files.push_back(dir->GetFile(i));
+        }
+        // The files don't depend on each other, so parse them all at once
+        std::vector<Hjson::Value> results(files.size());
+        common::util::ParallelForEach(static_cast<int>(files.size()), loading_threads, [&](int i) {
+            ZoneScopedN("Parse hjson file");
             try {
-                result = Hjson::Unmarshal(ReadAllFromVFileToString(file.get()), dec_opt);
-                if (result.type() == Hjson::Type::Vector) {
-                    // Append all the values in place
-                    for (int k = 0; k < result.size(); k++) {
-                        asset->data.push_back(result[k]);
-                    }
-                } else {
-                    ENGINE_LOG_ERROR("Failed to load hjson file {}: it needs to be a array", file->Path());
-                }
+                std::string storage;
+                results[i] = ParseHjson(path + "/" + dir->GetFilename(i), ViewVFileAsText(files[i].get(), storage),
+                                        dec_opt);
             } catch (Hjson::syntax_error& ex) {
-                ENGINE_LOG_ERROR("Failed to load hjson file {}: {}", file->Path(), ex.what());
+                ENGINE_LOG_ERROR("Failed to load hjson file {}: {}", files[i]->Path(), ex.what());
+            }
+        });
+        // Load and append to assets, in the same order as the files
+        for (size_t i = 0; i < results.size(); i++) {
+            const Hjson::Value& result = results[i];
+            if (result.type() == Hjson::Type::Vector) {
+                // Since it's a directory, we will assume it's an array, and push back the values.
+                for (int k = 0; k < result.size(); k++) {
+                    asset->data.push_back(result[k]);
+                }
+            } else if (result.defined()) {
+                ENGINE_LOG_ERROR("Failed to load hjson file {}: it needs to be a array", files[i]->Path());
             }
         }
     } else {
         auto file = mount->Open(path.c_str());
         // Read the file
         try {
-            asset->data = Hjson::Unmarshal(ReadAllFromVFileToString(file.get()), dec_opt);
+            std::string storage;
+            asset->data = ParseHjson(path, ViewVFileAsText(file.get(), storage), dec_opt);
         } catch (Hjson::syntax_error& ex) {
             ENGINE_LOG_ERROR("Failed to load hjson {}: {}", path, ex.what());
         }
@@ -561,6 +1102,20 @@ std::unique_ptr<Asset> AssetLoader::LoadHjson(VirtualMounter* mount, const std::
     return asset;
 }
 
+Hjson::Value AssetLoader::ParseHjson(const std::string& key, std::string_view text,
+                                     const Hjson::DecoderOptions& options) {
+    AssetCache* cache = GetCache();
+    Hjson::Value value;
+    if (cache != nullptr && cache->LoadHjson(key, text, value)) {
+        return value;
+    }
+    value = Hjson::Unmarshal(text.data(), text.size(), options);
+    if (cache != nullptr) {
+        cache->SaveHjson(key, text, value);
+    }
+    return value;
+}
+
 std::unique_ptr<Asset> AssetLoader::LoadShader(VirtualMounter* mount, const std::string& path, const std::string& key,
                                                const Hjson::Value& hints) {
     ZoneScoped;
@@ -610,11 +1165,10 @@ std::unique_ptr<Asset> AssetLoader::LoadFont(VirtualMounter* mount, const std::s
 
     std::unique_ptr<Font> asset = std::make_unique<Font>();
     auto file = mount->Open(path);
-    auto bytes = ReadAllFromVFile(file.get());
-
     FontPrototype* prototype = new FontPrototype();
-    prototype->fontBuffer = std::move(bytes);
-    prototype->size = file->Size();
+    prototype->fontBuffer = file->View();
+    prototype->file = std::move(file);
+    prototype->size = prototype->fontBuffer.size();
     prototype->key = key;
     prototype->asset = asset.get();
 
@@ -632,8 +1186,8 @@ std::unique_ptr<Asset> AssetLoader::LoadAudio(VirtualMounter* mount, const std::
         return nullptr;
     }
     auto file = mount->Open(path);
-    auto data = ReadAllFromVFile(file.get());
-    auto asset = LoadOgg(data.data(), file->Size());
+    std::span<const uint8_t> data = file->View();
+    auto asset = LoadOgg(data.data(), data.size());
     return std::move(asset);
 }
 
@@ -646,7 +1200,9 @@ std::unique_ptr<Asset> AssetLoader::LoadCubemap(VirtualMounter* mount, const std
     // Read file, which will be hjson, and load those files too
     Hjson::Value images_hjson;
     auto hjson_file = mount->Open(path);
-    images_hjson = Hjson::Unmarshal(ReadAllFromVFileToString(hjson_file.get()));
+    std::string storage;
+    std::string_view images_text = ViewVFileAsText(hjson_file.get(), storage);
+    images_hjson = Hjson::Unmarshal(images_text.data(), images_text.size());
 
     CubemapPrototype* prototype = new CubemapPrototype();
 
@@ -671,9 +1227,9 @@ std::unique_ptr<Asset> AssetLoader::LoadCubemap(VirtualMounter* mount, const std
         }
         ZoneNamed(CubemapRead, true);
         auto file = mount->Open(image_path);
-        auto file_data = ReadAllFromVFile(file.get());
+        std::span<const uint8_t> file_data = file->View();
         ZoneNamed(CubemapLoad, true);
-        unsigned char* image_data = stbi_load_from_memory(file_data.data(), file->Size(), &prototype->width,
+        unsigned char* image_data = stbi_load_from_memory(file_data.data(), file_data.size(), &prototype->width,
                                                           &prototype->height, &prototype->components, 0);
         prototype->data.push_back(image_data);
     }
@@ -713,9 +1269,11 @@ std::unique_ptr<ShaderDefinition> AssetLoader::LoadShaderDefinition(VirtualMount
 
     Hjson::Value uniforms = hjson["uniforms"];
     std::unique_ptr<ShaderDefinition> shader_def_ptr = std::make_unique<ShaderDefinition>();
+    shader_def_ptr->cache = GetCache();
     shader_def_ptr->uniforms = uniforms;
     shader_def_ptr->vert = vert_code;
     shader_def_ptr->frag = frag_code;
+    shader_def_ptr->sources = {path, vert_filename, frag_filename};
 
     // Load geometry file
     if (hjson["geom"].defined()) {
@@ -725,6 +1283,7 @@ std::unique_ptr<ShaderDefinition> AssetLoader::LoadShaderDefinition(VirtualMount
         auto geom_file = mount->Open(geom_filename);
         std::string geom_code = ReadAllFromVFileToString(geom_file.get());
         shader_def_ptr->geometry = geom_code;
+        shader_def_ptr->sources.push_back(geom_filename);
     }
     // Get uniforms, and then complain, I guess
     return shader_def_ptr;
@@ -796,40 +1355,76 @@ void AssetLoader::LoadResources(Package& package, const std::string& package_mou
     // Open the root directory
     auto directory = mounter.OpenDirectory(package_mount_path + "/");
     ENGINE_LOG_INFO("Loading {}", package_mount_path);
+    std::vector<std::shared_ptr<IVirtualFile>> resource_files;
     for (int i = 0; i < directory->GetSize(); i++) {
         auto resource_file = directory->GetFile(i);
         // Get the path
-        if (GetFilename(resource_file->Path()) != "resource.hjson") {
-            continue;
+        if (GetFilename(resource_file->Path()) == "resource.hjson") {
+            resource_files.push_back(resource_file);
         }
+    }
 
+    // Parse all the manifests first, so that we know every asset before decoding any of them
+    std::vector<Hjson::Value> manifests(resource_files.size());
+    common::util::ParallelForEach(static_cast<int>(resource_files.size()), loading_threads, [&](int i) {
+        ZoneScopedN("Parse resource.hjson");
         // Load the particular asset folder
         // Open the file
         Hjson::DecoderOptions dec_opt;
         dec_opt.comments = false;
         dec_opt.duplicateKeyException = true;
-        std::string asset_data = ReadAllFromVFileToString(resource_file.get());
-        Hjson::Value asset_value;
+        std::string asset_data = ReadAllFromVFileToString(resource_files[i].get());
 
         // Try to load and check for duplicate options, sadly hjson doesn't provide good
         // ways to see which keys are duplicated, except by exception, so we'll have
         // to do this as a hack for now
         try {
-            asset_value = Hjson::Unmarshal(asset_data, dec_opt);
+            manifests[i] = Hjson::Unmarshal(asset_data, dec_opt);
         } catch (Hjson::syntax_error& se) {
             ENGINE_LOG_WARN(se.what());
             // Then try again without the options
             dec_opt.duplicateKeyException = false;
-            asset_value = Hjson::Unmarshal(asset_data, dec_opt);
+            manifests[i] = Hjson::Unmarshal(asset_data, dec_opt);
         }
+    });
+
+    // Gather them in directory order, so that overriding a key works the same as loading them one by one
+    std::vector<ResourceEntry> entries;
+    for (size_t i = 0; i < resource_files.size(); i++) {
+        max_loading += manifests[i].size();
+        LoadResourceHjsonFile(package_mount_path, resource_files[i]->Path(), manifests[i], entries);
+    }
 
-        max_loading += asset_value.size();
-        LoadResourceHjsonFile(package, package_mount_path, resource_file->Path(), asset_value);
+    // Lazy assets are only listed, and are loaded when something asks for them
+    std::vector<ResourceEntry> eager_entries;
+    for (ResourceEntry& entry : entries) {
+        package.resources[entry.key] = entry;
+        const Hjson::Value& hints = entry.hints;
+        Hjson::Value lazy = hints["lazy"];
+        if (lazy.defined() && lazy.type() == Hjson::Type::Bool && static_cast<bool>(lazy)) {
+            package.lazy_assets[entry.key] = std::move(entry);
+            currentloading++;
+        } else {
+            eager_entries.push_back(std::move(entry));
+        }
     }
+    entries = std::move(eager_entries);
+
+    // None of the assets depend on each other, so they can all be decoded at once
+    common::util::ParallelForEach(static_cast<int>(entries.size()), loading_threads, [&](int i) {
+        const ResourceEntry& entry = entries[i];
+        // An exception would take down the whole worker thread, so only lose the asset
+        try {
+            PlaceAsset(package, entry.type, entry.path, entry.key, entry.hints);
+        } catch (std::exception& ex) {
+            ENGINE_LOG_ERROR("Failed to load asset {}: {}", entry.key, ex.what());
+        }
+        currentloading++;
+    });
 }
 
-void AssetLoader::LoadResourceHjsonFile(Package& package, const std::string& package_mount_path,
-                                        const std::string& resource_file_path, const Hjson::Value& asset_value) {
+void AssetLoader::LoadResourceHjsonFile(const std::string& package_mount_path, const std::string& resource_file_path,
+                                        const Hjson::Value& asset_value, std::vector<ResourceEntry>& entries) {
     ZoneScoped;
     for (const auto [key, val] : asset_value) {
         ENGINE_LOG_TRACE("Loading asset {}", key);
@@ -861,8 +1456,17 @@ void AssetLoader::LoadResourceHjsonFile(Package& package, const std::string& pac
         if (val["hints"].defined()) {
             hints = val["hints"];
         }
-        PlaceAsset(package, FromString(type), path, std::string(key), hints);
-        currentloading++;
+
+        ResourceEntry entry {FromString(type), path, std::string(key), hints};
+        auto existing = std::find_if(entries.begin(), entries.end(),
+                                     [&](const ResourceEntry& other) { return other.key == entry.key; });
+        if (existing != entries.end()) {
+            // Overridden, so the earlier one never gets loaded
+            *existing = std::move(entry);
+            currentloading++;
+        } else {
+            entries.push_back(std::move(entry));
+        }
     }
 }
 bool AssetLoader::HjsonPrototypeDirectory(Package& package, const std::string& path, const std::string& name) {
@@ -871,11 +1475,21 @@ bool AssetLoader::HjsonPrototypeDirectory(Package& package, const std::string& p
         return false;
     }
     package.assets[name] = LoadHjson(&mounter, path, name, Hjson::Value());
+    package.resources[name] = {AssetType::HJSON, path, name, Hjson::Value()};
     return true;
 }
 
 IVirtualFileSystem* AssetLoader::GetVfs(const std::string& path) {
-    // Return native filesystem for now.
+    // Mods are either a folder, or that folder packed into a single file
+    if (std::filesystem::path(path).extension() == PackFileSystem::extension &&
+        std::filesystem::is_regular_file(path)) {
+        PackFileSystem* pack = new PackFileSystem(path);
+        if (!pack->Initialize()) {
+            delete pack;
+            return nullptr;
+        }
+        return pack;
+    }
     return new NativeFileSystem(path.c_str());
 }
 }  // namespace cqsp::asset
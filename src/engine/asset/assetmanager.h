@@ -19,21 +19,33 @@
 #include <hjson.h>
 #include <spdlog/spdlog.h>
 
+#include <array>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
 #include <istream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "engine/asset/asset.h"
+#include "engine/asset/assetcache.h"
+#include "engine/asset/filewatcher.h"
 #include "engine/asset/textasset.h"
 #include "engine/asset/vfs/vfs.h"
 #include "engine/engine.h"
 #include "engine/enginelogger.h"
 #include "engine/graphics/shader.h"
+#include "engine/graphics/stagingring.h"
 #include "engine/graphics/text.h"
 #include "engine/graphics/texture.h"
 #include "engine/gui.h"
@@ -121,6 +133,16 @@ class ThreadsafeQueue {
 class AssetLoader;
 class AssetManager;
 
+/// <summary>
+/// An asset listed in a `resource.hjson` file that is waiting to be loaded
+/// </summary>
+struct ResourceEntry {
+    AssetType type;
+    std::string path;
+    std::string key;
+    Hjson::Value hints;
+};
+
 class Package {
  public:
     std::string name;
@@ -136,12 +158,30 @@ class Package {
         return dynamic_cast<T*>(assets[asset].get());
     }
 
+    /// <summary>
+    /// If the asset is in the package, loaded or not.
+    /// </summary>
     bool HasAsset(const char* asset);
     bool HasAsset(const std::string& asset);
 
+    /// <summary>
+    /// If the asset has been loaded, lazy assets are only loaded once they are asked for.
+    /// </summary>
+    bool IsLoaded(const std::string& asset) { return assets.count(asset) != 0; }
+
  private:
     std::map<std::string, std::unique_ptr<Asset>> assets;
 
+    /// <summary>
+    /// Assets that are listed with the `lazy` hint, and have not been loaded yet
+    /// </summary>
+    std::map<std::string, ResourceEntry> lazy_assets;
+
+    /// <summary>
+    /// Where every asset in the package is loaded from, so that they can be loaded again when they change
+    /// </summary>
+    std::map<std::string, ResourceEntry> resources;
+
     void ClearAssets();
 
     friend class AssetLoader;
@@ -159,59 +199,164 @@ class PackagePrototype {
     bool enabled;
 };
 
+template <class T>
+class AssetHandle;
+
+/// <summary>
+/// Key of an asset that is interned with @ref AssetManager::Intern.
+/// </summary>
+struct AssetId {
+    static constexpr uint32_t invalid = UINT32_MAX;
+    uint32_t index = invalid;
+
+    bool Valid() const { return index != invalid; }
+    bool operator==(const AssetId& other) const { return index == other.index; }
+};
+
+/// <summary>
+/// Unique tag for every asset type, so that types can be compared without RTTI.
+/// </summary>
+template <class T>
+const void* AssetTypeTag() {
+    static const char tag = 0;
+    return &tag;
+}
+
 class AssetManager {
  public:
     AssetManager();
+    ~AssetManager();
 
     ShaderProgram_t MakeShader(const std::string& vert, const std::string& frag);
     ShaderProgram_t MakeShader(const std::string& vert, const std::string& frag, const std::string& geom);
 
+    /// <summary>
+    /// Interns the key of an asset, so that the asset can be looked up without any string work. The id stays
+    /// valid for as long as the asset manager exists, even if the assets are cleared and loaded again.
+    /// </summary>
+    /// <param name="key">Key of the asset, in the same format as @ref GetAsset</param>
+    AssetId Intern(const std::string& key);
+
     /// <summary>
     /// Gets an asset.
     /// </summary>
     /// To get an asset, it defaults finding the asset in `core` if you do not specify a package,
     /// or else if the asset is from another asset pack, you can specify
     /// `mod_name:asset_name`, the separator between the two being a colon.
+    /// <br />
+    /// The key is interned every call, so use @ref Intern and the id for assets that are looked up often.
     /// <typeparam name="T">The type class</typeparam>
     /// <param name="key"></param>
     /// <returns></returns>
     template <class T>
     T* GetAsset(const std::string& key) {
+        return GetAsset<T>(Intern(key));
+    }
+
+    /// <summary>
+    /// Gets an asset from its interned key. Once the asset has been found, this is only an array index and a
+    /// check that the asset was found as the same type before.
+    /// </summary>
+    template <class T>
+    T* GetAsset(AssetId id) {
         static_assert(std::is_base_of<Asset, T>::value, "Class is not child of cqsp::asset::Asset");
-        std::size_t separation = key.find(":");
-        // Default name is core
-        std::string package_name = "core";
-        if (separation != std::string::npos) {
-            package_name = key.substr(0, separation);
+        if (!id.Valid()) {
+            return nullptr;
         }
-
-        // Check if package exists
-        if (packages.count(package_name) == 0) {
-            ENGINE_LOG_ERROR("Cannot find package {}", package_name);
+        AssetSlot& slot = GetSlot(id);
+        if (slot.type == AssetTypeTag<T>()) {
+            return static_cast<T*>(slot.typed);
         }
-        std::string pkg_key = key.substr(separation + 1, key.length());
-        auto& package = packages[package_name];
+        Asset* asset = ResolveSlot(slot);
         // Probably a better way to do this, to be honest
         // Load default texture
-        if (!package->HasAsset(pkg_key)) {
-            ENGINE_LOG_ERROR("Cannot find asset {}", pkg_key);
+        if (asset == nullptr) {
             if constexpr (std::is_same<T, asset::Texture>::value) {
                 return &empty_texture;
             }
+            return nullptr;
         }
-        // Check if asset exists
-        T* ptr = package->GetAsset<T>(pkg_key);
+        T* ptr = dynamic_cast<T*>(asset);
         if (ptr == nullptr) {
-            SPDLOG_WARN("Asset {} is wrong type", key);
+            SPDLOG_WARN("Asset {}:{} is wrong type", slot.package, slot.key);
+            return nullptr;
         }
+        slot.type = AssetTypeTag<T>();
+        slot.typed = ptr;
         return ptr;
     }
 
+    /// <summary>
+    /// Gets a handle to an asset. Unlike @ref GetAsset, lazy assets are loaded in the background
+    /// the first time the handle is used, and the handle gives a placeholder until then.
+    /// </summary>
+    template <class T>
+    AssetHandle<T> GetHandle(const std::string& key) {
+        static_assert(std::is_base_of<Asset, T>::value, "Class is not child of cqsp::asset::Asset");
+        return AssetHandle<T>(this, key);
+    }
+
+    /// <summary>
+    /// Starts loading a lazy asset in the background if it isn't loaded yet.
+    /// </summary>
+    /// <param name="key">Key of the asset, in the same format as @ref GetAsset</param>
+    /// <param name="callback">Called on the main thread once the asset is ready, with null if it failed to load.
+    /// If the asset is already loaded, it is called immediately.</param>
+    void RequestAsset(const std::string& key, const std::function<void(Asset*)>& callback = nullptr);
+
+    /// <summary>
+    /// Gets the asset if it is loaded, without loading it.
+    /// </summary>
+    Asset* FindLoadedAsset(const std::string& key);
+    Asset* FindLoadedAsset(AssetId id);
+
+    /// <summary>
+    /// What to show while an asset is loading, only textures have one.
+    /// </summary>
+    template <class T>
+    T* GetPlaceholder() {
+        if constexpr (std::is_same<T, asset::Texture>::value) {
+            return &empty_texture;
+        }
+        return nullptr;
+    }
+
+    /// <summary>
+    /// Builds the requested assets on the main thread and calls their callbacks. Needs to be called every frame.
+    /// </summary>
+    /// <param name="budget">Time budget in milliseconds</param>
+    void Update(double budget = update_budget);
+
+    /// <summary>
+    /// Keeps the loader that loaded the packages so that lazy assets can be loaded from the mounted packages.
+    /// </summary>
+    void SetLoader(std::unique_ptr<AssetLoader> loader);
+
+    /// <summary>
+    /// Watches the folders of the loaded packages, and reloads the assets whose files change in @ref Update.
+    /// Reloaded assets keep their address, so pointers to them stay valid. Packed packages can't change, so
+    /// they aren't watched.
+    /// </summary>
+    /// <returns>If hot reloading is supported on this platform</returns>
+    bool EnableHotReload();
+
+    /// <summary>
+    /// Called on the main thread after the asset is reloaded, so that whatever was made from the asset can be
+    /// made again.
+    /// </summary>
+    /// <param name="key">Key of the asset, in the same format as @ref GetAsset</param>
+    void AddReloadCallback(const std::string& key, const std::function<void(Asset*)>& callback);
+
     void LoadDefaultTexture();
     void ClearAssets();
 
     Package* GetPackage(const std::string& name) { return packages[name].get(); }
 
+    /// <summary>
+    /// Adds a loaded package, replacing the package with the same name if there is one.
+    /// </summary>
+    void AddPackage(std::unique_ptr<Package> package);
+
     int GetPackageCount() { return packages.size(); }
 
     auto GetPackageBegin() { return packages.begin(); }
@@ -220,14 +365,160 @@ class AssetManager {
 
     void SaveModList();
 
+    /// <summary>
+    /// Cache of decoded assets, kept in the save folder
+    /// </summary>
+    AssetCache& GetCache() { return cache; }
+
     std::map<std::string, PackagePrototype> m_package_prototype_list;
 
+    /// <summary>
+    /// Milliseconds every frame that can be spent building requested assets
+    /// </summary>
+    static constexpr double update_budget = 4.0;
+
  private:
+    /// <summary>
+    /// Finds the package of the key, and the key of the asset in the package.
+    /// </summary>
+    Package* FindPackage(const std::string& key, std::string& package_key);
+
+    /// <summary>
+    /// An interned key, and the asset that it was last found as.
+    /// </summary>
+    struct AssetSlot {
+        std::string package;
+        std::string key;
+        /// Null until the asset is found
+        Asset* asset = nullptr;
+        /// Tag of the type that the asset was last cast to, and the asset as that type
+        const void* type = nullptr;
+        void* typed = nullptr;
+    };
+
+    AssetSlot& GetSlot(AssetId id) { return slot_pages[id.index / slot_page_size][id.index % slot_page_size]; }
+
+    /// <summary>
+    /// Finds the asset of the slot, and loads it if it's lazy. Null if the asset doesn't exist.
+    /// </summary>
+    Asset* ResolveSlot(AssetSlot& slot);
+
+    /// <summary>
+    /// Loads a lazy asset on the calling thread, and waits for it to be built.
+    /// </summary>
+    void LoadLazyAsset(Package& package, const std::string& key);
+
+    /// <summary>
+    /// Places the asset into the package and calls the callbacks waiting for it.
+    /// </summary>
+    void FinishRequest(const std::string& key, std::unique_ptr<Asset> asset);
+
+    /// <summary>
+    /// Decodes the requested assets in the background
+    /// </summary>
+    void RequestWorker();
+
+    /// <summary>
+    /// Reloads the assets whose files were changed since the last call
+    /// </summary>
+    void ReloadChangedAssets();
+
+    /// <summary>
+    /// Loads the asset again and replaces the contents of the loaded asset with it.
+    /// </summary>
+    void ReloadAsset(Package& package, const ResourceEntry& entry);
+
+    struct AssetRequest {
+        Package* package;
+        std::string key;
+        std::vector<std::function<void(Asset*)>> callbacks;
+    };
+
     std::map<std::string, std::unique_ptr<Package>> packages;
     asset::Texture empty_texture;
+
+    // Slots are allocated in pages that never move, so that looking up a slot never needs a lock
+    static constexpr size_t slot_page_size = 256;
+    static constexpr size_t slot_page_count = 256;
+    std::array<std::unique_ptr<AssetSlot[]>, slot_page_count> slot_pages;
+    uint32_t slot_count = 0;
+    std::unordered_map<std::string, AssetId> interned_keys;
+    std::mutex intern_mutex;
+    AssetCache cache;
+
+    std::unique_ptr<AssetLoader> loader;
+    /// <summary>
+    /// Held while the loader loads an asset. The request worker, lazy loading and hot reloading all load
+    /// through the same loader, and its mount points and loading functions aren't made to be shared.
+    /// </summary>
+    std::mutex loader_mutex;
+    /// Requested assets that aren't ready yet, with the full key of the asset
+    std::map<std::string, AssetRequest> requests;
+    /// Assets that the worker needs to decode
+    std::queue<std::pair<std::string, ResourceEntry>> request_queue;
+    /// Assets that the worker has decoded
+    std::vector<std::pair<std::string, std::unique_ptr<Asset>>> decoded;
+    /// Decoded assets that are waiting for their prototypes to be built
+    std::vector<std::pair<std::string, std::unique_ptr<Asset>>> building;
+    std::mutex request_mutex;
+    std::condition_variable request_condition;
+    std::thread request_worker;
+    bool stop_worker = false;
+
+    std::unique_ptr<FileWatcher> watcher;
+    /// Native folders of the packages that are watched, and the name of their package
+    std::vector<std::pair<std::filesystem::path, std::string>> watched_packages;
+    /// Callbacks for reloaded assets, with the full key of the asset
+    std::map<std::string, std::vector<std::function<void(Asset*)>>> reload_callbacks;
+    std::mutex reload_mutex;
+
     friend class AssetLoader;
 };
 
+/// <summary>
+/// Handle to an asset that may not have been loaded yet. Handles are cheap to copy, and stay valid for as
+/// long as the asset manager has the asset.
+/// </summary>
+template <class T>
+class AssetHandle {
+ public:
+    AssetHandle() = default;
+    AssetHandle(AssetManager* _manager, const std::string& _key)
+        : manager(_manager), key(_key), id(_manager->Intern(_key)) {}
+
+    /// <summary>
+    /// Gets the asset, or the placeholder while it is loading. The first call starts loading the asset.
+    /// </summary>
+    T* Get() {
+        if (asset != nullptr || manager == nullptr) {
+            return asset;
+        }
+        Asset* loaded = manager->FindLoadedAsset(id);
+        if (loaded != nullptr) {
+            asset = dynamic_cast<T*>(loaded);
+            return asset;
+        }
+        manager->RequestAsset(key);
+        return manager->GetPlaceholder<T>();
+    }
+
+    /// <summary>
+    /// If the asset is loaded, rather than the placeholder being used.
+    /// </summary>
+    bool IsReady() { return asset != nullptr || (manager != nullptr && manager->FindLoadedAsset(id) != nullptr); }
+
+    const std::string& GetKey() const { return key; }
+
+    T* operator->() { return Get(); }
+    explicit operator bool() const { return manager != nullptr; }
+
+ private:
+    AssetManager* manager = nullptr;
+    std::string key;
+    AssetId id;
+    T* asset = nullptr;
+};
+
 class AssetLoader {
  public:
     AssetLoader();
@@ -276,6 +567,13 @@ class AssetLoader {
     /// </summary>
     void BuildNextAsset();
 
+    /// <summary>
+    /// Builds assets from the queue until the queue is empty or the time budget runs out. At least one
+    /// asset is built every call, so the queue always makes progress.
+    /// </summary>
+    /// <param name="budget">Time budget in milliseconds</param>
+    void BuildAssets(double budget);
+
     /// <summary>
     /// Checks if the queue has any remaining items to load on the main thread or not.
     /// </summary>
@@ -301,11 +599,21 @@ class AssetLoader {
 
     AssetManager* manager;
 
+    /// <summary>
+    /// Number of threads that decode assets in parallel, 0 uses all the hardware threads.
+    /// </summary>
+    unsigned int loading_threads = 0;
+
     typedef std::function<std::unique_ptr<Asset>(cqsp::asset::VirtualMounter* mount, const std::string& path,
                                                  const std::string& key, const Hjson::Value& hints)>
         LoaderFunction;
 
  private:
+    /// <summary>
+    /// The cache of the asset manager, or null if there isn't one
+    /// </summary>
+    AssetCache* GetCache() { return (manager != nullptr) ? &manager->cache : nullptr; }
+
     std::optional<PackagePrototype> LoadModPrototype(const std::string&);
 
     /// <summary>
@@ -323,13 +631,25 @@ class AssetLoader {
                                                           const std::string& key, const Hjson::Value& hints);
 
     /// <summary>
-    /// Textures have one hint, the `magfilter` hint. If it is present, and set to true, it will enable
+    /// Textures have two hints. The `magfilter` hint, if it is present, and set to true, it will enable
     /// closest magfilter, which will make the texture look pixellated.
     /// If it is not present, then it will be linear mag.
+    /// <br>
+    /// If the `streamed` hint is set to true, only a small placeholder of the texture is uploaded, and the
+    /// texture becomes a @ref StreamedTexture that can be streamed in by @ref TextureStreamer.
+    /// <br>
+    /// Decoded images are kept in the @ref AssetCache, so they only have to be decoded again when the file changes.
     /// </summary>
     std::unique_ptr<cqsp::asset::Asset> LoadTexture(cqsp::asset::VirtualMounter* mount, const std::string& path,
                                                     const std::string& key, const Hjson::Value& hints);
 
+    /// <summary>
+    /// Loads a texture that is streamed in by the @ref TextureStreamer. Only the image header is read, and the
+    /// placeholder comes from the @ref AssetCache, so the full image is decoded at most once, when it is not cached.
+    /// </summary>
+    std::unique_ptr<cqsp::asset::Asset> LoadStreamedTexture(const IVirtualFilePtr& file, const std::string& path,
+                                                            const std::string& key, bool mag_filter);
+
     /// <summary>
     /// Loads binary data straight from the file.
     /// </summary>
@@ -346,10 +666,18 @@ class AssetLoader {
     ///
     /// If it refers to directory, and a file that is loaded is not in a hjson array, it will not load that specific
     /// file, but it will not fail.
+    /// <br>
+    /// Parsed files are kept in the @ref AssetCache in binary form.
     /// </summary>
     std::unique_ptr<cqsp::asset::Asset> LoadHjson(cqsp::asset::VirtualMounter* mount, const std::string& path,
                                                   const std::string& key, const Hjson::Value& hints);
 
+    /// <summary>
+    /// Parses the hjson text, or reads it from the cache if it was parsed before.
+    /// </summary>
+    /// <param name="key">Virtual path of the file the text is from</param>
+    Hjson::Value ParseHjson(const std::string& key, std::string_view text, const Hjson::DecoderOptions& options);
+
     /// <summary>
     /// Shaders have one option, the `type` hint, to specify what type of shader it is.
     /// We have two so far, the `frag` option for a fragment shader, and `vert` for a vertex shader.
@@ -454,6 +782,8 @@ class AssetLoader {
     /// <summary>
     /// Conducts checks to determine if the asset was loaded correctly. Wraps Load asset,
     /// and contains the same parameters
+    /// <br>
+    /// Can be called from multiple threads at once.
     /// </summary>
     /// <param name="package">Package to load into</param>
     void PlaceAsset(Package& package, const AssetType& type, const std::string& path, const std::string& key,
@@ -486,19 +816,24 @@ class AssetLoader {
     /// }
     /// ```
     /// <br>
+    /// All the `resource.hjson` files are parsed first, then the assets that they list are decoded in parallel
+    /// on @ref loading_threads threads. If a key is listed more than once, the last one listed is loaded.
+    /// <br>
+    /// Assets with the `lazy` hint set to true are not loaded here. They are loaded when they are first asked
+    /// for, through @ref AssetManager::GetHandle or @ref AssetManager::GetAsset.
     /// </summary>
     void LoadResources(Package& package, const std::string& path);
 
     /// <summary>
-    /// Loads all the resources defined in the hjson `asset_value` in the hjson resource
-    /// loading format.
+    /// Reads all the resources defined in the hjson `asset_value` in the hjson resource
+    /// loading format, and adds them to the entries to load.
     /// </summary>
-    /// <param name="package">Package to load into</param>
     /// <param name="resource_mount_path">root path of the package</param>
     /// <param name="resource_file_path">Resource file path</param>
     /// <param name="asset_value">Hjson value to read from</param>
-    void LoadResourceHjsonFile(Package& package, const std::string& resource_mount_path,
-                               const std::string& resource_file_path, const Hjson::Value& asset_value);
+    /// <param name="entries">Entries to add to, an entry with the same key is replaced</param>
+    void LoadResourceHjsonFile(const std::string& resource_mount_path, const std::string& resource_file_path,
+                               const Hjson::Value& asset_value, std::vector<ResourceEntry>& entries);
     /// <summary>
     /// Defines a directory that contains hjson asset data.
     /// </summary>
@@ -509,7 +844,8 @@ class AssetLoader {
     bool HjsonPrototypeDirectory(Package& package, const std::string& path, const std::string& name);
 
     /// <summary>
-    /// Creates a virtual file system starting in path
+    /// Creates a virtual file system starting in path. If the path is a .cqpak file, the pack is mounted
+    /// instead. Returns nullptr if the pack is invalid.
     /// </summary>
     /// <param name="path"></param>
     /// <returns></returns>
@@ -537,6 +873,22 @@ class AssetLoader {
     /// \see @ref LoadScriptDirectory LoadCubemap LoadAudio LoadText LoadTexture LoadHjson LoadShader LoadFont
     std::map<AssetType, LoaderFunction> loading_functions;
     VirtualMounter mounter;
+
+    /// <summary>
+    /// Staging memory that textures are uploaded through, so that the copies to the GPU overlap with
+    /// the next assets being built.
+    /// </summary>
+    StagingRing staging_ring;
+
+    /// <summary>
+    /// Guards the assets of the package that is being loaded, since the assets are placed from many threads.
+    /// </summary>
+    std::mutex package_mutex;
+
+    /// <summary>
+    /// Largest side of the placeholders of streamed textures, in pixels
+    /// </summary>
+    static constexpr int streamed_placeholder_size = 512;
 };
 }  // namespace asset
 }  // namespace cqsp
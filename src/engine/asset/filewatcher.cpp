@@ -0,0 +1,125 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "engine/asset/filewatcher.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/enginelogger.h"
+
+namespace cqsp::asset {
+#ifdef __linux__
+namespace {
+// Editors either write the file in place, or write another file and move it over the original
+constexpr uint32_t watch_mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+}  // namespace
+
+FileWatcher::FileWatcher() { fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC); }
+
+FileWatcher::~FileWatcher() {
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+bool FileWatcher::IsSupported() const { return fd != -1; }
+
+bool FileWatcher::Watch(const std::string& directory) {
+    if (fd == -1 || !std::filesystem::is_directory(directory)) {
+        return false;
+    }
+    AddWatch(directory);
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, ec)) {
+        if (entry.is_directory()) {
+            AddWatch(entry.path().string());
+        }
+    }
+    return true;
+}
+
+void FileWatcher::AddWatch(const std::string& directory) {
+    int wd = inotify_add_watch(fd, directory.c_str(), watch_mask);
+    if (wd == -1) {
+        ENGINE_LOG_WARN("Cannot watch {}", directory);
+        return;
+    }
+    watches[wd] = directory;
+}
+
+std::vector<std::string> FileWatcher::Poll() {
+    std::vector<std::string> changed;
+    if (fd == -1) {
+        return changed;
+    }
+    ZoneScoped;
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // Nothing more to read, the descriptor is non blocking
+            break;
+        }
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            auto it = watches.find(event->wd);
+            if (it == watches.end() || event->len == 0) {
+                continue;
+            }
+            std::string path = (std::filesystem::path(it->second) / event->name).string();
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    Watch(path);
+                }
+                continue;
+            }
+            // Files are reported once they are closed, not when they are made
+            if (event->mask & IN_CREATE) {
+                continue;
+            }
+            if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                changed.push_back(path);
+            }
+        }
+    }
+    return changed;
+}
+#else
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::IsSupported() const { return false; }
+
+bool FileWatcher::Watch(const std::string& directory) { return false; }
+
+void FileWatcher::AddWatch(const std::string& directory) {}
+
+std::vector<std::string> FileWatcher::Poll() { return std::vector<std::string>(); }
+#endif
+}  // namespace cqsp::asset
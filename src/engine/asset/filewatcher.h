@@ -0,0 +1,56 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cqsp::asset {
+/// <summary>
+/// Watches directories for files that are written to, so that assets can be reloaded while the game runs.
+/// <br />
+/// Only implemented with inotify on linux, on other platforms nothing is ever reported.
+/// </summary>
+class FileWatcher {
+ public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool IsSupported() const;
+
+    /// <summary>
+    /// Watches the directory and all the directories in it, including ones that are made later.
+    /// </summary>
+    bool Watch(const std::string& directory);
+
+    /// <summary>
+    /// Gets the paths of the files that have changed since the last poll. Never blocks.
+    /// </summary>
+    std::vector<std::string> Poll();
+
+ private:
+    void AddWatch(const std::string& directory);
+
+    int fd = -1;
+    /// Watched directories by watch descriptor
+    std::map<int, std::string> watches;
+};
+}  // namespace cqsp::asset
@@ -19,13 +19,25 @@
 #include <hjson.h>
 
 #include <map>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "engine/asset/asset.h"
+#include "engine/asset/vfs/vfs.h"
 namespace cqsp::asset {
 class TextAsset : public Asset {
  public:
+    bool Replace(Asset& other) override {
+        auto* asset = dynamic_cast<TextAsset*>(&other);
+        if (asset == nullptr) {
+            return false;
+        }
+        std::swap(data, asset->data);
+        return true;
+    }
+
     std::string data;
 };
 
@@ -46,17 +58,49 @@ class PathedTextAsset {
 /// </summary>
 class TextDirectoryAsset : public Asset {
  public:
+    bool Replace(Asset& other) override {
+        auto* asset = dynamic_cast<TextDirectoryAsset*>(&other);
+        if (asset == nullptr) {
+            return false;
+        }
+        std::swap(paths, asset->paths);
+        return true;
+    }
+
     // Get the path of the assets
     std::map<std::string, PathedTextAsset> paths;
 };
 
 class HjsonAsset : public Asset {
  public:
+    bool Replace(Asset& other) override {
+        auto* asset = dynamic_cast<HjsonAsset*>(&other);
+        if (asset == nullptr) {
+            return false;
+        }
+        std::swap(data, asset->data);
+        return true;
+    }
+
     Hjson::Value data;
 };
 
 class BinaryAsset : public Asset {
  public:
-    std::vector<uint8_t> data;
+    bool Replace(Asset& other) override {
+        auto* asset = dynamic_cast<BinaryAsset*>(&other);
+        if (asset == nullptr) {
+            return false;
+        }
+        std::swap(file, asset->file);
+        std::swap(data, asset->data);
+        return true;
+    }
+
+    /// <summary>
+    /// The file is kept open, so that data can view it in place instead of copying it
+    /// </summary>
+    IVirtualFilePtr file;
+    std::span<const uint8_t> data;
 };
 }  // namespace cqsp::asset
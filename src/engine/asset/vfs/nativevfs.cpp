@@ -16,6 +16,15 @@
 */
 #include "engine/asset/vfs/nativevfs.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
 #include <filesystem>
 #include <memory>
@@ -44,6 +53,7 @@ std::shared_ptr<cqsp::asset::IVirtualFile> cqsp::asset::NativeFileSystem::Open(c
         file_name = file_name.erase(0, 1);
     }
     std::shared_ptr<NativeFile> nfile = std::make_shared<NativeFile>(this, file_name);
+    nfile->native_path = path;
     // Always open binary for carrige return purposes.
     // TODO(EhWhoAmI): Make this able to read text without carrige return.
     nfile->file.open(path, std::ios::binary);
@@ -64,6 +74,7 @@ void cqsp::asset::NativeFileSystem::Close(std::shared_ptr<IVirtualFile>& vf) {
     // Cast the pointer
     NativeFile* f = dynamic_cast<NativeFile*>(vf.get());
     f->file.close();
+    f->Unmap();
 }
 
 std::shared_ptr<cqsp::asset::IVirtualDirectory> cqsp::asset::NativeFileSystem::OpenDirectory(const std::string& dir) {
@@ -107,7 +118,64 @@ bool cqsp::asset::NativeFileSystem::Exists(const std::string& path) {
     return std::filesystem::exists(std::filesystem::path(root) / path);
 }
 
-cqsp::asset::NativeFile::~NativeFile() { file.close(); }
+cqsp::asset::NativeFile::~NativeFile() {
+    file.close();
+    Unmap();
+}
+
+std::span<const uint8_t> cqsp::asset::NativeFile::View() {
+    ZoneScoped;
+    if (mapped != nullptr) {
+        return std::span<const uint8_t>(mapped, size);
+    }
+    if (size <= 0) {
+        return std::span<const uint8_t>();
+    }
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(native_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle != INVALID_HANDLE_VALUE) {
+        mapping_handle = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        // The mapping keeps the file open by itself
+        CloseHandle(handle);
+        if (mapping_handle != nullptr) {
+            mapped = static_cast<const uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+#else
+    int fd = open(native_path.c_str(), O_RDONLY);
+    if (fd != -1) {
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping keeps the file open by itself
+        close(fd);
+        if (address != MAP_FAILED) {
+            mapped = static_cast<const uint8_t*>(address);
+        }
+    }
+#endif
+    if (mapped == nullptr) {
+        Unmap();
+        return IVirtualFile::View();
+    }
+    return std::span<const uint8_t>(mapped, size);
+}
+
+void cqsp::asset::NativeFile::Unmap() {
+#ifdef _WIN32
+    if (mapped != nullptr) {
+        UnmapViewOfFile(mapped);
+    }
+    if (mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+    }
+#else
+    if (mapped != nullptr) {
+        munmap(const_cast<uint8_t*>(mapped), size);
+    }
+#endif
+    mapped = nullptr;
+}
 
 const std::string& cqsp::asset::NativeFile::Path() { return path; }
 
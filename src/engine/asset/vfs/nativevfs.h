@@ -45,13 +45,27 @@ class NativeFile : public IVirtualFile {
 
     IVirtualFileSystem* GetFileSystem() override { return reinterpret_cast<IVirtualFileSystem*>(nfs); }
 
+    /// <summary>
+    /// Maps the file into memory, and falls back to reading it if mapping fails.
+    /// </summary>
+    std::span<const uint8_t> View() override;
+
     friend NativeFileSystem;
 
  private:
+    void Unmap();
+
     std::string path;
+    /// Path on the native file system, for mapping the file
+    std::string native_path;
     std::ifstream file;
     int size;
 
+    const uint8_t* mapped = nullptr;
+#ifdef _WIN32
+    void* mapping_handle = nullptr;
+#endif
+
     NativeFileSystem* const nfs;
 };
 
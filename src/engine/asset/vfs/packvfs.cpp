@@ -0,0 +1,314 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "engine/asset/vfs/packvfs.h"
+
+#include <lz4.h>
+#include <string.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/enginelogger.h"
+
+namespace cqsp::asset {
+namespace {
+// magic, version, entry count, reserved, table of contents offset
+constexpr size_t header_size = 4 + sizeof(uint32_t) * 3 + sizeof(uint64_t);
+
+/// Removes slashes at the ends and uses forward slashes, so that paths can be compared with the table of contents
+std::string NormalizePath(const std::string& path) {
+    std::string normalized = path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    size_t begin = normalized.find_first_not_of('/');
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = normalized.find_last_not_of('/');
+    return normalized.substr(begin, end - begin + 1);
+}
+
+template <typename T>
+bool Read(std::span<const uint8_t> data, size_t& position, T& value) {
+    if (position + sizeof(T) > data.size()) {
+        return false;
+    }
+    memcpy(&value, data.data() + position, sizeof(T));
+    position += sizeof(T);
+    return true;
+}
+
+template <typename T>
+void Write(std::ofstream& output, const T& value) {
+    output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+}  // namespace
+
+void PackFile::Read(uint8_t* buffer, int bytes) {
+    std::span<const uint8_t> data = View();
+    if (position >= data.size()) {
+        return;
+    }
+    size_t count = std::min(static_cast<size_t>(bytes), data.size() - position);
+    memcpy(buffer, data.data() + position, count);
+    position += count;
+}
+
+bool PackFile::Seek(long offset, Offset origin) {
+    int64_t base = 0;
+    switch (origin) {
+        case Offset::Beg:
+            base = 0;
+            break;
+        case Offset::Cur:
+            base = position;
+            break;
+        case Offset::End:
+            base = entry.size;
+            break;
+    }
+    if (base + offset < 0) {
+        return false;
+    }
+    position = base + offset;
+    return true;
+}
+
+IVirtualFileSystem* PackFile::GetFileSystem() { return pfs; }
+
+std::span<const uint8_t> PackFile::View() {
+    if (entry.compression == PackCompression::None) {
+        return stored;
+    }
+    if (view_buffer.size() == entry.size) {
+        return view_buffer;
+    }
+    ZoneScoped;
+    view_buffer.resize(entry.size);
+    int result = LZ4_decompress_safe(reinterpret_cast<const char*>(stored.data()),
+                                     reinterpret_cast<char*>(view_buffer.data()), static_cast<int>(stored.size()),
+                                     static_cast<int>(view_buffer.size()));
+    if (result != static_cast<int>(entry.size)) {
+        ENGINE_LOG_ERROR("Failed to decompress {} from pack", entry.path);
+        view_buffer.clear();
+    }
+    return view_buffer;
+}
+
+PackFileSystem::PackFileSystem(const std::string& _pack_path)
+    : pack_path(_pack_path), native_fs(std::filesystem::path(_pack_path).parent_path().string()) {}
+
+PackFileSystem::~PackFileSystem() {}
+
+bool PackFileSystem::Initialize() {
+    ZoneScoped;
+    pack_file = native_fs.Open(std::filesystem::path(pack_path).filename().string(), FileModes::Binary);
+    if (pack_file == nullptr) {
+        ENGINE_LOG_ERROR("Cannot open pack {}", pack_path);
+        return false;
+    }
+    // The whole pack is mapped, so the data of every file is read straight from the mapping
+    pack_data = pack_file->View();
+
+    size_t position = 0;
+    char file_magic[4];
+    uint32_t file_version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t toc_offset;
+    if (!Read(pack_data, position, file_magic) || memcmp(file_magic, magic, sizeof(magic)) != 0 ||
+        !Read(pack_data, position, file_version) || file_version != version || !Read(pack_data, position, count) ||
+        !Read(pack_data, position, reserved) || !Read(pack_data, position, toc_offset)) {
+        ENGINE_LOG_ERROR("{} is not a valid pack", pack_path);
+        return false;
+    }
+
+    position = toc_offset;
+    entries.clear();
+    entries.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        PackEntry entry;
+        uint16_t length;
+        if (!Read(pack_data, position, length) || position + length > pack_data.size()) {
+            ENGINE_LOG_ERROR("Table of contents of pack {} is truncated", pack_path);
+            entries.clear();
+            return false;
+        }
+        entry.path.assign(reinterpret_cast<const char*>(pack_data.data() + position), length);
+        position += length;
+        if (!Read(pack_data, position, entry.offset) || !Read(pack_data, position, entry.stored_size) ||
+            !Read(pack_data, position, entry.size) || !Read(pack_data, position, entry.compression) ||
+            entry.offset + entry.stored_size > pack_data.size()) {
+            ENGINE_LOG_ERROR("Table of contents of pack {} is truncated", pack_path);
+            entries.clear();
+            return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+    // Packs are written sorted, but make sure, because lookups depend on it
+    if (!std::is_sorted(entries.begin(), entries.end(),
+                        [](const PackEntry& a, const PackEntry& b) { return a.path < b.path; })) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const PackEntry& a, const PackEntry& b) { return a.path < b.path; });
+    }
+    ENGINE_LOG_INFO("Loaded pack {} with {} files", pack_path, entries.size());
+    return true;
+}
+
+const PackEntry* PackFileSystem::Find(const std::string& path) const {
+    std::string normalized = NormalizePath(path);
+    auto it = std::lower_bound(entries.begin(), entries.end(), normalized,
+                               [](const PackEntry& entry, const std::string& p) { return entry.path < p; });
+    if (it == entries.end() || it->path != normalized) {
+        return nullptr;
+    }
+    return &(*it);
+}
+
+std::shared_ptr<IVirtualFile> PackFileSystem::Open(const std::string& path, FileModes modes) {
+    const PackEntry* entry = Find(path);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+    return std::make_shared<PackFile>(this, *entry, pack_file, pack_data.subspan(entry->offset, entry->stored_size));
+}
+
+void PackFileSystem::Close(std::shared_ptr<IVirtualFile>& vf) {
+    // Only the decompressed data is owned by the file
+    PackFile* file = dynamic_cast<PackFile*>(vf.get());
+    file->view_buffer.clear();
+    file->view_buffer.shrink_to_fit();
+}
+
+std::shared_ptr<IVirtualDirectory> PackFileSystem::OpenDirectory(const std::string& path) {
+    if (!IsDirectory(path)) {
+        return nullptr;
+    }
+    std::string root = NormalizePath(path);
+    std::string prefix = root.empty() ? root : root + "/";
+    std::shared_ptr<PackDirectory> directory = std::make_shared<PackDirectory>(this, root);
+    auto it = std::lower_bound(entries.begin(), entries.end(), prefix,
+                               [](const PackEntry& entry, const std::string& p) { return entry.path < p; });
+    // Everything under the directory is next to each other because the entries are sorted
+    for (; it != entries.end() && it->path.starts_with(prefix); it++) {
+        directory->paths.push_back(it->path.substr(prefix.size()));
+    }
+    return directory;
+}
+
+bool PackFileSystem::IsFile(const std::string& path) { return Find(path) != nullptr; }
+
+bool PackFileSystem::IsDirectory(const std::string& path) {
+    std::string root = NormalizePath(path);
+    if (root.empty()) {
+        return true;
+    }
+    std::string prefix = root + "/";
+    auto it = std::lower_bound(entries.begin(), entries.end(), prefix,
+                               [](const PackEntry& entry, const std::string& p) { return entry.path < p; });
+    return it != entries.end() && it->path.starts_with(prefix);
+}
+
+bool PackFileSystem::Exists(const std::string& path) { return IsFile(path) || IsDirectory(path); }
+
+std::shared_ptr<IVirtualFile> PackDirectory::GetFile(int index, FileModes modes) {
+    if (root.empty()) {
+        return pfs->Open(paths[index], modes);
+    }
+    return pfs->Open(root + "/" + paths[index], modes);
+}
+
+bool WritePackFile(const std::string& directory, const std::string& output, bool compress) {
+    ZoneScoped;
+    if (!std::filesystem::is_directory(directory)) {
+        ENGINE_LOG_ERROR("Cannot pack {}, it is not a directory", directory);
+        return false;
+    }
+    std::vector<std::string> paths;
+    for (const auto& dir_entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (!dir_entry.is_regular_file()) {
+            continue;
+        }
+        std::string path = std::filesystem::relative(dir_entry.path(), directory).string();
+        paths.push_back(NormalizePath(path));
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::ofstream pack(output, std::ios::binary);
+    if (!pack.good()) {
+        ENGINE_LOG_ERROR("Cannot write pack {}", output);
+        return false;
+    }
+    // Write the header once the table of contents offset is known
+    pack.write(std::string(header_size, '\0').data(), header_size);
+
+    std::vector<PackEntry> entries;
+    std::vector<char> buffer;
+    std::vector<char> compressed;
+    for (const std::string& path : paths) {
+        std::ifstream input(std::filesystem::path(directory) / path, std::ios::binary);
+        buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+        PackEntry entry {path, static_cast<uint64_t>(pack.tellp()), buffer.size(), buffer.size(),
+                         PackCompression::None};
+        const char* data = buffer.data();
+        if (compress && !buffer.empty()) {
+            compressed.resize(LZ4_compressBound(static_cast<int>(buffer.size())));
+            int compressed_size = LZ4_compress_default(buffer.data(), compressed.data(),
+                                                       static_cast<int>(buffer.size()),
+                                                       static_cast<int>(compressed.size()));
+            // Images and audio are already compressed, so they are usually stored as is
+            if (compressed_size > 0 && static_cast<size_t>(compressed_size) < buffer.size()) {
+                entry.stored_size = compressed_size;
+                entry.compression = PackCompression::LZ4;
+                data = compressed.data();
+            }
+        }
+        pack.write(data, entry.stored_size);
+        entries.push_back(std::move(entry));
+    }
+
+    uint64_t toc_offset = pack.tellp();
+    for (const PackEntry& entry : entries) {
+        uint16_t length = static_cast<uint16_t>(entry.path.size());
+        Write(pack, length);
+        pack.write(entry.path.data(), length);
+        Write(pack, entry.offset);
+        Write(pack, entry.stored_size);
+        Write(pack, entry.size);
+        Write(pack, entry.compression);
+    }
+
+    pack.seekp(0);
+    pack.write(PackFileSystem::magic, sizeof(PackFileSystem::magic));
+    Write(pack, PackFileSystem::version);
+    Write(pack, static_cast<uint32_t>(entries.size()));
+    Write(pack, static_cast<uint32_t>(0));
+    Write(pack, toc_offset);
+    if (!pack.good()) {
+        ENGINE_LOG_ERROR("Failed to write pack {}", output);
+        return false;
+    }
+    ENGINE_LOG_INFO("Packed {} files from {} into {}", entries.size(), directory, output);
+    return true;
+}
+}  // namespace cqsp::asset
@@ -0,0 +1,153 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/asset/vfs/nativevfs.h"
+#include "engine/asset/vfs/vfs.h"
+
+namespace cqsp {
+namespace asset {
+class PackFileSystem;
+
+enum class PackCompression : uint8_t {
+    None = 0,
+    LZ4 = 1,
+};
+
+/// <summary>
+/// A file in the table of contents of a pack file.
+/// </summary>
+struct PackEntry {
+    /// Path relative to the root of the pack, with forward slashes
+    std::string path;
+    /// Offset of the data from the start of the pack
+    uint64_t offset;
+    /// Size of the data in the pack
+    uint64_t stored_size;
+    /// Size of the data once it is decompressed
+    uint64_t size;
+    PackCompression compression;
+};
+
+class PackFile : public IVirtualFile {
+ public:
+    PackFile(PackFileSystem* _pfs, const PackEntry& _entry, IVirtualFilePtr _pack, std::span<const uint8_t> _stored)
+        : IVirtualFile(), pfs(_pfs), entry(_entry), pack(std::move(_pack)), stored(_stored) {}
+
+    const std::string& Path() override { return entry.path; }
+    uint64_t Size() override { return entry.size; }
+
+    void Read(uint8_t* buffer, int bytes) override;
+
+    bool Seek(long offset, Offset origin) override;
+    uint64_t Tell() override { return position; }
+
+    IVirtualFileSystem* GetFileSystem() override;
+
+    /// <summary>
+    /// Uncompressed files are viewed directly from the pack, compressed files are decompressed once
+    /// and kept until the file is closed.
+    /// </summary>
+    std::span<const uint8_t> View() override;
+
+    friend PackFileSystem;
+
+ private:
+    PackFileSystem* const pfs;
+    /// Copied, so that the file stays valid when the table of contents changes or the pack is reloaded
+    const PackEntry entry;
+    /// The mapped pack, kept alive for as long as stored points into it
+    IVirtualFilePtr pack;
+    std::span<const uint8_t> stored;
+    uint64_t position = 0;
+};
+
+/// <summary>
+/// Read only file system that is packed into a single file, so that a mod can be loaded with a few
+/// large reads rather than opening thousands of files.
+/// <br />
+/// The pack is a header, the data of all the files, and then a table of contents sorted by path.
+/// The whole pack is mapped into memory when it is initialized.
+/// Create packs with @ref WritePackFile, or the cqsp-packer tool.
+/// </summary>
+class PackFileSystem : public IVirtualFileSystem {
+ public:
+    explicit PackFileSystem(const std::string& pack_path);
+    ~PackFileSystem();
+
+    /// <summary>
+    /// Reads the table of contents. Returns false if the file is not a valid pack.
+    /// </summary>
+    bool Initialize() override;
+
+    std::shared_ptr<IVirtualFile> Open(const std::string& path, FileModes = None) override;
+    void Close(std::shared_ptr<IVirtualFile>&) override;
+    std::shared_ptr<IVirtualDirectory> OpenDirectory(const std::string& path) override;
+
+    bool IsFile(const std::string& path) override;
+    bool IsDirectory(const std::string& path) override;
+    bool Exists(const std::string& path) override;
+
+    const std::vector<PackEntry>& GetEntries() const { return entries; }
+
+    static constexpr char magic[4] = {'C', 'Q', 'P', 'K'};
+    static constexpr uint32_t version = 1;
+    static constexpr char extension[] = ".cqpak";
+
+ private:
+    const PackEntry* Find(const std::string& path) const;
+
+    std::string pack_path;
+    NativeFileSystem native_fs;
+    IVirtualFilePtr pack_file;
+    std::span<const uint8_t> pack_data;
+    std::vector<PackEntry> entries;
+};
+
+class PackDirectory : public IVirtualDirectory {
+ public:
+    PackDirectory(PackFileSystem* _pfs, const std::string& _root) : pfs(_pfs), root(_root) {}
+
+    uint64_t GetSize() override { return paths.size(); }
+    const std::string& GetRoot() override { return root; }
+    std::shared_ptr<IVirtualFile> GetFile(int index, FileModes modes = None) override;
+    const std::string& GetFilename(int index) override { return paths[index]; }
+    IVirtualFileSystem* GetFileSystem() override { return pfs; }
+
+ private:
+    friend PackFileSystem;
+    std::vector<std::string> paths;
+    std::string root;
+    PackFileSystem* const pfs;
+};
+
+/// <summary>
+/// Packs every file in the directory into a pack file.
+/// </summary>
+/// <param name="directory">Directory to pack, usually the root of a mod</param>
+/// <param name="output">Path of the pack file to write</param>
+/// <param name="compress">Compress files with LZ4 if it makes them smaller</param>
+/// <returns>If the pack was written</returns>
+bool WritePackFile(const std::string& directory, const std::string& output, bool compress = true);
+}  // namespace asset
+}  // namespace cqsp
@@ -129,22 +129,43 @@ std::vector<uint8_t> ReadAllFromVFile(IVirtualFile* file) {
     return buffer;
 }
 
-std::string ReadAllFromVFileToString(IVirtualFile* file) {
-    int size = file->Size();
-    uint8_t* buf = new uint8_t[size];
-    file->Read(buf, size);
-    // Output to string
-    std::string str(reinterpret_cast<char*>(buf), size);
-    // Now convert to a proper string
-    size_t start_pos = 0;
+namespace {
+void RemoveCarriageReturns(std::string_view view, std::string& str) {
+    str.clear();
+    str.reserve(view.size());
     // Replace carrige returns because it's text mode
-    // Carrige return is 2 characters long, and findflaws is stupid and complaining about strlen.
-    const int return_length = 2;
-    while ((start_pos = str.find("\r\n", start_pos)) != std::string::npos) {
-        str.replace(start_pos, return_length, "\n");
-        start_pos += 1;  // In case 'to' contains 'from', like replacing 'x' with 'yx'
+    for (size_t i = 0; i < view.size(); i++) {
+        if (view[i] == '\r' && i + 1 < view.size() && view[i + 1] == '\n') {
+            continue;
+        }
+        str.push_back(view[i]);
     }
-    delete[] buf;
+}
+}  // namespace
+
+std::string ReadAllFromVFileToString(IVirtualFile* file) {
+    std::string str;
+    RemoveCarriageReturns(ViewVFileAsString(file), str);
     return str;
 }
+
+std::string_view ViewVFileAsText(IVirtualFile* file, std::string& storage) {
+    std::string_view view = ViewVFileAsString(file);
+    if (view.find("\r\n") == std::string_view::npos) {
+        return view;
+    }
+    RemoveCarriageReturns(view, storage);
+    return storage;
+}
+
+std::span<const uint8_t> IVirtualFile::View() {
+    if (view_buffer.size() != Size()) {
+        uint64_t position = Tell();
+        view_buffer.resize(Size());
+        Seek(0, Offset::Beg);
+        Read(view_buffer.data(), static_cast<int>(view_buffer.size()));
+        Seek(static_cast<long>(position), Offset::Beg);
+    }
+    return view_buffer;
+}
 }  // namespace cqsp::asset
@@ -18,7 +18,9 @@
 
 #include <map>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace cqsp {
@@ -150,6 +152,21 @@ class IVirtualFile {
     virtual const std::string& Path() = 0;
 
     virtual IVirtualFileSystem* GetFileSystem() = 0;
+
+    /// <summary>
+    /// Gets a read only view of the entire file, so that it can be read without copying it.
+    /// The view stays valid until the file is closed or destroyed.
+    /// <br />
+    /// File systems that can map files into memory should override this. The default implementation
+    /// reads the whole file into a buffer that the file owns.
+    /// </summary>
+    virtual std::span<const uint8_t> View();
+
+ protected:
+    /// <summary>
+    /// Buffer for the default implementation of @ref View
+    /// </summary>
+    std::vector<uint8_t> view_buffer;
 };
 
 class VirtualMounter {
@@ -202,6 +219,23 @@ std::vector<uint8_t> ReadAllFromVFile(IVirtualFile*);
 /// </summary>
 std::string ReadAllFromVFileToString(IVirtualFile* file);
 
+/// <summary>
+/// Views the whole file as raw bytes, without copying it. Carriage returns are not removed, so use
+/// @ref ViewVFileAsText for text that is parsed.
+/// </summary>
+inline std::string_view ViewVFileAsString(IVirtualFile* file) {
+    auto view = file->View();
+    return std::string_view(reinterpret_cast<const char*>(view.data()), view.size());
+}
+
+/// <summary>
+/// Views the whole file as text, the same as @ref ReadAllFromVFileToString reads it.
+/// <br />
+/// Files with LF line endings are viewed in place. Files with CRLF line endings have their carriage returns
+/// removed into storage, and the view points to storage instead, so it has to outlive the view.
+/// </summary>
+std::string_view ViewVFileAsText(IVirtualFile* file, std::string& storage);
+
 /// <summary>
 /// Gets filename from path.
 /// </summary>
@@ -45,7 +45,7 @@ std::unique_ptr<AudioAsset> LoadOgg(std::ifstream& input) {
     return audio_asset;
 }
 
-std::unique_ptr<AudioAsset> LoadOgg(uint8_t* buffer, int size) {
+std::unique_ptr<AudioAsset> LoadOgg(const uint8_t* buffer, int size) {
     std::unique_ptr<ALAudioAsset> audio_asset = std::make_unique<ALAudioAsset>();
     int16* output;
     int channels;
@@ -47,6 +47,8 @@ Hjson::Value cqsp::client::ClientOptions::GetDefaultOptions() {
     default_options["audio"]["ui"] = 0.80f;
     default_options["splashscreens"] = "../data/core/gui/splashscreens";
     default_options["samples"] = 4;
+    // Memory budget for streamed textures in megabytes
+    default_options["texture_budget"] = 512;
     return default_options;
 }
 
@@ -0,0 +1,71 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "engine/graphics/primitives/spherelod.h"
+
+#include <cmath>
+#include <limits>
+
+#include "engine/graphics/primitives/uvsphere.h"
+
+namespace cqsp::engine::primitive {
+namespace {
+// Segments around the sphere for each level. The first level is so small that it only
+// is really visible as a dot.
+constexpr std::array<int, SphereLod::level_count> resolutions = {8, 16, 32, 64, 128};
+
+// How long a segment should be on screen, in pixels
+constexpr float pixels_per_segment = 6.f;
+}  // namespace
+
+SphereLod::~SphereLod() {
+    for (Mesh* mesh : meshes) {
+        delete mesh;
+    }
+}
+
+void SphereLod::Initialize() {
+    for (int i = 0; i < level_count; i++) {
+        delete meshes[i];
+        meshes[i] = ConstructSphereMesh(resolutions[i], resolutions[i]);
+    }
+}
+
+Mesh* SphereLod::GetMesh(float screen_radius) { return meshes[GetLevel(screen_radius)]; }
+
+int SphereLod::GetLevel(float screen_radius) {
+    // Number of segments that the circumference of the sphere needs
+    float segments = 2 * 3.14159265359f * screen_radius / pixels_per_segment;
+    for (int i = 0; i < level_count; i++) {
+        if (segments <= resolutions[i]) {
+            return i;
+        }
+    }
+    return level_count - 1;
+}
+
+int SphereLod::GetResolution(int level) { return resolutions[level]; }
+
+float SphereLod::GetScreenRadius(double radius, double distance, float fov, float viewport_height) {
+    if (distance <= radius) {
+        // The camera is inside the sphere
+        return std::numeric_limits<float>::infinity();
+    }
+    // Angular radius of the sphere divided by half of the field of view
+    double angular = std::asin(radius / distance);
+    return static_cast<float>(std::tan(angular) / std::tan(fov / 2) * viewport_height / 2);
+}
+}  // namespace cqsp::engine::primitive
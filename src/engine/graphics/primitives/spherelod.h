@@ -0,0 +1,79 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <array>
+
+#include "engine/graphics/mesh.h"
+
+namespace cqsp {
+namespace engine::primitive {
+/// <summary>
+/// A set of unit sphere meshes at different tessellation levels, shared between all the
+/// bodies that are drawn. The level is chosen from how large the sphere is on screen, so
+/// far away bodies don't get drawn with the full amount of triangles.
+/// </summary>
+class SphereLod {
+ public:
+    SphereLod() = default;
+    ~SphereLod();
+
+    SphereLod(const SphereLod&) = delete;
+    SphereLod& operator=(const SphereLod&) = delete;
+
+    /// <summary>
+    /// Builds the meshes for every level. Needs a GL context.
+    /// </summary>
+    void Initialize();
+
+    /// <summary>
+    /// Gets the mesh to draw a sphere that is `screen_radius` pixels large.
+    /// </summary>
+    Mesh* GetMesh(float screen_radius);
+
+    /// <summary>
+    /// Gets the tessellation level for a sphere that is `screen_radius` pixels large.
+    /// </summary>
+    static int GetLevel(float screen_radius);
+
+    /// <summary>
+    /// Number of segments around the sphere for the level
+    /// </summary>
+    static int GetResolution(int level);
+
+    /// <summary>
+    /// Calculates the radius of a sphere projected onto the screen, in pixels.
+    /// </summary>
+    /// <param name="radius">Radius of the sphere</param>
+    /// <param name="distance">Distance from the camera to the center of the sphere</param>
+    /// <param name="fov">Vertical field of view in radians</param>
+    /// <param name="viewport_height">Height of the viewport in pixels</param>
+    static float GetScreenRadius(double radius, double distance, float fov, float viewport_height);
+
+    /// <summary>
+    /// Spheres smaller than this many pixels on screen should not be drawn as meshes,
+    /// their billboards already cover them.
+    /// </summary>
+    static constexpr float billboard_radius = 2.f;
+
+    static constexpr int level_count = 5;
+
+ private:
+    std::array<Mesh*, level_count> meshes {};
+};
+}  // namespace engine::primitive
+}  // namespace cqsp
@@ -20,6 +20,7 @@
 #include <spdlog/spdlog.h>
 
 #include <map>
+#include <utility>
 #include <vector>
 
 #include "engine/enginelogger.h"
@@ -262,6 +263,15 @@ cqsp::asset::Shader::~Shader() {
         glDeleteShader(id);
     }
 }
+
+bool cqsp::asset::Shader::Replace(Asset& other) {
+    auto* shader = dynamic_cast<Shader*>(&other);
+    if (shader == nullptr || shader->shader_type != shader_type) {
+        return false;
+    }
+    std::swap(id, shader->id);
+    return true;
+}
 namespace {
 GLenum GetUniformType(GLuint program, const char* name) {
     GLuint in[1];
@@ -431,17 +441,75 @@ std::map<Hjson::Type, std::string> hjson_type_set {
 }  // namespace
 
 cqsp::asset::ShaderProgram_t cqsp::asset::ShaderDefinition::MakeShader() {
-    cqsp::asset::Shader vert_shader(vert, cqsp::asset::ShaderType::VERT);
-    cqsp::asset::Shader frag_shader(frag, cqsp::asset::ShaderType::FRAG);
+    ShaderProgram_t shader = BuildProgram();
+    // Forget the programs that aren't used anymore
+    std::erase_if(programs, [](const std::weak_ptr<ShaderProgram>& program) { return program.expired(); });
+    programs.push_back(shader);
+    return shader;
+}
+
+bool cqsp::asset::ShaderDefinition::Replace(Asset& other) {
+    auto* definition = dynamic_cast<ShaderDefinition*>(&other);
+    if (definition == nullptr) {
+        return false;
+    }
+    std::swap(vert, definition->vert);
+    std::swap(frag, definition->frag);
+    std::swap(geometry, definition->geometry);
+    std::swap(uniforms, definition->uniforms);
+    std::swap(sources, definition->sources);
+    Relink();
+    return true;
+}
+
+bool cqsp::asset::ShaderDefinition::Relink() {
+    for (auto& weak_program : programs) {
+        ShaderProgram_t program = weak_program.lock();
+        if (program == nullptr) {
+            continue;
+        }
+        ShaderProgram_t relinked;
+        try {
+            relinked = BuildProgram();
+        } catch (std::runtime_error& error) {
+            ENGINE_LOG_ERROR("Failed to compile shader: {}", error.what());
+            return false;
+        }
+        GLint linked = GL_FALSE;
+        glGetProgramiv(relinked->program, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            ENGINE_LOG_ERROR("Failed to link shader");
+            return false;
+        }
+        // The relinked program deletes the old program when it goes out of scope
+        std::swap(program->program, relinked->program);
+    }
+    return true;
+}
+
+cqsp::asset::ShaderProgram_t cqsp::asset::ShaderDefinition::BuildProgram() {
+    // Try the cached binary first, so that nothing has to be compiled
+    std::string source = vert + '\0' + frag + '\0' + geometry;
+    unsigned int cached_program = (cache != nullptr) ? cache->LoadProgram(source) : 0;
 
     // Create the shader
     cqsp::asset::ShaderProgram_t shader = nullptr;
-    if (!geometry.empty()) {
-        cqsp::asset::Shader geom_shader(geometry, cqsp::asset::ShaderType::GEOM);
-        // Add to the shader
-        shader = cqsp::asset::MakeShaderProgram(vert_shader, frag_shader, geom_shader);
+    if (cached_program != 0) {
+        shader = std::make_shared<ShaderProgram>();
+        shader->program = cached_program;
     } else {
-        shader = cqsp::asset::MakeShaderProgram(vert_shader, frag_shader);
+        cqsp::asset::Shader vert_shader(vert, cqsp::asset::ShaderType::VERT);
+        cqsp::asset::Shader frag_shader(frag, cqsp::asset::ShaderType::FRAG);
+        if (!geometry.empty()) {
+            cqsp::asset::Shader geom_shader(geometry, cqsp::asset::ShaderType::GEOM);
+            // Add to the shader
+            shader = cqsp::asset::MakeShaderProgram(vert_shader, frag_shader, geom_shader);
+        } else {
+            shader = cqsp::asset::MakeShaderProgram(vert_shader, frag_shader);
+        }
+        if (cache != nullptr) {
+            cache->SaveProgram(source, shader->program);
+        }
     }
     // Initial values
     shader->UseProgram();
@@ -456,6 +524,8 @@ cqsp::asset::ShaderProgram_t cqsp::asset::ShaderDefinition::MakeShader() {
             case GL_SAMPLER_CUBE:
             case GL_SAMPLER_1D_SHADOW:
             case GL_SAMPLER_2D_SHADOW:
+            case GL_INT_SAMPLER_2D:
+            case GL_UNSIGNED_INT_SAMPLER_2D:
             case GL_INT:
                 // Type has to be int
                 if (value.second.type() != Hjson::Type::Int64) {
@@ -21,10 +21,12 @@
 #include <istream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
 #include "engine/asset/asset.h"
+#include "engine/asset/assetcache.h"
 
 namespace cqsp {
 namespace asset {
@@ -49,6 +51,9 @@ class Shader : public Asset {
     void operator()(const std::string& code, ShaderType type);
     ~Shader();
 
+    /// Programs that are already linked keep the old shader.
+    bool Replace(Asset& other) override;
+
     ShaderType shader_type = ShaderType::NONE;
 
     /// Id of the shader
@@ -156,7 +161,35 @@ class ShaderDefinition : public Asset {
     // All the uniforms
     Hjson::Value uniforms;
 
+    /// <summary>
+    /// Virtual paths of the files that the definition was made from
+    /// </summary>
+    std::vector<std::string> sources;
+
+    /// <summary>
+    /// Cache of the linked program binaries, null to always compile the shader
+    /// </summary>
+    AssetCache* cache = nullptr;
+
     ShaderProgram_t MakeShader();
+
+    /// <summary>
+    /// Takes the code of the other definition, and relinks every program made from this definition.
+    /// </summary>
+    bool Replace(Asset& other) override;
+
+    /// <summary>
+    /// Compiles the code again and swaps the new program into every program made from this definition that is
+    /// still in use. If the code doesn't compile or link, the programs are left as they are.
+    /// </summary>
+    /// <returns>If the programs were relinked</returns>
+    bool Relink();
+
+ private:
+    ShaderProgram_t BuildProgram();
+
+    /// Programs made with @ref MakeShader
+    std::vector<std::weak_ptr<ShaderProgram>> programs;
 };
 
 // Set of utility functions that load shaders
@@ -0,0 +1,118 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "engine/graphics/stagingring.h"
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/enginelogger.h"
+
+namespace cqsp::asset {
+namespace {
+// Keep every staged range aligned so that any pixel format can be read from its start
+constexpr size_t staging_alignment = 16;
+}  // namespace
+
+StagingRing::StagingRing(size_t _size) : size(_size) {}
+
+StagingRing::~StagingRing() {
+    for (auto& region : regions) {
+        if (region.fence != nullptr) {
+            glDeleteSync(static_cast<GLsync>(region.fence));
+        }
+    }
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+    }
+}
+
+std::optional<size_t> StagingRing::Stage(const void* data, size_t data_size) {
+    ZoneScoped;
+    if (data_size == 0 || data_size > size) {
+        return std::nullopt;
+    }
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+
+    size_t begin = (head + staging_alignment - 1) / staging_alignment * staging_alignment;
+    if (begin + data_size > size) {
+        // Wrap around to the start of the ring
+        begin = 0;
+    }
+    WaitFor(begin, begin + data_size);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    // Unsynchronized, because the fences already make sure that the GPU is not reading this range
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, begin, data_size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (mapped == nullptr) {
+        // Some drivers refuse unsynchronized maps of a busy buffer, so wait for the range and map it normally
+        ENGINE_LOG_WARN("Failed to map staging ring range {} to {}, retrying synchronized", begin, begin + data_size);
+        mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, begin, data_size,
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    }
+    if (mapped == nullptr) {
+        ENGINE_LOG_WARN("Failed to map staging ring");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return std::nullopt;
+    }
+    memcpy(mapped, data, data_size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    head = begin + data_size;
+    regions.push_back({begin, head, nullptr});
+    return begin;
+}
+
+void StagingRing::Fence() {
+    for (auto it = regions.rbegin(); it != regions.rend() && it->fence == nullptr; ++it) {
+        it->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void StagingRing::Bind() { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer); }
+
+void StagingRing::Unbind() { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); }
+
+void StagingRing::WaitFor(size_t begin, size_t end) {
+    ZoneScoped;
+    auto it = regions.begin();
+    while (it != regions.end()) {
+        if (it->end <= begin || it->begin >= end) {
+            ++it;
+            continue;
+        }
+        if (it->fence == nullptr) {
+            // Staged without a fence, so fence everything now to be safe
+            Fence();
+        }
+        GLsync fence = static_cast<GLsync>(it->fence);
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, 0, 1000000000);
+        }
+        glDeleteSync(fence);
+        it = regions.erase(it);
+    }
+}
+}  // namespace cqsp::asset
@@ -0,0 +1,87 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+
+namespace cqsp {
+namespace asset {
+/// <summary>
+/// A ring of staging memory in a pixel buffer object for uploading textures.
+/// <br>
+/// Data is copied into the next free part of the ring, and the texture is then uploaded from the buffer,
+/// so the driver copies it to the GPU asynchronously instead of stalling the frame. Each staged range is
+/// fenced after the upload commands are issued, and a range is only written over again once the GPU is done
+/// reading it, so the buffer never has to be orphaned or synchronized as a whole.
+/// <br>
+/// How to use:
+/// ```
+/// auto offset = ring.Stage(pixels, size);
+/// if (offset) {
+///     // The ring is bound as GL_PIXEL_UNPACK_BUFFER, so the pointer is the offset into the buffer
+///     glTexImage2D(..., reinterpret_cast<void*>(*offset));
+///     ring.Fence();
+///     ring.Unbind();
+/// }
+/// ```
+/// Has to be used on the main thread.
+/// </summary>
+class StagingRing {
+ public:
+    explicit StagingRing(size_t size = default_size);
+    ~StagingRing();
+
+    StagingRing(const StagingRing&) = delete;
+    StagingRing& operator=(const StagingRing&) = delete;
+
+    /// <summary>
+    /// Copies the data into the ring, and binds the ring as the pixel unpack buffer.
+    /// </summary>
+    /// <returns>The offset of the data in the buffer, or nothing if it does not fit in the ring</returns>
+    std::optional<size_t> Stage(const void* data, size_t size);
+
+    /// <summary>
+    /// Fences the data staged since the last fence. Call after issuing the commands that read the data.
+    /// </summary>
+    void Fence();
+
+    void Bind();
+    static void Unbind();
+
+    size_t GetSize() const { return size; }
+
+    static constexpr size_t default_size = 64ull * 1024 * 1024;
+
+ private:
+    struct Region {
+        size_t begin;
+        size_t end;
+        /// GLsync of the uploads reading this region, null until fenced
+        void* fence;
+    };
+
+    void WaitFor(size_t begin, size_t end);
+
+    unsigned int buffer = 0;
+    size_t size;
+    size_t head = 0;
+    std::deque<Region> regions;
+};
+}  // namespace asset
+}  // namespace cqsp
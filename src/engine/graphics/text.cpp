@@ -29,7 +29,7 @@
 
 #include "engine/enginelogger.h"
 
-void cqsp::asset::LoadFontData(Font &font, unsigned char *fontBuffer, uint64_t size) {
+void cqsp::asset::LoadFontData(Font &font, const unsigned char *fontBuffer, uint64_t size) {
     FT_Library ft;
     // All functions return a value different than 0 whenever an error occurred
     if (FT_Init_FreeType(&ft)) {
@@ -23,17 +23,16 @@
 #include <glad/glad.h>
 #include <stb_image_write.h>
 
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
 unsigned int cqsp::asset::CreateTexture(unsigned char* data, int width, int height, int components,
                                         const TextureLoadingOptions& options) {
     unsigned int texid;
     glGenTextures(1, &texid);
-    GLenum format;
-    if (components == 1)
-        format = GL_RED;
-    else if (components == 3)
-        format = GL_RGB;
-    else if (components == 4)
-        format = GL_RGBA;
+    GLenum format = GetTextureFormat(components);
 
     glBindTexture(GL_TEXTURE_2D, texid);
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
@@ -60,8 +59,24 @@ void cqsp::asset::CreateTexture(Texture& texture, unsigned char* data, int width
     texture.texture_type = GL_TEXTURE_2D;
 }
 
+void cqsp::asset::CreateIdTexture(Texture& texture, const uint32_t* data, int width, int height) {
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, data);
+    // Integer textures can't be filtered or mipmapped, or they will be incomplete
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    texture.width = width;
+    texture.height = height;
+    texture.texture_type = GL_TEXTURE_2D;
+}
+
 void cqsp::asset::LoadCubemapData(Texture& texture, std::vector<unsigned char*>& faces, int width, int height,
-                                  int components, TextureLoadingOptions& options) {
+                                  int components, TextureLoadingOptions& options, StagingRing* ring) {
     glGenTextures(1, &texture.id);
     glBindTexture(GL_TEXTURE_CUBE_MAP, texture.id);
 
@@ -75,8 +90,18 @@ void cqsp::asset::LoadCubemapData(Texture& texture, std::vector<unsigned char*>&
 
     for (unsigned int i = 0; i < faces.size(); i++) {
         if (faces[i]) {
+            std::optional<size_t> offset;
+            if (ring != nullptr) {
+                offset = ring->Stage(faces[i], static_cast<size_t>(width) * height * components);
+            }
+            // When the face is staged, the pointer is the offset into the ring
+            const void* pixels = offset ? reinterpret_cast<const void*>(*offset) : faces[i];
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE,
-                         faces[i]);
+                         pixels);
+            if (offset) {
+                ring->Fence();
+                StagingRing::Unbind();
+            }
             stbi_image_free(faces[i]);
         } else {
             stbi_image_free(faces[i]);
@@ -93,6 +118,52 @@ void cqsp::asset::LoadCubemapData(Texture& texture, std::vector<unsigned char*>&
     texture.texture_type = GL_TEXTURE_CUBE_MAP;
 }
 
+std::vector<unsigned char> cqsp::asset::DownsampleImage(const unsigned char* data, int width, int height,
+                                                        int components, int max_size, int& out_width,
+                                                        int& out_height) {
+    // Find how many times the image has to be halved
+    int factor = 1;
+    while (width / factor > max_size || height / factor > max_size) {
+        factor *= 2;
+    }
+    out_width = std::max(width / factor, 1);
+    out_height = std::max(height / factor, 1);
+
+    std::vector<unsigned char> output(static_cast<size_t>(out_width) * out_height * components);
+    for (int y = 0; y < out_height; y++) {
+        for (int x = 0; x < out_width; x++) {
+            for (int c = 0; c < components; c++) {
+                // Average the block of pixels
+                uint32_t sum = 0;
+                int count = 0;
+                for (int by = y * factor; by < std::min((y + 1) * factor, height); by++) {
+                    for (int bx = x * factor; bx < std::min((x + 1) * factor, width); bx++) {
+                        sum += data[(static_cast<size_t>(by) * width + bx) * components + c];
+                        count++;
+                    }
+                }
+                output[(static_cast<size_t>(y) * out_width + x) * components + c] =
+                    static_cast<unsigned char>(sum / std::max(count, 1));
+            }
+        }
+    }
+    return output;
+}
+
+unsigned int cqsp::asset::GetTextureFormat(int components) {
+    switch (components) {
+        case 1:
+            return GL_RED;
+        case 2:
+            return GL_RG;
+        case 3:
+            return GL_RGB;
+        case 4:
+        default:
+            return GL_RGBA;
+    }
+}
+
 bool cqsp::asset::SaveImage(const char* path, int width, int height, int components, const unsigned char* data,
                             bool flip) {
     if (flip) {
@@ -111,3 +182,16 @@ cqsp::asset::Texture::~Texture() {
         glDeleteTextures(1, &id);
     }
 }
+
+bool cqsp::asset::Texture::Replace(Asset& other) {
+    auto* texture = dynamic_cast<Texture*>(&other);
+    if (texture == nullptr || dynamic_cast<StreamedTexture*>(texture) != nullptr) {
+        return false;
+    }
+    // The other texture deletes the old texture when it is destroyed
+    std::swap(width, texture->width);
+    std::swap(height, texture->height);
+    std::swap(id, texture->id);
+    std::swap(texture_type, texture->texture_type);
+    return true;
+}
@@ -16,9 +16,13 @@
 */
 #pragma once
 
+#include <cstdint>
+#include <span>
 #include <vector>
 
 #include "engine/asset/asset.h"
+#include "engine/asset/vfs/vfs.h"
+#include "engine/graphics/stagingring.h"
 
 namespace cqsp {
 namespace asset {
@@ -39,6 +43,47 @@ class Texture : public Asset {
 
     Texture();
     ~Texture();
+
+    bool Replace(Asset& other) override;
+};
+
+/// <summary>
+/// A texture that only keeps a small placeholder on the GPU until it is needed. The full resolution
+/// image is decoded and uploaded by @ref cqsp::asset::TextureStreamer when the object using it comes
+/// close to the camera, and evicted again when the streamer runs out of its memory budget.
+/// <br>
+/// Loaded when the `streamed` hint of a texture is set to true in the `resource.hjson` file.
+/// </summary>
+class StreamedTexture : public Texture {
+ public:
+    /// <summary>
+    /// The encoded image file, decoded again every time the full resolution texture is streamed in.
+    /// It views the source file in place, which is kept open for as long as the texture exists.
+    /// </summary>
+    std::span<const uint8_t> file;
+    IVirtualFilePtr source;
+    TextureLoadingOptions options;
+
+    int full_width = 0;
+    int full_height = 0;
+    int components = 0;
+
+    /// <summary>
+    /// Pixels of the downsampled placeholder, kept so that the placeholder can be restored on eviction.
+    /// </summary>
+    std::vector<unsigned char> placeholder;
+    int placeholder_width = 0;
+    int placeholder_height = 0;
+
+    /// <summary>
+    /// If the full resolution image is on the GPU
+    /// </summary>
+    bool resident = false;
+
+    /// <summary>
+    /// The streamer may be decoding or holding the old image, so streamed textures aren't replaced.
+    /// </summary>
+    bool Replace(Asset& other) override { return false; }
 };
 
 unsigned int CreateTexture(unsigned char* data, int width, int height, int components,
@@ -47,8 +92,29 @@ unsigned int CreateTexture(unsigned char* data, int width, int height, int compo
 void CreateTexture(Texture& texture, unsigned char* data, int width, int height, int components,
                    const TextureLoadingOptions& options = TextureLoadingOptions());
 
+/// <summary>
+/// Creates a single channel unsigned integer texture, for data like ids that can't be filtered.
+/// The texture has to be sampled with a usampler2D.
+/// </summary>
+void CreateIdTexture(Texture& texture, const uint32_t* data, int width, int height);
+
+/// <summary>
+/// Uploads the six faces of a cubemap, and frees the face data.
+/// </summary>
+/// <param name="ring">If not null, the faces are uploaded through the ring</param>
 void LoadCubemapData(Texture& texture, std::vector<unsigned char*>& data, int width, int height, int components,
-                     TextureLoadingOptions& options);
+                     TextureLoadingOptions& options, StagingRing* ring = nullptr);
+
+/// <summary>
+/// Halves the image with a box filter until both sides are at most max_size pixels large.
+/// </summary>
+std::vector<unsigned char> DownsampleImage(const unsigned char* data, int width, int height, int components,
+                                           int max_size, int& out_width, int& out_height);
+
+/// <summary>
+/// Gets the GL pixel format for the number of components in an image
+/// </summary>
+unsigned int GetTextureFormat(int components);
 
 bool SaveImage(const char* path, int width, int height, int components, const unsigned char* data, bool flip = true);
 }  // namespace asset
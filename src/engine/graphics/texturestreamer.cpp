@@ -0,0 +1,262 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "engine/graphics/texturestreamer.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/enginelogger.h"
+
+namespace cqsp::asset {
+TextureStreamer::TextureStreamer() { worker = std::thread([this]() { Worker(); }); }
+
+TextureStreamer::~TextureStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        decode_queue.clear();
+    }
+    condition.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    for (auto& result : decoded) {
+        stbi_image_free(result.data);
+    }
+    for (auto& upload : uploads) {
+        stbi_image_free(upload.data);
+        glDeleteTextures(1, &upload.id);
+    }
+    EvictAll();
+}
+
+void TextureStreamer::Request(StreamedTexture* texture, float priority) {
+    if (texture == nullptr || texture->file.empty()) {
+        return;
+    }
+    Entry& entry = entries[texture];
+    entry.priority = priority;
+    entry.last_requested = frame;
+}
+
+void TextureStreamer::Update() {
+    ZoneScoped;
+    // Queue the requested textures for decoding, the most important first
+    std::vector<std::pair<float, StreamedTexture*>> requests;
+    for (auto& [texture, entry] : entries) {
+        if (entry.state == State::Placeholder && entry.last_requested == frame) {
+            requests.emplace_back(entry.priority, texture);
+        }
+    }
+    std::sort(requests.begin(), requests.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (auto& [priority, texture] : requests) {
+        uint64_t size = GetTextureSize(*texture);
+        if (!MakeRoom(size)) {
+            break;
+        }
+        entries[texture].state = State::Decoding;
+        resident_size += size;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            decode_queue.push_back(texture);
+        }
+        condition.notify_one();
+    }
+
+    StartUploads();
+    UploadRows();
+    frame++;
+}
+
+void TextureStreamer::EvictAll() {
+    for (auto& [texture, entry] : entries) {
+        if (entry.state == State::Resident) {
+            Evict(texture);
+        }
+    }
+}
+
+uint64_t TextureStreamer::GetTextureSize(const StreamedTexture& texture) {
+    // Mipmaps take up another third of the texture
+    return static_cast<uint64_t>(texture.full_width) * texture.full_height * texture.components * 4 / 3;
+}
+
+void TextureStreamer::Worker() {
+    while (true) {
+        StreamedTexture* texture = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return !running || !decode_queue.empty(); });
+            if (!running) {
+                return;
+            }
+            texture = decode_queue.front();
+            decode_queue.pop_front();
+        }
+        ZoneScopedN("Decode streamed texture");
+        int width, height, components;
+        unsigned char* data = stbi_load_from_memory(texture->file.data(), texture->file.size(), &width, &height,
+                                                    &components, texture->components);
+        if (data != nullptr && (width != texture->full_width || height != texture->full_height)) {
+            // Image changed after it was loaded
+            stbi_image_free(data);
+            data = nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        decoded.push_back({texture, data});
+    }
+}
+
+void TextureStreamer::StartUploads() {
+    std::vector<Decoded> results;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        results = std::move(decoded);
+        decoded.clear();
+    }
+    for (auto& result : results) {
+        StreamedTexture* texture = result.texture;
+        if (result.data == nullptr) {
+            ENGINE_LOG_WARN("Failed to decode streamed texture {}", texture->path);
+            entries[texture].state = State::Placeholder;
+            resident_size -= GetTextureSize(*texture);
+            continue;
+        }
+        // Allocate the full resolution texture, and fill it in over the next few frames
+        unsigned int id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        GLenum format = GetTextureFormat(texture->components);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, texture->full_width, texture->full_height, 0, format,
+                     GL_UNSIGNED_BYTE, nullptr);
+        uploads.push_back({texture, result.data, id, 0});
+        entries[texture].state = State::Uploading;
+    }
+}
+
+void TextureStreamer::UploadRows() {
+    ZoneScoped;
+    if (uploads.empty()) {
+        return;
+    }
+    // Never stage more than the ring can hold at once
+    uint64_t bytes_left = std::min<uint64_t>(upload_budget, staging_ring.GetSize());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    auto it = uploads.begin();
+    while (it != uploads.end() && bytes_left > 0) {
+        StreamedTexture* texture = it->texture;
+        uint64_t row_size = static_cast<uint64_t>(texture->full_width) * texture->components;
+        int rows = static_cast<int>(
+            std::min<uint64_t>(texture->full_height - it->row, std::max<uint64_t>(1, bytes_left / row_size)));
+        uint64_t size = rows * row_size;
+
+        std::optional<size_t> offset;
+        if (size <= staging_ring.GetSize()) {
+            offset = staging_ring.Stage(it->data + it->row * row_size, size);
+            if (!offset) {
+                // The ring could not be mapped, so leave the rows for the next frame
+                ENGINE_LOG_WARN("Failed to stage rows {} to {} of {}, retrying next frame", it->row, it->row + rows,
+                                texture->path);
+                break;
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, it->id);
+        // Upload straight from memory if a single row is larger than the ring
+        const void* pixels = offset ? reinterpret_cast<const void*>(*offset) : it->data + it->row * row_size;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, it->row, texture->full_width, rows, GetTextureFormat(texture->components),
+                        GL_UNSIGNED_BYTE, pixels);
+        if (offset) {
+            staging_ring.Fence();
+            StagingRing::Unbind();
+        }
+        it->row += rows;
+        bytes_left -= std::min(bytes_left, size);
+
+        if (it->row >= texture->full_height) {
+            FinishUpload(*it);
+            it = uploads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureStreamer::FinishUpload(Upload& upload) {
+    StreamedTexture* texture = upload.texture;
+    glBindTexture(GL_TEXTURE_2D, upload.id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Sample the mipmaps, otherwise generating them is wasted
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture->options.mag_filter ? GL_NEAREST : GL_LINEAR);
+
+    // Swap out the placeholder
+    glDeleteTextures(1, &texture->id);
+    texture->id = upload.id;
+    texture->width = texture->full_width;
+    texture->height = texture->full_height;
+    texture->resident = true;
+    entries[texture].state = State::Resident;
+
+    stbi_image_free(upload.data);
+    upload.data = nullptr;
+}
+
+void TextureStreamer::Evict(StreamedTexture* texture) {
+    unsigned int placeholder = CreateTexture(texture->placeholder.data(), texture->placeholder_width,
+                                             texture->placeholder_height, texture->components, texture->options);
+    glDeleteTextures(1, &texture->id);
+    texture->id = placeholder;
+    texture->width = texture->placeholder_width;
+    texture->height = texture->placeholder_height;
+    texture->resident = false;
+    entries[texture].state = State::Placeholder;
+    resident_size -= GetTextureSize(*texture);
+}
+
+bool TextureStreamer::MakeRoom(uint64_t size) {
+    while (resident_size + size > budget) {
+        // Evict the texture that has gone the longest without being requested
+        StreamedTexture* oldest = nullptr;
+        const Entry* oldest_entry = nullptr;
+        for (auto& [texture, entry] : entries) {
+            if (entry.state != State::Resident || entry.last_requested == frame) {
+                continue;
+            }
+            if (oldest_entry == nullptr || entry.last_requested < oldest_entry->last_requested ||
+                (entry.last_requested == oldest_entry->last_requested && entry.priority < oldest_entry->priority)) {
+                oldest = texture;
+                oldest_entry = &entry;
+            }
+        }
+        if (oldest == nullptr) {
+            // Everything on the GPU is still needed
+            return false;
+        }
+        Evict(oldest);
+    }
+    return true;
+}
+}  // namespace cqsp::asset
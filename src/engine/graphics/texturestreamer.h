@@ -0,0 +1,142 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "engine/graphics/stagingring.h"
+#include "engine/graphics/texture.h"
+
+namespace cqsp {
+namespace asset {
+/// <summary>
+/// Streams the full resolution images of @ref StreamedTexture in and out of GPU memory.
+/// <br>
+/// Every frame, the textures that should be at full resolution are requested with a priority, which
+/// is usually how large the object is on screen. The images are decoded on a worker thread, and then
+/// uploaded through a @ref StagingRing a few rows at a time, so that a large texture does not stall
+/// a single frame. When the textures on the GPU go over the memory budget, the textures that have not
+/// been requested for the longest time are swapped back to their placeholders.
+/// <br>
+/// How to use:
+/// ```
+/// TextureStreamer streamer;
+/// streamer.SetBudget(512 * 1024 * 1024);
+/// // .. Inside render loop, before drawing
+/// streamer.Request(texture, priority);
+/// streamer.Update();
+/// ```
+/// </summary>
+class TextureStreamer {
+ public:
+    TextureStreamer();
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    /// <summary>
+    /// Requests the full resolution image of the texture for this frame.
+    /// </summary>
+    /// <param name="priority">Textures with a higher priority are streamed in first</param>
+    void Request(StreamedTexture* texture, float priority);
+
+    /// <summary>
+    /// Processes the requests for this frame, uploads decoded images and evicts textures if needed.
+    /// Has to be called on the main thread.
+    /// </summary>
+    void Update();
+
+    /// <summary>
+    /// Maximum amount of GPU memory that full resolution textures can take, in bytes
+    /// </summary>
+    void SetBudget(uint64_t bytes) { budget = bytes; }
+    uint64_t GetBudget() const { return budget; }
+
+    /// <summary>
+    /// Maximum amount of bytes uploaded to the GPU every frame
+    /// </summary>
+    void SetUploadBudget(uint64_t bytes) { upload_budget = bytes; }
+
+    /// <summary>
+    /// GPU memory used by full resolution textures, including the ones being streamed in.
+    /// </summary>
+    uint64_t GetResidentSize() const { return resident_size; }
+
+    /// <summary>
+    /// Swaps all full resolution textures back to their placeholders.
+    /// </summary>
+    void EvictAll();
+
+    /// <summary>
+    /// Estimated GPU memory of the full resolution texture with all of its mipmaps.
+    /// </summary>
+    static uint64_t GetTextureSize(const StreamedTexture& texture);
+
+ private:
+    enum class State { Placeholder, Decoding, Uploading, Resident };
+
+    struct Entry {
+        State state = State::Placeholder;
+        float priority = 0;
+        uint64_t last_requested = 0;
+    };
+
+    struct Decoded {
+        StreamedTexture* texture;
+        unsigned char* data;
+    };
+
+    struct Upload {
+        StreamedTexture* texture;
+        unsigned char* data;
+        unsigned int id;
+        int row;
+    };
+
+    void Worker();
+    void StartUploads();
+    void UploadRows();
+    void FinishUpload(Upload& upload);
+    void Evict(StreamedTexture* texture);
+    bool MakeRoom(uint64_t size);
+
+    uint64_t budget = 512ull * 1024 * 1024;
+    uint64_t upload_budget = 8ull * 1024 * 1024;
+    uint64_t resident_size = 0;
+    uint64_t frame = 0;
+
+    std::map<StreamedTexture*, Entry> entries;
+    std::vector<Upload> uploads;
+    StagingRing staging_ring;
+
+    // Shared with the worker thread
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<StreamedTexture*> decode_queue;
+    std::vector<Decoded> decoded;
+    bool running = true;
+};
+}  // namespace asset
+}  // namespace cqsp
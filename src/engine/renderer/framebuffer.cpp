@@ -223,3 +223,113 @@ void LayerRenderer::InitFramebuffer(IFramebuffer* buffer, cqsp::asset::ShaderPro
     buffer->SetMesh(engine::primitive::MakeTexturedPaneMesh(true));
     buffer->SetShader(shader);
 }
+
+using cqsp::engine::SinglePassLayerRenderer;
+SinglePassLayerRenderer::~SinglePassLayerRenderer() { Free(); }
+
+void SinglePassLayerRenderer::Initialize(const engine::Window& window, int samples) {
+    this->samples = samples;
+    InitTarget(window.GetWindowWidth(), window.GetWindowHeight());
+}
+
+int SinglePassLayerRenderer::AddLayer(bool clear_depth) {
+    layers.push_back(clear_depth);
+    return layers.size() - 1;
+}
+
+void SinglePassLayerRenderer::InitTarget(int width, int height) {
+    this->width = width;
+    this->height = height;
+    if (samples <= 0) {
+        // Draw straight into the default framebuffer
+        framebuffer = 0;
+        return;
+    }
+    GenerateFrameBuffer(framebuffer);
+
+    glGenRenderbuffers(1, &colorbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorbuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorbuffer);
+
+    glGenRenderbuffers(1, &depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        ENGINE_LOG_ERROR("Multisampled layer framebuffer is not complete, drawing to the default framebuffer");
+        Free();
+        samples = 0;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SinglePassLayerRenderer::Free() {
+    if (framebuffer != 0) {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &colorbuffer);
+        glDeleteRenderbuffers(1, &depthbuffer);
+    }
+    framebuffer = 0;
+    colorbuffer = 0;
+    depthbuffer = 0;
+}
+
+void SinglePassLayerRenderer::BeginDraw(int layer) {
+    ZoneScoped;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (layer < current_layer) {
+        ENGINE_LOG_WARN("Layer {} is drawn after layer {}, it will be depth tested against it", layer,
+                        current_layer);
+        return;
+    }
+    if (layer == current_layer) {
+        return;
+    }
+    // Clear the depth of the layers below, so everything drawn in this layer will be on top of them.
+    // The first layer has a fresh depth buffer from NewFrame.
+    if (current_layer != -1 && layers[layer]) {
+        glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
+    current_layer = layer;
+}
+
+void SinglePassLayerRenderer::EndDraw(int layer) {
+    ZoneScoped;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SinglePassLayerRenderer::DrawAllLayers() {
+    ZoneScoped;
+    if (framebuffer != 0) {
+        // Resolve the multisampled framebuffer onto the screen
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    // Reset render buffer
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SinglePassLayerRenderer::NewFrame(const cqsp::engine::Window& window) {
+    ZoneScoped;
+    current_layer = -1;
+    if (window.WindowSizeChanged()) {
+        Free();
+        InitTarget(window.GetWindowWidth(), window.GetWindowHeight());
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (framebuffer != 0) {
+        glClearColor(0.f, 0.f, 0.f, 0.f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    } else {
+        // The application clears the color of the default framebuffer every frame, but
+        // another scene may have drawn into the depth buffer already.
+        glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+int SinglePassLayerRenderer::GetLayerCount() { return layers.size(); }
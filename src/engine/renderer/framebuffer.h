@@ -150,5 +150,83 @@ class LayerRenderer {
     std::vector<std::unique_ptr<IFramebuffer>> framebuffers;
     void InitFramebuffer(IFramebuffer* buffer, cqsp::asset::ShaderProgram_t shader, const cqsp::engine::Window& window);
 };
+
+/// <summary>
+/// Renders a series of layers into a single render target, instead of giving every layer its
+/// own framebuffer and compositing them with full screen passes like LayerRenderer does.
+/// <br>
+/// Layers are separated by draw order and the depth buffer: when a layer begins, the depth
+/// (and stencil) buffer is cleared so that everything drawn in that layer ends up on top of
+/// the layers drawn before it. This means layers have to be drawn in the order they were added,
+/// from back to front.
+/// <br>
+/// If samples is zero, the layers are drawn straight into the default framebuffer, which is
+/// already cleared by the application every frame, so there is no extra fill or blit at all.
+/// If samples is greater than zero, the layers are drawn into a multisampled framebuffer and
+/// resolved onto the default framebuffer with a single blit in DrawAllLayers.
+/// <br>
+/// Use LayerRenderer only if a layer needs a real post processing effect.
+/// <br>
+/// How to use:
+/// <br>
+/// ```
+/// SinglePassLayerRenderer layers;
+/// layers.Initialize(window);
+/// int back = layers.AddLayer();
+/// int front = layers.AddLayer();
+///
+/// // .. Inside render loop
+/// layers.NewFrame(window);
+/// layers.BeginDraw(back);
+/// // .. some drawing
+/// layers.EndDraw(back);
+/// layers.BeginDraw(front);
+/// // .. drawing that will be on top of back
+/// layers.EndDraw(front);
+///
+/// // Resolves the framebuffer if needed
+/// layers.DrawAllLayers();
+/// ```
+/// </summary>
+class SinglePassLayerRenderer {
+ public:
+    ~SinglePassLayerRenderer();
+
+    /// <summary>
+    /// Initializes the render target.
+    /// </summary>
+    /// <param name="samples">Number of MSAA samples, 0 to draw directly into the default framebuffer</param>
+    void Initialize(const engine::Window& window, int samples = 0);
+
+    /// <summary>
+    /// Adds a layer on top of all the previous layers.
+    /// </summary>
+    /// <param name="clear_depth">If the depth buffer should be cleared when the layer starts,
+    /// set to false if the layer should be depth tested against the layer below.</param>
+    /// <returns>Index of the layer</returns>
+    int AddLayer(bool clear_depth = true);
+
+    void BeginDraw(int layer);
+    void EndDraw(int layer);
+    void DrawAllLayers();
+    void NewFrame(const cqsp::engine::Window& window);
+    int GetLayerCount();
+
+ private:
+    void InitTarget(int width, int height);
+    void Free();
+
+    int width = 0;
+    int height = 0;
+    int samples = 0;
+
+    unsigned int framebuffer = 0;
+    unsigned int colorbuffer = 0;
+    unsigned int depthbuffer = 0;
+
+    // Highest layer that has been drawn this frame
+    int current_layer = -1;
+    std::vector<bool> layers;
+};
 }  // namespace engine
 }  // namespace cqsp
@@ -0,0 +1,180 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "engine/renderer/pickbuffer.h"
+
+#include <glad/glad.h>
+
+#include <tracy/Tracy.hpp>
+
+#include "engine/enginelogger.h"
+
+namespace cqsp::engine {
+PickBuffer::~PickBuffer() {
+    Free();
+    for (int i = 0; i < buffer_count; i++) {
+        if (fences[i] != nullptr) {
+            glDeleteSync(static_cast<GLsync>(fences[i]));
+        }
+    }
+    if (pixel_buffers[0] != 0) {
+        glDeleteBuffers(buffer_count, pixel_buffers);
+    }
+}
+
+void PickBuffer::Initialize(const Window& window) {
+    glGenBuffers(buffer_count, pixel_buffers);
+    for (int i = 0; i < buffer_count; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLuint) * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    InitTarget(window.GetWindowWidth(), window.GetWindowHeight());
+}
+
+void PickBuffer::InitTarget(int width, int height) {
+    this->width = width;
+    this->height = height;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    glGenRenderbuffers(1, &idbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, idbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA32UI, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, idbuffer);
+
+    glGenRenderbuffers(1, &depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        ENGINE_LOG_ERROR("Pick framebuffer is not complete, nothing can be picked");
+        Free();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PickBuffer::Free() {
+    if (framebuffer != 0) {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &idbuffer);
+        glDeleteRenderbuffers(1, &depthbuffer);
+    }
+    framebuffer = 0;
+    idbuffer = 0;
+    depthbuffer = 0;
+}
+
+bool PickBuffer::Begin(const Window& window, int x, int y) {
+    ZoneScoped;
+    // Nothing to read back into until it is initialized
+    if (pixel_buffers[0] == 0) {
+        return false;
+    }
+    if (window.WindowSizeChanged()) {
+        Free();
+        InitTarget(window.GetWindowWidth(), window.GetWindowHeight());
+    }
+    if (framebuffer == 0) {
+        return false;
+    }
+    // GL counts rows from the bottom of the window
+    pick_x = x;
+    pick_y = height - 1 - y;
+    if (!window.MouseInWindow() || pick_x < 0 || pick_x >= width || pick_y < 0 || pick_y >= height) {
+        Clear();
+        return false;
+    }
+    // The buffer that the read back goes into might still be in use
+    if (fences[current] != nullptr) {
+        Poll();
+        if (fences[current] != nullptr) {
+            return false;
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    // Only the pixel under the cursor matters, so don't draw anything else
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(pick_x, pick_y, 1, 1);
+    const GLuint empty[4] = {0, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, empty);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    // Blending doesn't apply to integer framebuffers, so it doesn't have to be disabled
+    return true;
+}
+
+void PickBuffer::End() {
+    ZoneScoped;
+    if (pixel_buffers[current] == 0) {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers[current]);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    // With a pack buffer bound, this only queues the copy
+    glReadPixels(pick_x, pick_y, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    current = (current + 1) % buffer_count;
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PickBuffer::Clear() {
+    // The read backs that are still in flight were under the cursor before it left
+    for (int i = 0; i < buffer_count; i++) {
+        if (fences[i] != nullptr) {
+            glDeleteSync(static_cast<GLsync>(fences[i]));
+            fences[i] = nullptr;
+        }
+    }
+    result = glm::uvec4(0);
+}
+
+bool PickBuffer::Poll() {
+    ZoneScoped;
+    glm::uvec4 previous = result;
+    // Check the read backs from oldest to newest, a read back can't finish before the ones before it
+    for (int i = 0; i < buffer_count; i++) {
+        int index = (current + i) % buffer_count;
+        if (fences[index] == nullptr) {
+            continue;
+        }
+        GLsync fence = static_cast<GLsync>(fences[index]);
+        // Don't wait at all, but make sure that the fence is flushed so that it will be signaled eventually
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        glDeleteSync(fence);
+        fences[index] = nullptr;
+
+        GLuint ids[4];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers[index]);
+        glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(ids), ids);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        result = glm::uvec4(ids[0], ids[1], ids[2], ids[3]);
+    }
+    return result != previous;
+}
+}  // namespace cqsp::engine
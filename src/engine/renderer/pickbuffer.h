@@ -0,0 +1,113 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "engine/window.h"
+
+namespace cqsp {
+namespace engine {
+/// <summary>
+/// Finds what is under the cursor by drawing ids instead of colors.
+/// <br>
+/// Objects are drawn into an unsigned integer framebuffer with up to four ids per pixel, one
+/// in each channel, and only the pixel under the cursor is drawn and read back. An id of 0
+/// means that nothing was drawn in that channel.
+/// <br>
+/// The pixel is read into a pixel buffer, and the result is picked up on a later frame once
+/// the GPU is done with it, so picking never waits on the GPU. This means that the result is
+/// usually a frame behind.
+/// <br>
+/// How to use:
+/// <br>
+/// ```
+/// PickBuffer picker;
+/// picker.Initialize(window);
+///
+/// // .. Inside render loop
+/// if (picker.Begin(window, mouse_x, mouse_y)) {
+///     // .. draw the objects with a shader that writes a uvec4 of ids
+///     picker.End();
+/// }
+///
+/// // .. Inside update
+/// picker.Poll();
+/// glm::uvec4 ids = picker.GetResult();
+/// ```
+/// </summary>
+class PickBuffer {
+ public:
+    ~PickBuffer();
+
+    void Initialize(const Window& window);
+
+    /// <summary>
+    /// Binds the pick framebuffer, and clears the ids and depth of the pixel under the cursor.
+    /// </summary>
+    /// <param name="x">Cursor position from the left of the window</param>
+    /// <param name="y">Cursor position from the top of the window</param>
+    /// <returns>False if the GPU is still busy with the earlier picks, or the cursor is outside the window, then
+    /// nothing should be drawn.</returns>
+    bool Begin(const Window& window, int x, int y);
+
+    /// <summary>
+    /// Queues the read back of the pixel and binds the default framebuffer again.
+    /// </summary>
+    void End();
+
+    /// <summary>
+    /// Picks up the newest read back that the GPU has finished.
+    /// </summary>
+    /// <returns>If the result changed</returns>
+    bool Poll();
+
+    /// <summary>
+    /// Ids under the cursor in the last finished pick.
+    /// </summary>
+    const glm::uvec4& GetResult() const { return result; }
+
+ private:
+    void InitTarget(int width, int height);
+    void Free();
+    /// <summary>
+    /// Drops the read backs in flight and clears the result, for when the cursor is not over anything.
+    /// </summary>
+    void Clear();
+
+    static constexpr int buffer_count = 2;
+
+    int width = 0;
+    int height = 0;
+
+    unsigned int framebuffer = 0;
+    unsigned int idbuffer = 0;
+    unsigned int depthbuffer = 0;
+
+    unsigned int pixel_buffers[buffer_count] = {};
+    // Opaque GLsync handles of the read backs that are still in flight
+    void* fences[buffer_count] = {};
+    // Buffer that the next read back goes into
+    int current = 0;
+
+    int pick_x = 0;
+    int pick_y = 0;
+
+    glm::uvec4 result = glm::uvec4(0);
+};
+}  // namespace engine
+}  // namespace cqsp
@@ -30,6 +30,10 @@ class Window {
     virtual bool MouseButtonIsReleased(int btn) const = 0;
     virtual bool MouseButtonIsPressed(int btn) const = 0;
     virtual bool MouseDragged() const = 0;
+    /// <summary>
+    /// The mouse position is kept when the cursor leaves the window, so check this before using it.
+    /// </summary>
+    virtual bool MouseInWindow() const = 0;
     virtual double MouseButtonLastReleased(int btn) const = 0;
     virtual bool MouseButtonDoubleClicked(int btn) const = 0;
 
@@ -0,0 +1,57 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "engine/asset/vfs/packvfs.h"
+#include "engine/enginelogger.h"
+
+// Packs a mod folder into a .cqpak file, which can be put in the mods folder instead of the folder itself.
+// Usage: cqsp-packer <mod folder> [output file] [--store]
+int main(int argc, char* argv[]) {
+    std::string directory;
+    std::string output;
+    bool compress = true;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--store") {
+            // Don't compress anything, which is faster to load but larger
+            compress = false;
+        } else if (directory.empty()) {
+            directory = arg;
+        } else if (output.empty()) {
+            output = arg;
+        }
+    }
+    if (directory.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <mod folder> [output file] [--store]" << std::endl;
+        return 1;
+    }
+    if (output.empty()) {
+        std::filesystem::path path = std::filesystem::absolute(directory);
+        if (!path.has_filename()) {
+            path = path.parent_path();
+        }
+        output = path.string() + cqsp::asset::PackFileSystem::extension;
+    }
+
+    cqsp::engine::engine_logger = spdlog::stdout_color_mt("packer");
+    return cqsp::asset::WritePackFile(directory, output, compress) ? 0 : 1;
+}
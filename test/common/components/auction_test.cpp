@@ -19,20 +19,28 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <random>
+#include <vector>
 
+#include "common/components/economy.h"
+#include "common/components/resource.h"
 #include "common/systems/economy/auctionhandler.h"
+#include "common/universe.h"
 
-using cqsp::common::components::AscendingSortedOrderList;
+using cqsp::common::components::AskList;
 using cqsp::common::components::AuctionHouse;
-using cqsp::common::components::DescendingSortedOrderList;
+using cqsp::common::components::BidList;
 using cqsp::common::components::Order;
+using cqsp::common::components::OrderBook;
+using cqsp::common::components::Trade;
 
 entt::entity test_good = static_cast<entt::entity>(1);
 entt::entity test_agent = static_cast<entt::entity>(2);
 
-TEST(AuctionTest, DescendingSortedOrderListTest) {
-    DescendingSortedOrderList sorted_list;
+TEST(AuctionTest, BidListTest) {
+    BidList sorted_list;
     // Add random elements, and sort
     // quantity should not matter
     sorted_list.put(Order(40, 5, test_agent));
@@ -47,15 +55,18 @@ TEST(AuctionTest, DescendingSortedOrderListTest) {
     sorted_list.put(Order(157, 5, test_agent));
     sorted_list.put(Order(45, 5, test_agent));
 
-    double previous = sorted_list[0].price;
-    for (auto &i : sorted_list) {
+    EXPECT_EQ(sorted_list.size(), 11);
+    EXPECT_EQ(sorted_list.BestPrice(), 157);
+    std::vector<Order> orders = sorted_list.Orders();
+    double previous = orders[0].price;
+    for (auto &i : orders) {
         EXPECT_LE(i.price, previous);
         previous = i.price;
     }
 }
 
-TEST(AuctionTest, AscendingSortedOrderListTest) {
-    AscendingSortedOrderList sorted_list;
+TEST(AuctionTest, AskListTest) {
+    AskList sorted_list;
     // Add random elements, and sort
     // quantity should not matter
     sorted_list.put(Order(40, 5, test_agent));
@@ -70,13 +81,41 @@ TEST(AuctionTest, AscendingSortedOrderListTest) {
     sorted_list.put(Order(157, 5, test_agent));
     sorted_list.put(Order(45, 5, test_agent));
 
-    double previous = sorted_list[0].price;
-    for (auto &i : sorted_list) {
+    EXPECT_EQ(sorted_list.size(), 11);
+    EXPECT_EQ(sorted_list.BestPrice(), 10);
+    std::vector<Order> orders = sorted_list.Orders();
+    double previous = orders[0].price;
+    for (auto &i : orders) {
         EXPECT_GE(i.price, previous);
         previous = i.price;
     }
 }
 
+// Orders at the same price are filled in the order that they were placed
+TEST(AuctionTest, PriceLevelQueueTest) {
+    AskList list;
+    entt::entity first = static_cast<entt::entity>(10);
+    entt::entity second = static_cast<entt::entity>(11);
+    list.put(Order(10, 5, first));
+    list.put(Order(10, 5, second));
+    list.put(Order(20, 5, test_agent));
+    EXPECT_EQ(list.DepthAt(10), 10);
+    EXPECT_EQ(list.Depth(), 15);
+
+    EXPECT_EQ(list.front().agent, first);
+    EXPECT_EQ(list.Fill(3), 3);
+    EXPECT_EQ(list.front().agent, first);
+    EXPECT_EQ(list.DepthAt(10), 7);
+    EXPECT_EQ(list.Fill(100), 2);
+    EXPECT_EQ(list.front().agent, second);
+    EXPECT_EQ(list.size(), 2);
+
+    list.pop_front();
+    EXPECT_EQ(list.BestPrice(), 20);
+    EXPECT_EQ(list.DepthAt(10), 0);
+    EXPECT_EQ(list.Depth(), 5);
+}
+
 TEST(AuctionTest, DemandTest) {
     AuctionHouse auction_house;
     // Price is irrelevant
@@ -108,16 +147,23 @@ TEST(AuctionTest, BasicBuyOrderTest) {
     // Add basic buy order
     auction_house.AddSellOrder(test_good, Order(10, 50, test_agent));
 
-    EXPECT_EQ(auction_house.sell_orders[test_good].size(), 1);
+    EXPECT_EQ(auction_house[test_good].asks.size(), 1);
     EXPECT_EQ(static_cast<int>(auction_house.GetSupply(test_good)), 50);
-    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 50);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 50, trades);
 
     // Ensure it's fufilled immediately
     EXPECT_TRUE(is_ordered);
 
     // Ensure the buy ordered is fufilled
-    EXPECT_TRUE(auction_house.buy_orders[test_good].empty());
-    EXPECT_TRUE(auction_house.sell_orders[test_good].empty());
+    EXPECT_TRUE(auction_house[test_good].bids.empty());
+    EXPECT_TRUE(auction_house[test_good].asks.empty());
+
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].good, test_good);
+    EXPECT_EQ(trades[0].buyer, test_agent);
+    EXPECT_EQ(trades[0].price, 10);
+    EXPECT_EQ(trades[0].quantity, 50);
 }
 
 // Test for buy orders that cannot be fully fufilled due to quantity
@@ -125,16 +171,17 @@ TEST(AuctionTest, UnfufilledBuyOrderTest) {
     AuctionHouse auction_house;
     // Add basic buy order
     auction_house.AddSellOrder(test_good, Order(10, 100, test_agent));
-    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 50);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 50, trades);
 
     // It's fufilled immediately
     EXPECT_TRUE(is_ordered);
 
     // ensure that sell order is not totally fufilled
-    EXPECT_FALSE(auction_house.sell_orders[test_good].empty());
+    EXPECT_FALSE(auction_house[test_good].asks.empty());
 
     // ensure no buy orders are sold
-    EXPECT_TRUE(auction_house.buy_orders[test_good].empty());
+    EXPECT_TRUE(auction_house[test_good].bids.empty());
 
     // They should have 50 test goods left
     EXPECT_EQ(50, auction_house.GetSupply(test_good));
@@ -145,13 +192,14 @@ TEST(AuctionTest, OverfufilledBuyOrderTest) {
     AuctionHouse auction_house;
     auction_house.AddSellOrder(test_good, Order(10, 100, test_agent));
 
-    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 1000);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 1000, trades);
 
     EXPECT_FALSE(is_ordered);
 
     // Sell order is fufilled
-    EXPECT_TRUE(auction_house.sell_orders[test_good].empty());
-    EXPECT_FALSE(auction_house.buy_orders[test_good].empty());
+    EXPECT_TRUE(auction_house[test_good].asks.empty());
+    EXPECT_FALSE(auction_house[test_good].bids.empty());
 
     EXPECT_EQ(900, auction_house.GetDemand(test_good));
 }
@@ -161,16 +209,17 @@ TEST(AuctionTest, OverpricedBuyOrderTest) {
     AuctionHouse auction_house;
     // Add basic buy order
     auction_house.AddSellOrder(test_good, Order(1000, 100, test_agent));
-    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 100);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 10, 100, trades);
 
     // It's fufilled immediately
     EXPECT_FALSE(is_ordered);
 
     // Ensure that sell order is not totally fufilled
-    EXPECT_FALSE(auction_house.sell_orders[test_good].empty());
+    EXPECT_FALSE(auction_house[test_good].asks.empty());
 
     // Ensure there's a buy order
-    EXPECT_FALSE(auction_house.buy_orders[test_good].empty());
+    EXPECT_FALSE(auction_house[test_good].bids.empty());
 
     // They should have 50 test goods left
     EXPECT_EQ(100, auction_house.GetSupply(test_good));
@@ -182,14 +231,20 @@ TEST(AuctionTest, BasicSellOrderTest) {
     AuctionHouse auction_house;
     // Add basic buy order
     auction_house.AddBuyOrder(test_good, Order(10, 50, test_agent));
-    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 10, 50);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 10, 50, trades);
 
     // Ensure it's fufilled immediately
     EXPECT_TRUE(is_ordered);
 
     // Ensure the buy ordered is fufilled, and no sell order is added
-    EXPECT_TRUE(auction_house.buy_orders[test_good].empty());
-    EXPECT_TRUE(auction_house.sell_orders[test_good].empty());
+    EXPECT_TRUE(auction_house[test_good].bids.empty());
+    EXPECT_TRUE(auction_house[test_good].asks.empty());
+
+    ASSERT_EQ(trades.size(), 1);
+    EXPECT_EQ(trades[0].seller, test_agent);
+    EXPECT_EQ(trades[0].price, 10);
+    EXPECT_EQ(trades[0].quantity, 50);
 }
 
 // Test for buy orders that cannot be fully fufilled due to quantity
@@ -197,16 +252,17 @@ TEST(AuctionTest, UnfufilledSellOrderTest) {
     AuctionHouse auction_house;
     // Add basic buy order
     auction_house.AddBuyOrder(test_good, Order(10, 100, test_agent));
-    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 10, 50);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 10, 50, trades);
 
     // It's fufilled immediately
     EXPECT_TRUE(is_ordered);
 
     // ensure that buy order is not totally fufilled
-    EXPECT_FALSE(auction_house.buy_orders[test_good].empty());
+    EXPECT_FALSE(auction_house[test_good].bids.empty());
 
     // ensure no sell orders are added
-    EXPECT_TRUE(auction_house.sell_orders[test_good].empty());
+    EXPECT_TRUE(auction_house[test_good].asks.empty());
 
     // They should have 50 test goods left
     EXPECT_EQ(50, auction_house.GetDemand(test_good));
@@ -217,13 +273,14 @@ TEST(AuctionTest, OverfufilledSellOrderTest) {
     AuctionHouse auction_house;
     auction_house.AddBuyOrder(test_good, Order(10, 100, test_agent));
 
-    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 10, 1000);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 10, 1000, trades);
 
     EXPECT_FALSE(is_ordered);
 
     // Sell order is fufilled
-    EXPECT_FALSE(auction_house.sell_orders[test_good].empty());
-    EXPECT_TRUE(auction_house.buy_orders[test_good].empty());
+    EXPECT_FALSE(auction_house[test_good].asks.empty());
+    EXPECT_TRUE(auction_house[test_good].bids.empty());
 
     EXPECT_EQ(900, auction_house.GetSupply(test_good));
     EXPECT_EQ(0, auction_house.GetDemand(test_good));
@@ -234,17 +291,149 @@ TEST(AuctionTest, OverpricedSellOrderTest) {
     AuctionHouse auction_house;
     // Add basic buy order
     auction_house.AddBuyOrder(test_good, Order(10, 100, test_agent));
-    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 1000, 100);
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::SellGood(auction_house, test_agent, test_good, 1000, 100, trades);
 
     // It's not fufilled immediately
     EXPECT_FALSE(is_ordered);
+    EXPECT_TRUE(trades.empty());
 
     // Ensure that sell order is not totally fufilled
-    EXPECT_FALSE(auction_house.sell_orders[test_good].empty());
+    EXPECT_FALSE(auction_house[test_good].asks.empty());
 
     // Ensure there's a buy order
-    EXPECT_FALSE(auction_house.buy_orders[test_good].empty());
+    EXPECT_FALSE(auction_house[test_good].bids.empty());
 
     EXPECT_EQ(100, auction_house.GetDemand(test_good));
     EXPECT_EQ(100, auction_house.GetSupply(test_good));
 }
+
+// A buy order takes the cheapest sell orders first, and stops at its price
+TEST(AuctionTest, BuyAcrossLevelsTest) {
+    AuctionHouse auction_house;
+    auction_house.AddSellOrder(test_good, Order(12, 10, test_agent));
+    auction_house.AddSellOrder(test_good, Order(10, 10, test_agent));
+    auction_house.AddSellOrder(test_good, Order(15, 10, test_agent));
+
+    std::vector<Trade> trades;
+    bool is_ordered = cqsp::common::systems::BuyGood(auction_house, test_agent, test_good, 12, 25, trades);
+    EXPECT_FALSE(is_ordered);
+
+    EXPECT_EQ(10, auction_house.GetSupply(test_good));
+    EXPECT_EQ(15, auction_house[test_good].asks.BestPrice());
+    EXPECT_EQ(5, auction_house.GetDemand(test_good));
+    EXPECT_EQ(12, auction_house[test_good].bids.BestPrice());
+
+    // Each sell order is bought at its own price
+    ASSERT_EQ(trades.size(), 2);
+    EXPECT_EQ(trades[0].price, 10);
+    EXPECT_EQ(trades[0].quantity, 10);
+    EXPECT_EQ(trades[1].price, 12);
+    EXPECT_EQ(trades[1].quantity, 10);
+}
+
+// Orders placed without matching are matched together at a single price
+TEST(AuctionTest, ClearBookTest) {
+    entt::entity buyer = static_cast<entt::entity>(10);
+    entt::entity seller = static_cast<entt::entity>(11);
+    OrderBook book;
+    book.bids.put(Order(14, 10, buyer));
+    book.bids.put(Order(11, 10, buyer));
+    book.bids.put(Order(8, 10, buyer));
+    book.asks.put(Order(9, 15, seller));
+    book.asks.put(Order(10, 10, seller));
+    book.asks.put(Order(13, 10, seller));
+    EXPECT_TRUE(book.Crossed());
+
+    std::vector<Trade> trades;
+    double volume = cqsp::common::systems::ClearBook(book, test_good, trades);
+    EXPECT_FALSE(book.Crossed());
+    EXPECT_EQ(volume, 20);
+    EXPECT_EQ(book.volume, 20);
+    ASSERT_EQ(trades.size(), 3);
+    // The last match was the bid at 11 and the ask at 10
+    for (const Trade& trade : trades) {
+        EXPECT_EQ(trade.price, 10.5);
+        EXPECT_EQ(trade.good, test_good);
+        EXPECT_EQ(trade.buyer, buyer);
+        EXPECT_EQ(trade.seller, seller);
+    }
+    EXPECT_EQ(book.last_price, 10.5);
+    EXPECT_EQ(book.bids.Depth(), 10);
+    EXPECT_EQ(book.asks.Depth(), 15);
+
+    // Nothing left to match
+    trades.clear();
+    EXPECT_EQ(cqsp::common::systems::ClearBook(book, test_good, trades), 0);
+    EXPECT_TRUE(trades.empty());
+    EXPECT_EQ(book.last_price, 10.5);
+}
+
+TEST(AuctionTest, SettleTradesTest) {
+    namespace cqspc = cqsp::common::components;
+    cqsp::common::Universe universe;
+    entt::entity good = universe.create();
+    entt::entity buyer = universe.create();
+    entt::entity seller = universe.create();
+    universe.emplace<cqspc::Wallet>(buyer, entt::null, 1000);
+    universe.emplace<cqspc::ResourceStockpile>(buyer);
+    universe.emplace<cqspc::Wallet>(seller, entt::null, 0);
+    universe.emplace<cqspc::ResourceStockpile>(seller)[good] = 50;
+
+    std::vector<Trade> trades;
+    trades.push_back({good, buyer, seller, 10, 20});
+    cqsp::common::systems::SettleTrades(universe, trades);
+
+    EXPECT_EQ(universe.get<cqspc::Wallet>(buyer).GetBalance(), 800);
+    EXPECT_EQ(universe.get<cqspc::Wallet>(seller).GetBalance(), 200);
+    EXPECT_EQ(universe.get<cqspc::ResourceStockpile>(buyer)[good], 20);
+    EXPECT_EQ(universe.get<cqspc::ResourceStockpile>(seller)[good], 30);
+}
+
+// Places and clears a million orders. Run with --gtest_also_run_disabled_tests --gtest_filter=AuctionTest.*
+TEST(AuctionTest, DISABLED_MillionOrderBenchmark) {
+    const int order_count = 1000000;
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> price_dist(900, 1100);
+    std::uniform_real_distribution<double> quantity_dist(1, 100);
+
+    AuctionHouse auction_house;
+    OrderBook& book = auction_house[test_good];
+    auto start = std::chrono::high_resolution_clock::now();
+    int filled = 0;
+    std::vector<Trade> immediate_trades;
+    for (int i = 0; i < order_count; i++) {
+        double price = price_dist(random) / 100.0;
+        double quantity = quantity_dist(random);
+        bool is_ordered =
+            (i % 2 == 0)
+                ? cqsp::common::systems::BuyGood(book, test_agent, test_good, price, quantity, immediate_trades)
+                : cqsp::common::systems::SellGood(book, test_agent, test_good, price, quantity, immediate_trades);
+        filled += is_ordered;
+    }
+    auto matched = std::chrono::high_resolution_clock::now();
+
+    // Then the batch path, where orders are placed through the tick and cleared together
+    OrderBook batch;
+    for (int i = 0; i < order_count; i++) {
+        double price = price_dist(random) / 100.0;
+        double quantity = quantity_dist(random);
+        if (i % 2 == 0) {
+            batch.bids.put(Order(price, quantity, test_agent));
+        } else {
+            batch.asks.put(Order(price, quantity, test_agent));
+        }
+    }
+    std::vector<Trade> trades;
+    double volume = cqsp::common::systems::ClearBook(batch, test_good, trades);
+    auto cleared = std::chrono::high_resolution_clock::now();
+
+    EXPECT_FALSE(book.Crossed());
+    EXPECT_FALSE(batch.Crossed());
+    std::cout << order_count << " orders matched as they were placed in "
+              << std::chrono::duration<double, std::milli>(matched - start).count() << " ms, " << filled
+              << " filled immediately in " << immediate_trades.size() << " trades\n";
+    std::cout << order_count << " orders placed and cleared in "
+              << std::chrono::duration<double, std::milli>(cleared - matched).count() << " ms, " << trades.size()
+              << " trades for " << volume << " units at " << batch.last_price << "\n";
+}
@@ -0,0 +1,123 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include "common/components/bodies.h"
+#include "common/components/coordinates.h"
+#include "common/components/population.h"
+#include "common/components/surface.h"
+#include "common/game.h"
+#include "common/scripting/luafunctions.h"
+
+namespace cqspb = cqsp::common::components::bodies;
+namespace cqspc = cqsp::common::components;
+namespace cqspt = cqsp::common::components::types;
+
+class BulkFunctionsTest : public ::testing::Test {
+ protected:
+    void SetUp() override { cqsp::scripting::LoadFunctions(universe(), script()); }
+
+    cqsp::common::Universe& universe() { return game.GetUniverse(); }
+    cqsp::scripting::ScriptInterface& script() { return game.GetScriptInterface(); }
+
+    cqsp::common::Game game;
+};
+
+TEST_F(BulkFunctionsTest, AddBodies) {
+    script().RunScript(R"(
+        bodies = core.add_bodies({
+            { star = true, radius = 696000 },
+            { radius = 6371, orbit = { semi_major_axis = 1.5e8, eccentricity = 0.01 } },
+            { radius = 1737 },
+        })
+    )");
+    ASSERT_TRUE(script().values.empty());
+    sol::table bodies = script()["bodies"];
+    ASSERT_EQ(bodies.size(), 3);
+    entt::entity star = bodies[1];
+    entt::entity planet = bodies[2];
+    entt::entity moon = bodies[3];
+
+    EXPECT_TRUE(universe().all_of<cqspb::Star>(star));
+    EXPECT_TRUE(universe().all_of<cqspb::LightEmitter>(star));
+    EXPECT_FALSE(universe().all_of<cqspb::Planet>(star));
+    EXPECT_EQ(universe().get<cqspb::Body>(star).radius, 696000);
+
+    EXPECT_TRUE(universe().all_of<cqspb::Planet>(planet));
+    EXPECT_EQ(universe().get<cqspb::Body>(planet).radius, 6371);
+    ASSERT_TRUE(universe().all_of<cqspt::Orbit>(planet));
+    EXPECT_EQ(universe().get<cqspt::Orbit>(planet).semi_major_axis, 1.5e8);
+    EXPECT_EQ(universe().get<cqspt::Orbit>(planet).eccentricity, 0.01);
+    EXPECT_TRUE(universe().all_of<cqspt::Kinematics>(planet));
+
+    EXPECT_FALSE(universe().all_of<cqspt::Orbit>(moon));
+}
+
+TEST_F(BulkFunctionsTest, SetOrbitsAndSettlements) {
+    script().RunScript(R"(
+        local bodies = core.add_bodies({ {}, {} })
+        core.set_orbits({
+            { body = bodies[1], semi_major_axis = 1000 },
+            { body = bodies[2], semi_major_axis = 2000, inclination = 0.5 },
+        })
+        planet = bodies[1]
+        cities = core.add_planet_settlements({
+            { planet = planet, latitude = 10, longitude = 20 },
+            { planet = planet, latitude = -10, longitude = 40 },
+        })
+    )");
+    ASSERT_TRUE(script().values.empty());
+    entt::entity planet = script()["planet"];
+    EXPECT_EQ(universe().get<cqspt::Orbit>(planet).semi_major_axis, 1000);
+    EXPECT_EQ(universe().view<cqspt::Orbit>().size(), 2);
+
+    sol::table cities = script()["cities"];
+    ASSERT_EQ(cities.size(), 2);
+    auto& habitation = universe().get<cqspc::Habitation>(planet);
+    ASSERT_EQ(habitation.settlements.size(), 2);
+    EXPECT_EQ(habitation.settlements[0], cities[1].get<entt::entity>());
+    EXPECT_EQ(habitation.settlements[1], cities[2].get<entt::entity>());
+    entt::entity city = cities[2];
+    EXPECT_TRUE(universe().all_of<cqspc::Settlement>(city));
+    EXPECT_NEAR(universe().get<cqspt::SurfaceCoordinate>(city).latitude(), -10, 1e-9);
+    EXPECT_NEAR(universe().get<cqspt::SurfaceCoordinate>(city).longitude(), 40, 1e-9);
+}
+
+TEST_F(BulkFunctionsTest, ReadPopulations) {
+    entt::entity segment = universe().create();
+    universe().emplace<cqspc::PopulationSegment>(segment, 1000ull, 600ull);
+    script().RunScript(R"(
+        local rows = core.read_populations()
+        size = rows:size()
+        population = rows:get(1, 1)
+        labor_force = rows:get(1, 2)
+        local values = rows:values()
+        if values ~= nil then
+            labor_force_value = values[1]
+        end
+        hidden = ffi == nil and package.loaded.ffi == nil and not pcall(require, "ffi")
+    )");
+    ASSERT_TRUE(script().values.empty());
+    EXPECT_EQ(script()["size"].get<int>(), 1);
+    EXPECT_EQ(script()["population"].get<double>(), 1000);
+    EXPECT_EQ(script()["labor_force"].get<double>(), 600);
+#ifdef CQSP_LUAJIT
+    EXPECT_EQ(script()["labor_force_value"].get<double>(), 600);
+#endif
+    // Only the reader is handed out, not ffi
+    EXPECT_TRUE(script()["hidden"].get<bool>());
+}
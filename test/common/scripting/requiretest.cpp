@@ -0,0 +1,39 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include "common/scripting/scripting.h"
+
+TEST(RequireTest, UnloadChangedTest) {
+    cqsp::scripting::ScriptInterface script;
+    script.RunScript("runs = 0");
+    const char* first = "runs = runs + 1 return 1";
+    EXPECT_EQ(script.RequireScript("module", first).as<int>(), 1);
+    // Required scripts are only run once
+    EXPECT_EQ(script.RequireScript("module", first).as<int>(), 1);
+    EXPECT_EQ(script["runs"].get<int>(), 1);
+
+    // Nothing changed, so it stays loaded
+    EXPECT_FALSE(script.UnloadChangedScript("module", first));
+    EXPECT_FALSE(script.UnloadChangedScript("missing", first));
+
+    const char* second = "runs = runs + 1 return 2";
+    EXPECT_TRUE(script.UnloadChangedScript("module", second));
+    EXPECT_EQ(script.RequireScript("module", second).as<int>(), 2);
+    EXPECT_EQ(script["runs"].get<int>(), 2);
+    EXPECT_TRUE(script.values.empty());
+}
@@ -0,0 +1,144 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "common/game.h"
+#include "common/scripting/luafunctions.h"
+#include "common/systems/scriptrunner.h"
+
+// Compares the cost of scripts on Lua and LuaJIT. Build once with each backend, and run with
+// --gtest_also_run_disabled_tests --gtest_filter=ScriptBenchmark.*
+namespace {
+std::string Backend(cqsp::scripting::ScriptInterface& script) {
+#ifdef CQSP_LUAJIT
+    return script["jit"]["version"];
+#else
+    return script["_VERSION"];
+#endif
+}
+
+template <class Function>
+double TimeMs(Function&& function) {
+    auto start = std::chrono::high_resolution_clock::now();
+    function();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+}  // namespace
+
+TEST(ScriptBenchmark, DISABLED_UniverseGeneration) {
+    cqsp::common::Game game;
+    cqsp::scripting::ScriptInterface& script = game.GetScriptInterface();
+    cqsp::scripting::LoadFunctions(game.GetUniverse(), script);
+
+    // The same calls that the universe generation makes, for a lot of bodies
+    double generation = TimeMs([&]() {
+        script.RunScript(R"(
+            for i = 1, 20000 do
+                local planet = core.add_planet()
+                core.set_orbit(planet, 1000 + i, 0.01 * (i % 50), 0.1, 0.2, 0.3, 0.4)
+                core.set_radius(planet, 6000)
+                for j = 1, 3 do
+                    core.add_planet_settlement(planet, j * 10, j * 20)
+                end
+            end
+        )");
+    });
+
+    // The same bodies, created with the bulk functions
+    double bulk_generation = TimeMs([&]() {
+        script.RunScript(R"(
+            local bodies = {}
+            for i = 1, 20000 do
+                bodies[i] = {
+                    radius = 6000,
+                    orbit = { semi_major_axis = 1000 + i, eccentricity = 0.01 * (i % 50), inclination = 0.1,
+                              LAN = 0.2, w = 0.3, M0 = 0.4 }
+                }
+            end
+            local planets = core.add_bodies(bodies)
+            local settlements = {}
+            for i = 1, #planets do
+                for j = 1, 3 do
+                    settlements[#settlements + 1] = { planet = planets[i], latitude = j * 10, longitude = j * 20 }
+                end
+            end
+            core.add_planet_settlements(settlements)
+        )");
+    });
+
+    double bulk_read = TimeMs([&]() {
+        script.RunScript(R"(
+            local rows = core.read_orbits()
+            local total = 0
+            for i = 1, rows:size() do
+                total = total + rows:get(i, 1) * (1 - rows:get(i, 2))
+            end
+            bulk_total = total
+        )");
+    });
+    EXPECT_TRUE(script.values.empty());
+    EXPECT_GT(script["bulk_total"].get<double>(), 0);
+
+    std::cout << Backend(script) << ": universe generation " << generation << " ms, in bulk " << bulk_generation
+              << " ms, reading orbits " << bulk_read << " ms\n";
+}
+
+namespace {
+/// <returns>Milliseconds that a tick of events takes</returns>
+double EventTickMs(int budget, std::string& backend) {
+    cqsp::common::Game game;
+    cqsp::scripting::ScriptInterface& script = game.GetScriptInterface();
+    script.RegisterDataGroup("events");
+    script["event_budget"] = budget;
+    script.RunScript(R"(
+        for i = 1, 200 do
+            local event = { value = 0, budget = event_budget }
+            function event:on_tick()
+                for j = 1, 100 do
+                    self.value = (self.value + j * date) % 1000
+                end
+            end
+            events:insert(event)
+        end
+    )");
+
+    const int ticks = 1000;
+    cqsp::common::systems::SysScript runner(game);
+    double time = TimeMs([&]() {
+        for (int i = 0; i < ticks; i++) {
+            game.GetUniverse().date.IncrementDate();
+            runner.DoSystem();
+        }
+    });
+    EXPECT_TRUE(script.values.empty());
+    backend = Backend(script);
+    return time / ticks;
+}
+}  // namespace
+
+TEST(ScriptBenchmark, DISABLED_EventTick) {
+    std::string backend;
+    double budgeted = EventTickMs(1000000, backend);
+    // Events without a budget are compiled on LuaJIT
+    double unbudgeted = EventTickMs(0, backend);
+    std::cout << backend << ": event tick " << budgeted << " ms, without budgets " << unbudgeted << " ms\n";
+}
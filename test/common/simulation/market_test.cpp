@@ -16,10 +16,14 @@
 */
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <iostream>
 
+#include "common/components/auction.h"
 #include "common/components/economy.h"
+#include "common/simulation.h"
 #include "common/systems/economy/markethelpers.h"
+#include "common/systems/economy/marketsolver.h"
 #include "common/systems/economy/sysmarket.h"
 #include "common/universe.h"
 
@@ -163,3 +167,114 @@ TEST_F(MarketTwoTest, BuySellOverSupplyTest) {
     // Check the price, lower price due to higher supply over demand
     EXPECT_LE(market_comp[good_1].price, good_1_default_price);
 }
+
+// Orders placed in the auction house of the market are matched and settled in the next tick
+TEST_F(MarketTwoTest, AuctionTickTest) {
+    universe.get<cqspc::Wallet>(agent1) = 1000;
+    universe.get<cqspc::ResourceStockpile>(agent2)[good_1] = 50;
+
+    auto& auction_house = universe.get<cqspc::AuctionHouse>(market);
+    auction_house.AddBuyOrder(good_1, cqspc::Order(12, 30, agent1));
+    auction_house.AddSellOrder(good_1, cqspc::Order(8, 50, agent2));
+
+    game.GetScriptInterface().RegisterDataGroup("events");
+    cqsp::common::systems::simulation::Simulation simulation(game);
+    simulation.tick();
+
+    // Cleared halfway between the bid and the ask
+    const cqspc::OrderBook& book = universe.get<cqspc::AuctionHouse>(market)[good_1];
+    EXPECT_EQ(book.last_price, 10);
+    EXPECT_EQ(book.volume, 30);
+    EXPECT_TRUE(book.bids.empty());
+    EXPECT_EQ(book.asks.Depth(), 20);
+
+    EXPECT_EQ(universe.get<cqspc::Wallet>(agent1).GetBalance(), 700);
+    EXPECT_EQ(universe.get<cqspc::Wallet>(agent2).GetBalance(), 300);
+    EXPECT_EQ(universe.get<cqspc::ResourceStockpile>(agent1)[good_1], 30);
+    EXPECT_EQ(universe.get<cqspc::ResourceStockpile>(agent2)[good_1], 20);
+}
+
+TEST(MarketSolverTest, SolveTest) {
+    cqsp::common::systems::MarketSolver solver;
+    entt::entity good_1 = static_cast<entt::entity>(3);
+    entt::entity good_2 = static_cast<entt::entity>(1);
+    entt::entity good_3 = static_cast<entt::entity>(7);
+    solver.SetGoods({good_1, good_2, good_3});
+
+    cqspc::ResourceLedger supply;
+    cqspc::ResourceLedger demand;
+    cqspc::ResourceLedger price;
+    // Demand is higher
+    supply[good_1] = 100;
+    demand[good_1] = 400;
+    price[good_1] = 10;
+    // Balanced
+    supply[good_2] = 50;
+    demand[good_2] = 50;
+    price[good_2] = 5;
+    // Nothing is supplied
+    demand[good_3] = 10;
+    price[good_3] = 2;
+
+    size_t row = solver.AddMarket(supply, demand, price);
+    solver.Solve();
+    solver.WritePrices(row, price);
+
+    using cqsp::common::systems::MarketSolver;
+    const double exponent = 1 / (MarketSolver::default_supply_elasticity + MarketSolver::default_demand_elasticity);
+    EXPECT_DOUBLE_EQ(price[good_1], 10 * std::pow(4, exponent));
+    EXPECT_DOUBLE_EQ(price[good_2], 5);
+    EXPECT_DOUBLE_EQ(price[good_3], 2 * MarketSolver::max_step);
+}
+
+// If supply and demand follow their elasticities, the price that is solved for clears the market, so
+// the next step doesn't move it
+TEST(MarketSolverTest, SettleTest) {
+    cqsp::common::systems::MarketSolver solver;
+    entt::entity good = static_cast<entt::entity>(1);
+    solver.SetGoods({good});
+    const double supply_elasticity = 0.8;
+    const double demand_elasticity = 1.2;
+    solver.SetElasticity(good, supply_elasticity, demand_elasticity);
+
+    const double start_price = 10;
+    const double base_supply = 100;
+    const double base_demand = 300;
+    cqspc::ResourceLedger price;
+    price[good] = start_price;
+    for (int i = 0; i < 3; i++) {
+        double ratio = price[good] / start_price;
+        cqspc::ResourceLedger supply;
+        cqspc::ResourceLedger demand;
+        supply[good] = base_supply * std::pow(ratio, supply_elasticity);
+        demand[good] = base_demand * std::pow(ratio, -demand_elasticity);
+
+        solver.Clear();
+        size_t row = solver.AddMarket(supply, demand, price);
+        solver.Solve();
+        solver.WritePrices(row, price);
+        EXPECT_NEAR(price[good], start_price * std::sqrt(3), 1e-9);
+    }
+}
+
+TEST_F(MarketTwoTest, SysMarketPriceTest) {
+    universe.emplace<cqspc::Price>(good_1, static_cast<double>(good_1_default_price));
+    universe.emplace<cqspc::Price>(good_2, static_cast<double>(good_2_default_price));
+    cqsp::common::systems::SysMarket::InitializeMarket(game);
+
+    auto& market_comp = universe.get<cqspc::Market>(market);
+    market_comp.supply[good_1] = 100;
+    market_comp.demand[good_1] = 50;
+    market_comp.supply[good_2] = 100;
+    market_comp.demand[good_2] = 100;
+
+    cqsp::common::systems::SysMarket market_two_system(game);
+    market_two_system.DoSystem();
+
+    // Over supplied, so the price drops
+    EXPECT_LT(market_comp.price[good_1], good_1_default_price);
+    EXPECT_DOUBLE_EQ(market_comp.price[good_2], good_2_default_price);
+    // Supply and demand were moved to the previous tick
+    EXPECT_EQ(market_comp.previous_supply[good_1], 100);
+    EXPECT_TRUE(market_comp.supply.empty());
+}
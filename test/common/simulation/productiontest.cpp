@@ -0,0 +1,110 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include "common/components/area.h"
+#include "common/components/economy.h"
+#include "common/components/infrastructure.h"
+#include "common/components/organizations.h"
+#include "common/components/resource.h"
+#include "common/game.h"
+#include "common/systems/economy/markethelpers.h"
+#include "common/systems/economy/sysfactory.h"
+
+namespace cqspc = cqsp::common::components;
+
+class ProductionTest : public ::testing::Test {
+ protected:
+    ProductionTest() : universe(game.GetUniverse()) {}
+
+    void SetUp() override {
+        ore = universe.create();
+        metal = universe.create();
+        machine = universe.create();
+
+        // Smelting takes 2 ore for a metal, with 10 machines of capital
+        smelting = universe.create();
+        auto& recipe = universe.emplace<cqspc::Recipe>(smelting);
+        recipe.input[ore] = 2;
+        recipe.capitalcost[machine] = 10;
+        recipe.output.entity = metal;
+        recipe.output.amount = 1;
+        recipe.workers = 1;
+
+        country = universe.create();
+        universe.emplace<cqspc::Country>(country);
+        cqsp::common::systems::economy::CreateMarket(universe, country);
+
+        city = universe.create();
+        universe.emplace<cqspc::infrastructure::CityInfrastructure>(city, 0., 0.);
+        universe.get_or_emplace<cqspc::CountryCityList>(country).city_list.push_back(city);
+
+        industry = universe.create();
+        universe.emplace<cqspc::Production>(industry, cqspc::factory, smelting);
+        universe.emplace<cqspc::IndustrySize>(industry, 500., 0.);
+        universe.emplace<cqspc::IndustrialZone>(city).industries.push_back(industry);
+
+        auto& market = universe.get<cqspc::Market>(country);
+        market.price[ore] = 5;
+        market.price[metal] = 10;
+        market.price[machine] = 20;
+        market.sd_ratio[machine] = 1;
+    }
+
+    cqsp::common::Game game;
+    cqsp::common::Universe& universe;
+    entt::entity ore, metal, machine;
+    entt::entity smelting;
+    entt::entity country;
+    entt::entity city;
+    entt::entity industry;
+};
+
+TEST_F(ProductionTest, SuppliedTest) {
+    universe.get<cqspc::Market>(country).sd_ratio[ore] = 1;
+    cqsp::common::systems::SysProduction production(game);
+    production.DoSystem();
+
+    // Inputs and outputs are scaled by the size of the industry
+    auto& market = universe.get<cqspc::Market>(country);
+    EXPECT_DOUBLE_EQ(market.demand[ore], 1000);
+    // Capital is used up slowly
+    EXPECT_DOUBLE_EQ(market.demand[machine], 50);
+    EXPECT_DOUBLE_EQ(market.supply[metal], 500);
+
+    // Wages are more than the metal makes, so its price goes up
+    EXPECT_NEAR(market.price[metal], 10.3, 1e-6);
+    // Prices that industries didn't change are kept as they were at the start of the day
+    EXPECT_EQ(market.price[ore], 5);
+    EXPECT_EQ(market.price[machine], 20);
+
+    // Metal isn't oversupplied, so the industry grows
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::IndustrySize>(industry).size, 505);
+}
+
+TEST_F(ProductionTest, ThrottledTest) {
+    // Only half of the ore that is needed is on the market
+    universe.get<cqspc::Market>(country).sd_ratio[ore] = 0.5;
+    cqsp::common::systems::SysProduction production(game);
+    production.DoSystem();
+
+    auto& market = universe.get<cqspc::Market>(country);
+    EXPECT_DOUBLE_EQ(market.demand[ore], 500);
+    EXPECT_DOUBLE_EQ(market.demand[machine], 25);
+    EXPECT_DOUBLE_EQ(market.supply[metal], 250);
+    EXPECT_EQ(market[metal].inputratio, 0.5);
+}
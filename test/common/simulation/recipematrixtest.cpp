@@ -0,0 +1,149 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "common/components/resource.h"
+#include "common/systems/economy/recipematrix.h"
+#include "common/universe.h"
+
+namespace cqspc = cqsp::common::components;
+using cqsp::common::systems::ProductionPlan;
+using cqsp::common::systems::RecipeMatrix;
+
+class RecipeMatrixTest : public ::testing::Test {
+ protected:
+    RecipeMatrixTest() : recipes(universe) {}
+
+    void SetUp() override {
+        ore = universe.create();
+        metal = universe.create();
+        machine = universe.create();
+        car = universe.create();
+
+        smelting = AddRecipe({{ore, 2}}, metal, 1);
+        universe.get<cqspc::Recipe>(smelting).capitalcost[machine] = 10;
+        machining = AddRecipe({{metal, 3}}, machine, 1);
+        assembly = AddRecipe({{metal, 4}, {machine, 1}}, car, 2);
+    }
+
+    entt::entity AddRecipe(std::vector<std::pair<entt::entity, double>> inputs, entt::entity output, double amount) {
+        entt::entity entity = universe.create();
+        auto& recipe = universe.emplace<cqspc::Recipe>(entity);
+        for (auto& [good, input] : inputs) {
+            recipe.input[good] = input;
+        }
+        recipe.output.entity = output;
+        recipe.output.amount = amount;
+        recipe.workers = 1;
+        return entity;
+    }
+
+    cqsp::common::Universe universe;
+    RecipeMatrix recipes;
+    entt::entity ore, metal, machine, car;
+    entt::entity smelting, machining, assembly;
+};
+
+TEST_F(RecipeMatrixTest, CompileTest) {
+    EXPECT_TRUE(recipes.Update());
+    EXPECT_FALSE(recipes.Update());
+    ASSERT_EQ(recipes.GoodCount(), 4);
+    ASSERT_EQ(recipes.RecipeCount(), 3);
+
+    const int r = recipes.RecipeIndex(assembly);
+    ASSERT_GE(r, 0);
+    EXPECT_EQ(recipes.Input(recipes.GoodIndex(metal), r), 4);
+    EXPECT_EQ(recipes.Input(recipes.GoodIndex(machine), r), 1);
+    EXPECT_EQ(recipes.Input(recipes.GoodIndex(ore), r), 0);
+    EXPECT_EQ(recipes.Output(recipes.GoodIndex(car), r), 2);
+    EXPECT_EQ(recipes.GetGood(recipes.OutputGood(r)), car);
+    EXPECT_EQ(recipes.InputSum(r), 5);
+    EXPECT_EQ(recipes.Capital(recipes.GoodIndex(machine), recipes.RecipeIndex(smelting)), 10);
+
+    // Changing a recipe compiles them again
+    universe.patch<cqspc::Recipe>(assembly, [](cqspc::Recipe& recipe) { recipe.output.amount = 3; });
+    EXPECT_TRUE(recipes.Update());
+    EXPECT_EQ(recipes.OutputAmount(recipes.RecipeIndex(assembly)), 3);
+}
+
+TEST_F(RecipeMatrixTest, ProductTest) {
+    recipes.Update();
+    std::vector<double> activity(recipes.RecipeCount(), 0);
+    activity[recipes.RecipeIndex(smelting)] = 10;
+    activity[recipes.RecipeIndex(assembly)] = 5;
+
+    cqspc::ResourceLedger demand;
+    cqspc::ResourceLedger supply;
+    recipes.AddTo(recipes.Consumption(activity, 0.5), demand);
+    recipes.AddTo(recipes.Production(activity), supply);
+    EXPECT_EQ(demand[ore], 20);
+    EXPECT_EQ(demand[metal], 20);
+    // Inputs and half of the capital
+    EXPECT_EQ(demand[machine], 5 + 50);
+    EXPECT_EQ(supply[metal], 10);
+    EXPECT_EQ(supply[car], 10);
+    EXPECT_EQ(supply[machine], 0);
+
+    cqspc::ResourceLedger sd_ratio;
+    sd_ratio[ore] = 0.5;
+    sd_ratio[metal] = 2;
+    sd_ratio[machine] = 0.8;
+    std::vector<double> input_min;
+    std::vector<double> capital_min;
+    recipes.MinOfInputs(recipes.Gather(sd_ratio), input_min, capital_min);
+    EXPECT_EQ(input_min[recipes.RecipeIndex(smelting)], 0.5);
+    EXPECT_EQ(capital_min[recipes.RecipeIndex(smelting)], 0.8);
+    EXPECT_EQ(input_min[recipes.RecipeIndex(assembly)], 0.8);
+    // No capital
+    EXPECT_EQ(capital_min[recipes.RecipeIndex(assembly)], 1);
+}
+
+TEST_F(RecipeMatrixTest, PlanTest) {
+    recipes.Update();
+    ProductionPlan plan = recipes.Plan(car, 20);
+
+    // 10 assemblies need 40 metal and 10 machines, which need 30 more metal
+    EXPECT_DOUBLE_EQ(plan.recipes[assembly], 10);
+    EXPECT_DOUBLE_EQ(plan.recipes[machining], 10);
+    EXPECT_DOUBLE_EQ(plan.recipes[smelting], 70);
+    EXPECT_DOUBLE_EQ(plan.raw[ore], 140);
+    EXPECT_EQ(plan.raw.size(), 1);
+    EXPECT_DOUBLE_EQ(plan.capital[machine], 700);
+
+    // Nothing makes ore
+    plan = recipes.Plan(ore, 5);
+    EXPECT_TRUE(plan.recipes.empty());
+    EXPECT_DOUBLE_EQ(plan.raw[ore], 5);
+}
+
+TEST_F(RecipeMatrixTest, PlanCycleTest) {
+    // Seeds grow into wheat, which is needed to grow more seeds
+    entt::entity wheat = universe.create();
+    entt::entity seed = universe.create();
+    entt::entity farming = AddRecipe({{seed, 1}}, wheat, 4);
+    entt::entity seeding = AddRecipe({{wheat, 1}}, seed, 2);
+    recipes.Update();
+
+    ProductionPlan plan = recipes.Plan(wheat, 8);
+    EXPECT_DOUBLE_EQ(plan.recipes[farming], 2);
+    EXPECT_DOUBLE_EQ(plan.recipes[seeding], 1);
+    // The wheat to start the loop has to come from somewhere
+    EXPECT_DOUBLE_EQ(plan.raw[wheat], 1);
+}
@@ -0,0 +1,303 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "common/components/coordinates.h"
+#include "common/components/economy.h"
+#include "common/components/infrastructure.h"
+#include "common/components/organizations.h"
+#include "common/components/surface.h"
+#include "common/game.h"
+#include "common/systems/economy/markethelpers.h"
+#include "common/systems/economy/systrade.h"
+#include "common/systems/economy/tradenetwork.h"
+#include "common/systems/loading/loadcities.h"
+
+namespace cqspc = cqsp::common::components;
+using cqsp::common::components::infrastructure::RouteType;
+using cqsp::common::components::infrastructure::TradeRoute;
+using cqsp::common::systems::economy::AddTradeRoute;
+
+class TradeNetworkTest : public ::testing::Test {
+ protected:
+    TradeNetworkTest() : universe(game.GetUniverse()), network(universe) {}
+
+    void SetUp() override {
+        for (entt::entity& market : markets) {
+            market = cqsp::common::systems::economy::CreateMarket(universe);
+        }
+        // A line of markets, and a more expensive shortcut from the first to the third
+        AddTradeRoute(universe, markets[0], markets[1], 1, 100, RouteType::Highway);
+        AddTradeRoute(universe, markets[1], markets[2], 1, 100, RouteType::Highway);
+        AddTradeRoute(universe, markets[2], markets[3], 1, 100, RouteType::SpacePort);
+        AddTradeRoute(universe, markets[3], markets[4], 1, 100, RouteType::Orbit);
+        shortcut = AddTradeRoute(universe, markets[0], markets[2], 5, 100, RouteType::Highway);
+        network.Update();
+    }
+
+    cqsp::common::Game game;
+    cqsp::common::Universe& universe;
+    cqsp::common::systems::TradeNetwork network;
+    entt::entity markets[5];
+    entt::entity shortcut;
+};
+
+TEST_F(TradeNetworkTest, PathTest) {
+    EXPECT_EQ(network.GetMarkets().size(), 5);
+    EXPECT_EQ(network.LastUpdateCount(), 5);
+    EXPECT_EQ(network.Distance(markets[0], markets[2]), 2);
+    EXPECT_EQ(network.Distance(markets[4], markets[0]), 4);
+    EXPECT_EQ(network.Distance(markets[1], markets[1]), 0);
+
+    auto path = network.Path(network.IndexOf(markets[0]), network.IndexOf(markets[2]));
+    ASSERT_EQ(path.size(), 2);
+    EXPECT_EQ(universe.get<TradeRoute>(path[0]).to, markets[2]);
+    EXPECT_EQ(universe.get<TradeRoute>(path[1]).from, markets[0]);
+
+    // Nothing changed
+    network.Update();
+    EXPECT_EQ(network.LastUpdateCount(), 0);
+}
+
+TEST_F(TradeNetworkTest, IncrementalUpdateTest) {
+    // Nobody uses the shortcut, and making it more expensive doesn't change that
+    universe.patch<TradeRoute>(shortcut, [](TradeRoute& route) { route.cost = 6; });
+    network.Update();
+    EXPECT_EQ(network.LastUpdateCount(), 0);
+    EXPECT_EQ(network.Distance(markets[0], markets[2]), 2);
+
+    // Now it's shorter for everyone except the second market
+    universe.patch<TradeRoute>(shortcut, [](TradeRoute& route) { route.cost = 1; });
+    network.Update();
+    EXPECT_EQ(network.LastUpdateCount(), 4);
+    EXPECT_EQ(network.Distance(markets[0], markets[2]), 1);
+    EXPECT_EQ(network.Distance(markets[4], markets[0]), 3);
+    EXPECT_EQ(network.Distance(markets[1], markets[3]), 2);
+
+    // Everyone that used it has to find a new path
+    universe.destroy(shortcut);
+    network.Update();
+    EXPECT_EQ(network.LastUpdateCount(), 4);
+    EXPECT_EQ(network.Distance(markets[0], markets[2]), 2);
+    EXPECT_EQ(network.Distance(markets[4], markets[0]), 4);
+}
+
+TEST_F(TradeNetworkTest, AddMarketTest) {
+    entt::entity market = cqsp::common::systems::economy::CreateMarket(universe);
+    AddTradeRoute(universe, markets[4], market, 3, 100, RouteType::Orbit);
+    network.Update();
+    EXPECT_EQ(network.GetMarkets().size(), 6);
+    EXPECT_EQ(network.LastUpdateCount(), 6);
+    EXPECT_EQ(network.Distance(markets[0], market), 7);
+}
+
+class TradeFlowTest : public ::testing::Test {
+ protected:
+    TradeFlowTest() : universe(game.GetUniverse()), trade(game) {}
+
+    void SetUp() override {
+        good = universe.create();
+        universe.emplace<cqspc::Price>(good, 5.0);
+        exporter = cqsp::common::systems::economy::CreateMarket(universe);
+        importer = cqsp::common::systems::economy::CreateMarket(universe);
+
+        auto& exporter_market = universe.get<cqspc::Market>(exporter);
+        exporter_market.supply[good] = 100;
+        exporter_market.price[good] = 5;
+        auto& importer_market = universe.get<cqspc::Market>(importer);
+        importer_market.demand[good] = 50;
+        importer_market.price[good] = 10;
+    }
+
+    cqsp::common::Game game;
+    cqsp::common::Universe& universe;
+    cqsp::common::systems::SysTrade trade;
+    entt::entity good;
+    entt::entity exporter;
+    entt::entity importer;
+};
+
+TEST_F(TradeFlowTest, FlowTest) {
+    entt::entity route = AddTradeRoute(universe, exporter, importer, 1, 1000, RouteType::Highway);
+    trade.DoSystem();
+
+    // The importer takes as much as it's short of
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::Market>(exporter).demand[good], 50);
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::Market>(importer).supply[good], 50);
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::TradeFlows>(exporter).exports[good], 50);
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::TradeFlows>(importer).imports[good], 50);
+    EXPECT_DOUBLE_EQ(trade.GetRouteLoad().at(route), 50);
+}
+
+TEST_F(TradeFlowTest, CapacityTest) {
+    // Trade runs every tick, with a tick's share of the daily capacity
+    entt::entity route =
+        AddTradeRoute(universe, exporter, importer, 1, 20 * cqspc::StarDate::DAY, RouteType::SpacePort);
+    trade.DoSystem();
+
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::Market>(importer).supply[good], 20);
+    EXPECT_DOUBLE_EQ(trade.GetRouteLoad().at(route), 20);
+}
+
+TEST_F(TradeFlowTest, TransportCostTest) {
+    // Moving the good costs more than the difference in price
+    AddTradeRoute(universe, exporter, importer, 10, 1000, RouteType::Highway);
+    trade.DoSystem();
+
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::Market>(importer).supply[good], 0);
+    EXPECT_FALSE(universe.all_of<cqspc::TradeFlows>(exporter));
+}
+
+class ConnectCityTest : public ::testing::Test {
+ protected:
+    ConnectCityTest() : universe(game.GetUniverse()) {}
+
+    void SetUp() override {
+        earth = universe.create();
+        moon = universe.create();
+        for (entt::entity& country : countries) {
+            country = universe.create();
+            universe.emplace<cqspc::Country>(country);
+            cqsp::common::systems::economy::CreateMarket(universe, country);
+        }
+    }
+
+    entt::entity AddCity(entt::entity country, entt::entity planet, double transport) {
+        entt::entity city = universe.create();
+        universe.emplace<cqspc::Settlement>(city);
+        universe.emplace<cqspc::types::SurfaceCoordinate>(city, 0., 0.).planet = planet;
+        universe.emplace<cqspc::Governed>(city, country);
+        universe.get_or_emplace<cqspc::CountryCityList>(country).city_list.push_back(city);
+        universe.emplace<cqspc::infrastructure::CityInfrastructure>(city, transport, 0.);
+        return city;
+    }
+
+    std::vector<TradeRoute> Routes() {
+        std::vector<TradeRoute> routes;
+        for (auto [entity, route] : universe.view<TradeRoute>().each()) {
+            routes.push_back(route);
+        }
+        return routes;
+    }
+
+    cqsp::common::Game game;
+    cqsp::common::Universe& universe;
+    entt::entity earth;
+    entt::entity moon;
+    entt::entity countries[3];
+};
+
+TEST_F(ConnectCityTest, HighwayAndSpacePortTest) {
+    using cqsp::common::systems::economy::ConnectCity;
+    namespace infrastructure = cqspc::infrastructure;
+    entt::entity first = AddCity(countries[0], earth, 1);
+    entt::entity second = AddCity(countries[1], earth, 2);
+    entt::entity lunar = AddCity(countries[2], moon, 3);
+    // Same country as the first city, so it doesn't need a route to it
+    entt::entity neighbor = AddCity(countries[0], earth, 1);
+    universe.emplace<infrastructure::Highway>(first);
+    universe.emplace<infrastructure::Highway>(second);
+    universe.emplace<infrastructure::Highway>(neighbor);
+    universe.emplace<infrastructure::Highway>(lunar);
+    universe.emplace<infrastructure::SpacePort>(second);
+    universe.emplace<infrastructure::SpacePort>(lunar);
+
+    for (entt::entity city : {first, second, lunar, neighbor}) {
+        ConnectCity(universe, city);
+    }
+    std::vector<TradeRoute> routes = Routes();
+    // A highway between the countries on earth, and space ports from the second country to the moon
+    ASSERT_EQ(routes.size(), 2);
+    for (const TradeRoute& route : routes) {
+        if (route.type == RouteType::Highway) {
+            EXPECT_TRUE((route.from == countries[0] && route.to == countries[1]) ||
+                        (route.from == countries[1] && route.to == countries[0]));
+            EXPECT_DOUBLE_EQ(route.cost, 3);
+            EXPECT_DOUBLE_EQ(route.capacity, cqsp::common::systems::economy::highway_capacity);
+        } else {
+            ASSERT_EQ(route.type, RouteType::SpacePort);
+            EXPECT_TRUE((route.from == countries[1] && route.to == countries[2]) ||
+                        (route.from == countries[2] && route.to == countries[1]));
+            EXPECT_DOUBLE_EQ(route.cost, 5 + cqsp::common::systems::economy::launch_cost);
+        }
+    }
+
+    // Connecting again doesn't add the routes twice
+    ConnectCity(universe, second);
+    EXPECT_EQ(Routes().size(), 2);
+
+    // Building a space port in the first country links it to the moon
+    universe.emplace<infrastructure::SpacePort>(first);
+    ConnectCity(universe, first);
+    EXPECT_EQ(Routes().size(), 4);
+
+    // The trade network picks up the routes
+    cqsp::common::systems::SysTrade trade(game);
+    trade.DoSystem();
+    EXPECT_EQ(trade.GetNetwork().GetMarkets().size(), 3);
+}
+
+TEST(ConnectCitiesTest, LoadManyCitiesTest) {
+    // 20 countries with 25 cities each, the first 15 countries on earth and the rest on the moon
+    const int country_count = 20;
+    const int city_count = 500;
+    cqsp::common::Game game;
+    cqsp::common::Universe& universe = game.GetUniverse();
+    universe.planets["earth"] = universe.create();
+    universe.planets["moon"] = universe.create();
+    for (int i = 0; i < country_count; i++) {
+        entt::entity country = universe.create();
+        universe.emplace<cqspc::Country>(country);
+        cqsp::common::systems::economy::CreateMarket(universe, country);
+        universe.countries["country" + std::to_string(i)] = country;
+    }
+
+    std::string cities = "[";
+    for (int i = 0; i < city_count; i++) {
+        const int country = i % country_count;
+        if (i > 0) {
+            cities += ",";
+        }
+        cities += R"({"identifier": "city)" + std::to_string(i) + R"(", "country": "country)" +
+                  std::to_string(country) + R"(", "planet": ")" + (country < 15 ? "earth" : "moon") +
+                  R"(", "coordinates": {"latitude": 0, "longitude": 0}, "transport": 1, )"
+                  R"("infrastructure": {"highway": 1})";
+        // Three countries have space ports, in every one of their cities
+        if (country == 0 || country == 5 || country == 17) {
+            cities += R"(, "space-port": {"launch": 0})";
+        }
+        cities += "}";
+    }
+    cities += "]";
+
+    cqsp::common::systems::loading::CityLoader loader(universe);
+    ASSERT_EQ(loader.LoadHjson(Hjson::Unmarshal(cities)), city_count);
+
+    int highways = 0;
+    int space_ports = 0;
+    for (auto [entity, route] : universe.view<TradeRoute>().each()) {
+        (route.type == RouteType::Highway ? highways : space_ports)++;
+        EXPECT_NE(route.from, route.to);
+    }
+    // A route for every pair of countries on the same planet, and between the countries with space ports,
+    // no matter how many of their cities could make it
+    EXPECT_EQ(highways, 15 * 14 / 2 + 5 * 4 / 2);
+    EXPECT_EQ(space_ports, 3);
+}
@@ -0,0 +1,67 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/components/economy.h"
+#include "common/systems/save/autosave.h"
+#include "common/systems/save/savedcomponents.h"
+#include "common/universe.h"
+
+// How long autosaves stop the simulation, which should stay within a few milliseconds. Run with
+// --gtest_also_run_disabled_tests --gtest_filter=AutosaveBenchmark.*
+TEST(AutosaveBenchmark, DISABLED_MarketHistoryPause) {
+    namespace cqspc = cqsp::common::components;
+    namespace save = cqsp::common::systems::save;
+    cqsp::common::Universe universe;
+    std::vector<entt::entity> goods(50);
+    for (entt::entity& good : goods) {
+        good = universe.create();
+    }
+    // A few years of history in a lot of markets
+    for (int i = 0; i < 200; i++) {
+        auto& market = universe.emplace<cqspc::Market>(universe.create());
+        for (entt::entity good : goods) {
+            market.price[good] = 1;
+            market.supply[good] = 1;
+        }
+        market.history.assign(1000, market);
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "cqsp_autosave_benchmark.cqsave").string();
+    {
+        save::AutoSaver autosaver(universe, path, 1000);
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+        std::cout << "First autosave: " << autosaver.GetLastPause() << " ms\n";
+
+        // A day passes in every market, like SysMarketHistory does
+        for (auto [entity, market] : universe.view<cqspc::Market>().each()) {
+            market.history.push_back(market);
+            save::MarkDirty<cqspc::Market>(universe, entity);
+        }
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+        std::cout << "Autosave after a day: " << autosaver.GetLastPause() << " ms\n";
+    }
+    std::filesystem::remove(save::GetDeltaPath(path, 1));
+    std::filesystem::remove(path);
+}
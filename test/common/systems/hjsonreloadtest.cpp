@@ -0,0 +1,49 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include "common/components/economy.h"
+#include "common/components/resource.h"
+#include "common/systems/loading/loadgoods.h"
+#include "common/universe.h"
+
+TEST(Common_Loading_Reload, GoodReloadTest) {
+    namespace cqspc = cqsp::common::components;
+    cqsp::common::Universe universe;
+    cqsp::common::systems::loading::GoodLoader loader(universe);
+    ASSERT_TRUE(loader.CanReload());
+
+    Hjson::Value goods = Hjson::Unmarshal(R"([
+        { identifier: steel, name: Steel, price: 10, tags: ["mineral"] }
+    ])");
+    ASSERT_EQ(loader.LoadHjson(goods), 1);
+    entt::entity steel = universe.goods["steel"];
+    ASSERT_TRUE(universe.all_of<cqspc::Mineral>(steel));
+
+    Hjson::Value changed = Hjson::Unmarshal(R"([
+        { identifier: steel, name: Steel, price: 15 }
+        { identifier: copper, name: Copper, price: 5 }
+    ])");
+    EXPECT_EQ(loader.ReloadHjson(changed), 2);
+
+    // Loaded into the same entity, without anything from the old values
+    EXPECT_EQ(universe.goods["steel"], steel);
+    EXPECT_DOUBLE_EQ(universe.get<cqspc::Price>(steel).price, 15);
+    EXPECT_FALSE(universe.all_of<cqspc::Mineral>(steel));
+    ASSERT_EQ(universe.goods.count("copper"), 1);
+    EXPECT_NE(universe.goods["copper"], steel);
+}
@@ -0,0 +1,47 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include "common/components/name.h"
+#include "common/components/organizations.h"
+#include "common/components/surface.h"
+#include "common/systems/loading/loadprovinces.h"
+#include "common/universe.h"
+
+TEST(Common_Loading_Provinces, LoadProvincesTest) {
+    namespace cqspc = cqsp::common::components;
+    cqsp::common::Universe universe;
+    entt::entity country = universe.create();
+    universe.countries["usa"] = country;
+
+    cqsp::common::systems::loading::LoadProvinces(universe,
+                                                  "ohio,10,20,30,usa\r\n"
+                                                  "\n"
+                                                  "atlantis,1,2,3,nowhere\n"
+                                                  "broken,a,b,c,usa\n");
+    ASSERT_EQ(universe.provinces.size(), 2);
+
+    entt::entity ohio = universe.provinces["ohio"];
+    EXPECT_EQ(universe.get<cqspc::Province>(ohio).country, country);
+    EXPECT_EQ(universe.get<cqspc::Identifier>(ohio).identifier, "ohio");
+    EXPECT_EQ(universe.province_colors[cqspc::ProvinceColor::toInt(10, 20, 30)], ohio);
+    ASSERT_EQ(universe.get<cqspc::CountryCityList>(country).province_list.size(), 1);
+
+    // Unknown countries don't get made
+    EXPECT_EQ(universe.get<cqspc::Province>(universe.provinces["atlantis"]).country, entt::null);
+    EXPECT_EQ(universe.countries.size(), 1);
+}
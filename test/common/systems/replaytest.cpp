@@ -0,0 +1,156 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+#include <hjson.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common/components/coordinates.h"
+#include "common/components/name.h"
+#include "common/game.h"
+#include "common/systems/commands/commands.h"
+#include "common/systems/commands/replay.h"
+#include "common/systems/save/savegame.h"
+
+namespace cqspt = cqsp::common::components::types;
+namespace commands = cqsp::common::systems::commands;
+namespace save = cqsp::common::systems::save;
+
+class ReplayTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        cqsp::common::Universe& universe = game.GetUniverse();
+        planet = universe.create();
+        universe.emplace<cqspt::Orbit>(planet).semi_major_axis = 100;
+        universe.planets["earth"] = planet;
+        AddNameGenerator(game);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+        std::filesystem::remove(commands::GetLogPath(path));
+    }
+
+    /// Name generators are loaded from scripts, and aren't saved
+    static void AddNameGenerator(cqsp::common::Game& game) {
+        cqsp::common::Universe& universe = game.GetUniverse();
+        Hjson::Value value = Hjson::UnmarshalFromFile("../data/core/data/names/name_gen_test.hjson");
+        auto& generator = universe.name_generators["Town Names"];
+        generator.LoadNameGenerator(value[0]);
+        generator.SetRandom(universe.random.get());
+    }
+
+    /// A tick that depends on the random generator, so that a replay only matches if the generator does
+    static void Tick(cqsp::common::Game& game, entt::entity planet) {
+        cqsp::common::Universe& universe = game.GetUniverse();
+        universe.date.IncrementDate();
+        universe.get<cqspt::Orbit>(planet).semi_major_axis += universe.random->GetRandomInt(0, 10);
+    }
+
+    /// Plays a game from a recording, issuing commands on some of the dates
+    void Record() {
+        cqsp::common::Universe& universe = game.GetUniverse();
+        ASSERT_TRUE(commands::StartRecording(universe, path));
+        for (int i = 0; i < ticks; i++) {
+            Tick(game, planet);
+            commands::RecordChecksum(universe);
+            if (i == 10 || i == 30) {
+                cities.push_back(commands::Issue(game, commands::FoundCity {planet, 0.5 * i, 1.}));
+            }
+            if (i == 20) {
+                commands::Issue(game, commands::AddImpulse {planet, {0, 1, 0}});
+            }
+        }
+        end_date = universe.GetDate();
+        end_checksum = commands::Checksum(universe);
+        ASSERT_TRUE(commands::StopRecording(universe, path));
+        EXPECT_FALSE(commands::IsRecording(universe));
+    }
+
+    commands::ReplayResult Replay(commands::CommandLog& log) {
+        cqsp::common::Universe& universe = replayed.GetUniverse();
+        EXPECT_TRUE(save::LoadUniverse(universe, path));
+        AddNameGenerator(replayed);
+        return commands::Replay(replayed, log, end_date, [this]() { Tick(replayed, planet); });
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "cqsp_replay_test.cqsave").string();
+    const int ticks = 50;
+
+    cqsp::common::Game game;
+    cqsp::common::Game replayed;
+    entt::entity planet;
+    std::vector<entt::entity> cities;
+    int end_date = 0;
+    uint64_t end_checksum = 0;
+};
+
+TEST_F(ReplayTest, ReplayMatchesRecording) {
+    Record();
+    commands::CommandLog log;
+    ASSERT_TRUE(commands::ReadLog(commands::GetLogPath(path), log));
+    ASSERT_EQ(log.entries.size(), 3);
+    EXPECT_EQ(log.checksums.size(), ticks + 1);
+
+    commands::ReplayResult result = Replay(log);
+    EXPECT_FALSE(result.Desynced());
+    EXPECT_EQ(result.checked, ticks + 1);
+
+    cqsp::common::Universe& universe = replayed.GetUniverse();
+    EXPECT_EQ(universe.GetDate(), end_date);
+    EXPECT_EQ(commands::Checksum(universe), end_checksum);
+    for (entt::entity city : cities) {
+        ASSERT_TRUE(universe.valid(city));
+        EXPECT_EQ(universe.get<cqsp::common::components::Name>(city).name,
+                  game.GetUniverse().get<cqsp::common::components::Name>(city).name);
+    }
+    EXPECT_EQ(universe.get<cqspt::Impulse>(planet).impulse.y, 1);
+}
+
+TEST_F(ReplayTest, ReplayFindsDesync) {
+    Record();
+    commands::CommandLog log;
+    ASSERT_TRUE(commands::ReadLog(commands::GetLogPath(path), log));
+    // Drop the impulse, so everything after it differs
+    int dropped_tick = log.entries[1].tick;
+    log.entries.erase(log.entries.begin() + 1);
+
+    commands::ReplayResult result = Replay(log);
+    EXPECT_TRUE(result.Desynced());
+    // Commands run after the checksum of their date, so the first difference is on the date after
+    EXPECT_EQ(result.desync_date, dropped_tick + 1);
+}
+
+TEST_F(ReplayTest, BrokenLog) {
+    {
+        std::ofstream output(commands::GetLogPath(path), std::ios::binary);
+        output << "CQLG garbage";
+    }
+    commands::CommandLog log;
+    EXPECT_FALSE(commands::ReadLog(commands::GetLogPath(path), log));
+}
+
+TEST(SeededRandomTest, SameSeedSameNumbers) {
+    cqsp::common::Universe first(7);
+    cqsp::common::Universe second(7);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(first.random->GetRandomInt(0, 1000000), second.random->GetRandomInt(0, 1000000));
+    }
+}
@@ -0,0 +1,238 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+
+#include "common/components/bodies.h"
+#include "common/components/coordinates.h"
+#include "common/components/economy.h"
+#include "common/components/name.h"
+#include "common/components/resource.h"
+#include "common/systems/save/autosave.h"
+#include "common/systems/save/savedcomponents.h"
+#include "common/systems/save/savegame.h"
+#include "common/universe.h"
+
+namespace cqspc = cqsp::common::components;
+namespace cqspb = cqsp::common::components::bodies;
+namespace cqspt = cqsp::common::components::types;
+
+class SaveGameTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        good = universe.create();
+        universe.emplace<cqspc::Name>(good, "Steel");
+        universe.emplace<cqspc::Good>(good);
+        universe.goods["steel"] = good;
+
+        // A destroyed entity, so that the entity versions are saved too
+        universe.destroy(universe.create());
+
+        planet = universe.create();
+        universe.emplace<cqspb::Planet>(planet);
+        universe.emplace<cqspt::Orbit>(planet).semi_major_axis = 1.5;
+        auto& stockpile = universe.emplace<cqspc::ResourceStockpile>(planet);
+        stockpile[good] = 120;
+        auto& market = universe.emplace<cqspc::Market>(planet);
+        market.price[good] = 10;
+        market[good].supply = 40;
+        market.participants.insert(good);
+        market.history.push_back(market);
+        universe.planets["earth"] = planet;
+
+        for (int i = 0; i < 30; i++) {
+            universe.date.IncrementDate();
+        }
+        universe.random->GetRandomInt(0, 100);
+    }
+
+    void RoundTrip(bool compress) {
+        std::stringstream stream;
+        ASSERT_TRUE(cqsp::common::systems::save::SaveUniverse(universe, stream, compress));
+        ASSERT_TRUE(cqsp::common::systems::save::LoadUniverse(loaded, stream));
+    }
+
+    void ExpectSame() {
+        EXPECT_EQ(loaded.GetDate(), universe.GetDate());
+        EXPECT_EQ(loaded.random->GetRandomInt(0, 1000000), universe.random->GetRandomInt(0, 1000000));
+        EXPECT_EQ(loaded.goods, universe.goods);
+        EXPECT_EQ(loaded.planets, universe.planets);
+
+        ASSERT_TRUE(loaded.valid(good));
+        ASSERT_TRUE(loaded.valid(planet));
+        EXPECT_EQ(loaded.get<cqspc::Name>(good).name, "Steel");
+        EXPECT_TRUE(loaded.all_of<cqspc::Good>(good));
+        EXPECT_TRUE(loaded.all_of<cqspb::Planet>(planet));
+        EXPECT_FALSE(loaded.all_of<cqspb::Planet>(good));
+        EXPECT_EQ(loaded.get<cqspt::Orbit>(planet).semi_major_axis, 1.5);
+        EXPECT_EQ(loaded.get<cqspc::ResourceStockpile>(planet)[good], 120);
+
+        auto& market = loaded.get<cqspc::Market>(planet);
+        EXPECT_EQ(market.price[good], 10);
+        EXPECT_EQ(market[good].supply, 40);
+        EXPECT_EQ(market.participants.count(good), 1);
+        ASSERT_EQ(market.history.size(), 1);
+        EXPECT_EQ(market.history[0].price[good], 10);
+
+        // New entities should not reuse the saved ones
+        entt::entity created = loaded.create();
+        EXPECT_NE(created, good);
+        EXPECT_NE(created, planet);
+    }
+
+    cqsp::common::Universe universe;
+    cqsp::common::Universe loaded;
+    entt::entity good;
+    entt::entity planet;
+};
+
+TEST_F(SaveGameTest, CompressedRoundTrip) {
+    RoundTrip(true);
+    ExpectSame();
+}
+
+TEST_F(SaveGameTest, UncompressedRoundTrip) {
+    RoundTrip(false);
+    ExpectSame();
+}
+
+TEST_F(SaveGameTest, LoadReplacesUniverse) {
+    entt::entity leftover = loaded.create();
+    loaded.emplace<cqspc::Name>(leftover, "Leftover");
+    loaded.countries["leftover"] = leftover;
+    RoundTrip(true);
+    EXPECT_TRUE(loaded.countries.empty());
+    EXPECT_EQ(loaded.view<cqspc::Name>().size(), 1);
+}
+
+TEST_F(SaveGameTest, TruncatedSave) {
+    std::stringstream stream;
+    ASSERT_TRUE(cqsp::common::systems::save::SaveUniverse(universe, stream, false));
+    std::string data = stream.str();
+    std::stringstream truncated(data.substr(0, data.size() - 8));
+    EXPECT_FALSE(cqsp::common::systems::save::LoadUniverse(loaded, truncated));
+
+    std::stringstream garbage("not a save at all");
+    EXPECT_FALSE(cqsp::common::systems::save::LoadUniverse(loaded, garbage));
+}
+
+TEST_F(SaveGameTest, MoveUniverse) {
+    namespace save = cqsp::common::systems::save;
+    cqsp::common::Universe target;
+    target.name_generators["test"] = cqsp::common::systems::names::NameGenerator();
+    target.goods["leftover"] = target.create();
+
+    // A save that fails to load doesn't touch the universe that it would have replaced
+    std::stringstream garbage("not a save at all");
+    EXPECT_FALSE(save::LoadUniverse(loaded, garbage));
+    EXPECT_EQ(target.goods.count("leftover"), 1);
+
+    RoundTrip(true);
+    save::MoveUniverse(loaded, target);
+    EXPECT_EQ(target.goods, universe.goods);
+    EXPECT_EQ(target.planets, universe.planets);
+    EXPECT_EQ(target.GetDate(), universe.GetDate());
+    EXPECT_EQ(target.random->GetRandomInt(0, 1000000), universe.random->GetRandomInt(0, 1000000));
+    EXPECT_EQ(target.get<cqspc::Name>(good).name, "Steel");
+    EXPECT_EQ(target.get<cqspc::Market>(planet).price[good], 10);
+    // Isn't saved, so it is kept
+    EXPECT_EQ(target.name_generators.count("test"), 1);
+}
+
+TEST_F(SaveGameTest, AutosaveDeltas) {
+    namespace save = cqsp::common::systems::save;
+    std::string path = (std::filesystem::temp_directory_path() / "cqsp_autosave_test.cqsave").string();
+    {
+        save::AutoSaver autosaver(universe, path, 2);
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+
+        // Changed in place, so it has to be marked
+        universe.get<cqspc::Market>(planet).price[good] = 25;
+        save::MarkDirty<cqspc::Market>(universe);
+        // Not tracked, so it is copied anyway
+        universe.get<cqspc::ResourceStockpile>(planet)[good] = 60;
+        // Tracked through the registry
+        entt::entity city = universe.create();
+        universe.emplace<cqspc::Name>(city, "City");
+        universe.date.IncrementDate();
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+        EXPECT_TRUE(std::filesystem::exists(save::GetDeltaPath(path, 1)));
+
+        ASSERT_TRUE(save::LoadUniverse(loaded, path));
+        EXPECT_EQ(loaded.GetDate(), universe.GetDate());
+        EXPECT_EQ(loaded.get<cqspc::Market>(planet).price[good], 25);
+        EXPECT_EQ(loaded.get<cqspc::ResourceStockpile>(planet)[good], 60);
+        EXPECT_EQ(loaded.get<cqspc::Name>(city).name, "City");
+        EXPECT_EQ(loaded.get<cqspc::Name>(good).name, "Steel");
+
+        // After two deltas, the next save writes everything again and removes the deltas
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+        EXPECT_TRUE(std::filesystem::exists(save::GetDeltaPath(path, 2)));
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+        EXPECT_FALSE(std::filesystem::exists(save::GetDeltaPath(path, 1)));
+        EXPECT_FALSE(std::filesystem::exists(save::GetDeltaPath(path, 2)));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_F(SaveGameTest, AutosaveMarkedEntities) {
+    namespace save = cqsp::common::systems::save;
+    std::string path = (std::filesystem::temp_directory_path() / "cqsp_autosave_entity_test.cqsave").string();
+    entt::entity other = universe.create();
+    universe.emplace<cqspc::Market>(other).price[good] = 5;
+    {
+        save::AutoSaver autosaver(universe, path, 5);
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+
+        // Only the marked market is copied again
+        auto& market = universe.get<cqspc::Market>(planet);
+        market.price[good] = 25;
+        market.history.push_back(market);
+        save::MarkDirty<cqspc::Market>(universe, planet);
+        universe.get<cqspc::Market>(other).price[good] = 50;
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+
+        ASSERT_TRUE(save::LoadUniverse(loaded, path));
+        auto& loaded_market = loaded.get<cqspc::Market>(planet);
+        EXPECT_EQ(loaded_market.price[good], 25);
+        ASSERT_EQ(loaded_market.history.size(), 2);
+        EXPECT_EQ(loaded_market.history[0].price[good], 10);
+        EXPECT_EQ(loaded_market.history[1].price[good], 25);
+        EXPECT_EQ(loaded.get<cqspc::Market>(other).price[good], 5);
+
+        // Removed components are removed from the copy too
+        universe.remove<cqspc::Market>(other);
+        ASSERT_TRUE(autosaver.Save());
+        autosaver.Wait();
+        ASSERT_TRUE(save::LoadUniverse(loaded, path));
+        EXPECT_FALSE(loaded.all_of<cqspc::Market>(other));
+        EXPECT_EQ(loaded.get<cqspc::Market>(planet).history.size(), 2);
+    }
+    for (int delta = 1; delta <= 2; delta++) {
+        std::filesystem::remove(save::GetDeltaPath(path, delta));
+    }
+    std::filesystem::remove(path);
+}
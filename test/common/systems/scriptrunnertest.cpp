@@ -0,0 +1,168 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "common/game.h"
+#include "common/systems/scriptrunner.h"
+
+class ScriptRunnerTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        script().RegisterDataGroup("events");
+        script().RunScript(R"(
+            counter = { runs = 0 }
+            function counter:on_tick()
+                self.runs = self.runs + 1
+                return date + 10
+            end
+            events:insert(counter)
+
+            sleeper = { runs = 0 }
+            function sleeper:on_tick()
+                self.runs = self.runs + 1
+                return false
+            end
+            events:insert(sleeper)
+
+            looper = { runs = 0, budget = 10000 }
+            function looper:on_tick()
+                self.runs = self.runs + 1
+                while true do end
+            end
+            events:insert(looper)
+        )");
+    }
+
+    void Tick(cqsp::common::systems::SysScript& runner, int ticks) {
+        for (int i = 0; i < ticks; i++) {
+            game.GetUniverse().date.IncrementDate();
+            runner.DoSystem();
+        }
+    }
+
+    int Runs(const char* event) { return script()[event]["runs"].get<int>(); }
+
+    cqsp::scripting::ScriptInterface& script() { return game.GetScriptInterface(); }
+
+    cqsp::common::Game game;
+};
+
+TEST_F(ScriptRunnerTest, EventsRunWhenDue) {
+    cqsp::common::systems::SysScript runner(game);
+    Tick(runner, 25);
+    // Runs on the first tick, then every 10 ticks
+    EXPECT_EQ(Runs("counter"), 3);
+    EXPECT_EQ(Runs("sleeper"), 1);
+
+    script().RunScript("events:wake(sleeper)");
+    Tick(runner, 1);
+    EXPECT_EQ(Runs("sleeper"), 2);
+
+    int date = game.GetUniverse().GetDate();
+    script().RunScript("events:wake(sleeper, " + std::to_string(date + 5) + ")");
+    Tick(runner, 4);
+    EXPECT_EQ(Runs("sleeper"), 2);
+    Tick(runner, 1);
+    EXPECT_EQ(Runs("sleeper"), 3);
+}
+
+TEST_F(ScriptRunnerTest, BudgetStopsEvent) {
+    cqsp::common::systems::SysScript runner(game);
+    Tick(runner, 5);
+    // The looping event is stopped, and sleeps after it runs out of its budget
+    EXPECT_EQ(Runs("looper"), 1);
+    EXPECT_FALSE(script().values.empty());
+    EXPECT_EQ(Runs("counter"), 1);
+}
+
+TEST_F(ScriptRunnerTest, ScheduleIsKept) {
+    {
+        cqsp::common::systems::SysScript runner(game);
+        Tick(runner, 5);
+    }
+    // The counter runs next on date 11, the others are asleep
+    auto& wake_dates = game.GetUniverse().event_wake_dates;
+    EXPECT_EQ(wake_dates["0"], 11);
+    EXPECT_EQ(wake_dates["1"], -1);
+    EXPECT_EQ(wake_dates["2"], -1);
+
+    // Like after loading the universe, the events run on the dates that they were saved with
+    cqsp::common::systems::SysScript runner(game);
+    Tick(runner, 5);
+    EXPECT_EQ(Runs("counter"), 1);
+    EXPECT_EQ(Runs("sleeper"), 1);
+    Tick(runner, 1);
+    EXPECT_EQ(Runs("counter"), 2);
+    EXPECT_EQ(Runs("looper"), 1);
+}
+
+namespace {
+class MemoryBytecodeCache : public cqsp::scripting::IBytecodeCache {
+ public:
+    bool Load(const std::string& name, std::string_view source, std::string& bytecode) override {
+        loads++;
+        auto entry = entries.find(name);
+        if (entry == entries.end() || entry->second.first != source) {
+            return false;
+        }
+        bytecode = entry->second.second;
+        return true;
+    }
+
+    void Save(const std::string& name, std::string_view source, const std::string& bytecode) override {
+        entries[name] = {std::string(source), bytecode};
+    }
+
+    std::map<std::string, std::pair<std::string, std::string>> entries;
+    int loads = 0;
+};
+}  // namespace
+
+TEST(ScriptBytecodeTest, RequireUsesCachedBytecode) {
+    MemoryBytecodeCache cache;
+    const std::string code = "required = (required or 0) + 1\nreturn { value = 5 }";
+    {
+        cqsp::scripting::ScriptInterface script;
+        script.SetBytecodeCache(&cache);
+        sol::table module = script.RequireScript("test.module", code).as<sol::table>();
+        EXPECT_EQ(module["value"].get<int>(), 5);
+        // Only runs once
+        script.RequireScript("test.module", code);
+        EXPECT_EQ(script["required"].get<int>(), 1);
+        ASSERT_EQ(cache.entries.count("test.module"), 1);
+    }
+    {
+        // A new state loads the bytecode from the cache instead of compiling it
+        cqsp::scripting::ScriptInterface script;
+        script.SetBytecodeCache(&cache);
+        sol::load_result chunk = script.LoadScript("test.module", code);
+        ASSERT_TRUE(chunk.valid());
+        EXPECT_EQ(cache.loads, 2);
+    }
+    {
+        // Changed source is compiled again
+        cqsp::scripting::ScriptInterface script;
+        script.SetBytecodeCache(&cache);
+        sol::table module = script.RequireScript("test.module", "return { value = 6 }").as<sol::table>();
+        EXPECT_EQ(module["value"].get<int>(), 6);
+    }
+}
@@ -0,0 +1,183 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "common/util/noisemapbuilder.h"
+
+namespace {
+noise::module::Perlin MakeTestModule() {
+    noise::module::Perlin module;
+    module.SetOctaveCount(3);
+    module.SetNoiseQuality(noise::QUALITY_FAST);
+    module.SetSeed(1234);
+    module.SetFrequency(2);
+    return module;
+}
+}  // namespace
+
+TEST(NoiseMapBuilderTest, ThreadCountTest) {
+    auto module = MakeTestModule();
+    noise::utils::NoiseMap single;
+    noise::utils::NoiseMap multi;
+    cqsp::common::util::BuildSphereNoiseMap(module, single, 64, 64, 1);
+    cqsp::common::util::BuildSphereNoiseMap(module, multi, 64, 64, 5);
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            ASSERT_EQ(single.GetValue(x, y), multi.GetValue(x, y));
+        }
+    }
+}
+
+TEST(NoiseMapBuilderTest, MatchesSphereBuilderTest) {
+    auto module = MakeTestModule();
+    noise::utils::NoiseMap expected;
+    noise::utils::NoiseMapBuilderSphere builder;
+    builder.SetSourceModule(module);
+    builder.SetDestNoiseMap(expected);
+    builder.SetDestSize(64, 32);
+    builder.SetBounds(-90.0, 90.0, -180.0, 180.0);
+    builder.Build();
+
+    noise::utils::NoiseMap result;
+    cqsp::common::util::BuildSphereNoiseMap(module, result, 64, 32, 4);
+    ASSERT_EQ(result.GetWidth(), 64);
+    ASSERT_EQ(result.GetHeight(), 32);
+    for (int y = 0; y < 32; y++) {
+        for (int x = 0; x < 64; x++) {
+            // The builder accumulates the coordinates, so it can differ slightly
+            EXPECT_NEAR(expected.GetValue(x, y), result.GetValue(x, y), 1e-4);
+        }
+    }
+}
+
+TEST(NoiseMapBuilderTest, TiledSizeTest) {
+    // Sizes that are not a multiple of the tile size
+    auto module = MakeTestModule();
+    noise::utils::NoiseMap single;
+    noise::utils::NoiseMap tiled;
+    const int width = cqsp::common::util::noise_map_tile_size * 2 + 7;
+    const int height = cqsp::common::util::noise_map_tile_size + 3;
+    cqsp::common::util::BuildSphereNoiseMap(module, single, width, height, 1);
+    cqsp::common::util::BuildSphereNoiseMap(module, tiled, width, height, 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            ASSERT_EQ(single.GetValue(x, y), tiled.GetValue(x, y));
+        }
+    }
+}
+
+TEST(NoiseMapBuilderTest, CacheTest) {
+    cqsp::common::util::NoiseMapCache cache("", 2);
+    int generated = 0;
+    auto generate = [&](noise::utils::NoiseMap& map) {
+        generated++;
+        map.SetSize(4, 4);
+        map.SetValue(1, 1, static_cast<float>(generated));
+    };
+
+    auto first = cache.Get(1, 3, 2, generate);
+    EXPECT_EQ(generated, 1);
+    EXPECT_EQ(cache.Get(1, 3, 2, generate), first);
+    EXPECT_EQ(generated, 1);
+
+    // Different keys are generated again
+    cache.Get(2, 3, 2, generate);
+    cache.Get(1, 4, 2, generate);
+    EXPECT_EQ(generated, 3);
+
+    // Only the two most recently used maps stay
+    EXPECT_EQ(cache.GetSize(), 2);
+    EXPECT_FALSE(cache.Contains(1, 3, 2));
+    EXPECT_TRUE(cache.Contains(1, 4, 2));
+}
+
+TEST(NoiseMapBuilderTest, ConcurrentCacheTest) {
+    cqsp::common::util::NoiseMapCache cache;
+    std::atomic_int generated = 0;
+    std::atomic_int building = 0;
+    std::atomic_int overlapped = 0;
+    auto generate = [&](noise::utils::NoiseMap& map) {
+        generated++;
+        building++;
+        // Wait a bit for the other thread, which can only get here if the lock isn't held while building
+        for (int i = 0; i < 200 && building < 2; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (building == 2) {
+            overlapped++;
+        }
+        map.SetSize(4, 4);
+        building--;
+    };
+
+    // Different maps are built at the same time
+    std::thread first([&]() { cache.Get(1, 3, 2, generate); });
+    std::thread second([&]() { cache.Get(2, 3, 2, generate); });
+    first.join();
+    second.join();
+    EXPECT_EQ(generated, 2);
+    EXPECT_GT(overlapped, 0);
+
+    // The same map is only built once, the other threads wait for it
+    std::vector<std::thread> threads;
+    std::vector<std::shared_ptr<const noise::utils::NoiseMap>> results(4);
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&, i]() { results[i] = cache.Get(3, 3, 2, generate); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(generated, 3);
+    for (auto& result : results) {
+        EXPECT_EQ(result, results[0]);
+    }
+}
+
+TEST(NoiseMapBuilderTest, DiskCacheTest) {
+    auto directory = std::filesystem::temp_directory_path() / "cqsp_noise_cache_test";
+    std::filesystem::remove_all(directory);
+
+    int generated = 0;
+    auto generate = [&](noise::utils::NoiseMap& map) {
+        generated++;
+        map.SetSize(8, 4);
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 8; x++) {
+                map.SetValue(x, y, x * 0.5f - y);
+            }
+        }
+    };
+    {
+        cqsp::common::util::NoiseMapCache cache(directory.string());
+        cache.Get(5, 2, 3, generate);
+    }
+    cqsp::common::util::NoiseMapCache cache(directory.string());
+    auto map = cache.Get(5, 2, 3, generate);
+    EXPECT_EQ(generated, 1);
+    ASSERT_EQ(map->GetWidth(), 8);
+    ASSERT_EQ(map->GetHeight(), 4);
+    EXPECT_FLOAT_EQ(map->GetValue(6, 3), 0.f);
+    EXPECT_FLOAT_EQ(map->GetValue(3, 1), 0.5f);
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,84 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "common/util/parallel.h"
+
+TEST(ParallelTest, ParallelForRangeTest) {
+    std::atomic_int sum = 0;
+    std::atomic_int calls = 0;
+    cqsp::common::util::ParallelForRange(1000, 7, [&](int begin, int end) {
+        calls++;
+        for (int i = begin; i < end; i++) {
+            sum += i;
+        }
+    });
+    EXPECT_EQ(sum, 999 * 1000 / 2);
+    EXPECT_EQ(calls, 7);
+
+    // More threads than work
+    calls = 0;
+    cqsp::common::util::ParallelForRange(3, 16, [&](int begin, int end) { calls++; });
+    EXPECT_EQ(calls, 3);
+}
+
+TEST(ParallelTest, ParallelForEachTest) {
+    std::vector<std::atomic_int> visits(100);
+    cqsp::common::util::ParallelForEach(100, 4, [&](int index) { visits[index]++; });
+    for (auto& visit : visits) {
+        EXPECT_EQ(visit, 1);
+    }
+
+    // Nothing to do
+    cqsp::common::util::ParallelForEach(0, 4, [&](int index) { FAIL(); });
+}
+
+TEST(ParallelTest, NestedTest) {
+    // Calls from inside the pool run on the same pool, and must not wait on each other
+    std::atomic_int count = 0;
+    for (int repeat = 0; repeat < 100; repeat++) {
+        cqsp::common::util::ParallelForEach(16, 0, [&](int) {
+            cqsp::common::util::ParallelForEach(16, 0, [&](int) { count++; });
+        });
+    }
+    EXPECT_EQ(count, 100 * 16 * 16);
+}
+
+TEST(ParallelTest, ExceptionTest) {
+    // Half of the ranges throw, both on the calling thread and on the workers
+    for (int repeat = 0; repeat < 100; repeat++) {
+        std::atomic_int calls = 0;
+        auto func = [&](int begin, int end) {
+            calls++;
+            if (begin % 16 == 0) {
+                throw std::runtime_error("range failed");
+            }
+        };
+        EXPECT_THROW(cqsp::common::util::ParallelForRange(64, 8, func), std::runtime_error);
+        // The other ranges still ran
+        EXPECT_EQ(calls, 8);
+    }
+
+    // The pool still works after that
+    std::atomic_int count = 0;
+    cqsp::common::util::ParallelForEach(100, 0, [&](int) { count++; });
+    EXPECT_EQ(count, 100);
+}
@@ -0,0 +1,149 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "engine/asset/assetcache.h"
+
+class AssetCacheTest : public ::testing::Test {
+ protected:
+    void SetUp() {
+        directory = std::filesystem::temp_directory_path() / "cqsp_asset_cache_test";
+        std::filesystem::remove_all(directory);
+        cache.SetDirectory(directory.string());
+    }
+
+    void TearDown() { std::filesystem::remove_all(directory); }
+
+    std::filesystem::path directory;
+    cqsp::asset::AssetCache cache;
+};
+
+TEST_F(AssetCacheTest, HjsonRoundTripTest) {
+    Hjson::Value value = Hjson::Unmarshal(R"({
+        name: test
+        count: 15
+        ratio: 0.25
+        enabled: true
+        nothing: null
+        list: [1, "two", 3.5, [false]]
+        nested: { b: 1, a: 2 }
+    })");
+    std::vector<uint8_t> data;
+    cqsp::asset::AssetCache::SerializeHjson(value, data);
+
+    size_t position = 0;
+    Hjson::Value result;
+    ASSERT_TRUE(cqsp::asset::AssetCache::DeserializeHjson(data, position, result));
+    EXPECT_EQ(position, data.size());
+    EXPECT_EQ(Hjson::Marshal(value), Hjson::Marshal(result));
+    EXPECT_EQ(result["count"].type(), Hjson::Type::Int64);
+    EXPECT_EQ(result["ratio"].type(), Hjson::Type::Double);
+    // Keeps the insertion order
+    EXPECT_EQ(result["nested"].key(0), "b");
+
+    // Truncated data is rejected
+    data.resize(data.size() / 2);
+    position = 0;
+    EXPECT_FALSE(cqsp::asset::AssetCache::DeserializeHjson(data, position, result));
+}
+
+TEST_F(AssetCacheTest, HjsonCacheTest) {
+    std::string source = "{ a: 1 }";
+    Hjson::Value value;
+    EXPECT_FALSE(cache.LoadHjson("core/test.hjson", source, value));
+
+    cache.SaveHjson("core/test.hjson", source, Hjson::Unmarshal(source));
+    ASSERT_TRUE(cache.LoadHjson("core/test.hjson", source, value));
+    EXPECT_EQ(value["a"].to_int64(), 1);
+
+    // Changing the source invalidates the entry
+    EXPECT_FALSE(cache.LoadHjson("core/test.hjson", "{ a: 2 }", value));
+}
+
+TEST_F(AssetCacheTest, ImageCacheTest) {
+    std::vector<uint8_t> source = {1, 2, 3, 4};
+    std::vector<unsigned char> pixels = {10, 20, 30, 40, 50, 60};
+    cache.SaveImage("core/image.png", source, pixels.data(), 2, 1, 3);
+
+    cqsp::asset::CachedImage image;
+    ASSERT_TRUE(cache.LoadImage("core/image.png", source, image));
+    EXPECT_EQ(image.width, 2);
+    EXPECT_EQ(image.height, 1);
+    EXPECT_EQ(image.components, 3);
+    EXPECT_EQ(image.pixels, pixels);
+
+    source[0] = 5;
+    EXPECT_FALSE(cache.LoadImage("core/image.png", source, image));
+    // Other keys are not affected
+    std::vector<uint8_t> other = {1, 2, 3, 4};
+    EXPECT_FALSE(cache.LoadImage("core/other.png", other, image));
+}
+
+TEST_F(AssetCacheTest, KeyedHashTest) {
+    // Test vectors from the SipHash paper, with the key 00 01 02 .. 0f and the message 00 01 02 ..
+    std::array<uint64_t, 2> key = {0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull};
+    std::vector<uint8_t> message(64);
+    for (size_t i = 0; i < message.size(); i++) {
+        message[i] = static_cast<uint8_t>(i);
+    }
+    EXPECT_EQ(cqsp::asset::AssetCache::KeyedHash(key, message.data(), 0), 0x726fdb47dd0e0e31ull);
+    EXPECT_EQ(cqsp::asset::AssetCache::KeyedHash(key, message.data(), 15), 0xa129ca6149be45e5ull);
+    EXPECT_EQ(cqsp::asset::AssetCache::KeyedHash(key, message.data(), 63), 0x958a324ceb064572ull);
+}
+
+TEST_F(AssetCacheTest, BytecodeCacheTest) {
+    std::string bytecode;
+    cache.SaveBytecode("test.module", "return 1", "5.1", "compiled");
+    ASSERT_TRUE(cache.LoadBytecode("test.module", "return 1", "5.1", bytecode));
+    EXPECT_EQ(bytecode, "compiled");
+    EXPECT_FALSE(cache.LoadBytecode("test.module", "return 2", "5.1", bytecode));
+    EXPECT_FALSE(cache.LoadBytecode("test.module", "return 1", "5.2", bytecode));
+
+    // Bytecode that another cache signed is not trusted
+    std::filesystem::path other_directory = directory.string() + "_other";
+    {
+        cqsp::asset::AssetCache other(other_directory.string());
+        other.SaveBytecode("test.module", "return 1", "5.1", "tampered");
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(other_directory)) {
+        if (entry.path().extension() == ".luac") {
+            std::filesystem::copy_file(entry.path(), directory / entry.path().filename(),
+                                       std::filesystem::copy_options::overwrite_existing);
+        }
+    }
+    std::filesystem::remove_all(other_directory);
+    EXPECT_FALSE(cache.LoadBytecode("test.module", "return 1", "5.1", bytecode));
+
+    // The key is kept, so a new cache in the same directory trusts what this one wrote
+    cache.SaveBytecode("test.module", "return 1", "5.1", "compiled");
+    cqsp::asset::AssetCache reopened(directory.string());
+    ASSERT_TRUE(reopened.LoadBytecode("test.module", "return 1", "5.1", bytecode));
+    EXPECT_EQ(bytecode, "compiled");
+}
+
+TEST_F(AssetCacheTest, DisabledTest) {
+    cqsp::asset::AssetCache disabled;
+    EXPECT_FALSE(disabled.IsEnabled());
+    disabled.SaveHjson("core/test.hjson", "{}", Hjson::Value());
+    Hjson::Value value;
+    EXPECT_FALSE(disabled.LoadHjson("core/test.hjson", "{}", value));
+}
@@ -0,0 +1,134 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "engine/asset/assetmanager.h"
+#include "engine/asset/textasset.h"
+#include "engine/enginelogger.h"
+
+class AssetHandleTest : public ::testing::Test {
+ protected:
+    static void SetUpTestSuite() {
+        if (cqsp::engine::engine_logger == nullptr) {
+            cqsp::engine::engine_logger = std::make_shared<spdlog::logger>("test");
+        }
+        package_path = std::filesystem::temp_directory_path() / "cqsp_asset_handle_test";
+        std::filesystem::remove_all(package_path);
+        std::filesystem::create_directories(package_path);
+        Write("info.hjson", "{\n    name: test\n    version: 1\n    title: Test\n    author: Test\n}\n");
+        Write("resource.hjson",
+              "{\n"
+              "    eager: {\n        path: eager.txt\n        type: text\n        hints: {}\n    }\n"
+              "    later: {\n        path: later.txt\n        type: text\n        hints: {\n            lazy: true\n"
+              "        }\n    }\n"
+              "    now: {\n        path: now.txt\n        type: text\n        hints: {\n            lazy: true\n"
+              "        }\n    }\n"
+              "}\n");
+        Write("eager.txt", "eager");
+        Write("later.txt", "later");
+        Write("now.txt", "now");
+    }
+
+    static void TearDownTestSuite() { std::filesystem::remove_all(package_path); }
+
+    static void Write(const std::string& name, const std::string& text) {
+        std::ofstream file(package_path / name, std::ios::binary);
+        file << text;
+    }
+
+    void SetUp() override {
+        auto loader = std::make_unique<cqsp::asset::AssetLoader>();
+        loader->manager = &manager;
+        auto package = loader->LoadPackage(package_path.string());
+        ASSERT_NE(package, nullptr);
+        manager.AddPackage(std::move(package));
+        manager.SetLoader(std::move(loader));
+    }
+
+    /// Updates the manager like the game loop does, until the handle is ready or it takes too long
+    bool WaitFor(cqsp::asset::AssetHandle<cqsp::asset::TextAsset>& handle) {
+        auto start = std::chrono::steady_clock::now();
+        while (!handle.IsReady() && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+            handle.Get();
+            manager.Update();
+        }
+        return handle.IsReady();
+    }
+
+    static inline std::filesystem::path package_path;
+    cqsp::asset::AssetManager manager;
+};
+
+TEST_F(AssetHandleTest, LazyNotLoadedTest) {
+    // Lazy assets are only registered until they are asked for
+    EXPECT_NE(manager.FindLoadedAsset("test:eager"), nullptr);
+    EXPECT_EQ(manager.FindLoadedAsset("test:later"), nullptr);
+    EXPECT_TRUE(manager.GetPackage("test")->HasAsset("later"));
+    EXPECT_FALSE(manager.GetPackage("test")->IsLoaded("later"));
+}
+
+TEST_F(AssetHandleTest, HandleTest) {
+    auto handle = manager.GetHandle<cqsp::asset::TextAsset>("test:later");
+    EXPECT_FALSE(handle.IsReady());
+    // Text has no placeholder
+    EXPECT_EQ(handle.Get(), nullptr);
+    ASSERT_TRUE(WaitFor(handle));
+    EXPECT_EQ(handle->data, "later");
+    EXPECT_TRUE(manager.GetPackage("test")->IsLoaded("later"));
+
+    // Handles to loaded assets are ready straight away
+    auto eager = manager.GetHandle<cqsp::asset::TextAsset>("test:eager");
+    EXPECT_TRUE(eager.IsReady());
+    EXPECT_EQ(eager->data, "eager");
+}
+
+TEST_F(AssetHandleTest, GetAssetTest) {
+    // Asking for a lazy asset directly loads it right away
+    auto* asset = manager.GetAsset<cqsp::asset::TextAsset>("test:now");
+    ASSERT_NE(asset, nullptr);
+    EXPECT_EQ(asset->data, "now");
+    EXPECT_EQ(manager.FindLoadedAsset("test:now"), asset);
+}
+
+TEST_F(AssetHandleTest, RequestTest) {
+    int calls = 0;
+    cqsp::asset::Asset* result = nullptr;
+    manager.RequestAsset("test:later", [&](cqsp::asset::Asset* asset) {
+        calls++;
+        result = asset;
+    });
+    // The same asset is only loaded once, but every callback is called
+    manager.RequestAsset("test:later", [&](cqsp::asset::Asset* asset) { calls++; });
+    auto start = std::chrono::steady_clock::now();
+    while (calls < 2 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        manager.Update();
+    }
+    ASSERT_EQ(calls, 2);
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(dynamic_cast<cqsp::asset::TextAsset*>(result)->data, "later");
+
+    // Missing assets call back with null
+    bool missing = false;
+    manager.RequestAsset("test:missing", [&](cqsp::asset::Asset* asset) { missing = asset == nullptr; });
+    EXPECT_TRUE(missing);
+}
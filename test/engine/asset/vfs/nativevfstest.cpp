@@ -17,7 +17,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <vector>
 
 #include "engine/asset/vfs/nativevfs.h"
 
@@ -80,6 +82,21 @@ TEST_F(NativeVfsTest, FileReadTest) {
     nfs.Close(ptr);
 }
 
+TEST_F(NativeVfsTest, FileViewTest) {
+    auto ptr = nfs.Open(test_file.c_str(), cqsp::asset::FileModes::Binary);
+    auto view = ptr->View();
+
+    std::ifstream file(full_name, std::ios::binary);
+    std::vector<uint8_t> truth((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ASSERT_EQ(view.size(), truth.size());
+    ASSERT_TRUE(std::equal(view.begin(), view.end(), truth.begin()));
+    // Viewing the file should not move the read position
+    ASSERT_EQ(ptr->Tell(), 0);
+
+    nfs.Close(ptr);
+}
+
 TEST_F(NativeVfsTest, SeekTest) {
     int size = std::filesystem::file_size(full_name);
 
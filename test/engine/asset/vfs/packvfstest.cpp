@@ -0,0 +1,141 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine/asset/vfs/nativevfs.h"
+#include "engine/asset/vfs/packvfs.h"
+#include "engine/enginelogger.h"
+
+class PackVfsTest : public ::testing::Test {
+ protected:
+    static void SetUpTestSuite() {
+        if (cqsp::engine::engine_logger == nullptr) {
+            cqsp::engine::engine_logger = std::make_shared<spdlog::logger>("test");
+        }
+        pack_path = (std::filesystem::temp_directory_path() / "cqsp_pack_test.cqpak").string();
+        ASSERT_TRUE(cqsp::asset::WritePackFile(package_root, pack_path));
+    }
+
+    static void TearDownTestSuite() { std::filesystem::remove(pack_path); }
+
+    PackVfsTest() : pfs(pack_path), nfs(package_root) {}
+
+    void SetUp() override { ASSERT_TRUE(pfs.Initialize()); }
+
+    static inline std::string package_root = "../data/core";
+    static inline std::string pack_path;
+    cqsp::asset::PackFileSystem pfs;
+    cqsp::asset::NativeFileSystem nfs;
+};
+
+TEST_F(PackVfsTest, FileReadTest) {
+    auto packed = pfs.Open("info.hjson");
+    auto native = nfs.Open("info.hjson");
+    ASSERT_NE(packed, nullptr);
+    ASSERT_EQ(packed->Path(), "info.hjson");
+    ASSERT_EQ(packed->Size(), native->Size());
+    ASSERT_EQ(cqsp::asset::ReadAllFromVFileToString(packed.get()),
+              cqsp::asset::ReadAllFromVFileToString(native.get()));
+    pfs.Close(packed);
+    nfs.Close(native);
+}
+
+TEST_F(PackVfsTest, EveryFileTest) {
+    // Every file has to come out of the pack the same as it went in, compressed or not
+    auto native_dir = nfs.OpenDirectory("");
+    ASSERT_EQ(pfs.GetEntries().size(), native_dir->GetSize());
+    for (const auto& entry : pfs.GetEntries()) {
+        auto packed = pfs.Open(entry.path);
+        auto native = nfs.Open(entry.path, cqsp::asset::FileModes::Binary);
+        ASSERT_NE(native, nullptr) << entry.path;
+        auto packed_view = packed->View();
+        auto native_view = native->View();
+        ASSERT_EQ(packed_view.size(), native_view.size()) << entry.path;
+        ASSERT_TRUE(std::equal(packed_view.begin(), packed_view.end(), native_view.begin())) << entry.path;
+    }
+}
+
+TEST_F(PackVfsTest, SeekTest) {
+    auto ptr = pfs.Open("info.hjson");
+    int size = ptr->Size();
+    ptr->Seek(10);
+    ASSERT_EQ(ptr->Tell(), 10);
+
+    ptr->Seek(30);
+    ASSERT_EQ(ptr->Tell(), 40);
+
+    ptr->Seek(10, cqsp::asset::Offset::Beg);
+    ASSERT_EQ(ptr->Tell(), 10);
+
+    ptr->Seek(-10, cqsp::asset::Offset::End);
+    ASSERT_EQ(ptr->Tell(), size - 10);
+    pfs.Close(ptr);
+}
+
+TEST_F(PackVfsTest, IsFileTest) {
+    ASSERT_TRUE(pfs.Exists("info.hjson"));
+    ASSERT_TRUE(pfs.IsFile("info.hjson"));
+    ASSERT_TRUE(pfs.IsFile("/info.hjson"));
+    // File doesn't exist
+    ASSERT_FALSE(pfs.IsFile("dir"));
+    ASSERT_FALSE(pfs.Exists("dir"));
+
+    // Is directory
+    ASSERT_FALSE(pfs.IsFile("data"));
+    ASSERT_TRUE(pfs.IsDirectory("data"));
+    ASSERT_TRUE(pfs.IsDirectory("data/"));
+
+    ASSERT_TRUE(pfs.Exists("data/goods"));
+    ASSERT_TRUE(pfs.IsDirectory("data/goods"));
+    // Only a prefix of a directory name
+    ASSERT_FALSE(pfs.IsDirectory("data/good"));
+}
+
+TEST_F(PackVfsTest, DirectoryTest) {
+    auto packed = pfs.OpenDirectory("data/goods");
+    auto native = nfs.OpenDirectory("data/goods");
+    ASSERT_NE(packed, nullptr);
+    ASSERT_EQ(packed->GetSize(), native->GetSize());
+    for (int i = 0; i < packed->GetSize(); i++) {
+        auto file = packed->GetFile(i);
+        ASSERT_NE(file, nullptr);
+        ASSERT_EQ(file->Path(), "data/goods/" + packed->GetFilename(i));
+    }
+    ASSERT_EQ(pfs.OpenDirectory("dir"), nullptr);
+}
+
+TEST_F(PackVfsTest, InvalidPackTest) {
+    cqsp::asset::PackFileSystem invalid(package_root + "/info.hjson");
+    ASSERT_FALSE(invalid.Initialize());
+}
+
+TEST_F(PackVfsTest, ReloadTest) {
+    // Open files keep working after the table of contents is read again
+    auto packed = pfs.Open("info.hjson");
+    std::string before = cqsp::asset::ReadAllFromVFileToString(packed.get());
+    ASSERT_TRUE(pfs.Initialize());
+    packed->Seek(0, cqsp::asset::Offset::Beg);
+    ASSERT_EQ(packed->Path(), "info.hjson");
+    ASSERT_EQ(cqsp::asset::ReadAllFromVFileToString(packed.get()), before);
+}
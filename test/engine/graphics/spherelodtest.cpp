@@ -0,0 +1,48 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "engine/graphics/primitives/spherelod.h"
+
+using cqsp::engine::primitive::SphereLod;
+
+TEST(SphereLodTest, LevelIncreasesWithSize) {
+    EXPECT_EQ(SphereLod::GetLevel(0), 0);
+    EXPECT_EQ(SphereLod::GetLevel(SphereLod::billboard_radius), 0);
+    int previous = 0;
+    for (float radius = 1; radius < 10000; radius *= 2) {
+        int level = SphereLod::GetLevel(radius);
+        EXPECT_GE(level, previous);
+        EXPECT_LT(level, SphereLod::level_count);
+        previous = level;
+    }
+    // Anything that fills the screen should get the highest level
+    EXPECT_EQ(SphereLod::GetLevel(5000), SphereLod::level_count - 1);
+}
+
+TEST(SphereLodTest, ScreenRadius) {
+    const float fov = 3.14159265359f / 2;
+    // With a 90 degree fov, a sphere at an angular radius of 45 degrees fills half the screen
+    double distance = std::sqrt(2.);
+    EXPECT_NEAR(SphereLod::GetScreenRadius(1, distance, fov, 1000), 500, 0.01);
+    // Further away bodies are smaller
+    EXPECT_LT(SphereLod::GetScreenRadius(1, 100, fov, 1000), SphereLod::GetScreenRadius(1, 10, fov, 1000));
+    // Inside the sphere
+    EXPECT_TRUE(std::isinf(SphereLod::GetScreenRadius(10, 1, fov, 1000)));
+}
@@ -0,0 +1,55 @@
+/* Conquer Space
+* Copyright (C) 2021 Conquer Space
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "engine/graphics/texture.h"
+#include "engine/graphics/texturestreamer.h"
+
+TEST(TextureTest, DownsampleImage) {
+    // 4x2 image with 2 components
+    std::vector<unsigned char> image = {0,  0,  10, 20, 100, 100, 200, 0,  //
+                                        20, 40, 30, 40, 100, 100, 0,   0};
+    int width, height;
+    auto result = cqsp::asset::DownsampleImage(image.data(), 4, 2, 2, 2, width, height);
+    ASSERT_EQ(width, 2);
+    ASSERT_EQ(height, 1);
+    ASSERT_EQ(result.size(), 4);
+    EXPECT_EQ(result[0], 15);
+    EXPECT_EQ(result[1], 25);
+    EXPECT_EQ(result[2], 100);
+    EXPECT_EQ(result[3], 50);
+}
+
+TEST(TextureTest, DownsampleSmallImage) {
+    std::vector<unsigned char> image = {1, 2, 3, 4, 5, 6};
+    int width, height;
+    // Already small enough
+    auto result = cqsp::asset::DownsampleImage(image.data(), 2, 1, 3, 16, width, height);
+    EXPECT_EQ(width, 2);
+    EXPECT_EQ(height, 1);
+    EXPECT_EQ(result, image);
+}
+
+TEST(TextureTest, StreamedTextureSize) {
+    cqsp::asset::StreamedTexture texture;
+    texture.full_width = 2048;
+    texture.full_height = 1024;
+    texture.components = 3;
+    EXPECT_EQ(cqsp::asset::TextureStreamer::GetTextureSize(texture), 2048ull * 1024 * 3 * 4 / 3);
+}